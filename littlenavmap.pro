@@ -289,6 +289,7 @@ SOURCES += \
   src/common/dialogrecordhelper.cpp \
   src/common/dirtool.cpp \
   src/common/elevationprovider.cpp \
+  src/common/globetilestore.cpp \
   src/common/filecheck.cpp \
   src/common/formatter.cpp \
   src/common/fueltool.cpp \
@@ -327,6 +328,7 @@ SOURCES += \
   src/export/exporter.cpp \
   src/geo/aircrafttrail.cpp \
   src/geo/coordinateconverter.cpp \
+  src/geo/linesimplifier.cpp \
   src/geo/marbleconverter.cpp \
   src/gui/holddialog.cpp \
   src/gui/coordinatedialog.cpp \
@@ -351,6 +353,7 @@ SOURCES += \
   src/mapgui/aprongeometrycache.cpp \
   src/mapgui/imageexportdialog.cpp \
   src/mapgui/mapairporthandler.cpp \
+  src/mapgui/mapbenchmark.cpp \
   src/mapgui/mapcontextmenu.cpp \
   src/mapgui/mapdetailhandler.cpp \
   src/mapgui/mapfunctions.cpp \
@@ -358,10 +361,13 @@ SOURCES += \
   src/mapgui/maplayersettings.cpp \
   src/mapgui/mapmarkhandler.cpp \
   src/mapgui/mappaintwidget.cpp \
+  src/mapgui/mapprefetcher.cpp \
   src/mapgui/mapscale.cpp \
+  src/mapgui/mapscreengrid.cpp \
   src/mapgui/mapscreenindex.cpp \
   src/mapgui/mapthemehandler.cpp \
   src/mapgui/maptooltip.cpp \
+  src/mapgui/mapviewportkey.cpp \
   src/mapgui/mapvisible.cpp \
   src/mapgui/mapwidget.cpp \
   src/mapgui/mapwidgetflags.cpp \
@@ -384,6 +390,8 @@ SOURCES += \
   src/mappainter/mappainterweather.cpp \
   src/mappainter/mappainterwind.cpp \
   src/mappainter/mappaintlayer.cpp \
+  src/mappainter/paintprofiler.cpp \
+  src/online/onlineclientstore.cpp \
   src/online/onlinedatacontroller.cpp \
   src/options/optiondata.cpp \
   src/options/optionsdialog.cpp \
@@ -425,6 +433,7 @@ SOURCES += \
   src/route/routelabel.cpp \
   src/route/routelabelflags.cpp \
   src/route/routeleg.cpp \
+  src/route/routenetworkcache.cpp \
   src/route/runwayselectiondialog.cpp \
   src/route/userwaypointdialog.cpp \
   src/routeexport/fetchroutedialog.cpp \
@@ -471,12 +480,15 @@ SOURCES += \
   src/weather/weathercontext.cpp \
   src/weather/weathercontexthandler.cpp \
   src/weather/weatherreporter.cpp \
+  src/weather/windgridcache.cpp \
   src/weather/windreporter.cpp \
   src/web/requesthandler.cpp \
   src/web/webapp.cpp \
   src/web/webcontroller.cpp \
   src/web/webflags.cpp \
   src/web/webmapcontroller.cpp \
+  src/web/webmaprequestscheduler.cpp \
+  src/web/webtilecache.cpp \
   src/web/webtools.cpp \
   src/webapi/abstractactionscontroller.cpp \
   src/webapi/abstractlnmactionscontroller.cpp \
@@ -498,6 +510,7 @@ HEADERS  += \
   src/common/dialogrecordhelper.h \
   src/common/dirtool.h \
   src/common/elevationprovider.h \
+  src/common/globetilestore.h \
   src/common/filecheck.h \
   src/common/formatter.h \
   src/common/fueltool.h \
@@ -538,6 +551,7 @@ HEADERS  += \
   src/export/exporter.h \
   src/geo/aircrafttrail.h \
   src/geo/coordinateconverter.h \
+  src/geo/linesimplifier.h \
   src/geo/marbleconverter.h \
   src/gui/holddialog.h \
   src/gui/coordinatedialog.h \
@@ -561,6 +575,7 @@ HEADERS  += \
   src/mapgui/aprongeometrycache.h \
   src/mapgui/imageexportdialog.h \
   src/mapgui/mapairporthandler.h \
+  src/mapgui/mapbenchmark.h \
   src/mapgui/mapcontextmenu.h \
   src/mapgui/mapdetailhandler.h \
   src/mapgui/mapfunctions.h \
@@ -568,10 +583,13 @@ HEADERS  += \
   src/mapgui/maplayersettings.h \
   src/mapgui/mapmarkhandler.h \
   src/mapgui/mappaintwidget.h \
+  src/mapgui/mapprefetcher.h \
   src/mapgui/mapscale.h \
+  src/mapgui/mapscreengrid.h \
   src/mapgui/mapscreenindex.h \
   src/mapgui/mapthemehandler.h \
   src/mapgui/maptooltip.h \
+  src/mapgui/mapviewportkey.h \
   src/mapgui/mapvisible.h \
   src/mapgui/mapwidget.h \
   src/mapgui/mapwidgetflags.h \
@@ -594,6 +612,8 @@ HEADERS  += \
   src/mappainter/mappainterweather.h \
   src/mappainter/mappainterwind.h \
   src/mappainter/mappaintlayer.h \
+  src/mappainter/paintprofiler.h \
+  src/online/onlineclientstore.h \
   src/online/onlinedatacontroller.h \
   src/options/optiondata.h \
   src/options/optionsdialog.h \
@@ -619,6 +639,7 @@ HEADERS  += \
   src/query/procedurequery.h \
   src/query/querymanager.h \
   src/query/querytypes.h \
+  src/query/tileindex.h \
   src/query/waypointquery.h \
   src/query/waypointtrackquery.h \
   src/route/customproceduredialog.h \
@@ -635,6 +656,7 @@ HEADERS  += \
   src/route/routelabel.h \
   src/route/routelabelflags.h \
   src/route/routeleg.h \
+  src/route/routenetworkcache.h \
   src/route/runwayselectiondialog.h \
   src/route/userwaypointdialog.h \
   src/routeexport/fetchroutedialog.h \
@@ -681,12 +703,15 @@ HEADERS  += \
   src/weather/weathercontext.h \
   src/weather/weathercontexthandler.h \
   src/weather/weatherreporter.h \
+  src/weather/windgridcache.h \
   src/weather/windreporter.h \
   src/web/requesthandler.h \
   src/web/webapp.h \
   src/web/webcontroller.h \
   src/web/webflags.h \
   src/web/webmapcontroller.h \
+  src/web/webmaprequestscheduler.h \
+  src/web/webtilecache.h \
   src/web/webtools.h \
   src/webapi/abstractactionscontroller.h \
   src/webapi/abstractlnmactionscontroller.h \
@@ -52,6 +52,13 @@ AirspaceController::AirspaceController(MainWindow *mainWindowParam)
   // Button and action handler =================================
   qDebug() << Q_FUNC_INFO;
 
+  auto airspacesModified = [this]() {
+    airspaceVersion++;
+  };
+  connect(this, &AirspaceController::updateAirspaceSources, this, airspacesModified);
+  connect(this, &AirspaceController::postDatabaseLoadAirspaces, this, airspacesModified);
+  connect(this, &AirspaceController::userAirspacesUpdated, this, airspacesModified);
+
   airspaceHandler = new AirspaceToolBarHandler(NavApp::getMainWindow());
   airspaceHandler->createToolButtons();
 
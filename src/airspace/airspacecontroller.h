@@ -88,6 +88,12 @@ public:
 
   void onlineClientAndAtcUpdated();
 
+  /* Incremented when airspace sources are changed or airspaces are loaded */
+  quint64 getAirspaceVersion() const
+  {
+    return airspaceVersion;
+  }
+
 signals:
   /* Filter in drop down buttons have changed */
   void updateAirspaceTypes(const map::MapAirspaceFilter& filter);
@@ -116,6 +122,8 @@ private:
 
   AirspaceToolBarHandler *airspaceHandler = nullptr;
   MainWindow *mainWindow;
+
+  quint64 airspaceVersion = 1;
 };
 
 #endif // LNM_AIRSPACECONTROLLER_H
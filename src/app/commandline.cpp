@@ -92,6 +92,13 @@ CommandLine::CommandLine()
                                                    "The code is not checked for existence or validity and "
                                                    "is saved for the next startup."), "language");
   parser->addOption(*languageOpt);
+
+  benchmarkMapOpt = new QCommandLineOption(lnm::STARTUP_BENCHMARK_MAP,
+                                           QObject::tr("Render all map views from the given <%1> JSON script file after startup "
+                                                       "and write paint times per view, painter and query into a report file. "
+                                                       "Uses the currently selected databases.").arg(lnm::STARTUP_BENCHMARK_MAP),
+                                           lnm::STARTUP_BENCHMARK_MAP);
+  parser->addOption(*benchmarkMapOpt);
 }
 
 CommandLine::~CommandLine()
@@ -106,6 +113,7 @@ CommandLine::~CommandLine()
   delete layoutOpt;
   delete languageOpt;
   delete quitOpt;
+  delete benchmarkMapOpt;
 }
 
 QString CommandLine::getOption(int argc, char *argv[], const QString& name, const QString& longname)
@@ -168,6 +176,9 @@ void CommandLine::process()
   if(parser->isSet(*quitOpt))
     Application::addStartupOptionStr(lnm::STARTUP_QUIT, QString());
 
+  if(parser->isSet(*benchmarkMapOpt) && !parser->value(*benchmarkMapOpt).isEmpty())
+    Application::addStartupOptionStr(lnm::STARTUP_BENCHMARK_MAP, parser->value(*benchmarkMapOpt));
+
   // Other arguments without option
   if(!parser->positionalArguments().isEmpty())
     Application::addStartupOptionStrList(lnm::STARTUP_OTHER_ARGUMENTS, parser->positionalArguments());
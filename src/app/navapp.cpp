@@ -489,9 +489,20 @@ Route& NavApp::getRoute()
   return mainWindow->getRouteController()->getRoute();
 }
 
+std::shared_ptr<const Route> NavApp::getRouteSnapshot()
+{
+  return mainWindow->getRouteController()->getRouteSnapshot();
+}
+
+std::shared_ptr<const Route> NavApp::getRouteSnapshotAdjusted(rf::RouteAdjustOptions options)
+{
+  return mainWindow->getRouteController()->getRouteSnapshotAdjusted(options);
+}
+
 void NavApp::updateRouteCycleMetadata()
 {
   getRoute().updateRouteCycleMetadata();
+  mainWindow->getRouteController()->routeModified();
 }
 
 QString NavApp::getRouteStringLogbook()
@@ -22,6 +22,9 @@
 
 #include "common/mapflags.h"
 #include "fs/fspaths.h"
+#include "route/routeflags.h"
+
+#include <memory>
 
 class AircraftPerfController;
 class AircraftTrail;
@@ -213,6 +216,10 @@ public:
 
   static const Route& getRouteConst();
   static Route& getRoute();
+
+  /* Shared immutable copies of the route. See RouteController::getRouteSnapshot() */
+  static std::shared_ptr<const Route> getRouteSnapshot();
+  static std::shared_ptr<const Route> getRouteSnapshotAdjusted(rf::RouteAdjustOptions options);
   static void updateRouteCycleMetadata();
 
   /* Get a generic route string for logbook entry */
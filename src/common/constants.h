@@ -485,6 +485,7 @@ const QLatin1String STARTUP_FLIGHTPLAN_DESCR("flight-plan-descr");
 const QLatin1String STARTUP_AIRCRAFT_PERF("aircraft-perf");
 const QLatin1String STARTUP_LAYOUT("layout");
 const QLatin1String STARTUP_QUIT("quit"); /* Exit application */
+const QLatin1String STARTUP_BENCHMARK_MAP("benchmark-map"); /* Replay map views from script and write report */
 
 /* Not used as long options */
 const QLatin1String STARTUP_OTHER_ARGUMENTS("others"); /* Positional arguments not found after option - string list */
@@ -18,6 +18,7 @@
 #include "common/elevationprovider.h"
 
 #include "common/constants.h"
+#include "common/globetilestore.h"
 #include "geo/calculations.h"
 #include "app/navapp.h"
 #include "fs/common/globereader.h"
@@ -32,7 +33,12 @@
 #include <marble/GeoDataCoordinates.h>
 #include <marble/ElevationModel.h>
 
+#include <QElapsedTimer>
+#include <QRandomGenerator>
 #include <QUrl>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <cmath>
 
 /* Limt altitude to this value */
 static Q_DECL_CONSTEXPR float ALTITUDE_LIMIT_METER = 8800.f;
@@ -53,7 +59,11 @@ ElevationProvider::ElevationProvider(QObject *parent)
 
 ElevationProvider::~ElevationProvider()
 {
-  delete globeReader;
+}
+
+std::shared_ptr<const GlobeTileStore> ElevationProvider::getGlobeStore() const
+{
+  return std::atomic_load(&globeStore);
 }
 
 void ElevationProvider::marbleUpdateAvailable()
@@ -64,15 +74,9 @@ void ElevationProvider::marbleUpdateAvailable()
 
 float ElevationProvider::getElevationMeter(const atools::geo::Pos& pos, float sampleRadiusMeter)
 {
-  if(isGlobeOfflineProvider())
-  {
-    QMutexLocker locker(&mutex);
-    float elevation = globeReader->getElevation(pos, sampleRadiusMeter);
-    if(!(elevation > atools::fs::common::OCEAN && elevation < atools::fs::common::INVALID))
-      return 0.f;
-    else
-      return elevation;
-  }
+  std::shared_ptr<const GlobeTileStore> store = getGlobeStore();
+  if(store != nullptr)
+    return std::min(store->getElevationMeter(pos, sampleRadiusMeter), ALTITUDE_LIMIT_METER);
   else
     return 0.f;
 }
@@ -87,21 +91,45 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
   if(!line.isValid())
     return;
 
-  QMutexLocker locker(&mutex);
-
-  if(isGlobeOfflineProvider())
+  std::shared_ptr<const GlobeTileStore> store = getGlobeStore();
+  if(store != nullptr)
   {
-    globeReader->getElevations(elevations, LineString(line.getPos1(), line.getPos2()), sampleRadiusMeter);
-    for(Pos& pos : elevations)
+    // Split line into points along the great circle and fetch all at once without locking
+    // Sample twice per GLOBE grid cell (about 460 m) so that hardly any cell crossed by the line is skipped
+    float lengthMeter = line.lengthMeter();
+    float sampleDistanceMeter = GlobeTileStore::getCellSizeMeter() / 2.f;
+    int numPoints = std::max(1, static_cast<int>(std::ceil(lengthMeter / sampleDistanceMeter)));
+
+    LineString positions;
+    line.interpolatePoints(lengthMeter, numPoints, positions);
+    positions.append(line.getPos2());
+
+    QVector<Pos> samples(positions.begin(), positions.end());
+    store->getElevationsMeter(samples, sampleRadiusMeter);
+
+    // Drop consecutive points with same elevation but keep first and last one of each stretch
+    Pos lastDropped;
+    for(int i = 0; i < samples.size(); i++)
     {
-      float alt = pos.getAltitude();
-      if(!(alt > atools::fs::common::OCEAN && alt < atools::fs::common::INVALID))
-        // Reset all invalid and ocean indicators to 0
-        pos.setAltitude(0.f);
+      const Pos& pos = samples.at(i);
+      if(!elevations.isEmpty() && i < samples.size() - 1 &&
+         atools::almostEqual(elevations.constLast().getAltitude(), pos.getAltitude()))
+      {
+        lastDropped = pos;
+        continue;
+      }
+      else if(lastDropped.isValid())
+      {
+        elevations.append(lastDropped);
+        lastDropped = Pos();
+      }
+      elevations.append(pos);
     }
   }
   else if(marbleModel != nullptr)
   {
+    QMutexLocker locker(&mutex);
+
     // Get altitude points for the line segment
     // The might not be complete and will be more complete on further iterations when we get a signal
     // from the elevation model
@@ -154,9 +182,65 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
     pos.setAltitude(std::min(pos.getAltitude(), ALTITUDE_LIMIT_METER));
 }
 
+void ElevationProvider::getElevations(QVector<atools::geo::Pos>& positions, float sampleRadiusMeter)
+{
+  std::shared_ptr<const GlobeTileStore> store = getGlobeStore();
+  if(store != nullptr)
+  {
+    store->getElevationsMeter(positions, sampleRadiusMeter);
+
+    for(Pos& pos : positions)
+      pos.setAltitude(std::min(pos.getAltitude(), ALTITUDE_LIMIT_METER));
+  }
+  else
+  {
+    for(Pos& pos : positions)
+      pos.setAltitude(0.f);
+  }
+}
+
+void ElevationProvider::benchmark()
+{
+  if(getGlobeStore() == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "No GLOBE data";
+    return;
+  }
+
+  const int NUM_SAMPLES = 1000000;
+
+  // Random positions world wide
+  QVector<Pos> positions;
+  positions.reserve(NUM_SAMPLES);
+  QRandomGenerator random(42);
+  for(int i = 0; i < NUM_SAMPLES; i++)
+    positions.append(Pos(static_cast<float>(random.bounded(360.) - 180.), static_cast<float>(random.bounded(180.) - 90.)));
+
+  for(int numThreads : {1, 2, 4, 8})
+  {
+    QElapsedTimer timer;
+    timer.start();
+
+    // Each thread samples all positions
+    QVector<QFuture<void> > futures;
+    for(int i = 0; i < numThreads; i++)
+      futures.append(QtConcurrent::run([this, positions]() {
+        QVector<Pos> samples(positions);
+        getElevations(samples, 0.f);
+      }));
+
+    for(QFuture<void>& future : futures)
+      future.waitForFinished();
+
+    double seconds = timer.nsecsElapsed() / 1.e9;
+    qInfo() << Q_FUNC_INFO << "threads" << numThreads << "samples per second"
+            << QString::number(NUM_SAMPLES * numThreads / seconds, 'f', 0);
+  }
+}
+
 bool ElevationProvider::isGlobeOfflineProvider() const
 {
-  return globeReader != nullptr && globeReader->isValid();
+  return getGlobeStore() != nullptr;
 }
 
 bool ElevationProvider::isGlobeDirValid()
@@ -193,42 +277,32 @@ void ElevationProvider::updateReader(bool startupParam)
   bool useOffline = OptionData::instance().getFlags().testFlag(opts::CACHE_USE_OFFLINE_ELEVATION);
   const QString& path = OptionData::instance().getOfflineElevationPath();
 
+  std::shared_ptr<const GlobeTileStore> store;
+  if(useOffline)
   {
-    // Make sure to wait for other methods to finish before changing the reader
-    QMutexLocker locker(&mutex);
-
-    if(useOffline)
+    if(!GlobeReader::isDirValid(path))
+      warnWrongGlobePath = true;
+    else
     {
-      if(!GlobeReader::isDirValid(path))
+      qDebug() << Q_FUNC_INFO << "Opening GLOBE files";
+
+      GlobeTileStore *newStore = new GlobeTileStore(path);
+      if(newStore->open())
       {
-        warnWrongGlobePath = true;
-        delete globeReader;
-        globeReader = nullptr;
+        store.reset(newStore);
+        qDebug() << Q_FUNC_INFO << "Opening GLOBE done";
       }
       else
       {
-        delete globeReader;
-        globeReader = new GlobeReader(path);
-
-        qDebug() << Q_FUNC_INFO << "Opening GLOBE files";
-
-        if(!globeReader->openFiles())
-        {
-          delete globeReader;
-          globeReader = nullptr;
-          warnOpenFiles = true;
-        }
-        else
-          qDebug() << Q_FUNC_INFO << "Opening GLOBE done";
+        delete newStore;
+        warnOpenFiles = true;
       }
     }
-    else
-    {
-      delete globeReader;
-      globeReader = nullptr;
-    }
   }
 
+  // Threads still using the previous store keep it alive until they are done
+  std::atomic_store(&globeStore, store);
+
   emit updateAvailable();
 }
 
@@ -20,18 +20,17 @@
 
 #include <QMutex>
 #include <QObject>
+#include <QVector>
+
+#include <memory>
 
 namespace Marble {
 class ElevationModel;
 }
 
-namespace atools {
-namespace fs {
-namespace common {
-class GlobeReader;
-}
-}
+class GlobeTileStore;
 
+namespace atools {
 namespace geo {
 class Pos;
 class LineString;
@@ -43,7 +42,8 @@ class Line;
  * Wraps the slow Marble online elevation provider and the fast offline GLOBE data provider.
  * Use GLOBE data if all paramters are set properly in settings.
  *
- * Class is thread safe.
+ * Class is thread safe. GLOBE lookups use a memory mapped read-only store and do not lock.
+ * Only the Marble online provider and changes of the GLOBE store are synchronized.
  */
 class ElevationProvider :
   public QObject
@@ -67,6 +67,13 @@ public:
    * "sampleRadiusMeter" defines a rectangle where five points are sampled for each pos and the maximum is used.*/
   void getElevations(atools::geo::LineString& elevations, const atools::geo::Line& line, float sampleRadiusMeter = 0.f);
 
+  /* Batched lookup which sets the altitude of all positions to the elevation in meter. Only for offline data.
+   * Altitude is set to 0 if offline data is not available. Can be called from many threads concurrently. */
+  void getElevations(QVector<atools::geo::Pos>& positions, float sampleRadiusMeter = 0.f);
+
+  /* Log samples per second for offline data using different numbers of threads. Only for debugging. */
+  void benchmark();
+
   /* true if the data is provided from the fast offline source */
   bool isGlobeOfflineProvider() const;
 
@@ -98,12 +105,17 @@ private:
   void marbleUpdateAvailable();
   void updateReader(bool startupParam);
 
+  /* Get current store. Null if offline data is not used. Store remains valid as long as the pointer is kept. */
+  std::shared_ptr<const GlobeTileStore> getGlobeStore() const;
+
   const Marble::ElevationModel *marbleModel = nullptr;
-  atools::fs::common::GlobeReader *globeReader = nullptr;
+
+  /* Replaced atomically when options change */
+  std::shared_ptr<const GlobeTileStore> globeStore;
 
   bool warnWrongGlobePath = false, warnOpenFiles = false, startup = false;
 
-  /* Need to synchronize here since it is called from profile widget thread */
+  /* Need to synchronize Marble model access since it is called from profile widget thread */
   mutable QMutex mutex;
 
 };
@@ -0,0 +1,179 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "common/globetilestore.h"
+
+#include "atools.h"
+#include "geo/calculations.h"
+#include "geo/pos.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QtEndian>
+
+#include <cmath>
+
+/* Number of files */
+static Q_DECL_CONSTEXPR int GLOBE_NUM_TILES = 16;
+
+/* Grid cells per degree and columns in each file */
+static Q_DECL_CONSTEXPR int GLOBE_CELLS_PER_DEGREE = 120;
+static Q_DECL_CONSTEXPR int GLOBE_COLUMNS = 90 * GLOBE_CELLS_PER_DEGREE;
+
+/* Value used in files for ocean */
+static Q_DECL_CONSTEXPR qint16 GLOBE_OCEAN = -500;
+
+/* Meter per degree latitude */
+static Q_DECL_CONSTEXPR double METER_PER_DEGREE = 111319.49;
+
+GlobeTileStore::GlobeTileStore(const QString& pathParam)
+  : path(pathParam)
+{
+  tiles.resize(GLOBE_NUM_TILES);
+}
+
+GlobeTileStore::~GlobeTileStore()
+{
+  for(Tile& tile : tiles)
+  {
+    if(tile.file != nullptr)
+    {
+      if(tile.data != nullptr)
+        tile.file->unmap(const_cast<uchar *>(tile.data));
+      tile.file->close();
+      delete tile.file;
+    }
+  }
+}
+
+bool GlobeTileStore::open()
+{
+  valid = false;
+  QDir dir(path);
+
+  for(int i = 0; i < GLOBE_NUM_TILES; i++)
+  {
+    Tile& tile = tiles[i];
+
+    // Row 0: a - d from 50 to 90 north, row 1: e - h from 0 to 50 north,
+    // row 2: i - l from 50 south to 0 and row 3: m - p from 90 to 50 south
+    int tileRow = i / 4;
+    tile.rows = (tileRow == 0 || tileRow == 3 ? 40 : 50) * GLOBE_CELLS_PER_DEGREE;
+
+    QString name = QString(QChar('a' + i)) + "10g";
+    QString filename = dir.filePath(name);
+    if(!QFile::exists(filename))
+      filename = dir.filePath(name.toUpper());
+
+    tile.file = new QFile(filename);
+    if(tile.file->open(QIODevice::ReadOnly))
+    {
+      qint64 size = static_cast<qint64>(tile.rows) * GLOBE_COLUMNS * static_cast<qint64>(sizeof(qint16));
+      if(tile.file->size() >= size)
+        tile.data = tile.file->map(0, size);
+
+      if(tile.data == nullptr)
+        qWarning() << Q_FUNC_INFO << "Cannot map" << filename << tile.file->errorString();
+      else
+        valid = true;
+    }
+  }
+
+  qDebug() << Q_FUNC_INFO << path << "valid" << valid;
+  return valid;
+}
+
+float GlobeTileStore::cellElevationMeter(double lonX, double latY) const
+{
+  // Wrap around at anti-meridian, clamp at poles and get tile
+  if(lonX < -180.)
+    lonX += 360.;
+  else if(lonX >= 180.)
+    lonX -= 360.;
+  lonX = atools::minmax(-180., 180. - 1. / GLOBE_CELLS_PER_DEGREE, lonX);
+  latY = atools::minmax(-90. + 1. / GLOBE_CELLS_PER_DEGREE, 90., latY);
+
+  int tileColumn = std::min(static_cast<int>((lonX + 180.) / 90.), 3);
+  int tileRow;
+  double tileTopLat;
+  if(latY > 50.)
+  {
+    tileRow = 0;
+    tileTopLat = 90.;
+  }
+  else if(latY > 0.)
+  {
+    tileRow = 1;
+    tileTopLat = 50.;
+  }
+  else if(latY > -50.)
+  {
+    tileRow = 2;
+    tileTopLat = 0.;
+  }
+  else
+  {
+    tileRow = 3;
+    tileTopLat = -50.;
+  }
+
+  const Tile& tile = tiles.at(tileRow * 4 + tileColumn);
+  if(tile.data == nullptr)
+    return 0.f;
+
+  // Cell in tile
+  int column = std::min(static_cast<int>((lonX + 180. - tileColumn * 90.) * GLOBE_CELLS_PER_DEGREE), GLOBE_COLUMNS - 1);
+  int row = std::min(static_cast<int>((tileTopLat - latY) * GLOBE_CELLS_PER_DEGREE), tile.rows - 1);
+
+  qint16 value = qFromLittleEndian<qint16>(tile.data + (static_cast<qint64>(row) * GLOBE_COLUMNS + column) * sizeof(qint16));
+  // Ocean is sea level - keep other values below zero like the Dead Sea shore
+  return value == GLOBE_OCEAN ? 0.f : static_cast<float>(value);
+}
+
+float GlobeTileStore::getCellSizeMeter()
+{
+  return static_cast<float>(METER_PER_DEGREE / GLOBE_CELLS_PER_DEGREE);
+}
+
+float GlobeTileStore::getElevationMeter(const atools::geo::Pos& pos, float sampleRadiusMeter) const
+{
+  if(!valid || !pos.isValid())
+    return 0.f;
+
+  double lonX = pos.getLonX(), latY = pos.getLatY();
+  float elevation = cellElevationMeter(lonX, latY);
+
+  if(sampleRadiusMeter > 0.f)
+  {
+    // Sample the corners of the rectangle and use the maximum
+    double radiusLat = sampleRadiusMeter / METER_PER_DEGREE;
+    double radiusLon = radiusLat / std::max(std::cos(atools::geo::toRadians(latY)), 0.01);
+
+    elevation = std::max(elevation, cellElevationMeter(lonX - radiusLon, latY + radiusLat));
+    elevation = std::max(elevation, cellElevationMeter(lonX + radiusLon, latY + radiusLat));
+    elevation = std::max(elevation, cellElevationMeter(lonX + radiusLon, latY - radiusLat));
+    elevation = std::max(elevation, cellElevationMeter(lonX - radiusLon, latY - radiusLat));
+  }
+  return elevation;
+}
+
+void GlobeTileStore::getElevationsMeter(QVector<atools::geo::Pos>& positions, float sampleRadiusMeter) const
+{
+  for(atools::geo::Pos& pos : positions)
+    pos.setAltitude(getElevationMeter(pos, sampleRadiusMeter));
+}
@@ -0,0 +1,85 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_GLOBETILESTORE_H
+#define LNM_GLOBETILESTORE_H
+
+#include <QString>
+#include <QVector>
+
+class QFile;
+
+namespace atools {
+namespace geo {
+class Pos;
+}
+}
+
+/*
+ * Read-only store for the GLOBE elevation data files a10g to p10g.
+ *
+ * All files are memory mapped on open() and never changed afterwards. Lookups only read the mapped memory and
+ * can be called from any number of threads at the same time without locking.
+ *
+ * Each file covers 90 degree longitude and 40 or 50 degree latitude at 30 arc seconds resolution stored as
+ * little endian 16 bit integers in rows from north to south.
+ * Ocean and missing values are returned as 0 meter.
+ */
+class GlobeTileStore
+{
+public:
+  explicit GlobeTileStore(const QString& pathParam);
+  ~GlobeTileStore();
+
+  GlobeTileStore(const GlobeTileStore& other) = delete;
+  GlobeTileStore& operator=(const GlobeTileStore& other) = delete;
+
+  /* Map all files found in path. Returns false if no file could be mapped. */
+  bool open();
+
+  /* At least one file mapped */
+  bool isValid() const
+  {
+    return valid;
+  }
+
+  /* Elevation in meter. "sampleRadiusMeter" defines a rectangle where five points are sampled and the maximum is used. */
+  float getElevationMeter(const atools::geo::Pos& pos, float sampleRadiusMeter = 0.f) const;
+
+  /* Batched version of above. Sets the altitude of all positions to the elevation in meter. */
+  void getElevationsMeter(QVector<atools::geo::Pos>& positions, float sampleRadiusMeter = 0.f) const;
+
+  /* Height of a grid cell in meter. This is also the width at the equator which gets smaller towards the poles. */
+  static float getCellSizeMeter();
+
+private:
+  struct Tile
+  {
+    QFile *file = nullptr;
+    const uchar *data = nullptr; /* Mapped file content or null if not available */
+    int rows = 0;
+  };
+
+  /* Elevation of the grid cell containing the coordinates */
+  float cellElevationMeter(double lonX, double latY) const;
+
+  QString path;
+  QVector<Tile> tiles;
+  bool valid = false;
+};
+
+#endif // LNM_GLOBETILESTORE_H
@@ -3103,7 +3103,7 @@ bool HtmlInfoBuilder::distanceToRouteText(const ageo::Pos& pos, HtmlBuilder& htm
   return false;
 }
 
-bool HtmlInfoBuilder::bearingToUserText(const ageo::Pos& pos, float magVar, HtmlBuilder& html) const
+QString HtmlInfoBuilder::bearingToUserValue(const ageo::Pos& pos, float magVar) const
 {
   if(OptionData::instance().getDisplayTooltipOptions().testFlag(optsd::TOOLTIP_DISTBRG_USER))
   {
@@ -3113,21 +3113,36 @@ bool HtmlInfoBuilder::bearingToUserText(const ageo::Pos& pos, float magVar, Html
 
       float distance = pos.distanceMeterTo(userAircraft.getPosition());
       if(distance < MAX_DISTANCE_FOR_BEARING_METER)
-      {
-        html.row2(tr("Bearing and distance from user aircraft:"),
-                  tr("%1, %2").
-                  arg(courseTextFromTrue(normalizeCourse(userAircraft.getPosition().angleDegTo(pos)), magVar)).
-                  arg(Unit::distMeter(distance)),
-                  ahtml::NO_ENTITIES);
+        return tr("%1, %2").
+               arg(courseTextFromTrue(normalizeCourse(userAircraft.getPosition().angleDegTo(pos)), magVar)).
+               arg(Unit::distMeter(distance));
+    }
+  }
+  return QString();
+}
+
+bool HtmlInfoBuilder::bearingToUserText(const ageo::Pos& pos, float magVar, HtmlBuilder& html) const
+{
+  QString value = bearingToUserValue(pos, magVar), text = value;
+
+  // Remember field even if not shown to detect when the row appears
+  if(dynamicFields != nullptr)
+  {
+    if(!value.isEmpty())
+      text = dynamicFieldHtml(dynamicFields->size(), value);
+    dynamicFields->append({pos, magVar, value});
+  }
+
+  if(!value.isEmpty())
+  {
+    html.row2(tr("Bearing and distance from user aircraft:"), text, ahtml::NO_ENTITIES);
 
 #ifdef DEBUG_INFORMATION_INFO
-        static bool heartbeat = false;
-        html.row2(heartbeat ? " X" : " 0");
-        heartbeat = !heartbeat;
+    static bool heartbeat = false;
+    html.row2(heartbeat ? " X" : " 0");
+    heartbeat = !heartbeat;
 #endif
-        return true;
-      }
-    }
+    return true;
   }
   return false;
 }
@@ -20,6 +20,7 @@
 
 #include "common/mapflags.h"
 #include "fs/weather/weathertypes.h"
+#include "geo/pos.h"
 #include "grib/windtypes.h"
 #include "util/locker.h"
 
@@ -309,6 +310,37 @@ public:
     symbolSizeTitle = value;
   }
 
+  /* Value which changes with the user aircraft position. Collected while building information texts
+   * to allow updating the document instead of rebuilding it. */
+  struct DynamicField
+  {
+    atools::geo::Pos pos;
+    float magVar;
+    QString value; /* Value as shown in text or empty if row was omitted */
+  };
+
+  /* Collect bearing fields into the given list while building texts. Shown values are wrapped into anchors
+   * named by dynamicFieldAnchor(). Pass null to stop collecting. */
+  void setDynamicFields(QVector<DynamicField> *fields)
+  {
+    dynamicFields = fields;
+  }
+
+  /* Anchor name for field at index in list */
+  static QString dynamicFieldAnchor(int index)
+  {
+    return QString("lnmdyn%1").arg(index);
+  }
+
+  /* Value wrapped into named anchor for field at index in list */
+  static QString dynamicFieldHtml(int index, const QString& value)
+  {
+    return QString("<a name=\"%1\">%2</a>").arg(dynamicFieldAnchor(index)).arg(value);
+  }
+
+  /* Bearing and distance from user aircraft or empty if not connected, too far away or disabled in options */
+  QString bearingToUserValue(const atools::geo::Pos& pos, float magVar) const;
+
   /* Add bearing and distance to user and last flight plan leg in a table if pos is valid */
   void bearingAndDistanceTexts(const atools::geo::Pos& pos, float magvar, atools::util::HtmlBuilder& html, bool bearing, bool distance);
 
@@ -463,6 +495,9 @@ private:
   Queries *queries;
 
   QLocale locale;
+
+  /* Not owned. Filled by bearingToUserText() if not null. */
+  QVector<DynamicField> *dynamicFields = nullptr;
 };
 
 /* Lock/unlock stack helper */
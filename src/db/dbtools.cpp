@@ -109,6 +109,39 @@ void openDatabaseFile(atools::sql::SqlDatabase *db, const QString& file, bool re
   }
 }
 
+void openDatabaseFileShared(atools::sql::SqlDatabase *db, const QString& file, int cacheKb, int mmapSizeMb)
+{
+  // Normal locking releases the shared lock after each statement which allows other connections to read in parallel
+  QStringList pragmas({QString("PRAGMA cache_size=-%1").arg(cacheKb), "PRAGMA locking_mode=NORMAL",
+                       "PRAGMA busy_timeout=2000", "PRAGMA query_only=ON"});
+
+  // Map file into memory to avoid copying pages into the per connection cache
+  if(mmapSizeMb > 0)
+    pragmas.append(QString("PRAGMA mmap_size=%1").arg(static_cast<qint64>(mmapSizeMb) * 1024 * 1024));
+
+  qDebug() << Q_FUNC_INFO << "Opening shared database file" << file;
+  qDebug() << Q_FUNC_INFO << "Pragmas" << pragmas;
+
+  db->setDatabaseName(file);
+  db->setAutomaticTransactions(false);
+  db->open(pragmas, true /* readonly */);
+}
+
+void openDatabaseFileTemporary(atools::sql::SqlDatabase *db, const QString& file, int cacheKb)
+{
+  // Content is rebuilt on each use - no need to sync
+  QStringList pragmas({QString("PRAGMA cache_size=-%1").arg(cacheKb), "PRAGMA page_size=8196",
+                       "PRAGMA locking_mode=NORMAL", "PRAGMA journal_mode=DELETE", "PRAGMA synchronous=OFF",
+                       "PRAGMA busy_timeout=2000", "PRAGMA foreign_keys = OFF"});
+
+  qDebug() << Q_FUNC_INFO << "Opening temporary database file" << file;
+  qDebug() << Q_FUNC_INFO << "Pragmas" << pragmas;
+
+  db->setDatabaseName(file);
+  db->setAutomaticTransactions(false);
+  db->open(pragmas, false /* readonly */);
+}
+
 void closeDatabaseFile(atools::sql::SqlDatabase *db)
 {
   try
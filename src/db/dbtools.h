@@ -51,12 +51,22 @@ const QString DATABASE_NAME_NAV_AIRSPACE = "LNMDBNAVAS";
 /* Network online player data */
 const QString DATABASE_NAME_ONLINE = "LNMDBONLINE";
 
+/* Network online player data parsed in background before copying to the online database */
+const QString DATABASE_NAME_ONLINE_STAGING = "LNMDBONLINESTAGING";
+
 /* Temporary database used for database checking, copying and preparation */
 const QString DATABASE_NAME_TEMP = "LNMTEMPDB";
 
 /* Temporary database used for compiling the scenery library */
 const QString DATABASE_NAME_LOADER = "LNMLOADER";
 
+/* Read only connections used to load the flight plan calculation networks in background */
+const QString DATABASE_NAME_ROUTE_NAV = "LNMROUTENAV";
+const QString DATABASE_NAME_ROUTE_TRACK = "LNMROUTETRACK";
+
+/* Prefix for read only connections of the per thread query pool. Followed by a number and the database name. */
+const QString DATABASE_NAME_THREAD_PREFIX = "LNMTHREAD";
+
 /* Used to temporary load metadata */
 const QString DATABASE_NAME_DLG_INFO_TEMP = "LNMTEMPDB2";
 
@@ -70,6 +80,15 @@ void openDatabaseFile(atools::sql::SqlDatabase *db, const QString& file, bool re
 void openDatabaseFileExt(atools::sql::SqlDatabase *db, const QString& file, bool readonly, bool createSchema, bool exclusive,
                          bool autoTransactions);
 
+/* Opens an additional read only connection to a database which is already opened by another connection.
+ * Uses normal locking to allow concurrent readers and memory mapped I/O if mmapSizeMb is larger than zero.
+ * Does not access settings and can be called from any thread. Throws exceptions. */
+void openDatabaseFileShared(atools::sql::SqlDatabase *db, const QString& file, int cacheKb, int mmapSizeMb);
+
+/* Opens a read/write database for temporary data like staging tables. Uses normal locking to allow attaching by
+ * other connections. Does not access settings and can be called from any thread. Throws exceptions. */
+void openDatabaseFileTemporary(atools::sql::SqlDatabase *db, const QString& file, int cacheKb);
+
 /* Catches exceptions and terminates program if any */
 void closeDatabaseFile(atools::sql::SqlDatabase *db);
 
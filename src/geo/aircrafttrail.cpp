@@ -23,6 +23,7 @@
 #include "fs/gpx/gpxtypes.h"
 #include "fs/sc/simconnectuseraircraft.h"
 #include "geo/calculations.h"
+#include "geo/linesimplifier.h"
 #include "geo/linestring.h"
 #include "geo/marbleconverter.h"
 #include "io/fileroller.h"
@@ -44,6 +45,13 @@ static const float MAX_POINT_DISTANCE_NM = 5.f;
 /* Split lines up for display */
 static const int PARTITION_POINT_SIZE = 200;
 
+/* Maximum deviation of trail points from the simplified lines for each level of detail. Each level is built
+ * from the full resolution trail. */
+static const QVector<float> LOD_TOLERANCE_METER({25.f, 100.f, 400.f, 1600.f, 6400.f});
+
+/* Fix a point after this number of skipped points to limit the effort for error checks per appended point */
+static const int LOD_MAX_SKIPPED = 64;
+
 static const quint32 FILE_MAGIC_NUMBER = 0x5B6C1A2B;
 
 /* Version 2 to adds timstamp and single floating point precision. Uses 32-bit second timestamps */
@@ -126,6 +134,13 @@ AircraftTrail::AircraftTrail()
 
   // Use maxAltDiffFtLower if below or maxAltDiffFtUpper if above - interpolated
   aglThresholdFt = settings.getAndStoreValue(lnm::SETTINGS_AIRCRAFT_TRAIL + "AglThresholdFt", 10000.).toFloat();
+
+  for(float tolerance : LOD_TOLERANCE_METER)
+  {
+    LodLevel level;
+    level.toleranceMeter = tolerance;
+    lodLevels.append(level);
+  }
 }
 
 AircraftTrail::~AircraftTrail()
@@ -162,6 +177,7 @@ AircraftTrail& AircraftTrail::operator=(const AircraftTrail& other)
 
   lineStrings = other.lineStrings;
   lineStringsIndex = other.lineStringsIndex;
+  lodLevels = other.lodLevels;
 
   return *this;
 }
@@ -554,6 +570,7 @@ int AircraftTrail::appendTrailPos(const atools::fs::sc::SimConnectUserAircraft&
     clearBoundaries();
     lineStrings.clear();
     lineStringsIndex.clear();
+    clearLod();
   }
 
 #ifdef DEBUG_INFORMATION_TRAIL
@@ -598,6 +615,7 @@ void AircraftTrail::clearTrail()
   clearBoundaries();
   lineStrings.clear();
   lineStringsIndex.clear();
+  clearLod();
 }
 
 void AircraftTrail::clearBoundaries()
@@ -680,6 +698,79 @@ void AircraftTrail::updateLineStringsLast()
         else
           lastLineString.append(lastTrailPos.getPosition());
       }
+
+      // Previous is invalid if trail was split before
+      appendLod(lastTrailPos.getPosition(), size() < 2 || !at(size() - 2).isValid());
+    }
+  }
+}
+
+const QVector<atools::geo::LineString>& AircraftTrail::getLineStrings(float maxErrorMeter) const
+{
+  // Find coarsest level within error
+  for(int i = lodLevels.size() - 1; i >= 0; i--)
+  {
+    if(lodLevels.at(i).toleranceMeter <= maxErrorMeter)
+      return lodLevels.at(i).lineStrings;
+  }
+  return lineStrings;
+}
+
+void AircraftTrail::clearLod()
+{
+  for(LodLevel& level : lodLevels)
+  {
+    level.lineStrings.clear();
+    level.skipped.clear();
+  }
+}
+
+void AircraftTrail::appendLod(const atools::geo::Pos& pos, bool newLine)
+{
+  for(LodLevel& level : lodLevels)
+  {
+    if(newLine || level.lineStrings.isEmpty())
+    {
+      level.lineStrings.append(atools::geo::LineString(pos));
+      level.skipped.clear();
+      continue;
+    }
+
+    atools::geo::LineString& lineString = level.lineStrings.last();
+    if(lineString.size() < 2)
+    {
+      lineString.append(pos);
+      continue;
+    }
+
+    if(lineString.size() > PARTITION_POINT_SIZE)
+    {
+      // Add new partition connected to the last one
+      lineString.append(pos);
+      level.lineStrings.append(atools::geo::LineString(pos));
+      level.skipped.clear();
+      continue;
+    }
+
+    // Try to move the floating last point to the new position - check if all replaced points are within tolerance
+    const atools::geo::Pos& fixed = lineString.at(lineString.size() - 2);
+    const atools::geo::Pos& floating = lineString.constLast();
+    bool withinTolerance = level.skipped.size() < LOD_MAX_SKIPPED &&
+                           lsimplify::segmentDistanceMeter(floating, fixed, pos) <= level.toleranceMeter;
+
+    for(int i = 0; i < level.skipped.size() && withinTolerance; i++)
+      withinTolerance = lsimplify::segmentDistanceMeter(level.skipped.at(i), fixed, pos) <= level.toleranceMeter;
+
+    if(withinTolerance)
+    {
+      level.skipped.append(floating);
+      lineString.last() = pos;
+    }
+    else
+    {
+      // Keep floating point as fixed one
+      level.skipped.clear();
+      lineString.append(pos);
     }
   }
 }
@@ -688,6 +779,20 @@ void AircraftTrail::updateLineStrings()
 {
   lineStrings.clear();
   lineStringsIndex.clear();
+  clearLod();
+
+  // Build level of detail pyramid - an invalid position starts a new line
+  bool newLine = true;
+  for(const AircraftTrailPos& trailPos : qAsConst(*this))
+  {
+    if(trailPos.isValid())
+    {
+      appendLod(trailPos.getPosition(), newLine);
+      newLine = false;
+    }
+    else
+      newLine = true;
+  }
 
   if(!isEmpty())
   {
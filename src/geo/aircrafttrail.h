@@ -188,6 +188,10 @@ public:
     return lineStrings;
   }
 
+  /* Simplified line strings where no trail point deviates more than maxErrorMeter from the lines.
+   * Returns the coarsest level of detail matching the error or the full resolution getLineStrings(). */
+  const QVector<atools::geo::LineString>& getLineStrings(float maxErrorMeter) const;
+
   /* Track will be truncated if it contains more track entries than this value. Default is 20000. */
   void setMaxTrackEntries(int value)
   {
@@ -230,6 +234,20 @@ private:
   /* As above but incrementally. lastTrackPos must be added before */
   void updateLineStringsLast();
 
+  /* Level of detail pyramid. One level for each tolerance in LOD_TOLERANCE_METER */
+  struct LodLevel
+  {
+    float toleranceMeter = 0.f;
+    QVector<atools::geo::LineString> lineStrings;
+
+    /* Trail points replaced by the last floating point of the last line string since the last fixed point */
+    atools::geo::LineString skipped;
+  };
+
+  /* Add position to all levels. Starts a new line string if newLine is true. */
+  void appendLod(const atools::geo::Pos& pos, bool newLine);
+  void clearLod();
+
   /* Accurate positions for GPX export */
   const QVector<QVector<atools::geo::PosD> > positionsD() const;
 
@@ -260,6 +278,9 @@ private:
   // Points to the first AircraftTrailPos in this - in sync with lineStrings
   QVector<int> lineStringsIndex;
 
+  // Simplified copies of lineStrings with increasing tolerance for painting
+  QVector<LodLevel> lodLevels;
+
   /* Needed in RouteExportFormat stream operators to read different formats */
   static quint16 version;
 };
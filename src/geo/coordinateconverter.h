@@ -166,6 +166,11 @@ public:
   bool wToSPoints(const atools::geo::Pos& pos, QVector<float>& x, float& y, const QSize& size, bool *isHidden) const;
   bool wToSPoints(const Marble::GeoDataCoordinates& coords, QVector<double>& x, double& y, const QSize& size, bool *isHidden) const;
 
+  const Marble::ViewportParams *getViewport() const
+  {
+    return viewport;
+  }
+
 private:
   bool wToSInternal(const Marble::GeoDataCoordinates& coords, double& x, double& y, const QSize& size, bool *isHidden) const;
 
@@ -0,0 +1,110 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "geo/linesimplifier.h"
+
+#include "atools.h"
+#include "geo/calculations.h"
+#include "geo/linestring.h"
+
+#include <QStack>
+
+#include <cmath>
+
+namespace lsimplify {
+
+using atools::geo::LineString;
+using atools::geo::Pos;
+
+/* Longitude difference considering the anti-meridian */
+static float lonDiffDeg(float lonX, float lonX1)
+{
+  float diff = lonX - lonX1;
+  if(diff > 180.f)
+    diff -= 360.f;
+  else if(diff < -180.f)
+    diff += 360.f;
+  return diff;
+}
+
+float segmentDistanceMeter(const Pos& pos, const Pos& pos1, const Pos& pos2)
+{
+  const float METER_PER_DEG = atools::geo::nmToMeter(60.f);
+  float lonScale = std::cos(atools::geo::toRadians(pos1.getLatY())) * METER_PER_DEG;
+
+  // All relative to pos1
+  float x = lonDiffDeg(pos.getLonX(), pos1.getLonX()) * lonScale;
+  float y = (pos.getLatY() - pos1.getLatY()) * METER_PER_DEG;
+  float x2 = lonDiffDeg(pos2.getLonX(), pos1.getLonX()) * lonScale;
+  float y2 = (pos2.getLatY() - pos1.getLatY()) * METER_PER_DEG;
+
+  float lengthSq = x2 * x2 + y2 * y2;
+  float t = lengthSq > 0.f ? atools::minmax(0.f, 1.f, (x * x2 + y * y2) / lengthSq) : 0.f;
+  float dx = x - t * x2, dy = y - t * y2;
+  return std::sqrt(dx * dx + dy * dy);
+}
+
+LineString simplify(const LineString& line, float toleranceMeter)
+{
+  if(line.size() < 3 || toleranceMeter <= 0.f)
+    return line;
+
+  // Flags for points to keep
+  QVector<bool> keep(line.size(), false);
+  keep[0] = keep[line.size() - 1] = true;
+
+  // Iterative to avoid deep recursion for long lines
+  QStack<std::pair<int, int> > stack;
+  stack.push(std::make_pair(0, line.size() - 1));
+
+  while(!stack.isEmpty())
+  {
+    std::pair<int, int> range = stack.pop();
+    const Pos& pos1 = line.at(range.first);
+    const Pos& pos2 = line.at(range.second);
+
+    // Find point with maximum distance to segment
+    float maxDist = 0.f;
+    int maxIndex = -1;
+    for(int i = range.first + 1; i < range.second; i++)
+    {
+      float dist = segmentDistanceMeter(line.at(i), pos1, pos2);
+      if(dist > maxDist)
+      {
+        maxDist = dist;
+        maxIndex = i;
+      }
+    }
+
+    if(maxIndex != -1 && maxDist > toleranceMeter)
+    {
+      keep[maxIndex] = true;
+      stack.push(std::make_pair(range.first, maxIndex));
+      stack.push(std::make_pair(maxIndex, range.second));
+    }
+  }
+
+  LineString simplified;
+  for(int i = 0; i < line.size(); i++)
+  {
+    if(keep.at(i))
+      simplified.append(line.at(i));
+  }
+  return simplified;
+}
+
+} // namespace lsimplify
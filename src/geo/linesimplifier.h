@@ -0,0 +1,41 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_GEO_LINESIMPLIFIER_H
+#define LNM_GEO_LINESIMPLIFIER_H
+
+namespace atools {
+namespace geo {
+class LineString;
+class Pos;
+}
+}
+
+/* Reduces the number of points in lines and polygons for display. Uses a local flat projection
+ * which is accurate enough for display tolerances. */
+namespace lsimplify {
+
+/* Distance of pos to the segment from pos1 to pos2 in meter */
+float segmentDistanceMeter(const atools::geo::Pos& pos, const atools::geo::Pos& pos1, const atools::geo::Pos& pos2);
+
+/* Douglas-Peucker simplification keeping first and last point.
+ * No point of the original line deviates more than toleranceMeter from the result. */
+atools::geo::LineString simplify(const atools::geo::LineString& line, float toleranceMeter);
+
+} // namespace lsimplify
+
+#endif // LNM_GEO_LINESIMPLIFIER_H
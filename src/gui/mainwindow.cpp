@@ -59,6 +59,7 @@
 #include "logging/logginghandler.h"
 #include "mapgui/imageexportdialog.h"
 #include "mapgui/mapairporthandler.h"
+#include "mapgui/mapbenchmark.h"
 #include "mapgui/mapdetailhandler.h"
 #include "mapgui/mapmarkhandler.h"
 #include "mapgui/mapthemehandler.h"
@@ -490,6 +491,12 @@ MainWindow::MainWindow()
     debugActionResetUpdate = new QAction("DEBUG - Reset update timestamp to -2 days", ui->menuHelp);
     this->addAction(debugActionResetUpdate);
 
+    debugActionBenchmarkElevation = new QAction("DEBUG - Benchmark GLOBE elevation lookups", ui->menuHelp);
+    this->addAction(debugActionBenchmarkElevation);
+
+    debugActionBenchmarkRouteAltitude = new QAction("DEBUG - Benchmark flight plan altitude and wind calculation", ui->menuHelp);
+    this->addAction(debugActionBenchmarkRouteAltitude);
+
     debugActionThrowException = new QAction("DEBUG - Crash by throwing an exception", ui->menuHelp);
     this->addAction(debugActionThrowException);
 
@@ -517,6 +524,8 @@ MainWindow::MainWindow()
     ui->menuHelp->addAction(debugActionPerfEdit);
     ui->menuHelp->addAction(debugActionDumpLayers);
     ui->menuHelp->addAction(debugActionResetUpdate);
+    ui->menuHelp->addAction(debugActionBenchmarkElevation);
+    ui->menuHelp->addAction(debugActionBenchmarkRouteAltitude);
 
     QMenu *crashMenu = new QMenu("DEBUG - Crash", ui->menuHelp);
     crashMenu->addAction(debugActionThrowException);
@@ -536,6 +545,8 @@ MainWindow::MainWindow()
     connect(debugActionPerfEdit, &QAction::triggered, this, &MainWindow::debugActionTriggeredPerfEdit);
     connect(debugActionDumpLayers, &QAction::triggered, this, &MainWindow::debugActionTriggeredDumpLayers);
     connect(debugActionResetUpdate, &QAction::triggered, this, &MainWindow::debugActionTriggeredResetUpdate);
+    connect(debugActionBenchmarkElevation, &QAction::triggered, this, &MainWindow::debugActionTriggeredBenchmarkElevation);
+    connect(debugActionBenchmarkRouteAltitude, &QAction::triggered, this, &MainWindow::debugActionTriggeredBenchmarkRouteAltitude);
     connect(debugActionThrowException, &QAction::triggered, this, &MainWindow::debugActionTriggeredThrowException);
     connect(debugActionSegfault, &QAction::triggered, this, &MainWindow::debugActionTriggeredSegfault);
     connect(debugActionAssert, &QAction::triggered, this, &MainWindow::debugActionTriggeredAssert);
@@ -732,6 +743,38 @@ void MainWindow::debugActionTriggeredResetUpdate()
   Settings::instance().setValueVar(lnm::OPTIONS_UPDATE_LAST_CHECKED, QDateTime::currentDateTime().toSecsSinceEpoch() - 3600L * 48L);
 }
 
+void MainWindow::runMapBenchmark()
+{
+  QString script = Application::getStartupOptionsConst().getPropertyStr(lnm::STARTUP_BENCHMARK_MAP);
+  qInfo() << Q_FUNC_INFO << "Running map benchmark" << script;
+
+  MapBenchmark benchmark(this);
+  bool result = benchmark.run(script);
+
+  if(benchmark.isQuit())
+  {
+    // Unattended run - only log errors and exit
+    if(!result)
+      qWarning() << Q_FUNC_INFO << benchmark.getErrorMessage();
+    QTimer::singleShot(0, this, &MainWindow::close);
+  }
+  else if(result)
+    atools::gui::Dialog::information(this, tr("Map benchmark finished.\nReport written to \"%1\".").arg(benchmark.getReportFilename()));
+  else
+    atools::gui::Dialog::warning(this, benchmark.getErrorMessage());
+}
+
+void MainWindow::debugActionTriggeredBenchmarkElevation()
+{
+  NavApp::getElevationProvider()->benchmark();
+}
+
+void MainWindow::debugActionTriggeredBenchmarkRouteAltitude()
+{
+  // Load a long flight plan and enable winds before running
+  NavApp::getRouteConst().benchmarkLegAltitudes();
+}
+
 void MainWindow::debugActionTriggeredThrowException()
 {
   throw std::exception();
@@ -1634,6 +1677,7 @@ void MainWindow::connectAllSlots()
 
   // Airway/tracks =======================================================
   TrackController *trackController = NavApp::getTrackController();
+  connect(trackController, &TrackController::preTrackLoad, routeController, &RouteController::preTrackLoad);
   connect(trackController, &TrackController::postTrackLoad, routeController, &RouteController::clearAirwayNetworkCache);
   connect(trackController, &TrackController::postTrackLoad, infoController, &InfoController::tracksChanged);
   connect(trackController, &TrackController::postTrackLoad, this, &MainWindow::postTrackLoad);
@@ -2415,6 +2459,7 @@ void MainWindow::routeFromFlightplan(const atools::fs::pln::Flightplan& flightpl
     routeController->loadFlightplan(flightplan, atools::fs::pln::LNM_PLN, QString(), changed, adjustAltitude, undo, correctProfile,
                                     false /* clearUndoState */);
     routeController->getRoute().getFlightplan().setLnmFormat(lnmpln);
+    routeController->routeModified();
     if(OptionData::instance().getFlags() & opts::GUI_CENTER_ROUTE)
       routeCenter();
     showFlightplan();
@@ -3640,7 +3685,10 @@ void MainWindow::mainWindowShownDelayed()
   mapThemeHandler->showThemeLoadingErrors();
 
   if(ui->actionRouteDownloadTracks->isChecked())
+    // Flight plan calculation networks are loaded in background after tracks are loaded
     QTimer::singleShot(1000, NavApp::getTrackController(), &TrackController::startDownloadStartup);
+  else
+    QTimer::singleShot(1000, routeController, &RouteController::preloadRouteNetworks);
 
   warnTrailPoints(0, true /* doNotShowAgain */);
 
@@ -3733,6 +3781,10 @@ void MainWindow::mainWindowShownDelayed()
   // Update the information display later delayed to avoid long loading times due to weather timeout
   QTimer::singleShot(100, infoController, &InfoController::restoreInformation);
 
+  // Run benchmark from command line delayed to let the map widget and databases settle
+  if(!Application::getStartupOptionsConst().getPropertyStr(lnm::STARTUP_BENCHMARK_MAP).isEmpty())
+    QTimer::singleShot(2000, this, &MainWindow::runMapBenchmark);
+
 #ifdef DEBUG_INFORMATION
   qDebug() << "mapDistanceLabel->size()" << mapDistanceLabel->size();
   qDebug() << "mapPositionLabel->size()" << mapPositionLabel->size();
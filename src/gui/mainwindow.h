@@ -328,6 +328,9 @@ private:
   void mainWindowShown();
   void mainWindowShownDelayed();
 
+  /* Run map benchmark script given on the command line */
+  void runMapBenchmark();
+
   /* Dock window functions */
   void raiseFloatingWindows();
   void hideTitleBar();
@@ -576,6 +579,8 @@ private:
   void debugActionTriggeredPerfEdit();
   void debugActionTriggeredDumpLayers();
   void debugActionTriggeredResetUpdate();
+  void debugActionTriggeredBenchmarkElevation();
+  void debugActionTriggeredBenchmarkRouteAltitude();
   void debugActionTriggeredThrowException();
   void debugActionTriggeredSegfault();
   void debugActionTriggeredAssert();
@@ -675,6 +680,7 @@ private:
   QAction *debugActionDumpRoute = nullptr, *debugActionDumpFlightplan = nullptr, *debugActionForceUpdates = nullptr,
           *debugActionReloadPlan = nullptr, *debugActionPlanEdit = nullptr,
           *debugActionPerfEdit = nullptr, *debugActionDumpLayers = nullptr, *debugActionResetUpdate = nullptr,
+          *debugActionBenchmarkElevation = nullptr, *debugActionBenchmarkRouteAltitude = nullptr,
           *debugActionThrowException = nullptr, *debugActionSegfault = nullptr,
           *debugActionAssert = nullptr, *debugActionMoveAircraft = nullptr, *debugActionExportPlans = nullptr;
 
@@ -45,6 +45,9 @@
 #include "weather/weathercontext.h"
 #include "weather/weathercontexthandler.h"
 
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
 #include <QUrlQuery>
 
 using atools::util::HtmlBuilder;
@@ -607,17 +610,26 @@ void InfoController::updateAirportInternal(bool newAirport, bool bearingChange,
     bool weatherChanged =
       NavApp::getWeatherContextHandler()->buildWeatherContextInfoFull(currentWeatherContext, currentSearchResult->airports.constFirst());
 
+    Ui::MainWindow *ui = NavApp::getMainUi();
+
+    // Update only bearing and distance in the document if nothing else changed
+    if(bearingChange && !newAirport && !weatherChanged && !forceWeatherUpdate && patchTextEdit(ui->textBrowserAirportInfo))
+      return;
+
     if(newAirport || weatherChanged || bearingChange || forceWeatherUpdate)
     {
       // Update airport overview ==============================================
       HtmlBuilder html(true);
-      Ui::MainWindow *ui = NavApp::getMainUi();
       map::MapAirport airport;
       queries->getAirportQuerySim()->getAirportById(airport, currentSearchResult->airports.constFirst().id);
+
+      QVector<HtmlInfoBuilder::DynamicField> fields;
+      infoBuilder->setDynamicFields(&fields);
       infoBuilder->airportText(airport, currentWeatherContext, html, &NavApp::getRouteConst());
+      infoBuilder->setDynamicFields(nullptr);
 
       // Leave position for weather or bearing updates
-      updateTextEdit(ui->textBrowserAirportInfo, html.getHtml(), scrollToTop, !scrollToTop /* keepSelection */);
+      updateTextEdit(ui->textBrowserAirportInfo, html.getHtml(), scrollToTop, !scrollToTop /* keepSelection */, fields);
 
       if(newAirport || weatherChanged || forceWeatherUpdate)
       {
@@ -1087,6 +1099,13 @@ bool InfoController::updateNavaidInternal(const map::MapResult& result, bool bea
   Ui::MainWindow *ui = NavApp::getMainUi();
   bool foundNavaid = false;
 
+  // Update only bearing and distance in the document of the current navaids
+  if(bearingChanged && !forceUpdate && patchTextEdit(ui->textBrowserNavaidInfo))
+    return true;
+
+  QVector<HtmlInfoBuilder::DynamicField> fields;
+  infoBuilder->setDynamicFields(&fields);
+
   // Remove header link ==============================
   html.tableAtts({
     {"width", "100%"}
@@ -1108,12 +1127,13 @@ bool InfoController::updateNavaidInternal(const map::MapResult& result, bool bea
                  &HtmlInfoBuilder::airportMsaText);
   buildOneNavaid(html, bearingChanged, foundNavaid, result.airways, currentSearchResult->airways, infoBuilder,
                  &HtmlInfoBuilder::airwayText);
+  infoBuilder->setDynamicFields(nullptr);
 
   if(!foundNavaid)
     html.clear();
 
   if(foundNavaid || forceUpdate)
-    updateTextEdit(ui->textBrowserNavaidInfo, html.getHtml(), scrollToTop, !scrollToTop /* keepSelection */);
+    updateTextEdit(ui->textBrowserNavaidInfo, html.getHtml(), scrollToTop, !scrollToTop /* keepSelection */, fields);
 
   return foundNavaid;
 }
@@ -1124,6 +1144,13 @@ bool InfoController::updateUserpointInternal(const map::MapResult& result, bool
   Ui::MainWindow *ui = NavApp::getMainUi();
   bool foundUserpoint = false;
 
+  // Update only bearing and distance in the document of the current userpoints
+  if(bearingChanged && patchTextEdit(ui->textBrowserUserpointInfo))
+    return true;
+
+  QVector<HtmlInfoBuilder::DynamicField> fields;
+  infoBuilder->setDynamicFields(&fields);
+
   // Userpoints on top of the list
   for(const map::MapUserpoint& userpoint : qAsConst(result.userpoints))
   {
@@ -1135,9 +1162,10 @@ bool InfoController::updateUserpointInternal(const map::MapResult& result, bool
     foundUserpoint |= infoBuilder->userpointText(userpoint, html);
     html.br();
   }
+  infoBuilder->setDynamicFields(nullptr);
 
   if(foundUserpoint)
-    updateTextEdit(ui->textBrowserUserpointInfo, html.getHtml(), scrollToTop, !scrollToTop /* keepSelection */);
+    updateTextEdit(ui->textBrowserUserpointInfo, html.getHtml(), scrollToTop, !scrollToTop /* keepSelection */, fields);
   else
     ui->textBrowserUserpointInfo->clear();
 
@@ -1153,6 +1181,7 @@ void InfoController::preDatabaseLoad()
   *currentSearchResult = map::MapResult();
   databaseLoadStatus = true;
   clearInfoTextBrowsers();
+  textEditStates.clear();
 }
 
 void InfoController::postDatabaseLoad()
@@ -1551,8 +1580,110 @@ const QBitArray& InfoController::getEnabledProgressBitsWeb() const
   return aircraftProgressConfig->getEnabledBitsWeb();
 }
 
-void InfoController::updateTextEdit(QTextEdit *textEdit, const QString& text, bool scrollToTop, bool keepSelection)
+void InfoController::updateTextEdit(QTextEdit *textEdit, const QString& text, bool scrollToTop, bool keepSelection,
+                                    const QVector<HtmlInfoBuilder::DynamicField>& fields)
 {
+  TextEditState& state = textEditStates[textEdit];
+  const QTextDocument *doc = textEdit->document();
+
+  // Setting a document resets layout and is expensive - skip if neither text nor document were changed
+  if(!scrollToTop && !text.isEmpty() && text == state.html && state.revision == doc->revision() && !doc->isEmpty() &&
+     !anchorsClicked.contains(textEdit))
+    return;
+
   // Clear selection if textEdit was in anchorsClicked and removed
   atools::gui::util::updateTextEdit(textEdit, text, scrollToTop, keepSelection, anchorsClicked.remove(textEdit));
+
+  state.html = text;
+  state.revision = textEdit->document()->revision();
+  state.fields = fields;
+}
+
+bool InfoController::patchTextEdit(QTextEdit *textEdit)
+{
+  auto state = textEditStates.find(textEdit);
+  QTextDocument *doc = textEdit->document();
+  if(state == textEditStates.end() || state->revision != doc->revision() || doc->isEmpty() || anchorsClicked.contains(textEdit))
+    return false;
+
+  // Get new values and check if rows have to be added or removed ====================
+  QHash<QString, int> changed;
+  QStringList values;
+  for(int i = 0; i < state->fields.size(); i++)
+  {
+    const HtmlInfoBuilder::DynamicField& field = state->fields.at(i);
+    QString value = infoBuilder->bearingToUserValue(field.pos, field.magVar);
+    if(value.isEmpty() != field.value.isEmpty())
+      return false;
+
+    if(value != field.value)
+      changed.insert(HtmlInfoBuilder::dynamicFieldAnchor(i), i);
+    values.append(value);
+  }
+
+  if(changed.isEmpty())
+    // Nothing visible changed
+    return true;
+
+  // Find text ranges of changed fields before modifying since this invalidates the fragments ====================
+  struct Range
+  {
+    int index, start, end;
+  };
+  QHash<int, Range> ranges;
+  for(QTextBlock block = doc->begin(); block.isValid(); block = block.next())
+  {
+    for(QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it)
+    {
+      QTextFragment fragment = it.fragment();
+      const QStringList names = fragment.charFormat().anchorNames();
+      for(const QString& name : names)
+      {
+        int index = changed.value(name, -1);
+        if(index != -1)
+        {
+          // Value can consist of several fragments with different formats
+          int end = fragment.position() + fragment.length();
+          auto range = ranges.find(index);
+          if(range == ranges.end())
+            ranges.insert(index, {index, fragment.position(), end});
+          else
+          {
+            range->start = std::min(range->start, fragment.position());
+            range->end = std::max(range->end, end);
+          }
+        }
+      }
+    }
+  }
+
+  if(ranges.size() != changed.size())
+  {
+    qWarning() << Q_FUNC_INFO << "Anchors not found" << changed.keys();
+    return false;
+  }
+
+  // Replace from end to start to keep positions valid ====================
+  QList<Range> sorted = ranges.values();
+  std::sort(sorted.begin(), sorted.end(), [](const Range& range1, const Range& range2) -> bool {
+    return range1.start > range2.start;
+  });
+
+  QTextCursor cursor(doc);
+  cursor.beginEditBlock();
+  for(const Range& range : qAsConst(sorted))
+  {
+    cursor.setPosition(range.start);
+    cursor.setPosition(range.end, QTextCursor::KeepAnchor);
+    cursor.insertHtml(HtmlInfoBuilder::dynamicFieldHtml(range.index, values.at(range.index)));
+  }
+  cursor.endEditBlock();
+
+  for(int i = 0; i < values.size(); i++)
+    state->fields[i].value = values.at(i);
+
+  // Document does not match the text anymore
+  state->html.clear();
+  state->revision = doc->revision();
+  return true;
 }
@@ -18,8 +18,10 @@
 #ifndef LITTLENAVMAP_INFOCONTROLLER_H
 #define LITTLENAVMAP_INFOCONTROLLER_H
 
+#include "common/htmlinfobuilder.h"
 #include "common/tabindexes.h"
 
+#include <QHash>
 #include <QObject>
 #include <QSet>
 
@@ -27,7 +29,6 @@ class MainWindow;
 class MapQuery;
 class AirportQuery;
 class InfoQuery;
-class HtmlInfoBuilder;
 class QTextEdit;
 class AircraftProgressConfig;
 
@@ -196,12 +197,28 @@ private:
   /* Blue help button in progress dock clicked */
   void helpAircraftClicked();
 
-  /* Update a text edit and clears selection after clicking a link */
-  void updateTextEdit(QTextEdit *textEdit, const QString& text, bool scrollToTop, bool keepSelection);
+  /* Update a text edit and clears selection after clicking a link. Does nothing if text is unchanged.
+   * fields are the bearing fields collected while building text. */
+  void updateTextEdit(QTextEdit *textEdit, const QString& text, bool scrollToTop, bool keepSelection,
+                      const QVector<HtmlInfoBuilder::DynamicField>& fields = QVector<HtmlInfoBuilder::DynamicField>());
+
+  /* Update only changed bearing fields in the document of the text edit. Returns false if the text has to be
+   * rebuilt since rows appear or disappear or the document was changed otherwise. */
+  bool patchTextEdit(QTextEdit *textEdit);
 
   /* Text edits are stored here after anchors were clicked. Needed to clear unwanted selections after clicking a link. */
   QSet<QTextEdit *> anchorsClicked;
 
+  /* Last text set by updateTextEdit() */
+  struct TextEditState
+  {
+    QString html; /* Empty after patching */
+    int revision = -1; /* Document revision after last update to detect changes like clear() */
+    QVector<HtmlInfoBuilder::DynamicField> fields;
+  };
+
+  QHash<QTextEdit *, TextEditState> textEditStates;
+
   QString waitingForUpdateText, notConnectedText;
 
   bool databaseLoadStatus = false;
@@ -82,6 +82,9 @@ LogdataController::LogdataController(atools::fs::userdata::LogdataManager *logda
 
   connect(this, &LogdataController::logDataChanged, statsDialog, &LogStatisticsDialog::logDataChanged);
   connect(this, &LogdataController::logDataChanged, manager, &atools::sql::DataManagerBase::updateUndoRedoActions);
+  connect(this, &LogdataController::logDataChanged, this, [this]() {
+    logdataVersion++;
+  });
 
   Ui::MainWindow *ui = NavApp::getMainUi();
   connect(ui->actionSearchLogdataUndo, &QAction::triggered, this, &LogdataController::undoTriggered);
@@ -457,8 +460,8 @@ void LogdataController::recordLanding(atools::sql::SqlRecord& record, const atoo
   recordFlightplanAndPerf(record);
 
   // Save GPX with simplified flight plan and trail =========================
-  const atools::fs::pln::Flightplan flightplan =
-    NavApp::getRouteConst().updatedAltitudes().adjustedToOptions(rf::DEFAULT_OPTS_GPX).getFlightplanConst();
+  std::shared_ptr<const Route> route = NavApp::getRouteSnapshotAdjusted(rf::DEFAULT_OPTS_GPX);
+  const atools::fs::pln::Flightplan& flightplan = route->getFlightplanConst();
   record.setValue("aircraft_trail", atools::fs::gpx::GpxIO().saveGpxGz(NavApp::getAircraftTrailLogbook().toGpxData(flightplan)));
 
   // Clear separate logbook track =========================
@@ -535,8 +538,8 @@ void LogdataController::logChanged(bool loadAll, bool keepSelection)
 
 void LogdataController::recordFlightplanAndPerf(atools::sql::SqlRecord& record)
 {
-  atools::fs::pln::Flightplan fp = NavApp::getRouteConst().
-                                   updatedAltitudes().adjustedToOptions(rf::DEFAULT_OPTS_LNMPLN).getFlightplanConst();
+  std::shared_ptr<const Route> route = NavApp::getRouteSnapshotAdjusted(rf::DEFAULT_OPTS_LNMPLN);
+  const atools::fs::pln::Flightplan& fp = route->getFlightplanConst();
 
   if(fp.isEmpty())
     record.setNull("flightplan"); // no plan
@@ -1279,8 +1282,8 @@ void LogdataController::gpxAttach(atools::sql::SqlRecord *record, QWidget *paren
 
     if(!track.isEmpty() || !NavApp::getRouteConst().isEmpty())
     {
-      const atools::fs::pln::Flightplan flightplan =
-        NavApp::getRouteConst().updatedAltitudes().adjustedToOptions(rf::DEFAULT_OPTS_GPX).getFlightplanConst();
+      std::shared_ptr<const Route> route = NavApp::getRouteSnapshotAdjusted(rf::DEFAULT_OPTS_GPX);
+      const atools::fs::pln::Flightplan& flightplan = route->getFlightplanConst();
       record->setValue("aircraft_trail", atools::fs::gpx::GpxIO().saveGpxGz(track.toGpxData(flightplan)));
     }
     else
@@ -194,6 +194,12 @@ public:
     return aircraftPassedTakeoffPoint;
   }
 
+  /* Incremented on each logDataChanged() signal */
+  quint64 getLogdataVersion() const
+  {
+    return logdataVersion;
+  }
+
 signals:
   /* Sent after database modification to update the search result table */
   void refreshLogSearch(bool loadAll, bool keepSelection, bool force);
@@ -263,6 +269,8 @@ private:
   MainWindow *mainWindow;
 
   QCache<int, AircraftTrail> aircraftTrailCache;
+
+  quint64 logdataVersion = 1;
 };
 
 #endif // LNM_LOGDATACONTROLLER_H
@@ -0,0 +1,389 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mapgui/mapbenchmark.h"
+
+#include "app/navapp.h"
+#include "atools.h"
+#include "mapgui/mappaintwidget.h"
+#include "mapgui/mapwidget.h"
+#include "mappainter/mappaintlayer.h"
+#include "query/querymanager.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+/* Names usable in script "show" and "hide" arrays */
+static const QHash<QString, map::MapTypes> TYPE_NAMES(
+{
+  {"AIRPORT", map::AIRPORT},
+  {"VOR", map::VOR},
+  {"NDB", map::NDB},
+  {"ILS", map::ILS},
+  {"MARKER", map::MARKER},
+  {"WAYPOINT", map::WAYPOINT},
+  {"AIRWAYV", map::AIRWAYV},
+  {"AIRWAYJ", map::AIRWAYJ},
+  {"TRACK", map::TRACK},
+  {"AIRSPACE", map::AIRSPACE},
+  {"HOLDING", map::HOLDING},
+  {"AIRPORT_MSA", map::AIRPORT_MSA},
+  {"USERPOINT", map::USERPOINT},
+  {"LOGBOOK", map::LOGBOOK},
+  {"AIRCRAFT_ONLINE", map::AIRCRAFT_ONLINE},
+  {"MISSED_APPROACH", map::MISSED_APPROACH}
+});
+
+/* Names usable in script "showdisplay" and "hidedisplay" arrays */
+static const QHash<QString, map::MapDisplayTypes> DISPLAY_TYPE_NAMES(
+{
+  {"AIRPORT_WEATHER", map::AIRPORT_WEATHER},
+  {"MORA", map::MORA},
+  {"WIND_BARBS", map::WIND_BARBS},
+  {"WIND_BARBS_ROUTE", map::WIND_BARBS_ROUTE},
+  {"FLIGHTPLAN", map::FLIGHTPLAN},
+  {"FLIGHTPLAN_TOC_TOD", map::FLIGHTPLAN_TOC_TOD},
+  {"FLIGHTPLAN_ALTERNATE", map::FLIGHTPLAN_ALTERNATE},
+  {"GLS", map::GLS}
+});
+
+/* Combine all flags from the names in the JSON array */
+template<typename TYPE>
+TYPE typesFromJson(const QJsonValue& value, const QHash<QString, TYPE>& names)
+{
+  TYPE types;
+  const QJsonArray array = value.toArray();
+  for(const QJsonValue& val : array)
+  {
+    QString name = val.toString().toUpper();
+    if(names.contains(name))
+      types |= names.value(name);
+    else
+      qWarning() << Q_FUNC_INFO << "Unknown type" << name;
+  }
+  return types;
+}
+
+/* Milliseconds for report */
+static double toMs(qint64 ns)
+{
+  return ns / 1000000.;
+}
+
+/* Average, median, minimum and maximum in milliseconds */
+static QJsonObject statistics(QVector<qint64> values)
+{
+  QJsonObject obj;
+  if(!values.isEmpty())
+  {
+    std::sort(values.begin(), values.end());
+    qint64 sum = 0L;
+    for(qint64 value : values)
+      sum += value;
+
+    obj.insert("avg_ms", toMs(sum) / values.size());
+    obj.insert("median_ms", toMs(values.at(values.size() / 2)));
+    obj.insert("min_ms", toMs(values.constFirst()));
+    obj.insert("max_ms", toMs(values.constLast()));
+  }
+  return obj;
+}
+
+MapBenchmark::MapBenchmark(QWidget *parentWidget)
+  : parent(parentWidget)
+{
+}
+
+MapBenchmark::~MapBenchmark()
+{
+  deInit();
+}
+
+void MapBenchmark::init()
+{
+  // Use own queries to avoid interfering with the web server
+  queries = QueryManager::instance()->createQueriesAdditional();
+  mapPaintWidget = new MapPaintWidget(parent, queries, false /* no real widget - hidden */, true /* web */);
+
+  // Copy all map settings including trail
+  mapPaintWidget->copySettings(*NavApp::getMapWidgetGui(), true /* deep */);
+
+  // Ensure MapPaintLayer::mapLayer initialisation
+  mapPaintWidget->getMapPaintLayer()->updateLayers();
+
+  // Activate painting
+  mapPaintWidget->setActive();
+}
+
+void MapBenchmark::deInit()
+{
+  if(mapPaintWidget != nullptr)
+  {
+    // Close queries to allow closing the databases
+    mapPaintWidget->preDatabaseLoad();
+    ATOOLS_DELETE_LOG(mapPaintWidget);
+  }
+
+  if(queries != nullptr)
+  {
+    QueryManager::instance()->releaseQueriesAdditional(queries);
+    queries = nullptr;
+  }
+}
+
+bool MapBenchmark::run(const QString& scriptFilename)
+{
+  qDebug() << Q_FUNC_INFO << scriptFilename;
+
+  errorMessage.clear();
+  if(!readScript(scriptFilename))
+    return false;
+
+  init();
+
+  QVector<FrameResult> results(frames.size());
+  const PaintProfiler *profiler = mapPaintWidget->getMapPaintLayer()->getProfiler();
+
+  for(int iteration = 0; iteration < warmup + iterations; iteration++)
+  {
+    bool measure = iteration >= warmup;
+    for(int i = 0; i < frames.size(); i++)
+    {
+      int numFrames = profiler->getNumFrames();
+
+      QElapsedTimer timer;
+      timer.start();
+      renderFrame(frames.at(i));
+      qint64 totalNs = timer.nsecsElapsed();
+
+      if(measure)
+      {
+        FrameResult& result = results[i];
+        result.totalNs.append(totalNs);
+
+        // Profiler values are only valid if the paint layer rendered - not the case if zoomed out too far
+        if(profiler->getNumFrames() > numFrames)
+        {
+          for(int id = 0; id < prof::NUM_IDS; id++)
+          {
+            qint64 ns = profiler->getLastFrameNs(static_cast<prof::Id>(id));
+            if(ns >= 0L)
+              result.painterNs[id].append(ns);
+          }
+
+          for(int counter = 0; counter < prof::NUM_COUNTERS; counter++)
+            result.counters[counter] += profiler->getLastFrameCounter(static_cast<prof::Counter>(counter));
+        }
+
+        result.objectCount = mapPaintWidget->getMapPaintLayer()->getObjectCount();
+        result.overflow = mapPaintWidget->isPaintOverflow();
+      }
+    }
+  }
+
+  deInit();
+
+  return writeReport(results);
+}
+
+void MapBenchmark::renderFrame(const Frame& frame)
+{
+  MapPaintWidgetLocker locker(mapPaintWidget);
+  QueryLocker queryLocker(queries);
+
+  // Copy all map settings except trail and apply script overrides
+  mapPaintWidget->copySettings(*NavApp::getMapWidgetGui(), false /* deep */);
+
+  if(frame.show != map::NONE)
+    mapPaintWidget->setShowMapObject(frame.show, true);
+  if(frame.hide != map::NONE)
+    mapPaintWidget->setShowMapObject(frame.hide, false);
+  if(frame.showDisplay != map::DISPLAY_TYPE_NONE)
+    mapPaintWidget->setShowMapObjectDisplay(frame.showDisplay, true);
+  if(frame.hideDisplay != map::DISPLAY_TYPE_NONE)
+    mapPaintWidget->setShowMapObjectDisplay(frame.hideDisplay, false);
+
+  mapPaintWidget->getMapPaintLayer()->setDetailLevel(frame.detailFactor, frame.detailFactor);
+
+  // Use the same size for positioning and painting
+  mapPaintWidget->setMapSize(width, height);
+  if(frame.rect.isValid())
+    mapPaintWidget->showRectStreamlined(frame.rect, false);
+  else
+    mapPaintWidget->showPosNotAdjusted(frame.pos, frame.distanceKm);
+
+  mapPaintWidget->setPaintCopyright(false);
+  mapPaintWidget->setPaintWindHeader(false);
+
+  // Render and discard image
+  mapPaintWidget->getPixmap(width, height);
+}
+
+bool MapBenchmark::readScript(const QString& scriptFilename)
+{
+  QFile file(scriptFilename);
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    errorMessage = tr("Cannot open benchmark script \"%1\": %2").arg(scriptFilename).arg(file.errorString());
+    return false;
+  }
+
+  QJsonParseError error;
+  QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+  file.close();
+
+  if(doc.isNull() || !doc.isObject())
+  {
+    errorMessage = tr("Cannot read benchmark script \"%1\": %2").arg(scriptFilename).arg(error.errorString());
+    return false;
+  }
+
+  QJsonObject script = doc.object();
+  width = atools::minmax(64, 8192, script.value("width").toInt(width));
+  height = atools::minmax(64, 8192, script.value("height").toInt(height));
+  iterations = atools::minmax(1, 10000, script.value("iterations").toInt(iterations));
+  warmup = atools::minmax(0, 100, script.value("warmup").toInt(warmup));
+  quit = script.value("quit").toBool(false);
+
+  QFileInfo scriptInfo(scriptFilename);
+  scriptName = scriptInfo.fileName();
+  QString output = script.value("output").toString();
+  if(output.isEmpty())
+    output = scriptInfo.completeBaseName() + "-report.json";
+  reportFilename = QFileInfo(output).isAbsolute() ? output : scriptInfo.absoluteDir().absoluteFilePath(output);
+
+  frames.clear();
+  const QJsonArray frameArray = script.value("frames").toArray();
+  for(const QJsonValue& value : frameArray)
+  {
+    Frame frame = readFrame(value.toObject());
+    if(frame.name.isEmpty())
+      frame.name = QString("Frame %1").arg(frames.size() + 1);
+
+    if(frame.rect.isValid() || (frame.pos.isValid() && frame.distanceKm > 0.f))
+      frames.append(frame);
+    else
+      qWarning() << Q_FUNC_INFO << "Invalid frame" << frame.name;
+  }
+
+  if(frames.isEmpty())
+  {
+    errorMessage = tr("No valid frames in benchmark script \"%1\".").arg(scriptFilename);
+    return false;
+  }
+
+  qDebug() << Q_FUNC_INFO << "frames" << frames.size() << "iterations" << iterations << "warmup" << warmup
+           << "size" << width << height << "report" << reportFilename;
+  return true;
+}
+
+MapBenchmark::Frame MapBenchmark::readFrame(const QJsonObject& object)
+{
+  Frame frame;
+  frame.name = object.value("name").toString();
+
+  if(object.contains("leftlon"))
+    frame.rect = atools::geo::Rect(static_cast<float>(object.value("leftlon").toDouble()),
+                                   static_cast<float>(object.value("toplat").toDouble()),
+                                   static_cast<float>(object.value("rightlon").toDouble()),
+                                   static_cast<float>(object.value("bottomlat").toDouble()));
+  else
+  {
+    frame.pos = atools::geo::Pos(object.value("lonx").toDouble(), object.value("laty").toDouble());
+    frame.distanceKm = static_cast<float>(object.value("distancekm").toDouble());
+  }
+
+  frame.detailFactor = atools::minmax(8, 15, object.value("detailfactor").toInt(frame.detailFactor));
+  frame.show = typesFromJson(object.value("show"), TYPE_NAMES);
+  frame.hide = typesFromJson(object.value("hide"), TYPE_NAMES);
+  frame.showDisplay = typesFromJson(object.value("showdisplay"), DISPLAY_TYPE_NAMES);
+  frame.hideDisplay = typesFromJson(object.value("hidedisplay"), DISPLAY_TYPE_NAMES);
+
+  return frame;
+}
+
+bool MapBenchmark::writeReport(const QVector<FrameResult>& results)
+{
+  QJsonArray frameArray;
+  QVector<qint64> allTotalNs;
+
+  for(int i = 0; i < frames.size(); i++)
+  {
+    const Frame& frame = frames.at(i);
+    const FrameResult& result = results.at(i);
+    allTotalNs.append(result.totalNs);
+
+    QJsonObject painters;
+    for(int id = 0; id < prof::NUM_IDS; id++)
+    {
+      if(!result.painterNs[id].isEmpty())
+        painters.insert(PaintProfiler::getName(static_cast<prof::Id>(id)), statistics(result.painterNs[id]));
+    }
+
+    // Average counter values per iteration
+    QJsonObject counters;
+    for(int counter = 0; counter < prof::NUM_COUNTERS; counter++)
+      counters.insert(PaintProfiler::getName(static_cast<prof::Counter>(counter)),
+                      static_cast<double>(result.counters[counter]) / iterations);
+
+    QJsonObject frameObj;
+    frameObj.insert("name", frame.name);
+    frameObj.insert("total", statistics(result.totalNs));
+    frameObj.insert("painters", painters);
+    frameObj.insert("counters", counters);
+    frameObj.insert("objects", result.objectCount);
+    frameObj.insert("overflow", result.overflow);
+    frameArray.append(frameObj);
+
+    qInfo() << Q_FUNC_INFO << frame.name << statistics(result.totalNs);
+  }
+
+  QJsonObject report;
+  report.insert("script", scriptName);
+  report.insert("date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+  report.insert("version", QCoreApplication::applicationVersion());
+  report.insert("simulator", NavApp::getCurrentSimulatorShortName());
+  report.insert("width", width);
+  report.insert("height", height);
+  report.insert("iterations", iterations);
+  report.insert("warmup", warmup);
+  report.insert("total", statistics(allTotalNs));
+  report.insert("frames", frameArray);
+
+  QFile file(reportFilename);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    errorMessage = tr("Cannot write benchmark report \"%1\": %2").arg(reportFilename).arg(file.errorString());
+    return false;
+  }
+
+  file.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+  file.close();
+
+  qInfo() << Q_FUNC_INFO << "Report written to" << reportFilename << "total" << statistics(allTotalNs);
+  return true;
+}
@@ -0,0 +1,130 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_MAPBENCHMARK_H
+#define LNM_MAPBENCHMARK_H
+
+#include "common/mapflags.h"
+#include "geo/rect.h"
+#include "mappainter/paintprofiler.h"
+
+#include <QCoreApplication>
+#include <QVector>
+
+class MapPaintWidget;
+class Queries;
+class QJsonObject;
+class QWidget;
+
+/*
+ * Replays a scripted list of map views through a hidden map widget and writes paint times per frame,
+ * painter and query to a JSON report file. Used to detect rendering performance regressions.
+ *
+ * Runs on the currently selected scenery library and navdata databases and uses the map settings of the
+ * main window as a base. Use command line option "--settings-path" to benchmark a prepared set of databases.
+ *
+ * Script is a JSON file like:
+ * {
+ *   "width": 1024, "height": 768,   Image size - optional
+ *   "iterations": 5,                Number of measured passes through all frames - optional
+ *   "warmup": 1,                    Number of passes which are not measured to fill caches - optional
+ *   "output": "report.json",        Report file relative to script - optional. Default is "SCRIPTNAME-report.json"
+ *   "quit": true,                   Exit application when done - optional
+ *   "frames": [
+ *     {"name": "EDDF area", "leftlon": 7.5, "toplat": 50.5, "rightlon": 9.5, "bottomlat": 49.5, "detailfactor": 10,
+ *      "show": ["AIRSPACE", "AIRWAYV"], "hide": ["ILS"], "showdisplay": ["WIND_BARBS"], "hidedisplay": ["FLIGHTPLAN"]},
+ *     {"name": "EDDF close", "lonx": 8.57, "laty": 50.03, "distancekm": 20}
+ *   ]
+ * }
+ *
+ * Not thread safe. Has to be run in the main thread.
+ */
+class MapBenchmark
+{
+  Q_DECLARE_TR_FUNCTIONS(MapBenchmark)
+
+public:
+  explicit MapBenchmark(QWidget *parentWidget);
+  ~MapBenchmark();
+
+  MapBenchmark(const MapBenchmark& other) = delete;
+  MapBenchmark& operator=(const MapBenchmark& other) = delete;
+
+  /* Read script, render all frames and write report. Returns false and sets error message on failure. */
+  bool run(const QString& scriptFilename);
+
+  /* Values from script file */
+  bool isQuit() const
+  {
+    return quit;
+  }
+
+  const QString& getErrorMessage() const
+  {
+    return errorMessage;
+  }
+
+  const QString& getReportFilename() const
+  {
+    return reportFilename;
+  }
+
+private:
+  /* One view from the script */
+  struct Frame
+  {
+    QString name;
+    atools::geo::Rect rect; /* Either rect or position and distance */
+    atools::geo::Pos pos;
+    float distanceKm = 0.f;
+    int detailFactor = 10;
+    map::MapTypes show = map::NONE, hide = map::NONE;
+    map::MapDisplayTypes showDisplay = map::DISPLAY_TYPE_NONE, hideDisplay = map::DISPLAY_TYPE_NONE;
+  };
+
+  /* Collected values for one frame over all iterations */
+  struct FrameResult
+  {
+    QVector<qint64> totalNs; /* Time for getPixmap() */
+    QVector<qint64> painterNs[prof::NUM_IDS]; /* Painter and section times from profiler */
+    quint64 counters[prof::NUM_COUNTERS] = {};
+    int objectCount = 0;
+    bool overflow = false;
+  };
+
+  bool readScript(const QString& scriptFilename);
+  Frame readFrame(const QJsonObject& object);
+
+  /* Prepare widget and render the frame into a pixmap */
+  void renderFrame(const Frame& frame);
+
+  void init();
+  void deInit();
+
+  bool writeReport(const QVector<FrameResult>& results);
+
+  QWidget *parent;
+  MapPaintWidget *mapPaintWidget = nullptr;
+  Queries *queries = nullptr;
+
+  QVector<Frame> frames;
+  int width = 1024, height = 768, iterations = 5, warmup = 1;
+  bool quit = false;
+  QString errorMessage, reportFilename, scriptName;
+};
+
+#endif // LNM_MAPBENCHMARK_H
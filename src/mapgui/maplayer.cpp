@@ -71,11 +71,6 @@ bool MapLayer::hasSameQueryParametersWaypoint(const MapLayer *other) const
   return waypoint == other->waypoint;
 }
 
-bool MapLayer::hasSameQueryParametersWind(const MapLayer *other) const
-{
-  return windBarbs == other->windBarbs;
-}
-
 bool MapLayer::hasSameQueryParametersMarker(const MapLayer *other) const
 {
   return marker == other->marker;
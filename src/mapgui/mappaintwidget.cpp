@@ -36,6 +36,7 @@
 #include "query/waypointtrackquery.h"
 #include "settings/settings.h"
 
+#include <QCoreApplication>
 #include <QPainter>
 #include <QJsonDocument>
 #include <QResizeEvent>
@@ -630,11 +631,8 @@ void MapPaintWidget::prepareDraw(const QSize& size)
   noNavPaint = false;
 }
 
-QPixmap MapPaintWidget::getPixmap(int pixmapWidth, int pixmapHeight, bool ignoreUiScale)
+void MapPaintWidget::resizeForPixmap(int pixmapWidth, int pixmapHeight, bool ignoreUiScale)
 {
-  if(verbose)
-    qDebug() << Q_FUNC_INFO << "Requested pixmapWidth" << pixmapWidth << "pixmapHeight" << pixmapHeight << "ignoreUiScale" << ignoreUiScale;
-
   if(pixmapWidth > 0 && pixmapHeight > 0)
   {
     // QWidget::grab() increases the pixel size by devicePixelRatio
@@ -654,6 +652,29 @@ QPixmap MapPaintWidget::getPixmap(int pixmapWidth, int pixmapHeight, bool ignore
       resize(pixmapWidth, pixmapHeight);
     }
   }
+}
+
+void MapPaintWidget::setMapSize(int pixmapWidth, int pixmapHeight, bool ignoreUiScale)
+{
+  QSize oldSize = size();
+  resizeForPixmap(pixmapWidth, pixmapHeight, ignoreUiScale);
+
+  if(size() != oldSize && !isVisible())
+  {
+    // Hidden widgets get the pending resize event only when grabbed or shown
+    // Send it now to update the Marble viewport without painting
+    QResizeEvent resizeEvent(size(), oldSize);
+    QCoreApplication::sendEvent(this, &resizeEvent);
+    setAttribute(Qt::WA_PendingResizeEvent, false);
+  }
+}
+
+QPixmap MapPaintWidget::getPixmap(int pixmapWidth, int pixmapHeight, bool ignoreUiScale)
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "Requested pixmapWidth" << pixmapWidth << "pixmapHeight" << pixmapHeight << "ignoreUiScale" << ignoreUiScale;
+
+  resizeForPixmap(pixmapWidth, pixmapHeight, ignoreUiScale);
 
   QPixmap pixmap = grab();
 
@@ -852,6 +873,20 @@ void MapPaintWidget::showRectStreamlined(const atools::geo::Rect& rect, bool con
   }
 }
 
+void MapPaintWidget::showRectMercatorExact(const atools::geo::Rect& rect, int widthPixel)
+{
+  // Marble Mercator covers 360 degree with four times the radius in pixels
+  double widthDeg = std::abs(static_cast<double>(rect.getEast()) - static_cast<double>(rect.getWest()));
+  if(widthDeg > 0. && widthPixel > 0)
+    setRadius(atools::roundToInt(widthPixel * 360. / (4. * widthDeg)));
+
+  // Center on the middle of the projected rectangle which is closer to the pole than the middle latitude
+  double northY = std::asinh(std::tan(atools::geo::toRadians(static_cast<double>(rect.getNorth()))));
+  double southY = std::asinh(std::tan(atools::geo::toRadians(static_cast<double>(rect.getSouth()))));
+  centerOn((static_cast<double>(rect.getWest()) + static_cast<double>(rect.getEast())) / 2.,
+           atools::geo::toDegree(std::atan(std::sinh((northY + southY) / 2.))), false /* animated */);
+}
+
 void MapPaintWidget::showRect(const atools::geo::Rect& rect, bool doubleClick)
 {
 #if DEBUG_INFORMATION
@@ -116,6 +116,10 @@ public:
    *  constrainDistance determines whether map distance should be constrained by OptionData values */
   void showRectStreamlined(const atools::geo::Rect& rect, bool constrainDistance = true);
 
+  /* Center on rectangle and set the radius so that its width fills exactly widthPixel.
+   * Does not snap to zoom steps like showRectStreamlined(). Used for map tiles. Requires Mercator projection. */
+  void showRectMercatorExact(const atools::geo::Rect& rect, int widthPixel);
+
   /* Show user simulator aircraft. state is tool button state */
   void showAircraft(bool centerAircraftChecked);
   void showAircraftNow(bool);
@@ -312,6 +316,10 @@ public:
   QPixmap getPixmap(int pixmapWidth = -1, int pixmapHeight = -1, bool ignoreUiScale = true);
   QPixmap getPixmap(const QSize& size);
 
+  /* Resizes the widget like getPixmap() and applies the new size to the Marble viewport without painting.
+   * Used to calculate zoom distance and map layer for a given image size. */
+  void setMapSize(int pixmapWidth, int pixmapHeight, bool ignoreUiScale = true);
+
   /* Prepare Marble widget drawing with a dummy paint event without drawing navaids */
   void prepareDraw(const QSize& size);
 
@@ -365,6 +373,12 @@ public:
     return visibleWidget;
   }
 
+  /* true if the map is kept centered on the user aircraft - default is false */
+  virtual bool isFollowingAircraft() const
+  {
+    return false;
+  }
+
   /* Logbook display options have changed or new or edited logbook entry */
   void updateLogEntryScreenGeometry();
 
@@ -571,6 +585,9 @@ protected:
   Queries *queries;
 
 private:
+  /* Resize widget if needed. Size is corrected by device pixel ratio if ignoreUiScale is true. */
+  void resizeForPixmap(int pixmapWidth, int pixmapHeight, bool ignoreUiScale);
+
   /* Set map theme and adjust properties accordingly. theme is the full path to the DGML */
   void setThemeInternal(const MapTheme& theme);
 
@@ -0,0 +1,235 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mapgui/mapprefetcher.h"
+
+#include "atools.h"
+#include "geo/calculations.h"
+#include "mapgui/mappaintwidget.h"
+#include "query/querymanager.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+using Marble::GeoDataLatLonBox;
+using Marble::GeoDataCoordinates;
+using atools::geo::Pos;
+
+/* Predict pan position this time ahead */
+const static qint64 PAN_LOOKAHEAD_MS = 1000L;
+
+/* Ignore frames with longer gaps since these are no continuous movements */
+const static qint64 MAX_FRAME_GAP_MS = 2000L;
+
+/* Predict aircraft position this time ahead */
+const static float AIRCRAFT_LOOKAHEAD_S = 120.f;
+
+/* Aircraft has to be faster to predict a view */
+const static float AIRCRAFT_MIN_GROUNDSPEED_KTS = 30.f;
+
+/* Requested views are enlarged by this factor to cover the following predictions too */
+const static double VIEW_INFLATION = 1.25;
+
+/* Number of requested views to remember */
+const static int MAX_REQUESTED_VIEWS = 8;
+
+/* Wrap longitude difference or position into range -180 to 180 */
+static double wrapLonX(double lonX)
+{
+  while(lonX > 180.)
+    lonX -= 360.;
+  while(lonX < -180.)
+    lonX += 360.;
+  return lonX;
+}
+
+MapPrefetcher::MapPrefetcher(MapPaintWidget *mapPaintWidgetParam)
+  : mapPaintWidget(mapPaintWidgetParam)
+{
+  connect(&watcher, &QFutureWatcher<MapQueryTiles>::finished, this, &MapPrefetcher::loadFinished);
+  frameTimer.start();
+}
+
+MapPrefetcher::~MapPrefetcher()
+{
+  watcher.disconnect(this);
+  watcher.waitForFinished();
+}
+
+void MapPrefetcher::cancel()
+{
+  // Results of the running task are discarded when the finished signal arrives
+  generation++;
+  pendingViews.clear();
+  requestedViews.clear();
+  lastCenter = Pos();
+  lastDistanceKm = 0.f;
+
+  if(watcher.isRunning())
+  {
+    qDebug() << Q_FUNC_INFO << "Waiting for prefetch";
+    watcher.waitForFinished();
+  }
+}
+
+void MapPrefetcher::frameRendered(const GeoDataLatLonBox& rect, float distanceKm, const MapLayer *mapLayer, map::MapTypes types,
+                                  LayerFunc layerFunc, const Pos& aircraftPos, float aircraftTrackDeg,
+                                  float aircraftGroundSpeedKts)
+{
+  if(mapLayer == nullptr || rect.isEmpty())
+    return;
+
+  qint64 frameMs = frameTimer.elapsed();
+  Pos center(rect.center().longitude(GeoDataCoordinates::Degree), rect.center().latitude(GeoDataCoordinates::Degree));
+  double width = rect.width(GeoDataCoordinates::Degree), height = rect.height(GeoDataCoordinates::Degree);
+
+  QVector<View> views;
+  bool zooming = lastDistanceKm > 0.f && std::abs(distanceKm - lastDistanceKm) / lastDistanceKm > 0.05f;
+
+  // Panning - continue movement of the last frame ==========================
+  if(!zooming && lastCenter.isValid() && frameMs > lastFrameMs && frameMs - lastFrameMs <= MAX_FRAME_GAP_MS)
+  {
+    double factor = static_cast<double>(PAN_LOOKAHEAD_MS) / (frameMs - lastFrameMs);
+    double lonX = wrapLonX(center.getLonX() - lastCenter.getLonX()) * factor;
+    double latY = (center.getLatY() - lastCenter.getLatY()) * factor;
+
+    // Not more than one view size
+    lonX = atools::minmax(-width, width, lonX);
+    latY = atools::minmax(-height, height, latY);
+
+    if(std::abs(lonX) > width / 10. || std::abs(latY) > height / 10.)
+      addView(views, moved(rect, lonX, latY), mapLayer);
+  }
+
+  // Zooming - continue in the same direction ==========================
+  if(zooming && layerFunc)
+  {
+    double factor = distanceKm < lastDistanceKm ? 0.5 : 2.;
+    const MapLayer *zoomLayer = layerFunc(static_cast<float>(distanceKm * factor));
+    if(zoomLayer != nullptr)
+      addView(views, scaled(rect, factor), zoomLayer);
+  }
+
+  // Aircraft following - view ahead on track ==========================
+  if(aircraftPos.isValid() && aircraftGroundSpeedKts > AIRCRAFT_MIN_GROUNDSPEED_KTS)
+  {
+    float distMeter = atools::geo::nmToMeter(aircraftGroundSpeedKts * AIRCRAFT_LOOKAHEAD_S / 3600.f);
+    Pos ahead = aircraftPos.endpoint(distMeter, aircraftTrackDeg);
+    if(ahead.isValid())
+      addView(views, moved(rect, wrapLonX(ahead.getLonX() - aircraftPos.getLonX()),
+                           ahead.getLatY() - aircraftPos.getLatY()), mapLayer);
+  }
+
+  lastFrameMs = frameMs;
+  lastCenter = center;
+  lastDistanceKm = distanceKm;
+
+  if(!views.isEmpty())
+  {
+    // Replace outdated predictions which are still waiting
+    pendingViews = views;
+    pendingTypes = types;
+    startLoading();
+  }
+}
+
+void MapPrefetcher::addView(QVector<View>& views, const GeoDataLatLonBox& rect, const MapLayer *mapLayer)
+{
+  if(rect.isEmpty())
+    return;
+
+  // Skip if covered by a recently requested view having the same layer
+  for(const View& view : qAsConst(requestedViews))
+  {
+    if(atools::almostEqual(view.mapLayer.getMaxRange(), mapLayer->getMaxRange()) && view.rect.contains(rect))
+      return;
+  }
+
+  views.append(View(scaled(rect, VIEW_INFLATION), *mapLayer));
+}
+
+void MapPrefetcher::startLoading()
+{
+  if(watcher.isRunning() || pendingViews.isEmpty())
+    return;
+
+  requestedViews.append(pendingViews);
+  while(requestedViews.size() > MAX_REQUESTED_VIEWS)
+    requestedViews.removeFirst();
+
+  taskGeneration = generation;
+  watcher.setFuture(QtConcurrent::run(&MapPrefetcher::loadViews, pendingViews, pendingTypes));
+  pendingViews.clear();
+}
+
+MapQueryTiles MapPrefetcher::loadViews(QVector<View> views, map::MapTypes types)
+{
+  MapQueryTiles tiles;
+  try
+  {
+    // Uses own read only connections for this pool thread
+    Queries *queries = QueryManager::instance()->getQueriesThread();
+    QueryLocker locker(queries);
+
+    for(const View& view : qAsConst(views))
+      queries->getMapQuery()->prefetch(tiles, view.rect, &view.mapLayer, types);
+  }
+  catch(std::exception& e)
+  {
+    // Not critical - objects are loaded when painting
+    qWarning() << Q_FUNC_INFO << "Error prefetching" << e.what();
+    tiles = MapQueryTiles();
+  }
+  return tiles;
+}
+
+void MapPrefetcher::loadFinished()
+{
+  QFuture<MapQueryTiles> future = watcher.future();
+  if(future.isCanceled() || future.resultCount() == 0)
+    return;
+
+  // Discard if database was changed in the meantime
+  if(taskGeneration == generation)
+    mapPaintWidget->getQueries()->getMapQuery()->insertPrefetched(future.result());
+
+  // Continue with views collected while loading
+  startLoading();
+}
+
+GeoDataLatLonBox MapPrefetcher::moved(const GeoDataLatLonBox& rect, double lonXDeg, double latYDeg)
+{
+  // Keep size but do not move beyond the poles
+  double north = rect.north(GeoDataCoordinates::Degree), south = rect.south(GeoDataCoordinates::Degree);
+  latYDeg = atools::minmax(-90. - south, 90. - north, latYDeg);
+
+  // Box can cross the anti-meridian afterwards which is handled by the queries
+  return GeoDataLatLonBox(north + latYDeg, south + latYDeg,
+                          wrapLonX(rect.east(GeoDataCoordinates::Degree) + lonXDeg),
+                          wrapLonX(rect.west(GeoDataCoordinates::Degree) + lonXDeg),
+                          GeoDataCoordinates::Degree);
+}
+
+GeoDataLatLonBox MapPrefetcher::scaled(const GeoDataLatLonBox& rect, double factor)
+{
+  double lonX = rect.center().longitude(GeoDataCoordinates::Degree), latY = rect.center().latitude(GeoDataCoordinates::Degree);
+  double halfWidth = std::min(rect.width(GeoDataCoordinates::Degree) * factor / 2., 179.9);
+  double halfHeight = rect.height(GeoDataCoordinates::Degree) * factor / 2.;
+
+  return GeoDataLatLonBox(std::min(latY + halfHeight, 90.), std::max(latY - halfHeight, -90.),
+                          wrapLonX(lonX + halfWidth), wrapLonX(lonX - halfWidth),
+                          GeoDataCoordinates::Degree);
+}
@@ -0,0 +1,128 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_MAPPREFETCHER_H
+#define LNM_MAPPREFETCHER_H
+
+#include "common/mapflags.h"
+#include "geo/pos.h"
+#include "mapgui/maplayer.h"
+#include "query/mapquery.h"
+
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+#include <marble/GeoDataLatLonBox.h>
+
+#include <functional>
+
+class MapPaintWidget;
+
+/*
+ * Predicts the next map views and loads the map objects for these in background before the user gets there.
+ *
+ * Views are predicted from the panning velocity, the zoom direction and the aircraft track if the map follows
+ * the user aircraft. Objects are loaded into the tile indexes of a worker thread map query which uses its own read only
+ * connections (see QueryManager::getQueriesThread()). Loaded tiles are then copied into the tile indexes of the map query
+ * used for painting. Painting itself never waits for prefetching.
+ *
+ * Only one background task runs at a time. Newer predictions replace the ones waiting for the task.
+ *
+ * All methods have to be called from the GUI thread.
+ */
+class MapPrefetcher :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  /* Get layer for zoom distance using the current detail level */
+  typedef std::function<const MapLayer *(float distanceKm)> LayerFunc;
+
+  explicit MapPrefetcher(MapPaintWidget *mapPaintWidgetParam);
+  virtual ~MapPrefetcher() override;
+
+  MapPrefetcher(const MapPrefetcher& other) = delete;
+  MapPrefetcher& operator=(const MapPrefetcher& other) = delete;
+
+  /* Called after each painted frame. Predicts the next views and starts loading for the ones not covered yet.
+   * aircraftPos has to be invalid if the map does not follow the aircraft. */
+  void frameRendered(const Marble::GeoDataLatLonBox& rect, float distanceKm, const MapLayer *mapLayer, map::MapTypes types,
+                     LayerFunc layerFunc, const atools::geo::Pos& aircraftPos, float aircraftTrackDeg, float aircraftGroundSpeedKts);
+
+  /* Drop waiting views, wait for a running task and discard its result. Needed before databases are modified. */
+  void cancel();
+
+private:
+  /* Predicted view with a copy of the layer since layers can be reloaded while the task is running */
+  struct View
+  {
+    View()
+      : mapLayer(0.f)
+    {
+    }
+
+    View(const Marble::GeoDataLatLonBox& rectParam, const MapLayer& mapLayerParam)
+      : rect(rectParam), mapLayer(mapLayerParam)
+    {
+    }
+
+    Marble::GeoDataLatLonBox rect;
+    MapLayer mapLayer;
+  };
+
+  /* Add view if not too close to the last requested ones */
+  void addView(QVector<View>& views, const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer);
+
+  /* Start background task for pending views if not running */
+  void startLoading();
+
+  /* Called in background thread */
+  static MapQueryTiles loadViews(QVector<View> views, map::MapTypes types);
+
+  /* Copy tiles into the GUI map query. Called by watcher. */
+  void loadFinished();
+
+  /* Move rect by the given degrees keeping the size */
+  static Marble::GeoDataLatLonBox moved(const Marble::GeoDataLatLonBox& rect, double lonXDeg, double latYDeg);
+
+  /* Scale rect around its center */
+  static Marble::GeoDataLatLonBox scaled(const Marble::GeoDataLatLonBox& rect, double factor);
+
+  MapPaintWidget *mapPaintWidget;
+  QFutureWatcher<MapQueryTiles> watcher;
+
+  /* Views waiting for the running task to finish */
+  QVector<View> pendingViews;
+  map::MapTypes pendingTypes = map::NONE;
+
+  /* Recently requested views to avoid loading the same region over and over again */
+  QVector<View> requestedViews;
+
+  /* Incremented on cancel. Results of older tasks are discarded. */
+  int generation = 0, taskGeneration = 0;
+
+  /* Values of last frame for velocity and zoom direction */
+  QElapsedTimer frameTimer;
+  qint64 lastFrameMs = -1L;
+  atools::geo::Pos lastCenter;
+  float lastDistanceKm = 0.f;
+};
+
+#endif // LNM_MAPPREFETCHER_H
@@ -0,0 +1,268 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mapgui/mapscreengrid.h"
+
+#include "atools.h"
+#include "geo/calculations.h"
+
+#include <marble/ViewportParams.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/* Cell width and height in pixel */
+const static int CELL_SIZE = 32;
+
+/* Cells added around the screen rectangle to catch objects which are partially visible */
+const static int CELL_MARGIN = 2;
+
+/* Clip line x1/y1 to x2/y2 to the rectangle 0,0 to width,height using Liang and Barsky.
+ * Returns false if the line is completely outside. */
+static bool clipLine(double& x1, double& y1, double& x2, double& y2, double width, double height)
+{
+  double dx = x2 - x1, dy = y2 - y1, t0 = 0., t1 = 1.;
+
+  // Left, right, top and bottom edge
+  const double p[4] = {-dx, dx, -dy, dy};
+  const double q[4] = {x1, width - x1, y1, height - y1};
+
+  for(int i = 0; i < 4; i++)
+  {
+    if(p[i] == 0.)
+    {
+      // Parallel to edge and outside
+      if(q[i] < 0.)
+        return false;
+    }
+    else
+    {
+      double t = q[i] / p[i];
+      if(p[i] < 0.)
+        t0 = std::max(t0, t);
+      else
+        t1 = std::min(t1, t);
+
+      if(t0 > t1)
+        return false;
+    }
+  }
+
+  x2 = x1 + t1 * dx;
+  y2 = y1 + t1 * dy;
+  x1 = x1 + t0 * dx;
+  y1 = y1 + t0 * dy;
+  return true;
+}
+
+// ======= MapScreenGrid ===============================================================
+MapScreenGrid::MapScreenGrid()
+{
+  layers.resize(grid::NUM_TYPES);
+}
+
+void MapScreenGrid::clear()
+{
+  for(int i = 0; i < grid::NUM_TYPES; i++)
+    clear(static_cast<grid::Type>(i));
+}
+
+void MapScreenGrid::clear(grid::Type type)
+{
+  layers[type] = Layer();
+}
+
+void MapScreenGrid::reset(grid::Type type, const QRect& screenRect)
+{
+  Layer& layer = layers[type];
+  layer = Layer();
+
+  if(screenRect.isEmpty())
+    return;
+
+  layer.rect = screenRect.adjusted(-CELL_MARGIN * CELL_SIZE, -CELL_MARGIN * CELL_SIZE,
+                                   CELL_MARGIN * CELL_SIZE, CELL_MARGIN * CELL_SIZE);
+  layer.columns = layer.rect.width() / CELL_SIZE + 1;
+  layer.rows = layer.rect.height() / CELL_SIZE + 1;
+  layer.cells.resize(layer.columns * layer.rows);
+}
+
+void MapScreenGrid::reset(grid::Type type, const Marble::ViewportParams *viewport, quint32 generation, int size)
+{
+  reset(type, QRect(0, 0, viewport->width(), viewport->height()));
+
+  Layer& layer = layers[type];
+  layer.viewportKey = MapViewportKey(viewport);
+  layer.generation = generation;
+  layer.size = size;
+}
+
+bool MapScreenGrid::isCurrent(grid::Type type, const Marble::ViewportParams *viewport, quint32 generation, int size) const
+{
+  const Layer& layer = layers.at(type);
+  return layer.columns > 0 && layer.generation == generation && layer.size == size && layer.viewportKey == MapViewportKey(viewport);
+}
+
+void MapScreenGrid::insertCell(Layer& layer, int column, int row, int index, const QPoint& point)
+{
+  if(column >= 0 && column < layer.columns && row >= 0 && row < layer.rows)
+    layer.cells[row * layer.columns + column].append({index, point});
+}
+
+void MapScreenGrid::cellRange(const Layer& layer, const QRect& rect, int& col1, int& row1, int& col2, int& row2) const
+{
+  col1 = atools::minmax(0, layer.columns - 1, (rect.left() - layer.rect.left()) / CELL_SIZE);
+  row1 = atools::minmax(0, layer.rows - 1, (rect.top() - layer.rect.top()) / CELL_SIZE);
+  col2 = atools::minmax(0, layer.columns - 1, (rect.right() - layer.rect.left()) / CELL_SIZE);
+  row2 = atools::minmax(0, layer.rows - 1, (rect.bottom() - layer.rect.top()) / CELL_SIZE);
+}
+
+void MapScreenGrid::insertPoint(grid::Type type, int index, const QPoint& point)
+{
+  Layer& layer = layers[type];
+  if(layer.columns == 0)
+    return;
+
+  // Clamp points outside of the grid into the border cells
+  int col1, row1, col2, row2;
+  cellRange(layer, QRect(point, point), col1, row1, col2, row2);
+  insertCell(layer, col1, row1, index, point);
+}
+
+void MapScreenGrid::insertRect(grid::Type type, int index, const QRect& rect)
+{
+  Layer& layer = layers[type];
+  if(layer.columns == 0 || !rect.intersects(layer.rect))
+    return;
+
+  int col1, row1, col2, row2;
+  cellRange(layer, rect, col1, row1, col2, row2);
+  for(int row = row1; row <= row2; row++)
+  {
+    for(int col = col1; col <= col2; col++)
+      insertCell(layer, col, row, index);
+  }
+}
+
+void MapScreenGrid::insertLine(grid::Type type, int index, const QLine& line)
+{
+  Layer& layer = layers[type];
+  if(layer.columns == 0)
+    return;
+
+  // Line in cell units
+  double x1 = (line.x1() - layer.rect.left()) / static_cast<double>(CELL_SIZE);
+  double y1 = (line.y1() - layer.rect.top()) / static_cast<double>(CELL_SIZE);
+  double x2 = (line.x2() - layer.rect.left()) / static_cast<double>(CELL_SIZE);
+  double y2 = (line.y2() - layer.rect.top()) / static_cast<double>(CELL_SIZE);
+
+  // Clip to grid first so that long and mostly invisible lines do not walk through cells outside
+  if(!clipLine(x1, y1, x2, y2, layer.columns, layer.rows))
+    return;
+
+  // Walk along all cells touched by the clipped line - Amanatides and Woo traversal
+  // Clamp since clipped end points can be on the right or bottom border
+  int col = atools::minmax(0, layer.columns - 1, static_cast<int>(std::floor(x1)));
+  int row = atools::minmax(0, layer.rows - 1, static_cast<int>(std::floor(y1)));
+  int endCol = atools::minmax(0, layer.columns - 1, static_cast<int>(std::floor(x2)));
+  int endRow = atools::minmax(0, layer.rows - 1, static_cast<int>(std::floor(y2)));
+
+  double dx = x2 - x1, dy = y2 - y1;
+  int stepCol = dx > 0. ? 1 : -1, stepRow = dy > 0. ? 1 : -1;
+  const double inf = std::numeric_limits<double>::max();
+
+  double tDeltaX = std::abs(dx) > 0. ? std::abs(1. / dx) : inf;
+  double tDeltaY = std::abs(dy) > 0. ? std::abs(1. / dy) : inf;
+  double tMaxX = dx > 0. ? (col + 1. - x1) / dx : (dx < 0. ? (x1 - col) / -dx : inf);
+  double tMaxY = dy > 0. ? (row + 1. - y1) / dy : (dy < 0. ? (y1 - row) / -dy : inf);
+
+  int steps = std::abs(endCol - col) + std::abs(endRow - row);
+  for(int i = 0; i <= steps; i++)
+  {
+    insertCell(layer, col, row, index);
+
+    if(col == endCol && row == endRow)
+      break;
+
+    if(tMaxX < tMaxY)
+    {
+      tMaxX += tDeltaX;
+      col += stepCol;
+    }
+    else
+    {
+      tMaxY += tDeltaY;
+      row += stepRow;
+    }
+  }
+}
+
+void MapScreenGrid::updateLines(grid::Type type, const QList<std::pair<int, QLine> >& lines, const QRect& screenRect)
+{
+  reset(type, screenRect);
+  for(int i = 0; i < lines.size(); i++)
+    insertLine(type, i, lines.at(i).second);
+}
+
+void MapScreenGrid::getNearestPoints(QVector<std::pair<int, QPoint> >& points, grid::Type type, int xs, int ys, int maxDistance) const
+{
+  const Layer& layer = layers.at(type);
+  if(layer.columns == 0)
+    return;
+
+  int col1, row1, col2, row2;
+  cellRange(layer, QRect(QPoint(xs - maxDistance, ys - maxDistance), QPoint(xs + maxDistance, ys + maxDistance)),
+            col1, row1, col2, row2);
+
+  for(int row = row1; row <= row2; row++)
+  {
+    for(int col = col1; col <= col2; col++)
+    {
+      for(const Entry& entry : layer.cells.at(row * layer.columns + col))
+      {
+        if(atools::geo::manhattanDistance(entry.point.x(), entry.point.y(), xs, ys) < maxDistance)
+          points.append(std::make_pair(entry.index, entry.point));
+      }
+    }
+  }
+}
+
+void MapScreenGrid::getCandidates(QVector<int>& indexes, grid::Type type, int xs, int ys, int maxDistance) const
+{
+  const Layer& layer = layers.at(type);
+  if(layer.columns == 0)
+    return;
+
+  int col1, row1, col2, row2;
+  cellRange(layer, QRect(QPoint(xs - maxDistance, ys - maxDistance), QPoint(xs + maxDistance, ys + maxDistance)),
+            col1, row1, col2, row2);
+
+  int start = indexes.size();
+  for(int row = row1; row <= row2; row++)
+  {
+    for(int col = col1; col <= col2; col++)
+    {
+      for(const Entry& entry : layer.cells.at(row * layer.columns + col))
+        indexes.append(entry.index);
+    }
+  }
+
+  // Lines and rectangles can cover more than one cell - remove duplicates. Sorting restores the order of the source list
+  std::sort(indexes.begin() + start, indexes.end());
+  indexes.erase(std::unique(indexes.begin() + start, indexes.end()), indexes.end());
+}
@@ -0,0 +1,131 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_MAPSCREENGRID_H
+#define LNM_MAPSCREENGRID_H
+
+#include "mapgui/mapviewportkey.h"
+
+#include <QLine>
+#include <QList>
+#include <QRect>
+#include <QVector>
+
+namespace Marble {
+class ViewportParams;
+}
+
+namespace grid {
+
+/* Object types kept in separate layers of the grid */
+enum Type : int
+{
+  /* Points from MapQuery rect caches. Index is position in cache list. */
+  AIRPORT,
+  AIRPORT_TOWER,
+  AIRPORT_MSA,
+  VOR,
+  NDB,
+  HOLDING,
+  USERPOINT,
+  MARKER,
+  ILS,
+
+  /* Lines and polygons from MapScreenIndex. Index is position in the screen geometry list. */
+  AIRWAY_LINES,
+  LOGBOOK_LINES,
+  ILS_LINES,
+  ROUTE_LINES,
+  ILS_POLYGONS,
+  AIRSPACE_POLYGONS,
+
+  NUM_TYPES
+};
+
+}
+
+/*
+ * Uniform bucket grid in screen coordinates used to speed up mouse over and tooltip queries.
+ *
+ * Each object type has its own layer which covers the screen rectangle plus a margin. Cells store indexes
+ * into the source lists (cache lists or screen geometry lists). Points outside of the grid are clamped into
+ * the border cells while lines and rectangles are only added to the cells they cover.
+ *
+ * A layer has to be rebuilt after the viewport or the source list changed. Layers filled from MapQuery caches
+ * are keyed by viewport parameters and source generation to detect this.
+ */
+class MapScreenGrid
+{
+public:
+  MapScreenGrid();
+
+  /* Clear all layers and free memory */
+  void clear();
+  void clear(grid::Type type);
+
+  /* Prepare an empty layer covering the screen rectangle */
+  void reset(grid::Type type, const QRect& screenRect);
+
+  /* Prepare an empty layer for the viewport and remember the source state */
+  void reset(grid::Type type, const Marble::ViewportParams *viewport, quint32 generation, int size);
+
+  /* True if the layer was built for the same viewport and the same source generation and size */
+  bool isCurrent(grid::Type type, const Marble::ViewportParams *viewport, quint32 generation, int size) const;
+
+  /* Add objects to the layer. Layer has to be reset before. */
+  void insertPoint(grid::Type type, int index, const QPoint& point);
+  void insertLine(grid::Type type, int index, const QLine& line);
+  void insertRect(grid::Type type, int index, const QRect& rect);
+
+  /* Reset layer and add all lines from the list */
+  void updateLines(grid::Type type, const QList<std::pair<int, QLine> >& lines, const QRect& screenRect);
+
+  /* Get index and screen point for all points with a manhattan distance below maxDistance to xs/ys */
+  void getNearestPoints(QVector<std::pair<int, QPoint> >& points, grid::Type type, int xs, int ys, int maxDistance) const;
+
+  /* Get indexes of all lines or rectangles in cells touched by the square of maxDistance around xs/ys.
+   * Indexes are unique. Caller has to check the distance. */
+  void getCandidates(QVector<int>& indexes, grid::Type type, int xs, int ys, int maxDistance) const;
+
+private:
+  struct Entry
+  {
+    int index;
+    QPoint point;
+  };
+
+  struct Layer
+  {
+    QRect rect; /* Covered screen area including margin */
+    int columns = 0, rows = 0;
+    QVector<QVector<Entry> > cells;
+
+    /* Only used for layers filled from MapQuery caches */
+    MapViewportKey viewportKey;
+    quint32 generation = 0;
+    int size = -1;
+  };
+
+  void insertCell(Layer& layer, int column, int row, int index, const QPoint& point = QPoint());
+
+  /* Cell range touched by the rectangle clamped to grid boundaries */
+  void cellRange(const Layer& layer, const QRect& rect, int& col1, int& row1, int& col2, int& row2) const;
+
+  QVector<Layer> layers;
+};
+
+#endif // LNM_MAPSCREENGRID_H
@@ -31,6 +31,7 @@
 #include "mapgui/mapmarkhandler.h"
 #include "mapgui/mappaintwidget.h"
 #include "mapgui/mapscale.h"
+#include "mapgui/mapscreengrid.h"
 #include "mappainter/mappaintlayer.h"
 #include "online/onlinedatacontroller.h"
 #include "query/airportquery.h"
@@ -82,6 +83,7 @@ MapScreenIndex::MapScreenIndex(MapPaintWidget *mapPaintWidgetParam, MapPaintLaye
   procedureLegHighlight = new proc::MapProcedureLeg;
   movingAverageSimAircraft = new atools::util::MovingAverageTime(TURN_PATH_AVERAGE_TIME_MS);
   profileHighlight = new atools::geo::Pos;
+  screenGrid = new MapScreenGrid;
 }
 
 MapScreenIndex::~MapScreenIndex()
@@ -94,6 +96,7 @@ MapScreenIndex::~MapScreenIndex()
   delete lastSimData;
   delete lastUserAircraftForAverage;
   delete profileHighlight;
+  delete screenGrid;
 }
 
 void MapScreenIndex::copy(const MapScreenIndex& other)
@@ -107,6 +110,7 @@ void MapScreenIndex::copy(const MapScreenIndex& other)
   *lastUserAircraftForAverage = *other.lastUserAircraftForAverage;
   *profileHighlight = *other.profileHighlight;
   *movingAverageSimAircraft = *other.movingAverageSimAircraft;
+  *screenGrid = *other.screenGrid;
 
   // Copy content of aggregated members
   procedureHighlights = other.procedureHighlights;
@@ -184,7 +188,9 @@ void MapScreenIndex::updateAirspaceScreenGeometryInternal(QSet<map::MapAirspaceI
             if(!poly->isEmpty())
             {
               // Cut off all polygon parts that are not visible on screen
-              airspacePolygons.append(std::make_pair(airspace->combinedId(), poly->intersected(QPolygon(mapWidget->rect())).toPolygon()));
+              const QPolygon polygon = poly->intersected(QPolygon(mapWidget->rect())).toPolygon();
+              airspacePolygons.append(std::make_pair(airspace->combinedId(), polygon));
+              screenGrid->insertRect(grid::AIRSPACE_POLYGONS, airspacePolygons.size() - 1, polygon.boundingRect());
               ids.insert(airspace->combinedId());
             }
           }
@@ -205,11 +211,14 @@ void MapScreenIndex::resetIlsScreenGeometry()
 {
   ilsPolygons.clear();
   ilsLines.clear();
+  screenGrid->reset(grid::ILS_POLYGONS, mapWidget->rect());
+  screenGrid->reset(grid::ILS_LINES, mapWidget->rect());
 }
 
 void MapScreenIndex::updateAirspaceScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
 {
   airspacePolygons.clear();
+  screenGrid->reset(grid::AIRSPACE_POLYGONS, mapWidget->rect());
   if(paintLayer == nullptr || paintLayer->getMapLayer() == nullptr)
     return;
 
@@ -317,9 +326,14 @@ void MapScreenIndex::updateIlsScreenGeometry(const Marble::GeoDataLatLonBox& cur
       }
       polygon = polygon.intersected(QPolygon(mapWidget->rect()));
       if(!polygon.isEmpty())
+      {
         ilsPolygons.append(std::make_pair(ils.id, polygon));
+        screenGrid->insertRect(grid::ILS_POLYGONS, ilsPolygons.size() - 1, polygon.boundingRect());
+      }
     }
   }
+
+  screenGrid->updateLines(grid::ILS_LINES, ilsLines, mapWidget->rect());
 }
 
 void MapScreenIndex::updateLogEntryScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
@@ -358,6 +372,8 @@ void MapScreenIndex::updateLogEntryScreenGeometry(const Marble::GeoDataLatLonBox
       }
     }
   }
+
+  screenGrid->updateLines(grid::LOGBOOK_LINES, logEntryLines, mapWidget->rect());
 }
 
 void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
@@ -375,6 +391,8 @@ void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonBox&
 
   // Get geometry from visible airways
   updateAirwayScreenGeometryInternal(ids, curBox, false /* highlight */);
+
+  screenGrid->updateLines(grid::AIRWAY_LINES, airwayLines, mapWidget->rect());
 }
 
 void MapScreenIndex::updateAirwayScreenGeometryInternal(QSet<int>& ids, const Marble::GeoDataLatLonBox& curBox, bool highlight)
@@ -811,6 +829,8 @@ void MapScreenIndex::updateRouteScreenGeometry(const Marble::GeoDataLatLonBox& c
     routePointsAll.append(otherPointsEditable);
     routePointsAll.append(otherPointsNotEditable);
   }
+
+  screenGrid->updateLines(grid::ROUTE_LINES, routeLines, mapWidget->rect());
 }
 
 void MapScreenIndex::getAllNearest(const QPoint& point, int maxDistance, map::MapResult& result, map::MapObjectQueryTypes types) const
@@ -1240,6 +1260,9 @@ int MapScreenIndex::getNearestRoutePointIndex(int xs, int ys, int maxDistance, b
 
 void MapScreenIndex::updateAllGeometry(const Marble::GeoDataLatLonBox& curBox)
 {
+  // Viewport changed - grid for cached map objects is rebuilt on next query
+  queries->getMapQuery()->clearScreenGrid();
+
   updateRouteScreenGeometry(curBox);
   updateAirwayScreenGeometry(curBox);
   updateLogEntryScreenGeometry(curBox);
@@ -1249,20 +1272,28 @@ void MapScreenIndex::updateAllGeometry(const Marble::GeoDataLatLonBox& curBox)
 
 void MapScreenIndex::getNearestAirspaces(int xs, int ys, map::MapResult& result) const
 {
-  for(const std::pair<map::MapAirspaceId, QPolygon>& polyPair : airspacePolygons)
+  // Get polygons having a bounding rectangle in the cell below the cursor
+  QVector<int> indexes;
+  screenGrid->getCandidates(indexes, grid::AIRSPACE_POLYGONS, xs, ys, 0);
+
+  for(int index : qAsConst(indexes))
   {
+    const std::pair<map::MapAirspaceId, QPolygon>& polyPair = airspacePolygons.at(index);
     if(polyPair.second.containsPoint(QPoint(xs, ys), Qt::OddEvenFill))
       result.airspaces.append(queries->getAirspaceQueries()->getAirspaceById(polyPair.first));
   }
 }
 
-QSet<int> MapScreenIndex::nearestLineIds(const QList<std::pair<int, QLine> >& lineList, int xs, int ys,
+QSet<int> MapScreenIndex::nearestLineIds(const QList<std::pair<int, QLine> >& lineList, grid::Type gridType, int xs, int ys,
                                          int maxDistance, bool lineDistanceOnly) const
 {
+  QVector<int> indexes;
+  screenGrid->getCandidates(indexes, gridType, xs, ys, maxDistance);
+
   QSet<int> ids;
-  for(int i = 0; i < lineList.size(); i++)
+  for(int index : qAsConst(indexes))
   {
-    const std::pair<int, QLine>& linePair = lineList.at(i);
+    const std::pair<int, QLine>& linePair = lineList.at(index);
     const QLine& line = linePair.second;
 
     if(atools::geo::distanceToLine(xs, ys, line.x1(), line.y1(), line.x2(), line.y2(), lineDistanceOnly) < maxDistance)
@@ -1291,7 +1322,7 @@ void MapScreenIndex::getNearestLogEntries(int xs, int ys, int maxDistance, map::
   if(paintLayer->getShownMapDisplayTypes().testFlag(map::LOGBOOK_DIRECT) ||
      paintLayer->getShownMapDisplayTypes().testFlag(map::LOGBOOK_ROUTE))
   {
-    const QSet<int> nearestIds = nearestLineIds(logEntryLines, xs, ys, maxDistance, false /* also distance to points */);
+    const QSet<int> nearestIds = nearestLineIds(logEntryLines, grid::LOGBOOK_LINES, xs, ys, maxDistance, false /* also distance to points */);
     for(int id : nearestIds)
       maptools::insertSortedByDistance(conv, result.logbookEntries, &ids, xs, ys,
                                        NavApp::getLogdataController()->getLogEntryById(id));
@@ -1306,12 +1337,14 @@ void MapScreenIndex::getNearestIls(int xs, int ys, int maxDistance, map::MapResu
     return;
 
   // Get nearest center lines (also considering buffer)
-  QSet<int> ilsIds = nearestLineIds(ilsLines, xs, ys, maxDistance, false /* lineDistanceOnly */);
+  QSet<int> ilsIds = nearestLineIds(ilsLines, grid::ILS_LINES, xs, ys, maxDistance, false /* lineDistanceOnly */);
 
   // Get nearest ILS by geometry - duplicates are removed in set
-  for(int i = 0; i < ilsPolygons.size(); i++)
+  QVector<int> indexes;
+  screenGrid->getCandidates(indexes, grid::ILS_POLYGONS, xs, ys, 0);
+  for(int index : qAsConst(indexes))
   {
-    const std::pair<int, QPolygon>& polyPair = ilsPolygons.at(i);
+    const std::pair<int, QPolygon>& polyPair = ilsPolygons.at(index);
     if(polyPair.second.containsPoint(QPoint(xs, ys), Qt::OddEvenFill))
       ilsIds.insert(polyPair.first);
   }
@@ -1326,7 +1359,7 @@ void MapScreenIndex::getNearestIls(int xs, int ys, int maxDistance, map::MapResu
 void MapScreenIndex::getNearestAirways(int xs, int ys, int maxDistance, map::MapResult& result) const
 {
   AirwayTrackQuery *airwayTrackQuery = queries->getAirwayTrackQuery();
-  const QSet<int> nearestIds = nearestLineIds(airwayLines, xs, ys, maxDistance, true /* lineDistanceOnly */);
+  const QSet<int> nearestIds = nearestLineIds(airwayLines, grid::AIRWAY_LINES, xs, ys, maxDistance, true /* lineDistanceOnly */);
   for(int id : nearestIds)
     result.airways.append(airwayTrackQuery->getAirwayById(id));
 }
@@ -1339,9 +1372,12 @@ int MapScreenIndex::getNearestRouteLegIndex(int xs, int ys, int maxDistance) con
   int minIndex = -1;
   float minDist = std::numeric_limits<float>::max();
 
-  for(int i = 0; i < routeLines.size(); i++)
+  QVector<int> indexes;
+  screenGrid->getCandidates(indexes, grid::ROUTE_LINES, xs, ys, maxDistance);
+
+  for(int index : qAsConst(indexes))
   {
-    const std::pair<int, QLine>& line = routeLines.at(i);
+    const std::pair<int, QLine>& line = routeLines.at(index);
 
     QLine l = line.second;
 
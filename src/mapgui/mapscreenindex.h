@@ -74,8 +74,13 @@ namespace Marble {
 class GeoDataLatLonBox;
 }
 
+namespace grid {
+enum Type : int;
+}
+
 class MapPaintWidget;
 class MapPaintLayer;
+class MapScreenGrid;
 class CoordinateConverter;
 
 /*
@@ -319,7 +324,9 @@ private:
   /* Fill average values for ground speed and turn speed for turn path display. */
   void updateAverageTurn();
 
-  QSet<int> nearestLineIds(const QList<std::pair<int, QLine> >& lineList, int xs, int ys, int maxDistance, bool lineDistanceOnly) const;
+  /* Get ids of lines near xs/ys using the screen grid layer gridType which has to be built from lineList */
+  QSet<int> nearestLineIds(const QList<std::pair<int, QLine> >& lineList, grid::Type gridType, int xs, int ys, int maxDistance,
+                           bool lineDistanceOnly) const;
 
   template<typename TYPE>
   int getNearestId(int xs, int ys, int maxDistance, const QHash<int, TYPE>& typeList) const;
@@ -385,6 +392,9 @@ private:
   QList<std::pair<int, QPolygon> > ilsPolygons;
   QList<std::pair<int, QLine> > ilsLines; /* Index ILS center lines separately to allow
                                            * tooltips when getting the cursor near a line */
+
+  /* Bucket grid for the line and polygon lists above. Rebuilt with the lists. */
+  MapScreenGrid *screenGrid;
 };
 
 #endif // LITTLENAVMAP_MAPSCREENINDEX_H
@@ -0,0 +1,40 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mapgui/mapviewportkey.h"
+
+#include "atools.h"
+
+#include <marble/ViewportParams.h>
+
+MapViewportKey::MapViewportKey(const Marble::ViewportParams *viewport)
+{
+  if(viewport != nullptr)
+  {
+    centerLon = viewport->centerLongitude();
+    centerLat = viewport->centerLatitude();
+    radius = viewport->radius();
+    projection = viewport->projection();
+    size = viewport->size();
+  }
+}
+
+bool MapViewportKey::operator==(const MapViewportKey& other) const
+{
+  return atools::almostEqual(centerLon, other.centerLon) && atools::almostEqual(centerLat, other.centerLat) &&
+         radius == other.radius && projection == other.projection && size == other.size;
+}
@@ -0,0 +1,58 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_MAPVIEWPORTKEY_H
+#define LNM_MAPVIEWPORTKEY_H
+
+#include <QSize>
+
+namespace Marble {
+class ViewportParams;
+}
+
+/*
+ * Viewport parameters which define the projection of world to screen coordinates.
+ * Used to detect if cached screen coordinates are still valid.
+ */
+class MapViewportKey
+{
+public:
+  MapViewportKey()
+  {
+  }
+
+  explicit MapViewportKey(const Marble::ViewportParams *viewport);
+
+  bool operator==(const MapViewportKey& other) const;
+
+  bool operator!=(const MapViewportKey& other) const
+  {
+    return !(*this == other);
+  }
+
+  bool isValid() const
+  {
+    return projection != -1;
+  }
+
+private:
+  double centerLon = 0., centerLat = 0.;
+  int radius = 0, projection = -1;
+  QSize size;
+};
+
+#endif // LNM_MAPVIEWPORTKEY_H
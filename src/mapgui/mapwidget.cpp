@@ -2586,6 +2586,7 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
   if(databaseLoadStatus || !aircraft.isValid())
   {
     getScreenIndex()->updateLastSimData(atools::fs::sc::SimConnectData());
+    paintLayer->clearSimUpdateOnly();
 
     // Update action states if needed
     if(userAircraftValidToggled)
@@ -2954,6 +2955,7 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
       if(touchdownDetectedZoom && od.getFlags2().testFlag(opts2::ROUTE_ZOOM_LANDING))
       {
         qDebug() << Q_FUNC_INFO << "Touchdown detected - zooming close" << touchdownZoomRectKm << "km";
+        paintLayer->clearSimUpdateOnly();
         centerPosOnMap(aircraft.getPosition());
         setDistanceToMap(touchdownZoomRectKm);
         touchdownDetectedZoom = false;
@@ -2961,6 +2963,7 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
       else if(takeoffDetectedZoom && !centerAircraftAndLeg && od.getFlags2().testFlag(opts2::ROUTE_ZOOM_TAKEOFF))
       {
         qDebug() << Q_FUNC_INFO << "Takeoff detected - zooming out" << takeoffZoomRectKm << "km";
+        paintLayer->clearSimUpdateOnly();
         centerPosOnMap(aircraft.getPosition());
         setDistanceToMap(takeoffZoomRectKm);
         takeoffDetectedZoom = false;
@@ -2968,11 +2971,19 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
     }
 
     if(!updatesEnabled())
+    {
+      // Map might have been centered - do not reuse base layers of a pending simulator update
+      paintLayer->clearSimUpdateOnly();
+
       // Re-enabling updates implicitly calls update() on the widget
       setUpdatesEnabled(true);
+    }
     else if((dataHasChanged || aiVisible || trailTruncated) && !contextMenuActive)
-      // Not scrolled or zoomed but needs a redraw
+    {
+      // Not scrolled or zoomed but needs a redraw - navigation layers can be reused if view is unchanged
+      paintLayer->setSimUpdateOnly();
       update();
+    }
 
     // Set flag if aircraft is or was close enought to the takeoff position on the runway
     const proc::MapProcedureLegs& sidLegs = route.getSidLegs();
@@ -3510,6 +3521,11 @@ void MapWidget::updateShowAircraftUi(bool centerAircraftChecked)
   }
 }
 
+bool MapWidget::isFollowingAircraft() const
+{
+  return mainWindow->getUi()->actionMapAircraftCenter->isChecked() && NavApp::isConnectedAndAircraft();
+}
+
 void MapWidget::updateMapObjectsShown()
 {
   // Checked if enabled and check state is true
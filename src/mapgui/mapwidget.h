@@ -413,6 +413,7 @@ private:
 
   virtual void handleHistory() override;
   virtual void updateShowAircraftUi(bool centerAircraftChecked) override;
+  virtual bool isFollowingAircraft() const override;
 
   /* Overloaded methods from QWidget ============================================================ */
   virtual void mousePressEvent(QMouseEvent *event) override;
@@ -43,6 +43,9 @@ using namespace Marble;
 using namespace atools::geo;
 using atools::roundToInt;
 
+/* Number of colors used to draw the aircraft trail altitude gradient */
+static const int TRAIL_GRADIENT_BUCKETS = 64;
+
 /* Minimum points to use for a circle */
 const float CIRCLE_MIN_POINTS = 32.f;
 /* Maximum points to use for a circle */
@@ -824,25 +827,52 @@ void MapPainter::paintAircraftTrail(const QVector<LineString>& lineStrings, floa
       if(lastToAircraft.isValid())
         drawLine(context->painter, lastToAircraft);
 
-      // Split linestring and draw single line segments using different colors for gradient ==========================
+      // Split linestring into runs of segments having the same altitude color bucket ==========================
+      // This avoids a pen change for each segment
+      float altRange = maxAlt - minAlt;
+      QVector<QVector<LineString> > buckets(TRAIL_GRADIENT_BUCKETS);
       for(const LineString& lineString : lineStrings)
       {
+        int lastBucket = -1;
         for(int i = 0; i < lineString.size() - 1; i++)
         {
-          Line line(lineString.at(i), lineString.at(i + 1));
+          const Pos& pos1 = lineString.at(i), &pos2 = lineString.at(i + 1);
 
           // Average altitude between start and end point
-          float alt = static_cast<float>((line.getPos1().getAltitude() + line.getPos2().getAltitude()) / 2.);
+          float alt = (pos1.getAltitude() + pos2.getAltitude()) / 2.f;
+          int bucket = altRange > 0.f ?
+                       atools::minmax(0, TRAIL_GRADIENT_BUCKETS - 1, static_cast<int>((alt - minAlt) / altRange * TRAIL_GRADIENT_BUCKETS)) : 0;
 
-          context->painter->setPen(mapcolors::aircraftTrailPen(context->szF(context->thicknessTrail, 2.f), minAlt, maxAlt, alt));
+          if(bucket != lastBucket)
+          {
+            // Start a new run for this color
+            buckets[bucket].append(LineString(pos1));
+            lastBucket = bucket;
+          }
+          buckets[bucket].last().append(pos2);
+        }
+      }
 
-          // Draw line and force drawing also for very short segments
-          drawLine(context->painter, line, true /* forceDraw */);
+      float penSize = context->szF(context->thicknessTrail, 2.f);
+      for(int bucket = 0; bucket < buckets.size(); bucket++)
+      {
+        const QVector<LineString>& runs = buckets.at(bucket);
+        if(!runs.isEmpty())
+        {
+          // Use altitude at bucket center for color
+          float alt = minAlt + (bucket + 0.5f) * altRange / TRAIL_GRADIENT_BUCKETS;
+          context->painter->setPen(mapcolors::aircraftTrailPen(penSize, minAlt, maxAlt, alt));
+
+          for(const LineString& run : runs)
+            drawPolyline(context->painter, run);
         }
       }
 
       if(lastToAircraft.isValid())
-        drawLine(context->painter, lastToAircraft);
+      {
+        context->painter->setPen(mapcolors::aircraftTrailPen(penSize, minAlt, maxAlt, lastToAircraft.getPos1().getAltitude()));
+        drawLine(context->painter, lastToAircraft, true /* forceDraw */);
+      }
     }
     else
     {
@@ -21,6 +21,7 @@
 #include "common/mapflags.h"
 #include "geo/coordinateconverter.h"
 #include "geo/rect.h"
+#include "mappainter/paintprofiler.h"
 #include "options/optiondata.h"
 
 #include <marble/MarbleGlobal.h>
@@ -264,26 +265,21 @@ struct PaintContext
   textflags::TextFlags airportTextFlagsMinor() const;
   textflags::TextFlags airportTextFlagsRoute(bool drawAsRoute, bool drawAsLog) const;
 
-  void startTimer(const QString& label)
+  /* Measure time for painters or sections in painters. Times for the same id are summed up per frame. */
+  void startTimer(prof::Id id)
   {
-    if(verboseDraw)
-      renderTimesMs.insert(label, QDateTime::currentMSecsSinceEpoch());
+    if(profiler != nullptr)
+      profiler->start(id);
   }
 
-  void endTimer(const QString& label)
+  void endTimer(prof::Id id)
   {
-    if(verboseDraw)
-      renderTimesMs.insert(label, QDateTime::currentMSecsSinceEpoch() - renderTimesMs.value(label));
-  }
-
-  void clearTimer()
-  {
-    if(verboseDraw)
-      renderTimesMs.clear();
+    if(profiler != nullptr)
+      profiler->end(id);
   }
 
   bool verboseDraw = false;
-  QMap<QString, qint64> renderTimesMs;
+  PaintProfiler *profiler = nullptr;
 };
 
 /* Used to collect airports for drawing. Needs to copy airport since it might be removed from the cache. */
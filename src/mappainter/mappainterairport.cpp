@@ -110,8 +110,6 @@ MapPainterAirport::~MapPainterAirport()
 
 void MapPainterAirport::render()
 {
-  context->startTimer("Airport");
-
   QVector<AirportPaintData> visibleAirports;
   collectVisibleAirports(visibleAirports);
 
@@ -176,7 +174,6 @@ void MapPainterAirport::render()
                                      context->mapLayerText->getMaxTextLengthAirport());
     }
   }
-  context->endTimer("Airport");
 }
 
 void MapPainterAirport::collectVisibleAirports(QVector<AirportPaintData>& visibleAirports)
@@ -21,6 +21,7 @@
 #include "atools.h"
 #include "common/mapcolors.h"
 #include "common/textplacement.h"
+#include "geo/linesimplifier.h"
 #include "mapgui/maplayer.h"
 #include "mapgui/mapscale.h"
 #include "query/airspacequeries.h"
@@ -34,11 +35,17 @@
 #include <marble/ViewportParams.h>
 
 #include <QElapsedTimer>
+#include <QSet>
+
+#include <cmath>
 
 using namespace Marble;
 using namespace atools::geo;
 using namespace map;
 
+/* Tolerances to detect straight line - trying all values on array until a sufficiently long line was found */
+const static QVector<float> MAX_ANGLES({5.f, 30.f});
+
 MapPainterAirspace::MapPainterAirspace(MapPaintWidget *mapWidget, MapScale *mapScale, PaintContext *paintContext)
   : MapPainter(mapWidget, mapScale, paintContext)
 {
@@ -49,16 +56,56 @@ MapPainterAirspace::~MapPainterAirspace()
 
 }
 
-void MapPainterAirspace::render()
+MapPainterAirspace::AirspaceCacheEntry& MapPainterAirspace::cacheEntry(const map::MapAirspaceId& id,
+                                                                       const LineString *lineString, int zoomBand,
+                                                                       const MapViewportKey& viewportKey)
 {
-  // Tolerances to detect straight line - trying all values on array until a sufficiently long line was found
-  const static float MAX_ANGLES[] = {5.f, 30.f};
+  AirspaceCacheEntry& entry = airspaceCache[id];
+
+  // Check if source geometry was reloaded or changed
+  if(entry.source != lineString || entry.sourceSize != lineString->size() ||
+     (!lineString->isEmpty() && (entry.sourceFirst != lineString->constFirst() || entry.sourceLast != lineString->constLast())))
+  {
+    entry = AirspaceCacheEntry();
+    entry.source = lineString;
+    entry.sourceSize = lineString->size();
+    if(!lineString->isEmpty())
+    {
+      entry.sourceFirst = lineString->constFirst();
+      entry.sourceLast = lineString->constLast();
+    }
+  }
 
+  if(entry.zoomBand != zoomBand)
+  {
+    // Remove points which cannot be distinguished at this zoom band - tolerance is half a pixel or less
+    entry.zoomBand = zoomBand;
+    entry.simplified = lsimplify::simplify(*lineString, std::ldexp(1.f, zoomBand) / 2.f);
+    entry.viewportKey = MapViewportKey();
+  }
+
+  if(entry.viewportKey != viewportKey)
+  {
+    // Convert to screen polygons probably cutting them and removing duplicate points =====================
+    entry.viewportKey = viewportKey;
+    entry.polygons.clear();
+    entry.lineDists.clear();
+    entry.lineDistsValid = false;
+
+    const QVector<QPolygonF *> polygons = createPolygons(entry.simplified, context->screenRect);
+    for(const QPolygonF *polygon : polygons)
+      entry.polygons.append(*polygon);
+    releasePolygons(polygons);
+  }
+
+  return entry;
+}
+
+void MapPainterAirspace::render()
+{
   if(!context->mapLayer->isAnyAirspace() || !(context->objectTypes.testFlag(map::AIRSPACE)))
     return;
 
-  context->startTimer("Airspace");
-
   // Get online and offline airspace and merge then into one list =============
   const GeoDataLatLonAltBox& curBox = context->viewport->viewLatLonAltBox();
   AirspaceVector airspaces;
@@ -73,19 +120,12 @@ void MapPainterAirspace::render()
   int displayThicknessAirspace = optionData.getDisplayThicknessAirspace();
   int displayTransparencyAirspace = optionData.getDisplayTransparencyAirspace();
 
-  // Collect visible airspaces ==================================================================================
-  struct DrawAirspace
-  {
-    explicit DrawAirspace(const MapAirspace *airspaceParam, const QVector<QPolygonF *> polygonsParam)
-      : airspace(airspaceParam), polygons(polygonsParam)
-    {
-    }
+  // Zoom band for simplification - distance in meter of one pixel rounded down to a power of two
+  int zoomBand = static_cast<int>(std::floor(std::log2(std::max(scale->getMeterPerPixel(), 1.f))));
+  MapViewportKey viewportKey(context->viewport);
 
-    const MapAirspace *airspace;
-    const QVector<QPolygonF *> polygons;
-  };
-
-  QVector<DrawAirspace> visibleAirspaces;
+  // Collect visible airspaces ==================================================================================
+  QVector<const MapAirspace *> visibleAirspaces;
   if(!airspaces.isEmpty())
   {
     Marble::GeoPainter *painter = context->painter;
@@ -124,11 +164,11 @@ void MapPainterAirspace::render()
           if(!context->drawFast)
             painter->setBrush(mapcolors::colorForAirspaceFill(*airspace, displayTransparencyAirspace));
 
-          // Convert to screen polygons probably cutting them and removing duplicate points =====================
-          const QVector<QPolygonF *> polygons = createPolygons(*lineString, context->screenRect);
+          // Get simplified and projected geometry from cache =====================
+          const QVector<QPolygonF>& polygons = cacheEntry(airspace->combinedId(), lineString, zoomBand, viewportKey).polygons;
 
           // Add for text placement later
-          visibleAirspaces.append(DrawAirspace(airspace, polygons));
+          visibleAirspaces.append(airspace);
 
 #ifdef DEBUG_DUMP_AIRSPACE
           static QSet<int> airspacesDumped;
@@ -139,10 +179,10 @@ void MapPainterAirspace::render()
             QString debug("\n" + airspace->name + "," + airspace->multipleCode + "\n");
 
             int i = 0;
-            for(const QPolygonF *poly : polygons)
+            for(const QPolygonF& poly : polygons)
             {
               debug.append("\nQPolygonF polygon({\n");
-              for(const QPointF& pt : *poly)
+              for(const QPointF& pt : poly)
                 /// * 13 */ {0, 3}, /* -> 3 */
                 debug.append(QString("/* %1 */ {%2, %3}, /* ->  */\n").arg(i++).arg(pt.x(), 0, 'f', 1).arg(pt.y(), 0, 'f', 1));
               debug.append("});\n");
@@ -162,7 +202,7 @@ void MapPainterAirspace::render()
             else if(i == 2)
               painter->setPen(QPen(QColor(0, 0, 255, 128), 10.));
 #endif
-            drawPolygon(painter, *polygons.at(i));
+            drawPolygon(painter, polygons.at(i));
           }
 
 #ifdef DEBUG_COLOR_AIRSPACE_POLY_POINTS
@@ -225,12 +265,12 @@ void MapPainterAirspace::render()
       painter->setBackground(mapcolors::textBoxColorAirspace);
       painter->setBackgroundMode(Qt::OpaqueMode);
 
-      for(const DrawAirspace& visibleAirspace : qAsConst(visibleAirspaces))
+      for(const MapAirspace *airspace : qAsConst(visibleAirspaces))
       {
-        const map::MapAirspace *airspace = visibleAirspace.airspace;
+        AirspaceCacheEntry& entry = airspaceCache[airspace->combinedId()];
 
         // Check if layer option enables text display for this airspace type
-        if(airspace->type & context->airspaceTextsByLayer && !visibleAirspace.polygons.isEmpty())
+        if(airspace->type & context->airspaceTextsByLayer && !entry.polygons.isEmpty())
         {
           // Build text depending on options
           QString airspaceText =
@@ -242,27 +282,38 @@ void MapPainterAirspace::render()
             textPen.setColor(textPen.color().darker(150));
             painter->setPen(textPen);
 
+            if(!entry.lineDistsValid)
+            {
+              // Calculate a list of longest line segments which are good for text placement ===========
+              // for each angle tolerance and polygon once for this view
+              for(float maxAngle : MAX_ANGLES)
+              {
+                for(const QPolygonF& polygon : qAsConst(entry.polygons))
+                  entry.lineDists.append(atools::util::PolygonLineDistance::getLongPolygonLines(polygon, context->screenRect, 5,
+                                                                                                maxAngle));
+              }
+              entry.lineDistsValid = true;
+            }
+
             // Iterate over different angle tolerances which combine segments to one
             bool drawn = false;
-            for(float maxAngle : MAX_ANGLES)
+            for(int angleIdx = 0; angleIdx < MAX_ANGLES.size(); angleIdx++)
             {
               // Already painted label - done and exit loop
               if(drawn)
                 break;
 
               // Airspace can consist of more than one polygon for Mercator
-              for(const QPolygonF *polygon : visibleAirspace.polygons)
+              for(int polyIdx = 0; polyIdx < entry.polygons.size(); polyIdx++)
               {
                 // Already painted label - exit loop
                 if(drawn)
                   break;
 
-                // Calculate a list of longest line segments which are good for text placement
-                atools::util::PolygonLineDistances lineDists =
-                  atools::util::PolygonLineDistance::getLongPolygonLines(*polygon, context->screenRect, 5, maxAngle);
+                const QPolygonF *polygon = &entry.polygons.at(polyIdx);
 
                 // Try all lines from longest to shortest until text was drawn
-                for(atools::util::PolygonLineDistance& lineDist : lineDists)
+                for(atools::util::PolygonLineDistance& lineDist : entry.lineDists[angleIdx * entry.polygons.size() + polyIdx])
                 {
                   // Increase distance to line for very long horizontal lines which result in misplaced text due to great circle route
                   float offset = 2.f;
@@ -349,10 +400,18 @@ void MapPainterAirspace::render()
       } // for(const DrawAirspace& drawAirspace : drawAirspaces)
     } // if(context->viewContext == Marble::Still && (name || restrictiveName || type || altitude || com))
 
-    // Delete airspace polygons ====================================================
-    for(const DrawAirspace& drawAirspace : qAsConst(visibleAirspaces))
-      releasePolygons(drawAirspace.polygons);
-
   } // if(!airspaces.isEmpty())
-  context->endTimer("Airspace");
+
+  // Remove airspaces from cache which are not visible anymore ====================================================
+  QSet<map::MapAirspaceId> visibleIds;
+  for(const MapAirspace *airspace : qAsConst(visibleAirspaces))
+    visibleIds.insert(airspace->combinedId());
+
+  for(auto it = airspaceCache.begin(); it != airspaceCache.end();)
+  {
+    if(!visibleIds.contains(it.key()))
+      it = airspaceCache.erase(it);
+    else
+      ++it;
+  }
 }
@@ -20,6 +20,13 @@
 
 #include "mappainter/mappainter.h"
 
+#include "common/mapflags.h"
+#include "geo/linestring.h"
+#include "mapgui/mapviewportkey.h"
+#include "util/polygontools.h"
+
+#include <limits>
+
 namespace Marble {
 class GeoDataLineString;
 }
@@ -28,6 +35,9 @@ class MapWidget;
 
 /*
  * Paints all airspaces/boundaries.
+ *
+ * Keeps a cache of simplified geometry for the current zoom band, projected screen polygons and label
+ * placement candidates for each visible airspace. Polygons are projected again only if the view changes.
  */
 class MapPainterAirspace :
   public MapPainter
@@ -40,6 +50,34 @@ public:
 
   virtual void render() override;
 
+private:
+  /* Cached geometry for one airspace */
+  struct AirspaceCacheEntry
+  {
+    /* Source geometry used to detect changes */
+    const atools::geo::LineString *source = nullptr;
+    int sourceSize = 0;
+    atools::geo::Pos sourceFirst, sourceLast;
+
+    /* Geometry simplified for zoomBand */
+    int zoomBand = std::numeric_limits<int>::min();
+    atools::geo::LineString simplified;
+
+    /* Screen polygons for viewportKey */
+    MapViewportKey viewportKey;
+    QVector<QPolygonF> polygons;
+
+    /* Label placement candidates for polygons and angle tolerances. Built on demand for viewportKey. */
+    bool lineDistsValid = false;
+    QVector<atools::util::PolygonLineDistances> lineDists;
+  };
+
+  /* Get entry and update simplified and projected geometry if needed */
+  AirspaceCacheEntry& cacheEntry(const map::MapAirspaceId& id, const atools::geo::LineString *lineString, int zoomBand,
+                                 const MapViewportKey& viewportKey);
+
+  /* Airspaces visible in the last frame. Others are removed after drawing. */
+  QHash<map::MapAirspaceId, AirspaceCacheEntry> airspaceCache;
 };
 
 #endif // LITTLENAVMAP_MAPPAINTERAIRSPACE_H
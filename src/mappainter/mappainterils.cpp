@@ -49,8 +49,6 @@ void MapPainterIls::render()
 {
   if(context->mapLayer->isIls())
   {
-    context->startTimer("ILS");
-
     // Get ILS from flight plan which are also painted in the profile
     QVector<map::MapIls> routeIls;
     QSet<int> routeIlsIds;
@@ -125,7 +123,6 @@ void MapPainterIls::render()
       if(visible)
         drawIlsSymbol(ils, context->drawFast);
     }
-    context->endTimer("ILS");
   }
 }
 
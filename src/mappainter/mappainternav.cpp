@@ -64,10 +64,10 @@ void MapPainterNav::render()
   if(drawAirway && !context->isObjectOverflow())
   {
     // Draw airway lines
-    context->startTimer("Airway fetch");
+    context->startTimer(prof::NAV_AIRWAY_FETCH);
     QList<MapAirway> airways;
     queries->getAirwayTrackQuery()->getAirways(airways, curBox, context->mapLayer, context->lazyUpdate);
-    context->endTimer("Airway fetch");
+    context->endTimer(prof::NAV_AIRWAY_FETCH);
 
     paintAirways(&airways, context->drawFast, false /* track */);
   }
@@ -77,10 +77,10 @@ void MapPainterNav::render()
   if(drawTrack && !context->isObjectOverflow())
   {
     // Draw track lines
-    context->startTimer("Track fetch");
+    context->startTimer(prof::NAV_TRACK_FETCH);
     QList<MapAirway> tracks;
     queries->getAirwayTrackQuery()->getTracks(tracks, curBox, context->mapLayer, context->lazyUpdate);
-    context->endTimer("Track fetch");
+    context->endTimer(prof::NAV_TRACK_FETCH);
 
     paintAirways(&tracks, context->drawFast, true /* track */);
   }
@@ -103,23 +103,23 @@ void MapPainterNav::render()
   QHash<int, MapNdb> allNdb;
   if((drawAirwayWpV || drawAirwayWpJ || drawTrackWp) && !context->isObjectOverflow())
   {
-    context->startTimer("Waypoint fetch");
+    context->startTimer(prof::NAV_WAYPOINT_FETCH);
     // If airways are drawn we also have to go through waypoints
     QList<MapWaypoint> waypoints;
     waypointQuery->getWaypointsAirway(waypoints, curBox, context->mapLayer, context->lazyUpdate, overflow);
     context->setQueryOverflow(overflow);
-    context->endTimer("Waypoint fetch");
+    context->endTimer(prof::NAV_WAYPOINT_FETCH);
 
-    context->startTimer("Waypoint resolve");
+    context->startTimer(prof::NAV_WAYPOINT_RESOLVE);
     // Resolve all artificial waypoints to the respective radio navaids and also filter by airway/track type
     // Do not copy flight plan waypoints - these are drawn in MapPainterRoute
     mapQuery->resolveWaypointNavaids(waypoints, allWaypoints, allVor, allNdb, false /* flightplan */,
                                      drawNormalWp, drawAirwayWpV, drawAirwayWpJ, drawTrackWp);
-    context->endTimer("Waypoint resolve");
+    context->endTimer(prof::NAV_WAYPOINT_RESOLVE);
   }
 
   // Waypoints -------------------------------------------------
-  context->startTimer("Waypoint draw");
+  context->startTimer(prof::NAV_WAYPOINT_DRAW);
   if(drawNormalWp && !context->isObjectOverflow())
   {
     QList<MapWaypoint> waypoints;
@@ -128,10 +128,10 @@ void MapPainterNav::render()
     maptools::insert(allWaypoints, waypoints);
   }
   paintWaypoints(allWaypoints);
-  context->endTimer("Waypoint draw");
+  context->endTimer(prof::NAV_WAYPOINT_DRAW);
 
   // VOR -------------------------------------------------
-  context->startTimer("VOR");
+  context->startTimer(prof::NAV_VOR);
   if(context->mapLayer->isVor() && context->objectTypes.testFlag(map::VOR) && !context->isObjectOverflow())
   {
     const QList<MapVor> *vors = mapQuery->getVors(curBox, context->mapLayer, context->lazyUpdate, overflow);
@@ -140,10 +140,10 @@ void MapPainterNav::render()
       maptools::insert(allVor, *vors);
   }
   paintVors(allVor, context->drawFast);
-  context->endTimer("VOR");
+  context->endTimer(prof::NAV_VOR);
 
   // NDB -------------------------------------------------
-  context->startTimer("NDB");
+  context->startTimer(prof::NAV_NDB);
   if(context->mapLayer->isNdb() && context->objectTypes.testFlag(map::NDB) && !context->isObjectOverflow())
   {
     const QList<MapNdb> *ndbs = mapQuery->getNdbs(curBox, context->mapLayer, context->lazyUpdate, overflow);
@@ -152,10 +152,10 @@ void MapPainterNav::render()
       maptools::insert(allNdb, *ndbs);
   }
   paintNdbs(allNdb, context->drawFast);
-  context->endTimer("NDB");
+  context->endTimer(prof::NAV_NDB);
 
   // Marker -------------------------------------------------
-  context->startTimer("Marker");
+  context->startTimer(prof::NAV_MARKER);
   if(context->objectTypes.testFlag(map::AIRPORT) &&
      context->mapLayer->isIls() && context->objectTypes.testFlag(map::ILS) &&
      context->mapLayer->isMarker() && context->objectTypes.testFlag(map::MARKER) &&
@@ -167,10 +167,10 @@ void MapPainterNav::render()
     if(markers != nullptr)
       paintMarkers(markers, context->drawFast);
   }
-  context->endTimer("Marker");
+  context->endTimer(prof::NAV_MARKER);
 
   // Holding -------------------------------------------------
-  context->startTimer("Hold");
+  context->startTimer(prof::NAV_HOLD);
   if(context->mapLayer->isHolding() && context->objectTypes.testFlag(map::HOLDING) && !context->isObjectOverflow())
   {
     const QList<MapHolding> *holds = mapQuery->getHoldings(curBox, context->mapLayer, context->lazyUpdate, overflow);
@@ -179,7 +179,7 @@ void MapPainterNav::render()
     if(holds != nullptr)
       paintHoldingMarks(*holds, context->mapLayer, context->mapLayerText, false /* user */, context->drawFast, context->darkMap);
   }
-  context->endTimer("Hold");
+  context->endTimer(prof::NAV_HOLD);
 }
 
 /* Draw airways and texts */
@@ -218,7 +218,7 @@ void MapPainterNav::paintAirways(const QList<map::MapAirway> *airways, bool fast
   QPolygonF arrowTrack = buildArrow(static_cast<float>(linewidthTrack * 2.5));
   Marble::GeoPainter *painter = context->painter;
 
-  context->startTimer(track ? "Track draw" : "Airway draw");
+  context->startTimer(track ? prof::NAV_TRACK_DRAW : prof::NAV_AIRWAY_DRAW);
   for(int i = 0; i < airways->size(); i++)
   {
     const MapAirway& airway = airways->at(i);
@@ -316,9 +316,9 @@ void MapPainterNav::paintAirways(const QList<map::MapAirway> *airways, bool fast
       }
     }
   }
-  context->endTimer(track ? "Track draw" : "Airway draw");
+  context->endTimer(track ? prof::NAV_TRACK_DRAW : prof::NAV_AIRWAY_DRAW);
 
-  context->startTimer(track ? "Track draw text" : "Airway draw text");
+  context->startTimer(track ? prof::NAV_TRACK_TEXT : prof::NAV_AIRWAY_TEXT);
   // Draw texts ----------------------------------------
   TextPlacement textPlacement(painter, this, context->screenRect);
   if(!textlist.isEmpty())
@@ -379,7 +379,7 @@ void MapPainterNav::paintAirways(const QList<map::MapAirway> *airways, bool fast
       }
     }
   }
-  context->endTimer(track ? "Track draw text" : "Airway draw text");
+  context->endTimer(track ? prof::NAV_TRACK_TEXT : prof::NAV_AIRWAY_TEXT);
 }
 
 /* Draw waypoints. If airways are enabled corresponding waypoints are drawn too */
@@ -76,7 +76,7 @@ void MapPainterRoute::render()
   // Draw the approach preview if any selected in the procedure search tab ========================
   if(context->mapLayerRoute->isApproach())
   {
-    context->startTimer("Approach Preview");
+    context->startTimer(prof::ROUTE_APPROACH_PREVIEW);
 
     // Draw multi preview ===========================================================
     QSet<map::MapRef> procIdMapDummy; // No need for de-duplication pass dummy map in
@@ -90,7 +90,7 @@ void MapPainterRoute::render()
       paintProcedure(procIdMapDummy, procedureHighlight, 0, procedureHighlight.previewColor,
                      true /* preview */, false /* previewAll */);
 
-    context->endTimer("Approach Preview");
+    context->endTimer(prof::ROUTE_APPROACH_PREVIEW);
   }
 }
 
@@ -224,7 +224,7 @@ void MapPainterRoute::paintRoute()
     return;
   }
 
-  context->startTimer("Route");
+  context->startTimer(prof::ROUTE_LEGS);
 
   int passedRouteLeg = context->flags2.testFlag(opts2::MAP_ROUTE_DIM_PASSED) ? activeRouteLeg : 0;
 
@@ -286,7 +286,7 @@ void MapPainterRoute::paintRoute()
     // Remember last point across procedures to avoid overlaying text
     if(!mapPaintWidget->isDistanceCutOff())
     {
-      context->startTimer("Route Procedures");
+      context->startTimer(prof::ROUTE_PROCEDURES);
 
       // Draw in reverse flying order to have close legs on top
       const QColor& flightplanProcedureColor = OptionData::instance().getFlightplanProcedureColor();
@@ -306,7 +306,7 @@ void MapPainterRoute::paintRoute()
         paintProcedure(routeProcIdMap, route->getSidLegs(), route->getSidLegsOffset(), flightplanProcedureColor,
                        false /* preview */, false /* previewAll */);
 
-      context->endTimer("Route Procedures");
+      context->endTimer(prof::ROUTE_PROCEDURES);
     }
   }
 
@@ -340,7 +340,7 @@ void MapPainterRoute::paintRoute()
   }
   context->painter->restore();
 #endif
-  context->endTimer("Route");
+  context->endTimer(prof::ROUTE_LEGS);
 
   // Draw TOD and TOC markers ======================
   if(context->objectDisplayTypes.testFlag(map::FLIGHTPLAN_TOC_TOD) && context->mapLayerRoute->isRouteTextAndDetail())
@@ -764,7 +764,7 @@ void MapPainterRoute::paintTopOfDescentAndClimb()
   if(route->getSizeWithoutAlternates() >= 2)
   {
     atools::util::PainterContextSaver saver(context->painter);
-    context->startTimer("Route TOC TOD");
+    context->startTimer(prof::ROUTE_TOC_TOD);
 
     float width = context->szF(context->symbolSizeNavaid, 3.f);
     float radius = context->szF(context->symbolSizeNavaid, 6.f);
@@ -820,7 +820,7 @@ void MapPainterRoute::paintTopOfDescentAndClimb()
         }
       }
     }
-    context->endTimer("Route TOC TOD");
+    context->endTimer(prof::ROUTE_TOC_TOD);
   }
 }
 
@@ -165,8 +165,9 @@ void MapPainterTop::render()
     labels.append(QString("Min RW %1").arg(context->mapLayer->getMinRunwayLength()));
     labels.append("-");
 
-    for(auto it = context->renderTimesMs.constBegin(); it != context->renderTimesMs.constEnd(); ++it)
-      labels.append(QString("%1: %2 ms").arg(it.key()).arg(it.value()));
+    // Statistics up to the previous frame since this one is not finished yet
+    if(context->profiler != nullptr)
+      labels.append(context->profiler->getOverlayText());
 
     symbolPainter->textBox(context->painter, labels, QPen(Qt::black), 1, 1, textatt::BELOW);
   }
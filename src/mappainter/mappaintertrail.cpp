@@ -77,10 +77,11 @@ void MapPainterTrail::render()
       if(context->route->getSizeWithoutAlternates() > 2)
         maxAltitude = std::max(context->route->getCruiseAltitudeFt(), maxAltitude);
 
-      context->startTimer("Aircraft Trail");
       atools::util::PainterContextSaver saver(context->painter);
-      paintAircraftTrail(aircraftTrail.getLineStrings(), aircraftTrail.getMinAltitude(), maxAltitude, aircraftPos);
-      context->endTimer("Aircraft Trail");
+
+      // Use a simplified trail where the error is below half a pixel
+      const QVector<atools::geo::LineString>& lineStrings = aircraftTrail.getLineStrings(scale->getMeterPerPixel() / 2.f);
+      paintAircraftTrail(lineStrings, aircraftTrail.getMinAltitude(), maxAltitude, aircraftPos);
     }
   }
 }
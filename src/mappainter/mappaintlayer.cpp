@@ -17,12 +17,16 @@
 
 #include "mappainter/mappaintlayer.h"
 
+#include "airspace/airspacecontroller.h"
 #include "app/navapp.h"
 #include "common/constants.h"
 #include "common/mapcolors.h"
 #include "geo/calculations.h"
+#include "fs/sc/simconnectuseraircraft.h"
 #include "geo/marbleconverter.h"
+#include "logbook/logdatacontroller.h"
 #include "mapgui/maplayersettings.h"
+#include "mapgui/mapprefetcher.h"
 #include "mapgui/mapscale.h"
 #include "mapgui/mapwidget.h"
 #include "mappainter/mappainteraiaircraft.h"
@@ -41,11 +45,14 @@
 #include "mappainter/mappainteruseraircraft.h"
 #include "mappainter/mappainterweather.h"
 #include "mappainter/mappainterwind.h"
+#include "online/onlinedatacontroller.h"
 #include "options/optiondata.h"
 #include "route/route.h"
+#include "route/routecontroller.h"
 #include "settings/settings.h"
 #include "userdata/userdatacontroller.h"
 
+#include <QDateTime>
 #include <QElapsedTimer>
 
 #include <marble/GeoPainter.h>
@@ -53,6 +60,10 @@
 using namespace Marble;
 using namespace atools::geo;
 
+/* Paint base layers again after this time even if only the aircraft moved. Catches other changes like weather
+ * updates which were merged into a simulator repaint. */
+const static qint64 BASE_LAYER_CACHE_MAX_AGE_MS = 2000L;
+
 MapPaintLayer::MapPaintLayer(MapPaintWidget *widget)
   : mapPaintWidget(widget)
 {
@@ -64,6 +75,10 @@ MapPaintLayer::MapPaintLayer(MapPaintWidget *widget)
   initMapLayerSettings();
 
   mapScale = new MapScale();
+  profiler = new PaintProfiler();
+
+  if(mapPaintWidget->isVisibleWidget())
+    prefetcher = new MapPrefetcher(mapPaintWidget);
 
   // Create all painters
   mapPainterNav = new MapPainterNav(mapPaintWidget, mapScale, &context);
@@ -91,6 +106,8 @@ MapPaintLayer::MapPaintLayer(MapPaintWidget *widget)
 
 MapPaintLayer::~MapPaintLayer()
 {
+  delete prefetcher;
+
   delete mapPainterNav;
   delete mapPainterIls;
   delete mapPainterAirport;
@@ -110,6 +127,7 @@ MapPaintLayer::~MapPaintLayer()
 
   delete layers;
   delete mapScale;
+  delete profiler;
 }
 
 void MapPaintLayer::copySettings(const MapPaintLayer& other)
@@ -127,6 +145,10 @@ void MapPaintLayer::copySettings(const MapPaintLayer& other)
 void MapPaintLayer::preDatabaseLoad()
 {
   databaseLoadStatus = true;
+
+  // Drop predictions and wait for background queries before connections are closed
+  if(prefetcher != nullptr)
+    prefetcher->cancel();
 }
 
 void MapPaintLayer::postDatabaseLoad()
@@ -321,11 +343,9 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
       qDebug() << Q_FUNC_INFO << "layer" << *mapLayer;
 #endif
 
-      // Clear the airport id cache
-      shownDetailAirportIds.clear();
-
       // Prepare context =====================================================
       context = PaintContext();
+      context.profiler = profiler;
       context.shownDetailAirportIds = &shownDetailAirportIds;
       context.route = &NavApp::getRouteConst();
       context.mapLayer = mapLayer;
@@ -417,10 +437,11 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
       context.visibleWidget = mapPaintWidget->isVisibleWidget();
 
       // Prepare index for all navaids drawn by route - needed for context menu and tooltips
+      // Cleared when drawing base layers
       context.routeDrawnNavaids = mapPaintWidget->getRouteDrawnNavaids();
-      context.routeDrawnNavaids->clear();
 
-      context.startTimer("All");
+      profiler->beginFrame();
+      context.startTimer(prof::ALL);
       setNoAntiAliasFont();
 
       // ====================================
@@ -547,68 +568,81 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
 
       // =========================================================================
       // Draw ====================================
-
-      // Altitude below all others
-      mapPainterAltitude->render();
-
-      // Ship below other navaids and airports
-      mapPainterShip->render();
-
-      if(!mapPaintWidget->isDistanceCutOff())
+      // Cache base layers only for the visible map while connected and not moving the map
+      bool useCache = NavApp::isConnected() && still && mapPaintWidget->isVisibleWidget() && !mapPaintWidget->isPrinting();
+
+      BaseLayerKey key;
+      key.viewportKey = MapViewportKey(viewport);
+      key.mapLayer = mapLayer;
+      key.objectTypes = objectTypes;
+      key.objectDisplayTypes = objectDisplayTypes;
+      key.airspaceFilter = context.airspaceFilterByLayer;
+      key.activeLegIndex = context.route->getActiveLegIndex();
+      key.routeSize = context.route->size();
+      key.minimumRunwayLengthFt = minimumRunwayLengthFt;
+      if(useCache)
       {
-        if(!context.isObjectOverflow())
-          mapPainterAirspace->render();
+        // Controllers are created after the map widget - read only when caching
+        key.routeVersion = NavApp::getRouteController()->getRouteVersion();
+        key.userdataVersion = NavApp::getUserdataController()->getUserdataVersion();
+        key.logdataVersion = NavApp::getLogdataController()->getLogdataVersion();
+        key.onlineVersion = NavApp::getOnlinedataController()->getOnlineVersion();
+        key.airspaceVersion = NavApp::getAirspaceController()->getAirspaceVersion();
+      }
 
-        if(!context.isObjectOverflow())
-          mapPainterIls->render();
+      qint64 now = QDateTime::currentMSecsSinceEpoch();
+      if(useCache && simUpdateOnly && !baseLayerCache.isNull() && baseLayerCacheKey == key &&
+         now - baseLayerCacheTimestampMs < BASE_LAYER_CACHE_MAX_AGE_MS)
+      {
+        // Only aircraft moved - reuse image of base layers and restore the counters
+        prof::count(prof::BASE_LAYER_CACHE_HIT);
+        context.startTimer(prof::BASE_LAYER_COPY);
+        painter->drawPixmap(QPoint(0, 0), baseLayerCache);
+        context.endTimer(prof::BASE_LAYER_COPY);
+        context.objectCount = baseLayerCacheObjectCount;
+        context.queryOverflow = baseLayerCacheQueryOverflow;
+      }
+      else if(useCache)
+      {
+        // Paint base layers into transparent image and keep it for following simulator updates
+        prof::count(prof::BASE_LAYER_CACHE_MISS);
+        qreal pixelRatio = painter->device()->devicePixelRatioF();
+        baseLayerCache = QPixmap(viewport->size() * pixelRatio);
+        baseLayerCache.setDevicePixelRatio(pixelRatio);
+        baseLayerCache.fill(Qt::transparent);
 
-        if(context.mapLayer->isAirportDiagram())
         {
-          if(!context.isObjectOverflow())
-            mapPainterAirport->render();
+          GeoPainter cachePainter(&baseLayerCache, viewport, mapPaintWidget->mapQuality());
+          cachePainter.setFont(painter->font());
+          cachePainter.setRenderHints(painter->renderHints());
 
-          if(!context.isObjectOverflow())
-            mapPainterNav->render();
+          context.painter = &cachePainter;
+          renderBaseLayers();
+          context.painter = painter;
         }
-        else
-        {
-          if(!context.isObjectOverflow())
-            mapPainterMsa->render();
 
-          if(!context.isObjectOverflow())
-            mapPainterNav->render();
-
-          if(!context.isObjectOverflow())
-            mapPainterAirport->render();
-        }
+        context.startTimer(prof::BASE_LAYER_COPY);
+        painter->drawPixmap(QPoint(0, 0), baseLayerCache);
+        context.endTimer(prof::BASE_LAYER_COPY);
+        baseLayerCacheKey = key;
+        baseLayerCacheTimestampMs = now;
+        baseLayerCacheObjectCount = context.objectCount;
+        baseLayerCacheQueryOverflow = context.queryOverflow;
       }
+      else
+      {
+        // Free memory
+        baseLayerCache = QPixmap();
+        renderBaseLayers();
+      }
+      simUpdateOnly = false;
 
-      if(!context.isObjectOverflow())
-        mapPainterUser->render();
-
-      if(!context.isObjectOverflow())
-        mapPainterWind->render();
-
-      // if(!context.isOverflow()) always paint route even if number of objects is too large
-      mapPainterRoute->render();
-
-      if(!context.isObjectOverflow())
-        mapPainterWeather->render();
-
-      if(context.mapLayer->isAirportDiagram() && !context.isObjectOverflow())
-        mapPainterMsa->render();
-
-      if(!context.isObjectOverflow())
-        mapPainterTrail->render();
-
-      mapPainterMark->render();
-      mapPainterAiAircraft->render();
-      mapPainterUserAircraft->render();
+      renderDynamicLayers();
 
       resetNoAntiAliasFont();
-      context.endTimer("All");
+      context.endTimer(prof::ALL);
 
-      mapPainterTop->render();
+      renderPainter(mapPainterTop, prof::TOP);
 
       if(debugTileSize)
       {
@@ -621,6 +655,21 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
         context.painter->drawText(mapPaintWidget->geometry().center(), QString("%1x%2").
                                   arg(mapPaintWidget->width()).arg(mapPaintWidget->height()));
       }
+
+      profiler->endFrame();
+
+      if(prefetcher != nullptr && !mapPaintWidget->isPrinting())
+      {
+        // Load objects for the next views in background
+        const atools::fs::sc::SimConnectUserAircraft& aircraft = mapPaintWidget->getUserAircraft();
+        bool follow = mapPaintWidget->isFollowingAircraft() && aircraft.isFullyValid();
+        auto layerFunc = [this](float distanceKm) -> const MapLayer * {
+                           return layers->getLayer(distanceKm, detailLevel);
+                         };
+
+        prefetcher->frameRendered(viewport->viewLatLonAltBox(), context.distanceKm, mapLayer, objectTypes, layerFunc,
+                                  follow ? aircraft.getPosition() : Pos(), aircraft.getTrackDegTrue(), aircraft.getGroundSpeedKts());
+      }
     } // if(!noRender())
 
     if(!mapPaintWidget->isPrinting() && mapPaintWidget->isVisibleWidget())
@@ -630,6 +679,90 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
   return true;
 }
 
+void MapPaintLayer::renderBaseLayers()
+{
+  // Clear the airport id cache and navaids drawn by route which are filled by painters
+  shownDetailAirportIds.clear();
+  context.routeDrawnNavaids->clear();
+
+  // Altitude below all others
+  renderPainter(mapPainterAltitude, prof::ALTITUDE);
+
+  // Ship below other navaids and airports
+  renderPainter(mapPainterShip, prof::SHIP);
+
+  if(!mapPaintWidget->isDistanceCutOff())
+  {
+    if(!context.isObjectOverflow())
+      renderPainter(mapPainterAirspace, prof::AIRSPACE);
+
+    if(!context.isObjectOverflow())
+      renderPainter(mapPainterIls, prof::ILS);
+
+    if(context.mapLayer->isAirportDiagram())
+    {
+      if(!context.isObjectOverflow())
+        renderPainter(mapPainterAirport, prof::AIRPORT);
+
+      if(!context.isObjectOverflow())
+        renderPainter(mapPainterNav, prof::NAV);
+    }
+    else
+    {
+      if(!context.isObjectOverflow())
+        renderPainter(mapPainterMsa, prof::MSA);
+
+      if(!context.isObjectOverflow())
+        renderPainter(mapPainterNav, prof::NAV);
+
+      if(!context.isObjectOverflow())
+        renderPainter(mapPainterAirport, prof::AIRPORT);
+    }
+  }
+
+  if(!context.isObjectOverflow())
+    renderPainter(mapPainterUser, prof::USER);
+
+  if(!context.isObjectOverflow())
+    renderPainter(mapPainterWind, prof::WIND);
+
+  // if(!context.isOverflow()) always paint route even if number of objects is too large
+  renderPainter(mapPainterRoute, prof::ROUTE);
+
+  if(!context.isObjectOverflow())
+    renderPainter(mapPainterWeather, prof::WEATHER);
+
+  if(context.mapLayer->isAirportDiagram() && !context.isObjectOverflow())
+    renderPainter(mapPainterMsa, prof::MSA);
+}
+
+void MapPaintLayer::renderDynamicLayers()
+{
+  if(!context.isObjectOverflow())
+    renderPainter(mapPainterTrail, prof::TRAIL);
+
+  renderPainter(mapPainterMark, prof::MARK);
+  renderPainter(mapPainterAiAircraft, prof::AI_AIRCRAFT);
+  renderPainter(mapPainterUserAircraft, prof::USER_AIRCRAFT);
+}
+
+void MapPaintLayer::renderPainter(MapPainter *painter, prof::Id id)
+{
+  context.startTimer(id);
+  painter->render();
+  context.endTimer(id);
+}
+
+bool MapPaintLayer::BaseLayerKey::operator==(const BaseLayerKey& other) const
+{
+  return viewportKey == other.viewportKey && mapLayer == other.mapLayer && objectTypes == other.objectTypes &&
+         objectDisplayTypes == other.objectDisplayTypes && airspaceFilter == other.airspaceFilter &&
+         activeLegIndex == other.activeLegIndex && routeSize == other.routeSize &&
+         minimumRunwayLengthFt == other.minimumRunwayLengthFt && routeVersion == other.routeVersion &&
+         userdataVersion == other.userdataVersion && logdataVersion == other.logdataVersion &&
+         onlineVersion == other.onlineVersion && airspaceVersion == other.airspaceVersion;
+}
+
 void MapPaintLayer::setNoAntiAliasFont()
 {
   if(context.viewContext == Marble::Animation)
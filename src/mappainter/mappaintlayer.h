@@ -19,8 +19,10 @@
 #define LITTLENAVMAP_MAPPAINTLAYER_H
 
 #include "mappainter/mappainter.h"
+#include "mapgui/mapviewportkey.h"
 
 #include <QPen>
+#include <QPixmap>
 
 #include <marble/LayerInterface.h>
 
@@ -52,6 +54,7 @@ class MapPainterAltitude;
 class MapPainterWeather;
 class MapPainterWind;
 class MapPaintWidget;
+class MapPrefetcher;
 
 /*
  * Implements the Marble layer interface that paints upon the Marble map. Contains all painter instances
@@ -193,6 +196,30 @@ public:
     return shownDetailAirportIds;
   }
 
+  /* Next repaint is caused by simulator aircraft updates only. Allows to reuse the cached navigation layers
+   * if the view did not change. */
+  void setSimUpdateOnly()
+  {
+    simUpdateOnly = true;
+  }
+
+  /* Next repaint has other causes than simulator updates. Overrides setSimUpdateOnly() if not painted yet. */
+  void clearSimUpdateOnly()
+  {
+    simUpdateOnly = false;
+  }
+
+  /* Paint times and counters. Always enabled. */
+  const PaintProfiler *getProfiler() const
+  {
+    return profiler;
+  }
+
+  PaintProfiler *getProfiler()
+  {
+    return profiler;
+  }
+
 private:
   void initMapLayerSettings();
 
@@ -205,6 +232,15 @@ private:
   // Implemented from LayerInterface
   virtual bool render(Marble::GeoPainter *painter, Marble::ViewportParams *viewport, const QString&, Marble::GeoSceneLayer *) override;
 
+  /* Paint all layers below the aircraft trail which do not change with simulator updates */
+  void renderBaseLayers();
+
+  /* Paint the trail, marks and aircraft on top of base layers */
+  void renderDynamicLayers();
+
+  /* Call render on the painter and measure time */
+  void renderPainter(MapPainter *painter, prof::Id id);
+
   /* Disable font anti-aliasing for default and painter font */
   void setNoAntiAliasFont();
 
@@ -231,6 +267,10 @@ private:
   bool databaseLoadStatus = false;
 
   PaintContext context;
+  PaintProfiler *profiler;
+
+  /* Loads objects for predicted views in background. Only for the visible map widget. */
+  MapPrefetcher *prefetcher = nullptr;
 
   /* All painters */
   MapPainterAirport *mapPainterAirport;
@@ -258,6 +298,34 @@ private:
   bool verbose = false, verboseDraw = false, debugTileSize = false;
   QFont::StyleStrategy savedFontStrategy, savedDefaultFontStrategy;
 
+  /* State which requires a new base layer image if changed */
+  struct BaseLayerKey
+  {
+    MapViewportKey viewportKey;
+    const MapLayer *mapLayer = nullptr;
+    map::MapTypes objectTypes = map::NONE;
+    map::MapDisplayTypes objectDisplayTypes = map::DISPLAY_TYPE_NONE;
+    map::MapAirspaceFilter airspaceFilter;
+    int activeLegIndex = -1, routeSize = 0, minimumRunwayLengthFt = 0;
+
+    /* Change counters of flight plan and data sources shown in base layers */
+    quint64 routeVersion = 0, userdataVersion = 0, logdataVersion = 0, onlineVersion = 0, airspaceVersion = 0;
+
+    bool operator==(const BaseLayerKey& other) const;
+
+    bool operator!=(const BaseLayerKey& other) const
+    {
+      return !(*this == other);
+    }
+  };
+
+  /* Offscreen image of all base layers. Only kept while connected to a simulator. */
+  QPixmap baseLayerCache;
+  BaseLayerKey baseLayerCacheKey;
+  qint64 baseLayerCacheTimestampMs = 0L;
+  int baseLayerCacheObjectCount = 0;
+  bool baseLayerCacheQueryOverflow = false, simUpdateOnly = false;
+
 };
 
 #endif // LITTLENAVMAP_MAPPAINTLAYER_H
@@ -0,0 +1,256 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mappainter/paintprofiler.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <atomic>
+
+namespace prof {
+
+static std::atomic<quint64> counters[prof::NUM_COUNTERS];
+
+void count(Counter counter)
+{
+  counters[counter].fetch_add(1, std::memory_order_relaxed);
+}
+
+quint64 counterValue(Counter counter)
+{
+  return counters[counter].load(std::memory_order_relaxed);
+}
+
+}
+
+/* Names used in overlay and JSON. Order has to match prof::Id. */
+static const char *ID_NAMES[prof::NUM_IDS] =
+{
+  "all",
+  "altitude",
+  "ship",
+  "airspace",
+  "ils",
+  "msa",
+  "nav",
+  "airport",
+  "user",
+  "wind",
+  "route",
+  "weather",
+  "trail",
+  "mark",
+  "ai_aircraft",
+  "user_aircraft",
+  "top",
+  "base_layer_copy",
+  "route_legs",
+  "route_procedures",
+  "route_toc_tod",
+  "route_approach_preview",
+  "nav_airway_fetch",
+  "nav_track_fetch",
+  "nav_airway_draw",
+  "nav_track_draw",
+  "nav_airway_text",
+  "nav_track_text",
+  "nav_waypoint_fetch",
+  "nav_waypoint_resolve",
+  "nav_waypoint_draw",
+  "nav_vor",
+  "nav_ndb",
+  "nav_marker",
+  "nav_hold"
+};
+
+/* Order has to match prof::Counter */
+static const char *COUNTER_NAMES[prof::NUM_COUNTERS] =
+{
+  "rect_cache_hit",
+  "rect_cache_miss",
+  "record_cache_hit",
+  "record_cache_miss",
+  "base_layer_cache_hit",
+  "base_layer_cache_miss",
+  "tile_index_hit",
+  "tile_index_miss"
+};
+
+// ======= PaintProfiler::Histogram ===============================================================
+void PaintProfiler::Histogram::add(qint64 ns)
+{
+  // Find logarithmic bucket for microseconds
+  qint64 us = ns / 1000L;
+  int bucket = 0;
+  while(us > 0 && bucket < NUM_BUCKETS - 1)
+  {
+    us >>= 1;
+    bucket++;
+  }
+
+  buckets[static_cast<size_t>(bucket)]++;
+  samples++;
+  sumNs += ns;
+  maxNs = std::max(maxNs, ns);
+  lastNs = ns;
+}
+
+qint64 PaintProfiler::Histogram::percentileNs(double fraction) const
+{
+  quint32 limit = static_cast<quint32>(samples * fraction), sum = 0;
+  for(int i = 0; i < NUM_BUCKETS; i++)
+  {
+    sum += buckets.at(static_cast<size_t>(i));
+    if(sum > limit || sum == samples)
+      // Upper bound of bucket but not more than the worst case
+      return std::min((Q_INT64_C(1) << i) * Q_INT64_C(1000), maxNs);
+  }
+  return maxNs;
+}
+
+// ======= PaintProfiler ===============================================================
+PaintProfiler::PaintProfiler()
+{
+  timer.start();
+  reset();
+}
+
+void PaintProfiler::reset()
+{
+  startNs.fill(0L);
+  frameNs.fill(0L);
+  frameUsed.fill(false);
+  histograms.fill(Histogram());
+
+  frameCounters.fill(0L);
+  counterTotals.fill(0L);
+  for(int i = 0; i < prof::NUM_COUNTERS; i++)
+    frameCounterStart[static_cast<size_t>(i)] = prof::counterValue(static_cast<prof::Counter>(i));
+
+  numFrames = 0;
+}
+
+void PaintProfiler::beginFrame()
+{
+  frameNs.fill(0L);
+  frameUsed.fill(false);
+
+  for(int i = 0; i < prof::NUM_COUNTERS; i++)
+    frameCounterStart[static_cast<size_t>(i)] = prof::counterValue(static_cast<prof::Counter>(i));
+}
+
+void PaintProfiler::endFrame()
+{
+  for(size_t i = 0; i < prof::NUM_IDS; i++)
+  {
+    if(frameUsed.at(i))
+      histograms[i].add(frameNs.at(i));
+  }
+
+  for(int i = 0; i < prof::NUM_COUNTERS; i++)
+  {
+    size_t idx = static_cast<size_t>(i);
+    frameCounters[idx] = prof::counterValue(static_cast<prof::Counter>(i)) - frameCounterStart.at(idx);
+    counterTotals[idx] += frameCounters.at(idx);
+  }
+
+  numFrames++;
+}
+
+QString PaintProfiler::getName(prof::Id id)
+{
+  return QLatin1String(ID_NAMES[id]);
+}
+
+QString PaintProfiler::getName(prof::Counter counter)
+{
+  return QLatin1String(COUNTER_NAMES[counter]);
+}
+
+QStringList PaintProfiler::getOverlayText() const
+{
+  QStringList labels;
+  labels.append(QString("Frames %1").arg(numFrames));
+
+  // Last value, average and 95th percentile in milliseconds
+  for(size_t i = 0; i < prof::NUM_IDS; i++)
+  {
+    const Histogram& hist = histograms.at(i);
+    if(hist.samples > 0)
+      labels.append(QString("%1: %2 ms (avg %3, p95 %4)").
+                    arg(getName(static_cast<prof::Id>(i))).
+                    arg(hist.lastNs / 1000000., 0, 'f', 3).
+                    arg(hist.sumNs / 1000000. / hist.samples, 0, 'f', 3).
+                    arg(hist.percentileNs(0.95) / 1000000., 0, 'f', 3));
+  }
+
+  labels.append("-");
+  for(size_t i = 0; i < prof::NUM_COUNTERS; i++)
+    labels.append(QString("%1: %2 (total %3)").
+                  arg(getName(static_cast<prof::Counter>(i))).arg(frameCounters.at(i)).arg(counterTotals.at(i)));
+
+  return labels;
+}
+
+QJsonObject PaintProfiler::getJson() const
+{
+  QJsonObject timers;
+  for(size_t i = 0; i < prof::NUM_IDS; i++)
+  {
+    const Histogram& hist = histograms.at(i);
+    if(hist.samples > 0)
+    {
+      QJsonObject timer;
+      timer.insert("samples", static_cast<qint64>(hist.samples));
+      timer.insert("last_ms", hist.lastNs / 1000000.);
+      timer.insert("avg_ms", hist.sumNs / 1000000. / hist.samples);
+      timer.insert("max_ms", hist.maxNs / 1000000.);
+      timer.insert("p50_ms", hist.percentileNs(0.5) / 1000000.);
+      timer.insert("p95_ms", hist.percentileNs(0.95) / 1000000.);
+      timer.insert("p99_ms", hist.percentileNs(0.99) / 1000000.);
+
+      // Bucket counts - index i covers 2^(i-1) to 2^i microseconds - trailing empty buckets are omitted
+      int last = NUM_BUCKETS - 1;
+      while(last > 0 && hist.buckets.at(static_cast<size_t>(last)) == 0)
+        last--;
+
+      QJsonArray buckets;
+      for(int b = 0; b <= last; b++)
+        buckets.append(static_cast<qint64>(hist.buckets.at(static_cast<size_t>(b))));
+      timer.insert("buckets_us_log2", buckets);
+
+      timers.insert(getName(static_cast<prof::Id>(i)), timer);
+    }
+  }
+
+  QJsonObject counters;
+  for(size_t i = 0; i < prof::NUM_COUNTERS; i++)
+  {
+    QJsonObject counter;
+    counter.insert("last_frame", static_cast<qint64>(frameCounters.at(i)));
+    counter.insert("total", static_cast<qint64>(counterTotals.at(i)));
+    counters.insert(getName(static_cast<prof::Counter>(i)), counter);
+  }
+
+  QJsonObject json;
+  json.insert("frames", numFrames);
+  json.insert("timers", timers);
+  json.insert("counters", counters);
+  return json;
+}
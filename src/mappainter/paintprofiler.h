@@ -0,0 +1,185 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_PAINTPROFILER_H
+#define LNM_PAINTPROFILER_H
+
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <array>
+
+class QJsonObject;
+
+namespace prof {
+
+/* Timer ids. Whole painters are measured by MapPaintLayer while the others are sections inside painters. */
+enum Id : int
+{
+  ALL, /* All painters except top */
+
+  /* Painters */
+  ALTITUDE,
+  SHIP,
+  AIRSPACE,
+  ILS,
+  MSA,
+  NAV,
+  AIRPORT,
+  USER,
+  WIND,
+  ROUTE,
+  WEATHER,
+  TRAIL,
+  MARK,
+  AI_AIRCRAFT,
+  USER_AIRCRAFT,
+  TOP,
+  BASE_LAYER_COPY, /* Drawing the cached base layer image */
+
+  /* Sections in painters */
+  ROUTE_LEGS,
+  ROUTE_PROCEDURES,
+  ROUTE_TOC_TOD,
+  ROUTE_APPROACH_PREVIEW,
+  NAV_AIRWAY_FETCH,
+  NAV_TRACK_FETCH,
+  NAV_AIRWAY_DRAW,
+  NAV_TRACK_DRAW,
+  NAV_AIRWAY_TEXT,
+  NAV_TRACK_TEXT,
+  NAV_WAYPOINT_FETCH,
+  NAV_WAYPOINT_RESOLVE,
+  NAV_WAYPOINT_DRAW,
+  NAV_VOR,
+  NAV_NDB,
+  NAV_MARKER,
+  NAV_HOLD,
+
+  NUM_IDS
+};
+
+/* Process wide event counters. Can be incremented from any thread. */
+enum Counter : int
+{
+  RECT_CACHE_HIT, /* Rect cache covered the view */
+  RECT_CACHE_MISS, /* Rect cache was cleared and objects have to be queried */
+  RECORD_CACHE_HIT, /* Record found in QCache */
+  RECORD_CACHE_MISS, /* Query executed for record */
+  BASE_LAYER_CACHE_HIT, /* Base layer image reused */
+  BASE_LAYER_CACHE_MISS, /* Base layer image painted */
+  TILE_INDEX_HIT, /* Tile of the map object index found in memory */
+  TILE_INDEX_MISS, /* Tile of the map object index loaded from database */
+
+  NUM_COUNTERS
+};
+
+/* Increment counter. Lock free and cheap enough for query code. */
+void count(prof::Counter counter);
+
+/* Get current value of the counter */
+quint64 counterValue(prof::Counter counter);
+
+}
+
+/*
+ * Low overhead profiler for map painting which is always enabled.
+ *
+ * Uses nanoseconds from a monotonic clock and fixed integer ids to avoid string handling and lookups.
+ * Each frame is bracketed by beginFrame() and endFrame(). Times for the same id are summed up within a frame
+ * and added to a logarithmic histogram at the end of the frame. Counter differences per frame are collected too.
+ *
+ * Not thread safe. Has to be used from the thread painting the map.
+ */
+class PaintProfiler
+{
+public:
+  PaintProfiler();
+
+  /* Clear all per frame values and remember counter state */
+  void beginFrame();
+
+  /* Add all times measured in this frame to histograms */
+  void endFrame();
+
+  void start(prof::Id id)
+  {
+    startNs[id] = timer.nsecsElapsed();
+  }
+
+  void end(prof::Id id)
+  {
+    frameNs[id] += timer.nsecsElapsed() - startNs[id];
+    frameUsed[id] = true;
+  }
+
+  /* Clear all histograms and totals */
+  void reset();
+
+  /* Lines for the debug overlay showing last frame and statistics */
+  QStringList getOverlayText() const;
+
+  /* Statistics for all ids with at least one sample and counters */
+  QJsonObject getJson() const;
+
+  int getNumFrames() const
+  {
+    return numFrames;
+  }
+
+  /* Time of the id in the last finished frame or -1 if not measured */
+  qint64 getLastFrameNs(prof::Id id) const
+  {
+    return frameUsed.at(id) ? frameNs.at(id) : -1L;
+  }
+
+  /* Counter difference in the last finished frame */
+  quint64 getLastFrameCounter(prof::Counter counter) const
+  {
+    return frameCounters.at(counter);
+  }
+
+  static QString getName(prof::Id id);
+  static QString getName(prof::Counter counter);
+
+private:
+  /* Bucket i covers durations from 2^(i-1) to 2^i microseconds. Last bucket gets all above. */
+  const static int NUM_BUCKETS = 24;
+
+  struct Histogram
+  {
+    std::array<quint32, NUM_BUCKETS> buckets = {};
+    quint32 samples = 0;
+    qint64 sumNs = 0L, maxNs = 0L, lastNs = 0L;
+
+    void add(qint64 ns);
+
+    /* Upper bound of the bucket containing the given fraction of samples in nanoseconds */
+    qint64 percentileNs(double fraction) const;
+  };
+
+  QElapsedTimer timer;
+  std::array<qint64, prof::NUM_IDS> startNs, frameNs;
+  std::array<bool, prof::NUM_IDS> frameUsed;
+  std::array<Histogram, prof::NUM_IDS> histograms;
+
+  /* Counter values at frame start and sums of differences over all frames */
+  std::array<quint64, prof::NUM_COUNTERS> frameCounterStart, frameCounters, counterTotals;
+  int numFrames = 0;
+};
+
+#endif // LNM_PAINTPROFILER_H
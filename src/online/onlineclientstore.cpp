@@ -0,0 +1,131 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "online/onlineclientstore.h"
+
+#include "fs/online/onlinedatamanager.h"
+#include "sql/sqlquery.h"
+
+#include <marble/GeoDataLatLonBox.h>
+
+#include <algorithm>
+#include <cmath>
+
+void OnlineClientStore::load(atools::sql::SqlDatabase *db)
+{
+  clear();
+
+  const static atools::fs::sc::SimConnectAircraft EMPTY_SIM_AIRCRAFT;
+
+  atools::sql::SqlQuery query(db);
+  query.exec("select * from client");
+  while(query.next())
+  {
+    atools::sql::SqlRecord record = query.record();
+
+    atools::fs::sc::SimConnectAircraft ac;
+    atools::fs::online::OnlinedataManager::fillFromClient(ac, record, EMPTY_SIM_AIRCRAFT);
+
+    idToIndex.insert(record.valueInt("client_id"), ids.size());
+    ids.append(record.valueInt("client_id"));
+    lonX.append(ac.getPosition().getLonX());
+    latY.append(ac.getPosition().getLatY());
+    aircraft.append(ac);
+    records.append(record);
+  }
+
+  updateGrid();
+}
+
+void OnlineClientStore::clear()
+{
+  ids.clear();
+  lonX.clear();
+  latY.clear();
+  aircraft.clear();
+  records.clear();
+  idToIndex.clear();
+  cellStart.clear();
+  cellIndexes.clear();
+}
+
+void OnlineClientStore::swap(OnlineClientStore& other)
+{
+  ids.swap(other.ids);
+  lonX.swap(other.lonX);
+  latY.swap(other.latY);
+  aircraft.swap(other.aircraft);
+  records.swap(other.records);
+  idToIndex.swap(other.idToIndex);
+  cellStart.swap(other.cellStart);
+  cellIndexes.swap(other.cellIndexes);
+}
+
+int OnlineClientStore::column(float lonX)
+{
+  return std::max(0, std::min(COLUMNS - 1, static_cast<int>(std::floor(lonX + 180.f))));
+}
+
+int OnlineClientStore::row(float latY)
+{
+  return std::max(0, std::min(ROWS - 1, static_cast<int>(std::floor(latY + 90.f))));
+}
+
+void OnlineClientStore::updateGrid()
+{
+  // Counting sort of client indexes by cell
+  QVector<int> cells(ids.size());
+  cellStart.fill(0, COLUMNS * ROWS + 1);
+  for(int i = 0; i < ids.size(); i++)
+  {
+    cells[i] = row(latY.at(i)) * COLUMNS + column(lonX.at(i));
+    cellStart[cells.at(i) + 1]++;
+  }
+
+  for(int cell = 0; cell < COLUMNS * ROWS; cell++)
+    cellStart[cell + 1] += cellStart.at(cell);
+
+  QVector<int> next(cellStart);
+  cellIndexes.resize(ids.size());
+  for(int i = 0; i < ids.size(); i++)
+    cellIndexes[next[cells.at(i)]++] = i;
+}
+
+void OnlineClientStore::getIndexes(QVector<int>& indexes, const Marble::GeoDataLatLonBox& box) const
+{
+  if(isEmpty())
+    return;
+
+  using Marble::GeoDataCoordinates;
+  float west = static_cast<float>(box.west(GeoDataCoordinates::Degree)), east = static_cast<float>(box.east(GeoDataCoordinates::Degree)),
+        south = static_cast<float>(box.south(GeoDataCoordinates::Degree)),
+        north = static_cast<float>(box.north(GeoDataCoordinates::Degree));
+
+  int column1 = column(west), column2 = column(east), row1 = row(south), row2 = row(north);
+  for(int r = row1; r <= row2; r++)
+  {
+    // Cells of adjacent columns are consecutive in cellIndexes
+    int start = cellStart.at(r * COLUMNS + column1), end = cellStart.at(r * COLUMNS + column2 + 1);
+    for(int i = start; i < end; i++)
+    {
+      int index = cellIndexes.at(i);
+      float x = lonX.at(index), y = latY.at(index);
+      if(x >= west && x <= east && y >= south && y <= north)
+        indexes.append(index);
+    }
+  }
+}
@@ -0,0 +1,115 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_ONLINECLIENTSTORE_H
+#define LNM_ONLINECLIENTSTORE_H
+
+#include "fs/sc/simconnectaircraft.h"
+#include "sql/sqlrecord.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace Marble {
+class GeoDataLatLonBox;
+}
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+/*
+ * In-memory copy of the online client table filled once per download.
+ *
+ * Columns needed for spatial and id lookups are kept in separate arrays. Aircraft objects are built once when loading.
+ * A grid of one degree cells stores client indexes sorted by cell which allows to find all clients in a rectangle
+ * without touching other cells.
+ *
+ * Not thread safe. Can be loaded in a worker thread and then be swapped into the store used by the GUI.
+ */
+class OnlineClientStore
+{
+public:
+  /* Load all rows from table "client" of the given database. Clears store before. */
+  void load(atools::sql::SqlDatabase *db);
+
+  void clear();
+
+  void swap(OnlineClientStore& other);
+
+  /* Append indexes of all clients inside box. Box must not cross the anti-meridian. */
+  void getIndexes(QVector<int>& indexes, const Marble::GeoDataLatLonBox& box) const;
+
+  /* Index for table and column "client.client_id" or -1 if not found */
+  int getIndex(int clientId) const
+  {
+    return idToIndex.value(clientId, -1);
+  }
+
+  int getId(int index) const
+  {
+    return ids.at(index);
+  }
+
+  /* Aircraft built without simulator shadow */
+  const atools::fs::sc::SimConnectAircraft& getAircraft(int index) const
+  {
+    return aircraft.at(index);
+  }
+
+  /* Record with all columns of table "client" */
+  const atools::sql::SqlRecord& getRecord(int index) const
+  {
+    return records.at(index);
+  }
+
+  int size() const
+  {
+    return ids.size();
+  }
+
+  bool isEmpty() const
+  {
+    return ids.isEmpty();
+  }
+
+private:
+  const static int COLUMNS = 360, ROWS = 180;
+
+  static int column(float lonX);
+  static int row(float latY);
+
+  /* Fill cellStart and cellIndexes from coordinates */
+  void updateGrid();
+
+  /* Hot columns used for searching */
+  QVector<int> ids;
+  QVector<float> lonX, latY;
+
+  /* Cold columns used to return results */
+  QVector<atools::fs::sc::SimConnectAircraft> aircraft;
+  QVector<atools::sql::SqlRecord> records;
+
+  QHash<int, int> idToIndex;
+
+  /* Client indexes of cell i are cellIndexes[cellStart[i]] to cellIndexes[cellStart[i + 1] - 1] */
+  QVector<int> cellStart, cellIndexes;
+};
+
+#endif // LNM_ONLINECLIENTSTORE_H
@@ -20,9 +20,11 @@
 #include "app/navapp.h"
 #include "common/constants.h"
 #include "common/maptools.h"
+#include "db/dbtools.h"
 #include "fs/online/onlinedatamanager.h"
 #include "fs/sc/simconnectdata.h"
 #include "geo/calculations.h"
+#include "gui/application.h"
 #include "gui/dialog.h"
 #include "gui/mainwindow.h"
 #include "mapgui/maplayer.h"
@@ -30,8 +32,10 @@
 #include "query/airspacequeries.h"
 #include "query/querymanager.h"
 #include "settings/settings.h"
+#include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
+#include "sql/sqltransaction.h"
 #include "util/httpdownloader.h"
 #include "zip/gzip.h"
 
@@ -39,6 +43,10 @@
 #include <QTextCodec>
 #include <QCoreApplication>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QStringBuilder>
+#include <QtConcurrent/QtConcurrentRun>
 
 static const int MIN_SERVER_DOWNLOAD_INTERVAL_MIN = 15;
 static const int MIN_TRANSCEIVER_DOWNLOAD_INTERVAL_MIN = 5;
@@ -46,12 +54,20 @@ static const int MIN_TRANSCEIVER_DOWNLOAD_INTERVAL_MIN = 5;
 // Minimum reload time for whazzup files (JSON or txt)
 static const int MIN_RELOAD_TIME_SECONDS = 15;
 
+// Minimum time between position samples of simulator aircraft and maximum age of samples for shadow matching
+static const qint64 SHADOW_SAMPLE_INTERVAL_MS = 2000L;
+static const qint64 SHADOW_HISTORY_MS = 10L * 60L * 1000L;
+
+// SQLite page cache for the staging database connection of the worker thread
+static const int STAGING_CACHE_KB = 20000;
+
 using atools::fs::online::OnlinedataManager;
 using atools::util::HttpDownloader;
 using atools::geo::LineString;
 using atools::geo::Pos;
 using atools::fs::online::OnlineAircraft;
 using atools::fs::sc::SimConnectAircraft;
+using atools::sql::SqlDatabase;
 
 atools::fs::online::Format convertFormat(opts::OnlineFormat format)
 {
@@ -75,6 +91,13 @@ atools::fs::online::Format convertFormat(opts::OnlineFormat format)
 OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager *onlineManager, MainWindow *parent)
   : manager(onlineManager), mainWindow(parent), aircraftCache()
 {
+  connect(this, &OnlinedataController::onlineClientAndAtcUpdated, this, [this]() {
+    onlineVersion++;
+  });
+  connect(this, &OnlinedataController::onlineNetworkChanged, this, [this]() {
+    onlineVersion++;
+  });
+
   // Files use Windows code with embedded UTF-8 for ATIS text
   codec = QTextCodec::codecForName("Windows-1252");
   if(codec == nullptr)
@@ -94,7 +117,12 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
   // Request gzipped content if possible
   downloader->setAcceptEncoding("gzip");
 
-  updateAtcSizes();
+  // Staging database next to the online database - opened by the worker thread ==============================
+  stagingDatabaseFile = QFileInfo(getDatabase()->databaseName()).absolutePath() % QDir::separator() %
+                        lnm::DATABASE_PREFIX % "onlinedata_staging" % lnm::DATABASE_SUFFIX;
+  parserDebug = settings.getAndStoreValue(lnm::OPTIONS_WHAZZUP_PARSER_DEBUG, false).toBool();
+
+  connect(&whazzupWatcher, &QFutureWatcher<WhazzupResult>::finished, this, &OnlinedataController::whazzupLoaded);
 
   connect(downloader, &HttpDownloader::downloadFinished, this, &OnlinedataController::downloadFinished);
   connect(downloader, &HttpDownloader::downloadFailed, this, &OnlinedataController::downloadFailed);
@@ -103,9 +131,6 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
   // Recurring downloads
   connect(&downloadTimer, &QTimer::timeout, this, &OnlinedataController::startDownloadInternal);
 
-  using namespace std::placeholders;
-  manager->setGeometryCallback(std::bind(&OnlinedataController::airspaceGeometryCallback, this, _1, _2));
-
 #ifdef DEBUG_ONLINE_DOWNLOAD
   downloader->enableCache(60);
 #endif
@@ -113,19 +138,20 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
 
 OnlinedataController::~OnlinedataController()
 {
-  manager->setGeometryCallback(atools::fs::online::GeoCallbackType(nullptr));
+  // Worker uses geometry callback and removes the staging connection when done
+  whazzupWatcher.waitForFinished();
 
   deInitQueries();
 
   delete downloader;
 
-  // Remove all from the database to avoid confusion on startup
+  // Remove all from the database to avoid confusion on startup - staging schema is recreated by each load
 #ifndef DEBUG_INFORMATION
   manager->clearData();
 #endif
 }
 
-void OnlinedataController::updateAtcSizes()
+atools::fs::online::AtcSizeMap OnlinedataController::atcSizesFromOptions() const
 {
   // Override default circle radius for certain ATC center types
   const OptionData& opts = OptionData::instance();
@@ -185,7 +211,7 @@ void OnlinedataController::updateAtcSizes()
 
     sizeMap.insert(type, atools::fs::online::AtcSizeMapValue(useDefault, std::max(1, diameter / 2)));
   }
-  manager->setAtcSize(sizeMap);
+  return sizeMap;
 }
 
 void OnlinedataController::startProcessing()
@@ -341,13 +367,9 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
     if(verbose)
       qDebug() << Q_FUNC_INFO << "DOWNLOADING_TRANSCEIVERS";
 
-    QString tranceiversTxt = uncompress(data, Q_FUNC_INFO, true /* utf8 */);
-
-#ifdef DEBUG_INFORMATION_ONLINE
-    atools::strToFile(QDir::tempPath() + "/lnm_tranceivers.json", tranceiversTxt);
-#endif
     // transceivers.json downloaded ============================================
-    manager->readFromTransceivers(tranceiversTxt);
+    // Parsed in background together with each following whazzup file until the next download
+    transceiverData = data;
 
     // Next in chain after transceivers is JSON
     currentState = DOWNLOADING_WHAZZUP;
@@ -361,56 +383,8 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
       qDebug() << Q_FUNC_INFO << "DOWNLOADING_WHAZZUP";
 
     // whazzup.txt or JSON downloaded ============================================
-    atools::fs::online::Format format = convertFormat(OptionData::instance().getOnlineFormat());
-
-    // Contains servers and does not need an extra download
-    bool vatsimJson = format == atools::fs::online::VATSIM_JSON3;
-    bool ivaoJson = format == atools::fs::online::IVAO_JSON2;
-
-    QString whazzupTxt = uncompress(data, Q_FUNC_INFO, ivaoJson || vatsimJson /* utf8 */);
-
-#ifdef DEBUG_INFORMATION_ONLINE
-    atools::strToFile(QDir::tempPath() + "/lnm_whazzup." + (ivaoJson || vatsimJson ? "json" : "txt"), whazzupTxt);
-#endif
-
-    if(manager->readFromWhazzup(whazzupTxt, format, manager->getLastUpdateTimeFromWhazzup()))
-    {
-      QString whazzupVoiceUrlFromStatus = manager->getWhazzupVoiceUrlFromStatus();
-      if(!vatsimJson && !ivaoJson && !whazzupVoiceUrlFromStatus.isEmpty() &&
-         lastServerDownload < now.addSecs(-MIN_SERVER_DOWNLOAD_INTERVAL_MIN * 60))
-      {
-        // Next in chain is server file
-        currentState = DOWNLOADING_WHAZZUP_SERVERS;
-        downloader->setUrl(whazzupVoiceUrlFromStatus);
-        startDownloader();
-      }
-      else
-      {
-        // Done after downloading whazzup.txt - start timer for next session
-        startDownloadTimer();
-        currentState = NONE;
-        lastUpdateTime = now;
-
-        // Clear map display cache and update spatial index to match simulator shadow aircraft
-        aircraftCache.clear();
-        updateShadowIndex();
-
-        // Message for search tabs, map widget and info
-        emit onlineServersUpdated(true /* load all */, true /* keep selection */, true /* force */);
-        emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */, true /* force */);
-        statusBarMessage();
-      }
-    }
-    else
-    {
-      if(verbose)
-        qInfo() << Q_FUNC_INFO << "whazzup.txt is not recent";
-
-      // Done after old update - try again later
-      startDownloadTimer();
-      currentState = NONE;
-      lastUpdateTime = now;
-    }
+    // Download chain continues in whazzupLoaded()
+    startWhazzupLoading(data);
   }
   else if(currentState == DOWNLOADING_WHAZZUP_SERVERS)
   {
@@ -438,7 +412,7 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
     atools::strToFile(QDir::tempPath() + "/lnm_servers." + suffix, serversTxt);
 #endif
 
-    manager->readServersFromWhazzup(serversTxt, format, manager->getLastUpdateTimeFromWhazzup());
+    manager->readServersFromWhazzup(serversTxt, format, lastUpdateTimeFromWhazzup);
     lastServerDownload = now;
 
     // Done after downloading server.txt - start timer for next session
@@ -453,6 +427,221 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
   }
 }
 
+void OnlinedataController::startWhazzupLoading(const QByteArray& data)
+{
+  // Should not happen since the download chain waits for loading
+  whazzupWatcher.waitForFinished();
+
+  // Copy options in GUI thread for geometry callback
+  opts2::Flags2 flags = OptionData::instance().getFlags2();
+  airspaceByName = flags.testFlag(opts2::ONLINE_AIRSPACE_BY_NAME);
+  airspaceByFile = flags.testFlag(opts2::ONLINE_AIRSPACE_BY_FILE);
+
+  whazzupGeneration = generation;
+  whazzupWatcher.setFuture(QtConcurrent::run(this, &OnlinedataController::loadWhazzup, data, transceiverData,
+                                             convertFormat(OptionData::instance().getOnlineFormat()),
+                                             lastUpdateTimeFromWhazzup, atcSizesFromOptions()));
+}
+
+OnlinedataController::WhazzupResult OnlinedataController::loadWhazzup(QByteArray whazzupData, QByteArray transceiverDataParam,
+                                                                      atools::fs::online::Format format, QDateTime lastUpdate,
+                                                                      atools::fs::online::AtcSizeMap atcSizeMap)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  WhazzupResult result;
+  try
+  {
+    // Uses own read only connections for this pool thread in geometry callback
+    Queries *queries = QueryManager::instance()->getQueriesThread();
+    QueryLocker locker(queries);
+
+    // Connection and manager have to be created, used and removed in this thread
+    SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, dbtools::DATABASE_NAME_ONLINE_STAGING);
+
+    {
+      // Destroy database and manager before removing the connection
+      SqlDatabase stagingDatabase(dbtools::DATABASE_NAME_ONLINE_STAGING);
+      dbtools::openDatabaseFileTemporary(&stagingDatabase, stagingDatabaseFile, STAGING_CACHE_KB);
+
+      OnlinedataManager stagingManager(&stagingDatabase, parserDebug);
+      stagingManager.createSchema();
+      stagingManager.initQueries();
+      stagingManager.setAtcSize(atcSizeMap);
+
+      // ATC geometry is only needed when parsing whazzup into the staging database
+      using namespace std::placeholders;
+      stagingManager.setGeometryCallback(std::bind(&OnlinedataController::airspaceGeometryCallback, this,
+                                                   queries->getAirspaceQueries(), _1, _2));
+
+      if(!transceiverDataParam.isEmpty())
+      {
+        QString tranceiversTxt = uncompress(transceiverDataParam, Q_FUNC_INFO, true /* utf8 */);
+
+#ifdef DEBUG_INFORMATION_ONLINE
+        atools::strToFile(QDir::tempPath() + "/lnm_tranceivers.json", tranceiversTxt);
+#endif
+        stagingManager.readFromTransceivers(tranceiversTxt);
+      }
+
+      // Contains servers and does not need an extra download
+      bool json = format == atools::fs::online::VATSIM_JSON3 || format == atools::fs::online::IVAO_JSON2;
+
+      QString whazzupTxt = uncompress(whazzupData, Q_FUNC_INFO, json /* utf8 */);
+
+#ifdef DEBUG_INFORMATION_ONLINE
+      atools::strToFile(QDir::tempPath() + "/lnm_whazzup." + (json ? "json" : "txt"), whazzupTxt);
+#endif
+
+      result.updated = stagingManager.readFromWhazzup(whazzupTxt, format, lastUpdate);
+
+      if(result.updated)
+      {
+        // Copy metadata for the GUI thread
+        result.lastUpdateTime = stagingManager.getLastUpdateTimeFromWhazzup();
+        result.reloadMinutes = stagingManager.getReloadMinutesFromWhazzup();
+        for(const OnlineAircraft& onlineAircraft : stagingManager.getClientCallsignAndPosMap())
+          result.clientCallsignAndPos.append(onlineAircraft);
+
+        // Build in-memory clients for map and shadow lookups
+        result.clients.load(&stagingDatabase);
+      }
+
+      stagingManager.setGeometryCallback(atools::fs::online::GeoCallbackType(nullptr));
+      stagingManager.deInitQueries();
+      stagingDatabase.close();
+    }
+  }
+  catch(std::exception& e)
+  {
+    // Try again with next download
+    qWarning() << Q_FUNC_INFO << "Error loading whazzup" << e.what();
+    result = WhazzupResult();
+  }
+
+  SqlDatabase::removeDatabase(dbtools::DATABASE_NAME_ONLINE_STAGING);
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "Loading took" << timer.elapsed() << "ms" << "updated" << result.updated;
+
+  return result;
+}
+
+void OnlinedataController::whazzupLoaded()
+{
+  QFuture<WhazzupResult> future = whazzupWatcher.future();
+  if(future.isCanceled() || future.resultCount() == 0)
+    return;
+
+  WhazzupResult result = future.result();
+
+  // Avoid taking the result a second time
+  whazzupWatcher.setFuture(QFuture<WhazzupResult>());
+
+  // Discard if options were changed in the meantime - a new download chain was started already
+  if(whazzupGeneration != generation)
+    return;
+
+  const QDateTime now = QDateTime::currentDateTime();
+  if(result.updated)
+  {
+    atools::fs::online::Format format = convertFormat(OptionData::instance().getOnlineFormat());
+
+    lastUpdateTimeFromWhazzup = result.lastUpdateTime;
+    reloadMinutesFromWhazzup = result.reloadMinutes;
+    clientCallsignAndPos.swap(result.clientCallsignAndPos);
+
+    copyStagingTables(format);
+    clientStore.swap(result.clients);
+
+    QString whazzupVoiceUrlFromStatus = manager->getWhazzupVoiceUrlFromStatus();
+    bool json = format == atools::fs::online::VATSIM_JSON3 || format == atools::fs::online::IVAO_JSON2;
+
+    if(!json && !whazzupVoiceUrlFromStatus.isEmpty() && lastServerDownload < now.addSecs(-MIN_SERVER_DOWNLOAD_INTERVAL_MIN * 60))
+    {
+      // Next in chain is server file
+      currentState = DOWNLOADING_WHAZZUP_SERVERS;
+      downloader->setUrl(whazzupVoiceUrlFromStatus);
+      startDownloader();
+    }
+    else
+    {
+      // Done after downloading whazzup.txt - start timer for next session
+      startDownloadTimer();
+      currentState = NONE;
+      lastUpdateTime = now;
+
+      // Clear map display cache and update spatial index to match simulator shadow aircraft
+      aircraftCache.clear();
+      updateShadowIndex();
+
+      // Message for search tabs, map widget and info
+      emit onlineServersUpdated(true /* load all */, true /* keep selection */, true /* force */);
+      emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */, true /* force */);
+      statusBarMessage();
+    }
+  }
+  else
+  {
+    if(verbose)
+      qInfo() << Q_FUNC_INFO << "whazzup.txt is not recent";
+
+    // Done after old update - try again later
+    startDownloadTimer();
+    currentState = NONE;
+    lastUpdateTime = now;
+  }
+}
+
+void OnlinedataController::copyStagingTables(atools::fs::online::Format format)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  SqlDatabase *db = getDatabase();
+  try
+  {
+    db->attachDatabase(stagingDatabaseFile, "staging");
+
+    // Servers for text formats are downloaded separately and written to the online database only
+    bool json = format == atools::fs::online::VATSIM_JSON3 || format == atools::fs::online::IVAO_JSON2;
+
+    QStringList tables;
+    atools::sql::SqlQuery query(db);
+    query.exec("select name from staging.sqlite_master where type = 'table' and name not like 'sqlite_%'");
+    while(query.next())
+    {
+      QString table = query.valueStr("name");
+      if(json || table != "server")
+        tables.append(table);
+    }
+    query.finish();
+
+    // Readers see either the old or the new data
+    atools::sql::SqlTransaction transaction(db);
+    for(const QString& table : qAsConst(tables))
+    {
+      db->exec("delete from " % table);
+      db->exec("insert into " % table % " select * from staging." % table);
+    }
+    transaction.commit();
+
+    db->detachDatabase("staging");
+  }
+  catch(atools::Exception& e)
+  {
+    ATOOLS_HANDLE_EXCEPTION(e);
+  }
+  catch(...)
+  {
+    ATOOLS_HANDLE_UNKNOWN_EXCEPTION;
+  }
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "Copying took" << timer.elapsed() << "ms";
+}
+
 void OnlinedataController::startDownloader()
 {
   if(verbose)
@@ -517,18 +706,18 @@ void OnlinedataController::showMessageDialog()
   atools::gui::Dialog::information(mainWindow, tr("Message from downloaded status file:\n\n%2\n").arg(manager->getMessageFromStatus()));
 }
 
-const LineString *OnlinedataController::airspaceGeometryCallback(const QString& callsign, atools::fs::online::fac::FacilityType type)
+const LineString *OnlinedataController::airspaceGeometryCallback(AirspaceQueries *airspaceQueries, const QString& callsign,
+                                                                 atools::fs::online::fac::FacilityType type)
 {
-  opts2::Flags2 flags = OptionData::instance().getFlags2();
-  AirspaceQueries *airspaceQueries = QueryManager::instance()->getQueriesGui()->getAirspaceQueries();
+  // Queries are locked by loadWhazzup() - do not call getQueriesThread() again since it might reopen them
   const LineString *lineString = nullptr;
 
   // Try to get airspace boundary by name vs. callsign if set in options
-  if(flags.testFlag(opts2::ONLINE_AIRSPACE_BY_NAME))
+  if(airspaceByName)
     lineString = airspaceQueries->getOnlineAirspaceGeoByName(callsign, atools::fs::online::facilityTypeToDb(type));
 
   // Try to get airspace boundary by file name vs. callsign if set in options
-  if(flags.testFlag(opts2::ONLINE_AIRSPACE_BY_FILE) && (lineString == nullptr || lineString->isEmpty()))
+  if(airspaceByFile && (lineString == nullptr || lineString->isEmpty()))
     lineString = airspaceQueries->getOnlineAirspaceGeoByFile(callsign);
 
   return lineString != nullptr && lineString->isValidPolygon() ? lineString : nullptr;
@@ -538,19 +727,28 @@ void OnlinedataController::optionsChanged()
 {
   qDebug() << Q_FUNC_INFO;
 
+  // Discard result of a running task
+  generation++;
+  whazzupWatcher.waitForFinished();
+
   // Clear all URL from status.txt too
   manager->resetForNewOptions();
   stopAllProcesses();
+  transceiverData.clear();
+  lastUpdateTimeFromWhazzup = QDateTime();
+  reloadMinutesFromWhazzup = 0;
+  clientCallsignAndPos.clear();
 
-  // Remove all from the database
+  // Remove all from the database - staging schema is recreated by the next load
   manager->clearData();
+  clientStore.clear();
   aircraftCache.clear();
   onlineAircraftSpatialIndex.clearIndex();
   aircraftIdSimToOnline.clear();
   aircraftIdOnlineToSim.clear();
-  currentDataPacketMap.clear();
-
-  updateAtcSizes();
+  onlineAircraftByKey.clear();
+  shadowHistories.clear();
+  shadowSimAircraft.clear();
 
   emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */, true /* force */);
   emit onlineServersUpdated(true /* load all */, true /* keep selection */, true /* force */);
@@ -648,20 +846,16 @@ const QList<atools::fs::sc::SimConnectAircraft> *OnlinedataController::getAircra
 
   if((aircraftCache.list.isEmpty() && !lazy))
   {
+    QVector<int> indexes;
     for(const Marble::GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(r, aircraftByRectQuery);
-      aircraftByRectQuery->exec();
-      while(aircraftByRectQuery->next())
-      {
-        SimConnectAircraft onlineAircraft;
-        OnlinedataManager::fillFromClient(onlineAircraft, aircraftByRectQuery->record(),
-                                          getShadowSimAircraft(aircraftByRectQuery->valueInt("client_id")));
+      clientStore.getIndexes(indexes, r);
 
-        if(!aircraftIdOnlineToSim.contains(onlineAircraft.getId()))
-          // Avoid duplicates with simulator shadow aircraft - sim aircraft are drawn in another context
-          aircraftCache.list.append(onlineAircraft);
-      }
+    for(int index : qAsConst(indexes))
+    {
+      // Avoid duplicates with simulator shadow aircraft - sim aircraft are drawn in another context
+      // Remaining aircraft have no shadow and can be used as built by the store
+      if(!aircraftIdOnlineToSim.contains(clientStore.getId(index)))
+        aircraftCache.list.append(clientStore.getAircraft(index));
     }
   }
   overflow = aircraftCache.validate(queryMaxRows);
@@ -672,25 +866,8 @@ const atools::fs::sc::SimConnectAircraft& OnlinedataController::getShadowSimAirc
 {
   const static atools::fs::sc::SimConnectAircraft EMPTY_SIM_AIRCRAFT;
 
-  int simId = aircraftIdOnlineToSim.value(onlineId, -1);
-  if(simId != -1 && !currentDataPacketMap.isEmpty())
-  {
-    // Get latest data packet
-    const atools::fs::sc::SimConnectData& last = currentDataPacketMap.last();
-    const atools::fs::sc::SimConnectUserAircraft& userAircraft = last.getUserAircraftConst();
-    if(userAircraft.isValid() && userAircraft.getId() == simId)
-      // Is user aircraft
-      return userAircraft;
-    else
-    {
-      // Look for AI aircraft
-      const atools::fs::sc::SimConnectAircraft *simAircraft = last.getAiAircraftConstById(simId);
-      if(simAircraft != nullptr)
-        return *simAircraft;
-    }
-  }
-
-  return EMPTY_SIM_AIRCRAFT;
+  auto it = shadowSimAircraft.constFind(aircraftIdOnlineToSim.value(onlineId, -1));
+  return it != shadowSimAircraft.constEnd() ? it.value() : EMPTY_SIM_AIRCRAFT;
 }
 
 /* Get an online network aircraft for given simulator shadow aircraft with updated position */
@@ -699,7 +876,7 @@ atools::fs::sc::SimConnectAircraft OnlinedataController::getShadowedOnlineAircra
   atools::fs::sc::SimConnectAircraft onlineAircraft;
   if(isShadowAircraft(simAircraft))
   {
-    atools::sql::SqlRecord client = manager->getClientRecordById(aircraftIdSimToOnline.value(simAircraft.getId()));
+    atools::sql::SqlRecord client = getClientRecordById(aircraftIdSimToOnline.value(simAircraft.getId()));
 
     if(!client.isEmpty())
     {
@@ -722,97 +899,171 @@ bool OnlinedataController::isShadowAircraft(const atools::fs::sc::SimConnectAirc
 // Called by ConnectClient after each simulator data package
 void OnlinedataController::updateAircraftShadowState(atools::fs::sc::SimConnectData& dataPacket)
 {
-  // Check if connected online to avoid overflow of currentDataPacketMap which
-  // is cleared in updateShadowIndex() after each online download
+  // Check if connected online to avoid overflow of shadowHistories which
+  // is pruned in updateShadowIndex() after each online download
   if(isNetworkActive())
   {
     // Modify AI aircraft and set shadow flag if a online network aircraft is registered as shadowed in the index
     if(!dataPacket.isEmptyReply() && dataPacket.isUserAircraftValid())
     {
-      atools::fs::sc::SimConnectUserAircraft& userAircraft = dataPacket.getUserAircraft();
-      userAircraft.setFlag(atools::fs::sc::SIM_ONLINE_SHADOW, isShadowAircraft(userAircraft));
+      qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+      bool removeShadow = OptionData::instance().getFlags().testFlag(opts::ONLINE_REMOVE_SHADOW);
 
-      for(SimConnectAircraft& aiAircraft : dataPacket.getAiAircraft())
-        aiAircraft.setFlag(atools::fs::sc::SIM_ONLINE_SHADOW, isShadowAircraft(aiAircraft));
+      updateShadowAircraft(dataPacket.getUserAircraft(), nowMs, removeShadow);
 
-      currentDataPacketMap.insert(QDateTime::currentDateTimeUtc(), dataPacket);
+      for(SimConnectAircraft& aiAircraft : dataPacket.getAiAircraft())
+        updateShadowAircraft(aiAircraft, nowMs, removeShadow);
     }
   }
   else
-    currentDataPacketMap.clear();
+  {
+    shadowHistories.clear();
+    shadowSimAircraft.clear();
+  }
+}
+
+void OnlinedataController::updateShadowAircraft(atools::fs::sc::SimConnectAircraft& simAircraft, qint64 nowMs, bool removeShadow)
+{
+  int simId = simAircraft.getId();
+  ShadowHistory& history = shadowHistories[simId];
+
+  // Match only new aircraft or ones which changed registration - all others are matched after download
+  bool changed = history.samples.isEmpty() || history.registrationKey != simAircraft.getAirplaneRegistrationKey();
+  history.registrationKey = simAircraft.getAirplaneRegistrationKey();
+  history.user = simAircraft.isUser();
+  history.boat = simAircraft.isAnyBoat();
+
+  ShadowSample sample;
+  sample.timeMs = nowMs;
+  sample.pos = simAircraft.getPosition();
+  sample.altitudeFt = simAircraft.getActualAltitudeFt();
+  sample.groundSpeedKts = simAircraft.getGroundSpeedKts();
+  sample.headingDegTrue = simAircraft.getHeadingDegTrue();
+
+  if(history.samples.isEmpty() || nowMs - history.samples.constLast().timeMs >= SHADOW_SAMPLE_INTERVAL_MS)
+    history.samples.append(sample);
+
+  if(changed && removeShadow && !history.boat)
+    matchShadowAircraft(simId, history, sample);
+
+  bool shadow = isShadowAircraft(simAircraft);
+  simAircraft.setFlag(atools::fs::sc::SIM_ONLINE_SHADOW, shadow);
+
+  // Keep latest state for shadowed aircraft only
+  if(shadow)
+    shadowSimAircraft.insert(simId, simAircraft);
+  else
+    shadowSimAircraft.remove(simId);
+}
+
+void OnlinedataController::matchShadowAircraft(int simId, const ShadowHistory& history, const ShadowSample& sample)
+{
+  // Remove previous assignment
+  if(aircraftIdSimToOnline.contains(simId))
+    aircraftIdOnlineToSim.remove(aircraftIdSimToOnline.take(simId));
+
+  const OnlineAircraft onlineAircraft = shadowAircraftInternal(history, sample);
+  if(onlineAircraft.isValid())
+  {
+    aircraftIdSimToOnline.insert(simId, onlineAircraft.id);
+    aircraftIdOnlineToSim.insert(onlineAircraft.id, simId);
+
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << (history.user ? "User sim" : "Sim") << simId << history.registrationKey << sample.pos
+               << "online" << onlineAircraft.id << onlineAircraft.registration << onlineAircraft.pos;
+  }
 }
 
 /* Return online aircraft for simulator aircraft based on distance and other parameter similarity */
-OnlineAircraft OnlinedataController::shadowAircraftInternal(const atools::fs::sc::SimConnectAircraft& simAircraft)
+OnlineAircraft OnlinedataController::shadowAircraftInternal(const ShadowHistory& history, const ShadowSample& sample)
 {
   const static OnlineAircraft EMPTY_ONLINE_AIRCRAFT;
 
 #ifdef DEBUG_INFORMATION_USER_ONLINE_DISABLED
-  if(simAircraft.isUser())
+  if(history.user)
   {
-    qDebug() << Q_FUNC_INFO << simAircraft.getAirplaneRegistrationKey() << simAircraft.getPosition();
+    qDebug() << Q_FUNC_INFO << history.registrationKey << sample.pos;
 
-    if(onlineAircraftRegKeyIndex.contains(simAircraft.getAirplaneRegistrationKey()))
+    if(onlineAircraftByKey.contains(history.registrationKey))
     {
-      const atools::geo::Pos pos = onlineAircraftRegKeyIndex.value(simAircraft.getAirplaneRegistrationKey()).getPosition();
-      qDebug() << Q_FUNC_INFO << "online" << pos << "sim" << simAircraft.getPosition();
+      const atools::geo::Pos pos = onlineAircraftByKey.value(history.registrationKey).pos;
+      qDebug() << Q_FUNC_INFO << "online" << pos << "sim" << sample.pos;
 
-      qDebug() << Q_FUNC_INFO << atools::geo::meterToNm(pos.distanceMeterTo3d(simAircraft.getPosition()));
+      qDebug() << Q_FUNC_INFO << atools::geo::meterToNm(pos.distanceMeterTo3d(sample.pos));
     }
   }
 #endif
 
-  if(!onlineAircraftSpatialIndex.isEmpty())
-  {
-    // First get all nearest aircraft from spatial index ======================================
-    QVector<OnlineAircraft> nearest;
-    onlineAircraftSpatialIndex.getRadius(nearest, simAircraft.getPosition(), atools::geo::nmToMeter(maxShadowDistanceNm));
+  // Check criteria which are not covered by the spatial index
+  auto matches = [&sample, this](const OnlineAircraft& aircraft) -> bool {
+    bool altOk = true, gsOk = true, hdgOk = true;
 
-    if(verbose && simAircraft.isUser())
-      qDebug() << Q_FUNC_INFO << "nearest.size()" << nearest.size();
+    if(atools::inRange(-1000.f, map::INVALID_ALTITUDE_VALUE / 4.f, sample.altitudeFt) &&
+       atools::inRange(-1000.f, map::INVALID_ALTITUDE_VALUE / 4.f, aircraft.pos.getAltitude()))
+      altOk = atools::almostEqual(sample.altitudeFt, aircraft.pos.getAltitude(), maxShadowAltDiffFt);
 
-    // Filter out all which do not match more non-spatial criteria =================================
-    nearest.erase(std::remove_if(nearest.begin(), nearest.end(),
-                                 [&simAircraft, this](const OnlineAircraft& aircraft) -> bool {
-      bool altOk = true, gsOk = true, hdgOk = true;
+    if(atools::inRange(0.f, map::INVALID_SPEED_VALUE / 4.f, sample.groundSpeedKts) &&
+       atools::inRange(0.f, map::INVALID_SPEED_VALUE / 4.f, aircraft.groundSpeedKts))
+      gsOk = atools::almostEqual(sample.groundSpeedKts, aircraft.groundSpeedKts, maxShadowGsDiffKts);
+
+    if(atools::inRange(0.f, map::INVALID_HEADING_VALUE / 4.f, sample.headingDegTrue) &&
+       atools::inRange(0.f, map::INVALID_HEADING_VALUE / 4.f, aircraft.headingTrue))
+      hdgOk = atools::geo::angleAbsDiff(sample.headingDegTrue, aircraft.headingTrue) < maxShadowHdgDiffDeg;
+
+    return altOk && gsOk && hdgOk;
+  };
 
-      if(atools::inRange(-1000.f, map::INVALID_ALTITUDE_VALUE / 4.f, simAircraft.getActualAltitudeFt()) &&
-         atools::inRange(-1000.f, map::INVALID_ALTITUDE_VALUE / 4.f, aircraft.pos.getAltitude()))
-        altOk = atools::almostEqual(simAircraft.getActualAltitudeFt(), aircraft.pos.getAltitude(), maxShadowAltDiffFt);
+  float maxDistanceMeter = atools::geo::nmToMeter(maxShadowDistanceNm);
+  QVector<OnlineAircraft> nearest;
 
-      if(atools::inRange(0.f, map::INVALID_SPEED_VALUE / 4.f, simAircraft.getGroundSpeedKts()) &&
-         atools::inRange(0.f, map::INVALID_SPEED_VALUE / 4.f, aircraft.groundSpeedKts))
-        gsOk = atools::almostEqual(simAircraft.getGroundSpeedKts(), aircraft.groundSpeedKts, maxShadowGsDiffKts);
+  // Try clients with the same callsign first which avoids the radius search in most cases ======================
+  if(!history.registrationKey.isEmpty())
+  {
+    for(auto it = onlineAircraftByKey.constFind(history.registrationKey);
+        it != onlineAircraftByKey.constEnd() && it.key() == history.registrationKey; ++it)
+    {
+      if(sample.pos.distanceMeterTo(it.value().pos) <= maxDistanceMeter && matches(it.value()))
+        nearest.append(it.value());
+    }
+  }
 
-      if(atools::inRange(0.f, map::INVALID_HEADING_VALUE / 4.f, simAircraft.getHeadingDegTrue()) &&
-         atools::inRange(0.f, map::INVALID_HEADING_VALUE / 4.f, aircraft.headingTrue))
-        hdgOk = atools::geo::angleAbsDiff(simAircraft.getHeadingDegTrue(), aircraft.headingTrue) < maxShadowHdgDiffDeg;
+  // Get all nearest aircraft from spatial index ======================================
+  if(nearest.isEmpty() && !onlineAircraftSpatialIndex.isEmpty())
+  {
+    onlineAircraftSpatialIndex.getRadius(nearest, sample.pos, maxDistanceMeter);
 
-      return !(altOk && gsOk && hdgOk);
+    if(verbose && history.user)
+      qDebug() << Q_FUNC_INFO << "nearest.size()" << nearest.size();
+
+    // Filter out all which do not match more non-spatial criteria =================================
+    nearest.erase(std::remove_if(nearest.begin(), nearest.end(), [&matches](const OnlineAircraft& aircraft) -> bool {
+      return !matches(aircraft);
     }), nearest.end());
 
-    if(verbose && simAircraft.isUser())
+    if(verbose && history.user)
       qDebug() << Q_FUNC_INFO << "nearest.size() after filter" << nearest.size();
+  }
 
-    if(!nearest.isEmpty())
-    {
-      // Sort to get closest by coordinates and altitude to start of list
-      maptools::sortByDistanceAndAltitude(nearest, simAircraft.getPosition());
+  if(!nearest.isEmpty())
+  {
+    // Sort to get closest by coordinates and altitude to start of list
+    maptools::sortByDistanceAndAltitude(nearest, sample.pos);
 
-      if(verbose && simAircraft.isUser())
-        qDebug() << Q_FUNC_INFO << "Found" << nearest.first().registrationKey;
+    if(verbose && history.user)
+      qDebug() << Q_FUNC_INFO << "Found" << nearest.first().registrationKey;
 
-      return nearest.constFirst();
-    }
-  } // if(!onlineAircraftSpatialIndex.isEmpty())
+    return nearest.constFirst();
+  }
   return EMPTY_ONLINE_AIRCRAFT;
 }
 
 void OnlinedataController::clearShadowIndexes()
 {
   onlineAircraftSpatialIndex.clearIndex();
+  onlineAircraftByKey.clear();
   aircraftIdSimToOnline.clear();
   aircraftIdOnlineToSim.clear();
+  shadowSimAircraft.clear();
 }
 
 // Called after each download
@@ -821,104 +1072,66 @@ void OnlinedataController::updateShadowIndex()
   if(verbose)
     qDebug() << Q_FUNC_INFO << "===========================";
 
-  // Clear the id maps and the spatial index
+  // Clear the id maps and the indexes
   clearShadowIndexes();
 
-  if(OptionData::instance().getFlags().testFlag(opts::ONLINE_REMOVE_SHADOW) && !currentDataPacketMap.isEmpty())
+  // Remove aircraft which left the simulator and samples which are too old to be used ==========
+  qint64 minTimeMs = QDateTime::currentMSecsSinceEpoch() - SHADOW_HISTORY_MS;
+  for(auto it = shadowHistories.begin(); it != shadowHistories.end();)
   {
-    const QDateTime lastUpdateTimeWhazzup = manager->getLastUpdateTimeFromWhazzup();
-    const auto upper = currentDataPacketMap.upperBound(lastUpdateTimeWhazzup);
-    const auto lower = currentDataPacketMap.lowerBound(lastUpdateTimeWhazzup);
-    QMap<QDateTime, atools::fs::sc::SimConnectData>::iterator entry = currentDataPacketMap.end();
+    QVector<ShadowSample>& samples = it.value().samples;
+    int numOld = 0;
+    while(numOld < samples.size() && samples.at(numOld).timeMs < minTimeMs)
+      numOld++;
+    samples.remove(0, numOld);
+
+    if(samples.isEmpty())
+      it = shadowHistories.erase(it);
+    else
+      ++it;
+  }
 
-    if(upper != currentDataPacketMap.end() && lower != currentDataPacketMap.end())
-    {
-      qint64 lastUpdateWhazzupSecs = lastUpdateTimeWhazzup.toSecsSinceEpoch();
-      if(std::abs(upper.key().toSecsSinceEpoch() - lastUpdateWhazzupSecs) <
-         std::abs(lower.key().toSecsSinceEpoch() - lastUpdateWhazzupSecs))
-        entry = upper;
-      else
-        entry = lower;
-    }
-    else if(upper != currentDataPacketMap.end())
-      entry = upper;
-    else if(lower != currentDataPacketMap.end())
-      entry = lower;
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "shadowHistories.size()" << shadowHistories.size();
 
-    if(verbose)
+  if(OptionData::instance().getFlags().testFlag(opts::ONLINE_REMOVE_SHADOW) && !shadowHistories.isEmpty())
+  {
+    // Fill spatial and callsign index =================================
+    for(const OnlineAircraft& onlineAircraft : qAsConst(clientCallsignAndPos))
     {
-      qDebug() << Q_FUNC_INFO << currentDataPacketMap.firstKey() << currentDataPacketMap.lastKey();
-      qDebug() << Q_FUNC_INFO << "lastUpdateTimeWhazzup" << lastUpdateTimeWhazzup
-               << "lower" << lower.key() << "upper" << upper.key();
-
-      if(entry != currentDataPacketMap.end())
-        qDebug() << Q_FUNC_INFO << "entry.key()" << entry.key();
+      onlineAircraftSpatialIndex.append(onlineAircraft);
+      onlineAircraftByKey.insert(onlineAircraft.registrationKey, onlineAircraft);
     }
+    onlineAircraftSpatialIndex.updateIndex();
 
-    if(entry != currentDataPacketMap.end())
+    // Match all aircraft using the position closest to the time of the whazzup file =================================
+    qint64 whazzupMs = lastUpdateTimeFromWhazzup.toMSecsSinceEpoch();
+    for(auto it = shadowHistories.constBegin(); it != shadowHistories.constEnd(); ++it)
     {
-      int removed = 0;
-      while(currentDataPacketMap.begin() != entry && !currentDataPacketMap.isEmpty())
-      {
-        currentDataPacketMap.erase(currentDataPacketMap.begin());
-        removed++;
-      }
-
-      if(verbose)
-        qDebug() << Q_FUNC_INFO << "removed" << removed << "currentDataPackets.size()" << currentDataPacketMap.size();
-
-      atools::fs::sc::SimConnectData currentDataPacket = entry.value();
-      if(currentDataPacket.isUserAircraftValid())
-      {
-        // Fill and update spatial index =================================
-        onlineAircraftSpatialIndex.append(manager->getClientCallsignAndPosMap());
-        onlineAircraftSpatialIndex.updateIndex();
-
-        const atools::fs::sc::SimConnectUserAircraft& simUserAircraft = currentDataPacket.getUserAircraftConst();
-        if(!simUserAircraft.isAnyBoat())
-        {
-          const OnlineAircraft onlineUserAircraft = shadowAircraftInternal(simUserAircraft);
-          if(onlineUserAircraft.isValid())
-          {
-            int simId = simUserAircraft.getId();
-            int onlineId = onlineUserAircraft.id;
-            aircraftIdSimToOnline.insert(simId, onlineId);
-            aircraftIdOnlineToSim.insert(onlineId, simId);
-
-            if(verbose)
-              qDebug() << Q_FUNC_INFO << "User sim" << simId << simUserAircraft.getAirplaneRegistration() << simUserAircraft.getPosition()
-                       << "online" << onlineId << onlineUserAircraft.registration << onlineUserAircraft.pos;
-          }
-        }
-
-        // update an index for currentDataPacket
-        for(const SimConnectAircraft& simAircraft : currentDataPacket.getAiAircraftConst())
-        {
-          if(!simAircraft.isAnyBoat())
-          {
-            OnlineAircraft onlineAircraft = shadowAircraftInternal(simAircraft);
-
-            if(onlineAircraft.isValid())
-            {
-              int simId = simAircraft.getId();
-              int onlineId = onlineAircraft.id;
-              aircraftIdSimToOnline.insert(simId, onlineId);
-              aircraftIdOnlineToSim.insert(onlineId, simId);
-
-              if(verbose)
-                qDebug() << Q_FUNC_INFO << "Sim" << simId << simAircraft.getAirplaneRegistration() << simAircraft.getPosition()
-                         << "online" << onlineId << onlineAircraft.registration << onlineAircraft.pos;
-            }
-          }
-        }
-      }
+      const ShadowHistory& history = it.value();
+      if(history.boat)
+        continue;
+
+      // Samples are sorted by time
+      auto sampleIt = std::lower_bound(history.samples.constBegin(), history.samples.constEnd(), whazzupMs,
+                                       [](const ShadowSample& sample, qint64 timeMs) -> bool {
+        return sample.timeMs < timeMs;
+      });
+
+      if(sampleIt == history.samples.constEnd())
+        --sampleIt;
+      else if(sampleIt != history.samples.constBegin() && whazzupMs - (sampleIt - 1)->timeMs < sampleIt->timeMs - whazzupMs)
+        --sampleIt;
+
+      matchShadowAircraft(it.key(), history, *sampleIt);
     }
   }
 }
 
 atools::fs::sc::SimConnectAircraft OnlinedataController::getClientAircraftById(int id)
 {
-  return manager->getClientAircraftById(id);
+  int index = clientStore.getIndex(id);
+  return index != -1 ? clientStore.getAircraft(index) : SimConnectAircraft();
 }
 
 void OnlinedataController::fillAircraftFromClient(atools::fs::sc::SimConnectAircraft& ac, const atools::sql::SqlRecord& record)
@@ -948,7 +1161,8 @@ void OnlinedataController::removeOnlineShadowedAircraft(QList<map::MapOnlineAirc
 
 atools::sql::SqlRecord OnlinedataController::getClientRecordById(int clientId)
 {
-  return manager->getClientRecordById(clientId);
+  int index = clientStore.getIndex(clientId);
+  return index != -1 ? clientStore.getRecord(index) : atools::sql::SqlRecord();
 }
 
 void OnlinedataController::initQueries()
@@ -956,9 +1170,6 @@ void OnlinedataController::initQueries()
   deInitQueries();
 
   manager->initQueries();
-
-  aircraftByRectQuery = new atools::sql::SqlQuery(getDatabase());
-  aircraftByRectQuery->prepare("select * from client where lonx between :leftx and :rightx and laty between :bottomy and :topy");
 }
 
 void OnlinedataController::deInitQueries()
@@ -966,9 +1177,6 @@ void OnlinedataController::deInitQueries()
   aircraftCache.clear();
 
   manager->deInitQueries();
-
-  delete aircraftByRectQuery;
-  aircraftByRectQuery = nullptr;
 }
 
 int OnlinedataController::getNumClients() const
@@ -994,7 +1202,7 @@ void OnlinedataController::startDownloadTimer()
     if(intervalSeconds == -1)
     {
       // Use time from whazzup.txt - mode auto
-      intervalSeconds = std::max(manager->getReloadMinutesFromWhazzup() * 60, 60);
+      intervalSeconds = std::max(reloadMinutesFromWhazzup * 60, 60);
       source = "whazzup";
     }
     else
@@ -1041,10 +1249,13 @@ void OnlinedataController::debugDumpContainerSizes() const
 {
   if(downloader != nullptr)
     downloader->debugDumpContainerSizes();
-  qDebug() << Q_FUNC_INFO << "currentDataPacketMap.size()" << currentDataPacketMap.size();
+  qDebug() << Q_FUNC_INFO << "shadowHistories.size()" << shadowHistories.size();
+  qDebug() << Q_FUNC_INFO << "shadowSimAircraft.size()" << shadowSimAircraft.size();
+  qDebug() << Q_FUNC_INFO << "onlineAircraftByKey.size()" << onlineAircraftByKey.size();
   qDebug() << Q_FUNC_INFO << "onlineAircraftSpatialIndex.size()" << onlineAircraftSpatialIndex.size();
   qDebug() << Q_FUNC_INFO << "aircraftIdSimToOnline.size()" << aircraftIdSimToOnline.size();
   qDebug() << Q_FUNC_INFO << "aircraftIdOnlineToSim.size()" << aircraftIdOnlineToSim.size();
   qDebug() << Q_FUNC_INFO << "aircraftCache.list.size()" << aircraftCache.list.size();
+  qDebug() << Q_FUNC_INFO << "clientStore.size()" << clientStore.size();
 
 }
@@ -18,14 +18,20 @@
 #ifndef LNM_ONLINECONTROLLER_H
 #define LNM_ONLINECONTROLLER_H
 
+#include "fs/online/onlinedatamanager.h"
 #include "fs/online/onlinetypes.h"
+#include "geo/pos.h"
 #include "geo/spatialindex.h"
+#include "online/onlineclientstore.h"
 #include "query/querytypes.h"
 
 #include <QDateTime>
+#include <QFutureWatcher>
+#include <QHash>
 #include <QObject>
 #include <QTimer>
 
+class AirspaceQueries;
 class MapLayer;
 
 namespace Marble {
@@ -49,9 +55,6 @@ namespace fs {
 namespace sc {
 class SimConnectAircraft;
 }
-namespace online {
-class OnlinedataManager;
-}
 }
 }
 
@@ -66,6 +69,10 @@ class QTextCodec;
 /*
  * Manages recurring download of online network data from the status.txt and whazzup.txt files.
  * Uses options to determine how to download data.
+ *
+ * Whazzup and transceiver files are parsed into a staging database in a background thread. The task creates and removes
+ * its own connection and manager for the staging database and returns only plain metadata and clients.
+ * Tables are then copied into the online database in one transaction and update signals are sent afterwards.
  */
 class OnlinedataController :
   public QObject
@@ -104,14 +111,14 @@ public:
   QString getNetwork() const;
   bool isNetworkActive() const;
 
-  /* Get aircraft within bounding rectangle. Objects are cached. */
+  /* Get aircraft within bounding rectangle from the client store. Objects are cached. */
   const QList<atools::fs::sc::SimConnectAircraft> *getAircraft(const Marble::GeoDataLatLonBox& rect,
                                                                const MapLayer *mapLayer, bool lazy, bool& overflow);
 
   /* Get aircraft from last bounding rectangle query from cache. */
   const QList<atools::fs::sc::SimConnectAircraft> *getAircraftFromCache();
 
-  /* Fill aircraft object from table "client" in database. */
+  /* Get aircraft for table and column "client.client_id" from the client store. */
   atools::fs::sc::SimConnectAircraft getClientAircraftById(int id);
 
   /* Fill from a record based on table "client". Tries to get sim shadow aircraft and fill additional fields. */
@@ -120,7 +127,7 @@ public:
   /* Removes the online aircraft from "onlineAircraft" which also have a simulator shadow in "simAircraft" */
   void removeOnlineShadowedAircraft(QList<map::MapOnlineAircraft>& onlineAircraftList, const QList<map::MapAiAircraft>& simAircraftList);
 
-  /* Get client record with all field values */
+  /* Get client record with all field values from the client store */
   atools::sql::SqlRecord getClientRecordById(int clientId);
 
   /* Close all query objects thus disconnecting from the database */
@@ -139,13 +146,19 @@ public:
   const atools::fs::sc::SimConnectAircraft& getShadowSimAircraft(int onlineId);
 
   /* Modify AI and user aircraft and set shadow flag if a online network aircraft with the same id exists.
-   * Also stores simulator aircraft data to maintain spatial index.
+   * Also stores a short position history of simulator aircraft and matches new aircraft against the last download.
    * Called by ConnectClient after receiving simulator data package. */
   void updateAircraftShadowState(atools::fs::sc::SimConnectData& dataPacket);
 
   /* Print the size of all container classes to detect overflow or memory leak conditions */
   void debugDumpContainerSizes() const;
 
+  /* Incremented on each client, ATC or network change */
+  quint64 getOnlineVersion() const
+  {
+    return onlineVersion;
+  }
+
 signals:
   /* Sent whenever new data was downloaded */
   void onlineClientAndAtcUpdated(bool loadAll, bool keepSelection, bool force);
@@ -167,26 +180,102 @@ private:
   void startDownloadInternal();
   void startDownloadTimer();
   void stopAllProcesses();
-  void updateAtcSizes();
 
   /* Show message from status.txt */
   void showMessageDialog();
   QString uncompress(const QByteArray& data, const QString& func, bool utf8);
   void startDownloader();
 
-  /* Tries to fetch geometry for atc centers from the user geometry database from cache */
-  const atools::geo::LineString *airspaceGeometryCallback(const QString& callsign, atools::fs::online::fac::FacilityType type);
+  /* Result of background loading which is taken over by the GUI thread */
+  struct WhazzupResult
+  {
+    /* True if the data was parsed and is more recent than the last one */
+    bool updated = false;
+
+    /* Metadata from the whazzup file */
+    QDateTime lastUpdateTime;
+    int reloadMinutes = 0;
+
+    /* Callsigns and positions of all aircraft in the file */
+    QList<atools::fs::online::OnlineAircraft> clientCallsignAndPos;
+
+    /* Clients loaded from the staging database */
+    OnlineClientStore clients;
+  };
+
+  /* Start parsing of whazzup and last transceivers data in background */
+  void startWhazzupLoading(const QByteArray& data);
+
+  /* Called in background thread. Opens staging database and manager, parses the files and closes all again. */
+  WhazzupResult loadWhazzup(QByteArray whazzupData, QByteArray transceiverData, atools::fs::online::Format format,
+                            QDateTime lastUpdate, atools::fs::online::AtcSizeMap atcSizeMap);
+
+  /* Called by watcher when loading is done. Copies staging tables and continues the download chain. */
+  void whazzupLoaded();
+
+  /* Copy tables owned by the staging database to the online database in one transaction.
+   * Servers are kept if they are downloaded separately for the given format. */
+  void copyStagingTables(atools::fs::online::Format format);
+
+  /* Build ATC circle sizes from options */
+  atools::fs::online::AtcSizeMap atcSizesFromOptions() const;
+
+  /* Tries to fetch geometry for atc centers from the user geometry database from cache.
+   * Called in background thread while parsing. airspaceQueries have to be locked by the caller. */
+  const atools::geo::LineString *airspaceGeometryCallback(AirspaceQueries *airspaceQueries, const QString& callsign,
+                                                          atools::fs::online::fac::FacilityType type);
 
   /* Called after each download */
   void updateShadowIndex();
   void clearShadowIndexes();
 
-  /* Return online aircraft for simulator aircraft based on distance and other parameter similarity */
-  atools::fs::online::OnlineAircraft shadowAircraftInternal(const atools::fs::sc::SimConnectAircraft& simAircraft);
+  /* Position and movement of a simulator aircraft at a given time */
+  struct ShadowSample
+  {
+    qint64 timeMs = 0L;
+    atools::geo::Pos pos;
+    float altitudeFt = 0.f, groundSpeedKts = 0.f, headingDegTrue = 0.f;
+  };
+
+  /* Samples of a simulator aircraft sorted by time and taken in intervals of a few seconds */
+  struct ShadowHistory
+  {
+    QString registrationKey;
+    bool user = false, boat = false;
+    QVector<ShadowSample> samples;
+  };
+
+  /* Add sample to history, match new or changed aircraft and set shadow flag */
+  void updateShadowAircraft(atools::fs::sc::SimConnectAircraft& simAircraft, qint64 nowMs, bool removeShadow);
+
+  /* Find online aircraft for sample and update id maps */
+  void matchShadowAircraft(int simId, const ShadowHistory& history, const ShadowSample& sample);
+
+  /* Return online aircraft for simulator aircraft based on callsign, distance and other parameter similarity */
+  atools::fs::online::OnlineAircraft shadowAircraftInternal(const ShadowHistory& history, const ShadowSample& sample);
 
   /* Database manager */
   atools::fs::online::OnlinedataManager *manager;
 
+  /* Staging database file next to the online database. Connection is opened only by the worker thread. */
+  QString stagingDatabaseFile;
+
+  /* Whazzup metadata and aircraft positions of the last parsed file returned by the worker thread */
+  QDateTime lastUpdateTimeFromWhazzup;
+  int reloadMinutesFromWhazzup = 0;
+  QList<atools::fs::online::OnlineAircraft> clientCallsignAndPos;
+
+  QFutureWatcher<WhazzupResult> whazzupWatcher;
+
+  /* Incremented on options changes to discard results of running tasks */
+  int generation = 0, whazzupGeneration = 0;
+
+  /* Last downloaded transceivers file which is parsed together with each whazzup file */
+  QByteArray transceiverData;
+
+  /* Options for the geometry callback copied before starting the worker */
+  bool airspaceByName = false, airspaceByFile = false;
+
   /* Downloader for all files */
   atools::util::HttpDownloader *downloader;
 
@@ -225,7 +314,7 @@ private:
 
   QTextCodec *codec = nullptr;
 
-  bool verbose = false;
+  bool verbose = false, parserDebug = false;
 
   // All online aircraft from download for spatial search (nearest)
   atools::geo::SpatialIndex<atools::fs::online::OnlineAircraft> onlineAircraftSpatialIndex;
@@ -237,13 +326,23 @@ private:
   QHash<int, int> aircraftIdSimToOnline, // All shadow aircraft mapped from sim key to online value
                   aircraftIdOnlineToSim; // Shadow aircraft mapped from online key to sim value
 
-  // Time series of all data received from simulator. Needed to get a set of aircraft which
+  // Position history of all simulator aircraft by object ID. Needed to get positions which
   // fit to the last update time of the downloaded whazzup file
-  QMap<QDateTime, atools::fs::sc::SimConnectData> currentDataPacketMap;
+  QHash<int, ShadowHistory> shadowHistories;
+
+  // Latest simulator state of shadow aircraft by object ID
+  QHash<int, atools::fs::sc::SimConnectAircraft> shadowSimAircraft;
+
+  // All online aircraft from download by normalized callsign (registration key)
+  QMultiHash<QString, atools::fs::online::OnlineAircraft> onlineAircraftByKey;
 
   // Cache used for map display
   query::SimpleRectCache<atools::fs::sc::SimConnectAircraft> aircraftCache;
-  atools::sql::SqlQuery *aircraftByRectQuery = nullptr;
+
+  // Clients of the last download used instead of SQL queries
+  OnlineClientStore clientStore;
+
+  quint64 onlineVersion = 1;
 };
 
 #endif // LNM_ONLINECONTROLLER_H
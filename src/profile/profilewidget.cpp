@@ -41,6 +41,7 @@
 #include "profile/profileoptions.h"
 #include "profile/profilescrollarea.h"
 #include "route/route.h"
+#include "route/routecontroller.h"
 #include "route/routealtitude.h"
 #include "settings/settings.h"
 #include "ui_mainwindow.h"
@@ -48,7 +49,9 @@
 #include "weather/windreporter.h"
 
 #include <QPainter>
+#include <QSet>
 #include <QTimer>
+#include <QtConcurrent/QtConcurrentMap>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QStringBuilder>
 
@@ -160,14 +163,32 @@ struct ElevationLeg
 
 struct ElevationLegList
 {
-  Route route; /* Copy from route controller.
-                * Need a copy to avoid thread synchronization problems. */
+  /* Shared snapshot from route controller. Immutable to avoid thread synchronization problems. */
+  std::shared_ptr<const Route> route = std::make_shared<const Route>();
   QList<ElevationLeg> elevationLegs; /* Elevation data for each route leg */
   float maxElevationFt = 0.f /* Maximum ground elevation for the route */,
         totalDistance = 0.f /* Total route distance in nautical miles */;
   int totalNumPoints = 0; /* Number of elevation points in whole flight plan */
+
+  /* Raw elevation points in meter keyed by leg geometry. Passed to the next calculation to fetch only changed legs.
+   * Contains only legs of the current route. */
+  QHash<QByteArray, atools::geo::LineString> elevationCache;
 };
 
+/* Build cache key from all coordinates of the leg geometry */
+static QByteArray elevationCacheKey(const atools::geo::LineString& geometry)
+{
+  QByteArray key;
+  key.reserve(geometry.size() * 2 * static_cast<int>(sizeof(float)));
+  for(const Pos& pos : geometry)
+  {
+    float lonX = pos.getLonX(), latY = pos.getLatY();
+    key.append(reinterpret_cast<const char *>(&lonX), sizeof(float));
+    key.append(reinterpret_cast<const char *>(&latY), sizeof(float));
+  }
+  return key;
+}
+
 // =======================================================================================
 
 ProfileWidget::ProfileWidget(QWidget *parent)
@@ -394,11 +415,21 @@ float ProfileWidget::getGroundBufferForLegFt(int legIndex)
 
 void ProfileWidget::showIlsChanged()
 {
-  NavApp::getRoute().updateApproachIls();
-  legList->route.updateApproachIls();
+  updateApproachIls();
+
+  // Snapshot is immutable - update ILS on a copy of the route belonging to the elevation data
+  Route *route = new Route(*legList->route);
+  route->updateApproachIls();
+  legList->route.reset(route);
   update();
 }
 
+void ProfileWidget::updateApproachIls()
+{
+  NavApp::getRoute().updateApproachIls();
+  NavApp::getRouteController()->routeModified();
+}
+
 float ProfileWidget::calcGroundBufferFt(float maxElevationFt)
 {
   if(maxElevationFt < map::INVALID_ALTITUDE_VALUE)
@@ -430,9 +461,9 @@ void ProfileWidget::updateScreenCoords()
   minSafeAltitudeFt = calcGroundBufferFt(legList->maxElevationFt);
 
   if(profileOptions->getDisplayOptions().testFlag(optsp::PROFILE_SAFE_ALTITUDE) && minSafeAltitudeFt < map::INVALID_ALTITUDE_VALUE)
-    maxWindowAlt = std::max(minSafeAltitudeFt, legList->route.getCruiseAltitudeFt());
+    maxWindowAlt = std::max(minSafeAltitudeFt, legList->route->getCruiseAltitudeFt());
   else
-    maxWindowAlt = legList->route.getCruiseAltitudeFt();
+    maxWindowAlt = legList->route->getCruiseAltitudeFt();
 
   if(simData.getUserAircraftConst().isValid() && (showAircraft || showAircraftTrail) && !NavApp::getRouteConst().isFlightplanEmpty())
     maxWindowAlt = std::max(maxWindowAlt, aircraftAlt(simData.getUserAircraftConst()));
@@ -538,7 +569,7 @@ int ProfileWidget::getMinSafeAltitudeY() const
 
 int ProfileWidget::getFlightplanAltY() const
 {
-  return altitudeY(legList->route.getCruiseAltitudeFt());
+  return altitudeY(legList->route->getCruiseAltitudeFt());
 }
 
 bool ProfileWidget::hasValidRouteForDisplay() const
@@ -853,15 +884,15 @@ void ProfileWidget::calcLeftMargin()
 {
   QFontMetrics metrics(OptionData::instance().getMapFont());
   left = 30;
-  if(!legList->route.isEmpty())
+  if(!legList->route->isEmpty())
   {
     // Calculate departure altitude text size
-    float departAlt = legList->route.getDepartureAirportLeg().getAltitude();
+    float departAlt = legList->route->getDepartureAirportLeg().getAltitude();
     if(departAlt < map::INVALID_ALTITUDE_VALUE / 2.f)
       left = std::max(metrics.horizontalAdvance(Unit::altFeet(departAlt)), left);
 
     // Calculate destination altitude text size
-    float destAlt = legList->route.getDestinationAirportLeg().getAltitude();
+    float destAlt = legList->route->getDestinationAirportLeg().getAltitude();
     if(destAlt < map::INVALID_ALTITUDE_VALUE / 2.f)
       left = std::max(metrics.horizontalAdvance(Unit::altFeet(destAlt)), left);
     left += 8;
@@ -878,7 +909,7 @@ void ProfileWidget::paintEvent(QPaintEvent *)
     return;
 
   // Saved route that was used to create the geometry
-  const Route& route = legList->route;
+  const Route& route = *legList->route;
 
   const RouteAltitude& altitudeLegs = route.getAltitudeLegs();
   const OptionData& optionData = OptionData::instance();
@@ -911,7 +942,7 @@ void ProfileWidget::paintEvent(QPaintEvent *)
     return;
   }
 
-  if(legList->route.size() != route.size() || atools::almostNotEqual(legList->route.getTotalDistance(), route.getTotalDistance()))
+  if(legList->route->size() != route.size() || atools::almostNotEqual(legList->route->getTotalDistance(), route.getTotalDistance()))
     // Do not draw if route is updated to avoid invalid indexes
     return;
 
@@ -1006,7 +1037,7 @@ void ProfileWidget::paintEvent(QPaintEvent *)
     {
       // Set all points to flight plan cruise altitude if no TOD and TOC wanted
       for(QPointF& pt : geo)
-        pt.setY(legList->route.getCruiseAltitudeFt());
+        pt.setY(legList->route->getCruiseAltitudeFt());
     }
     altLegs.append(toScreen(geo));
   }
@@ -1615,7 +1646,7 @@ void ProfileWidget::paintEvent(QPaintEvent *)
 
     // Departure altitude label =========================================================
     QColor labelColor = mapcolors::profileLabelColor;
-    float departureAlt = legList->route.getDepartureAirportLeg().getAltitude();
+    float departureAlt = legList->route->getDepartureAirportLeg().getAltitude();
     int departureAltTextY = TOP + roundToInt(h - departureAlt * verticalScale);
     departureAltTextY = std::min(departureAltTextY, TOP + h - painter.fontMetrics().height() / 2);
     QString startAltStr = Unit::altFeet(departureAlt);
@@ -1855,6 +1886,9 @@ void ProfileWidget::elevationUpdateAvailable()
 
   // Do not terminate thread here since this can lead to starving updates
 
+  // Elevation data is more complete or provider changed - fetch all legs again
+  legList->elevationCache.clear();
+
   // Start thread after long delay to calculate new data
   // Calls ProfileWidget::updateTimeout()
   updateTimer->start(NavApp::isGlobeOfflineProvider() ?
@@ -1878,7 +1912,7 @@ void ProfileWidget::aircraftPerformanceChanged(const atools::fs::perf::AircraftP
 
 const Route& ProfileWidget::getRoute() const
 {
-  return legList->route;
+  return *legList->route;
 }
 
 void ProfileWidget::windUpdated()
@@ -1891,7 +1925,8 @@ void ProfileWidget::routeChanged(bool geometryChanged, bool newFlightplan)
   if(databaseLoadStatus)
     return;
 
-  showIlsChanged();
+  // Elevation data and its route are replaced later by the thread if geometry changed
+  updateApproachIls();
   scrollArea->routeChanged(geometryChanged);
 
   if(newFlightplan)
@@ -1926,8 +1961,11 @@ void ProfileWidget::updateTimeout()
   // Need a copy of the leg list before starting thread to avoid synchronization problems
   // Start the computation in background
   ElevationLegList legs;
-  legs.route = NavApp::getRouteConst();
-  legs.route.updateApproachIls();
+  // Shared snapshot of the route which already has approach ILS updated in routeChanged()
+  legs.route = NavApp::getRouteSnapshot();
+
+  // Pass elevation points of last calculation to avoid fetching unchanged legs again
+  legs.elevationCache = legList->elevationCache;
 
   // Start thread
   future = QtConcurrent::run(this, &ProfileWidget::fetchRouteElevationsThread, legs);
@@ -2018,7 +2056,8 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations, co
   return true;
 }
 
-/* Background thread. Fetches elevation points from Marble elevation model and updates totals. */
+/* Background thread. Fetches elevation points from Marble elevation model and updates totals.
+ * Elevations for legs not found in the cache are fetched in parallel using the global thread pool. */
 ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs) const
 {
   QThread::currentThread()->setPriority(QThread::LowestPriority);
@@ -2033,27 +2072,85 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
   legs.maxElevationFt = 0.f;
   legs.elevationLegs.clear();
 
-  if(legs.route.getSizeWithoutAlternates() <= 1)
+  if(legs.route->getSizeWithoutAlternates() <= 1)
     // Return empty result
     return ElevationLegList();
 
-  if(legs.route.getAltitudeLegs().isEmpty())
+  if(legs.route->getAltitudeLegs().isEmpty())
     // Return empty result
     return ElevationLegList();
 
+  // Collect geometry for all legs and find the ones which have to be fetched ===============================
+  int numLegs = 0;
+  QVector<LineString> legGeometries; /* Empty geometry for skipped legs */
+  QVector<LineString> missingGeometries;
+  QSet<QByteArray> missingKeys;
+  for(int i = 1; i <= legs.route->getDestinationLegIndex(); i++)
+  {
+    const RouteAltitudeLeg& altLeg = legs.route->getAltitudeLegAt(i);
+    if(altLeg.isMissed() || altLeg.isAlternate())
+      break;
+
+    LineString geometry;
+
+    // Skip for too long segments when using the marble online provider
+    if(altLeg.getDistanceTo() < ELEVATION_MAX_LEG_NM || NavApp::isGlobeOfflineProvider())
+    {
+      geometry = altLeg.getGeoLineString();
+      geometry.removeInvalid();
+      if(geometry.isEmpty())
+        // Return empty result
+        return ElevationLegList();
+
+      if(geometry.size() == 1)
+        geometry.append(geometry.constFirst());
+
+      QByteArray key = elevationCacheKey(geometry);
+      if(!legs.elevationCache.contains(key) && !missingKeys.contains(key))
+      {
+        missingKeys.insert(key);
+        missingGeometries.append(geometry);
+      }
+    }
+    legGeometries.append(geometry);
+    numLegs++;
+  }
+
+  // Fetch changed legs in parallel ============================================================
+  if(!missingGeometries.isEmpty())
+  {
+    const QVector<LineString> missingElevations =
+      QtConcurrent::blockingMapped<QVector<LineString> >(missingGeometries, [this](const LineString& geometry) -> LineString {
+      LineString elevations;
+      fetchRouteElevations(elevations, geometry);
+      return elevations;
+    });
+
+    if(terminateThreadSignal)
+      return ElevationLegList();
+
+    for(int i = 0; i < missingGeometries.size(); i++)
+      legs.elevationCache.insert(elevationCacheKey(missingGeometries.at(i)), missingElevations.at(i));
+  }
+
+#ifdef DEBUG_INFORMATION_PROFILE
+  qDebug() << Q_FUNC_INFO << "legs" << numLegs << "fetched" << missingGeometries.size();
+#endif
+
+  // Merge legs in order and calculate distances ==============================================
   // Total calculated distance across all legs
   double totalDistanceNm = 0.;
+  QHash<QByteArray, LineString> usedElevations;
 
   // Loop over all route legs - first is departure airport point
-  for(int i = 1; i <= legs.route.getDestinationLegIndex(); i++)
+  for(int i = 1; i <= numLegs; i++)
   {
     if(terminateThreadSignal)
       // Return empty result
       return ElevationLegList();
 
-    const RouteAltitudeLeg& altLeg = legs.route.getAltitudeLegAt(i);
-    if(altLeg.isMissed() || altLeg.isAlternate())
-      break;
+    const RouteAltitudeLeg& altLeg = legs.route->getAltitudeLegAt(i);
+    const LineString& geometry = legGeometries.at(i - 1);
 
     ElevationLeg leg;
     leg.ident = altLeg.getIdent();
@@ -2061,19 +2158,12 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
     // Used to adapt distances of all legs to total distance due to inaccuracies
     double scale = 1.;
 
-    // Skip for too long segments when using the marble online provider
-    if(altLeg.getDistanceTo() < ELEVATION_MAX_LEG_NM || NavApp::isGlobeOfflineProvider())
+    if(!geometry.isEmpty())
     {
-      LineString geometry = altLeg.getGeoLineString();
-
-      geometry.removeInvalid();
-      if(geometry.size() == 1)
-        geometry.append(geometry.constFirst());
-
       // Includes first and last point
-      LineString elevations;
-      if(!fetchRouteElevations(elevations, geometry))
-        return ElevationLegList();
+      QByteArray key = elevationCacheKey(geometry);
+      LineString elevations = legs.elevationCache.value(key);
+      usedElevations.insert(key, elevations);
 
       if(elevations.isEmpty())
         return ElevationLegList();
@@ -2090,9 +2180,6 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
       Pos lastPos;
       for(int j = 0; j < elevations.size(); j++)
       {
-        if(terminateThreadSignal)
-          return ElevationLegList();
-
         Pos& coord = elevations[j];
         float altFeet = meterToFeet(coord.getAltitude());
         coord.setAltitude(altFeet);
@@ -2154,6 +2241,9 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
     legs.elevationLegs.append(leg);
   }
 
+  // Keep only legs of the current route to limit cache size
+  legs.elevationCache = usedElevations;
+
   legs.totalDistance = static_cast<float>(totalDistanceNm);
   return legs;
 }
@@ -2248,7 +2338,7 @@ void ProfileWidget::calculateDistancesAndPos(int x, atools::geo::Pos& pos, int&
 
 void ProfileWidget::mouseMoveEvent(QMouseEvent *mouseEvent)
 {
-  if(!widgetVisible || legList->elevationLegs.isEmpty() || legList->route.isEmpty())
+  if(!widgetVisible || legList->elevationLegs.isEmpty() || legList->route->isEmpty())
     return;
 
   if(rubberBand == nullptr)
@@ -2331,7 +2421,7 @@ void ProfileWidget::buildTooltipText(int x, bool force)
            << "distanceToGo" << distanceToGo << "groundElevation" << groundElevation << "maxElev" << maxElev;
 #endif
 
-  const RouteLeg& routeLeg = legList->route.value(index + 1);
+  const RouteLeg& routeLeg = legList->route->value(index + 1);
   if(routeLeg.isAnyProcedure() && proc::procedureLegFrom(routeLeg.getProcedureLegType()))
     fromTo = tr("from");
 
@@ -2341,8 +2431,8 @@ void ProfileWidget::buildTooltipText(int x, bool force)
   atools::util::HtmlBuilder html;
 
   // Header from and to distance, altitude and next waypoint ============
-  float altitude = legList->route.getAltitudeForDistance(distanceToGo);
-  const RouteLeg *leg = index < legList->route.size() - 1 ? &legList->route.value(index + 1) : nullptr;
+  float altitude = legList->route->getAltitudeForDistance(distanceToGo);
+  const RouteLeg *leg = index < legList->route->size() - 1 ? &legList->route->value(index + 1) : nullptr;
   WindReporter *windReporter = NavApp::getWindReporter();
   atools::grib::Wind wind;
   if(windReporter->hasAnyWindData() && leg != nullptr)
@@ -2366,7 +2456,7 @@ void ProfileWidget::buildTooltipText(int x, bool force)
     // Crab angle / heading ========================================
     if(wind.isValid() && !wind.isNull())
     {
-      float tas = legList->route.getSpeedForDistance(distanceToGo);
+      float tas = legList->route->getSpeedForDistance(distanceToGo);
       if(tas < map::INVALID_SPEED_VALUE)
       {
 #ifdef DEBUG_INFORMATION_PROFILE
@@ -2384,7 +2474,7 @@ void ProfileWidget::buildTooltipText(int x, bool force)
 
   // Vertical angle ===============================================================
   bool required = false;
-  float verticalAngle = legList->route.getVerticalAngleAtDistance(distanceToGo, &required);
+  float verticalAngle = legList->route->getVerticalAngleAtDistance(distanceToGo, &required);
 
   if(verticalAngle < -0.5f)
     html.br().b(required ? tr("Required Flight Path Angle: ") : tr("Flight path angle: ")).
@@ -2661,7 +2751,7 @@ void ProfileWidget::leaveEvent(QEvent *)
 
 void ProfileWidget::hideRubberBand()
 {
-  if(!widgetVisible || legList->elevationLegs.isEmpty() || legList->route.isEmpty())
+  if(!widgetVisible || legList->elevationLegs.isEmpty() || legList->route->isEmpty())
     return;
 
   delete rubberBand;
@@ -215,6 +215,10 @@ private:
 
   bool fetchRouteElevations(atools::geo::LineString& elevations, const atools::geo::LineString& geometry) const;
   ElevationLegList fetchRouteElevationsThread(ElevationLegList legs) const;
+
+  /* Update ILS in flight plan for current display options */
+  void updateApproachIls();
+
   void elevationUpdateAvailable();
   void updateTimeout();
   void updateThreadFinished();
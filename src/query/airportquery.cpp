@@ -25,7 +25,6 @@
 #include "fs/common/binarygeometry.h"
 #include "sql/sqldatabase.h"
 #include "common/maptools.h"
-#include "settings/settings.h"
 #include "app/navapp.h"
 #include "sql/sqlutil.h"
 #include "fs/util/fsutil.h"
@@ -54,21 +53,21 @@ inline uint qHash(const NearestCacheKeyPosIdentDist& key)
   return qHash(std::get<0>(key)) ^ qHash(std::get<1>(key)) ^ qHash(std::get<2>(key));
 }
 
-AirportQuery::AirportQuery(atools::sql::SqlDatabase *sqlDb, const Queries *queriesParam, bool nav)
+AirportQuery::AirportQuery(atools::sql::SqlDatabase *sqlDb, const Queries *queriesParam, bool nav,
+                           const query::QuerySettings& settings)
   : navdata(nav), db(sqlDb), queries(queriesParam)
 {
   mapTypesFactory = new MapTypesFactory();
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
-
-  runwayCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "RunwayCache", 2000).toInt());
-  apronCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "ApronCache", 1000).toInt());
-  taxipathCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "TaxipathCache", 1000).toInt());
-  parkingCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "ParkingCache", 1000).toInt());
-  startCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "StartCache", 1000).toInt());
-  helipadCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "HelipadCache", 1000).toInt());
-  airportIdCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "AirportIdCache", 1000).toInt());
-  airportFuzzyIdCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "AirportFuzzyIdCache", 1000).toInt());
-  airportIdentCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "AirportIdentCache", 1000).toInt());
+
+  runwayCache.setMaxCost(settings.airportQuery.runwayCache);
+  apronCache.setMaxCost(settings.airportQuery.apronCache);
+  taxipathCache.setMaxCost(settings.airportQuery.taxipathCache);
+  parkingCache.setMaxCost(settings.airportQuery.parkingCache);
+  startCache.setMaxCost(settings.airportQuery.startCache);
+  helipadCache.setMaxCost(settings.airportQuery.helipadCache);
+  airportIdCache.setMaxCost(settings.airportQuery.airportIdCache);
+  airportFuzzyIdCache.setMaxCost(settings.airportQuery.airportFuzzyIdCache);
+  airportIdentCache.setMaxCost(settings.airportQuery.airportIdentCache);
 }
 
 AirportQuery::~AirportQuery()
@@ -24,6 +24,9 @@
 #include <QSet>
 
 class Queries;
+namespace query {
+struct QuerySettings;
+}
 namespace Marble {
 class GeoDataLatLonBox;
 }
@@ -218,7 +221,7 @@ private:
    * @param sqlDb database for simulator scenery data
    * @param sqlDbNav for updated navaids
    */
-  explicit AirportQuery(atools::sql::SqlDatabase *sqlDb, const Queries *queriesParam, bool nav);
+  explicit AirportQuery(atools::sql::SqlDatabase *sqlDb, const Queries *queriesParam, bool nav, const query::QuerySettings& settings);
 
   /* Close all query objects thus disconnecting from the database */
   void initQueries();
@@ -20,20 +20,20 @@
 #include "query/airspacequery.h"
 
 AirspaceQueries::AirspaceQueries(atools::sql::SqlDatabase *dbSim, atools::sql::SqlDatabase *dbNav, atools::sql::SqlDatabase *dbUser,
-                                 atools::sql::SqlDatabase *dbOnline)
+                                 atools::sql::SqlDatabase *dbOnline, const query::QuerySettings& settings)
 {
   // Create all query objects =================================
   if(dbSim != nullptr)
-    airspaceQueries.insert(map::AIRSPACE_SRC_SIM, new AirspaceQuery(dbSim, map::AIRSPACE_SRC_SIM));
+    airspaceQueries.insert(map::AIRSPACE_SRC_SIM, new AirspaceQuery(dbSim, map::AIRSPACE_SRC_SIM, settings));
 
   if(dbNav != nullptr)
-    airspaceQueries.insert(map::AIRSPACE_SRC_NAV, new AirspaceQuery(dbNav, map::AIRSPACE_SRC_NAV));
+    airspaceQueries.insert(map::AIRSPACE_SRC_NAV, new AirspaceQuery(dbNav, map::AIRSPACE_SRC_NAV, settings));
 
   if(dbUser != nullptr)
-    airspaceQueries.insert(map::AIRSPACE_SRC_USER, new AirspaceQuery(dbUser, map::AIRSPACE_SRC_USER));
+    airspaceQueries.insert(map::AIRSPACE_SRC_USER, new AirspaceQuery(dbUser, map::AIRSPACE_SRC_USER, settings));
 
   if(dbOnline != nullptr)
-    airspaceQueries.insert(map::AIRSPACE_SRC_ONLINE, new AirspaceQuery(dbOnline, map::AIRSPACE_SRC_ONLINE));
+    airspaceQueries.insert(map::AIRSPACE_SRC_ONLINE, new AirspaceQuery(dbOnline, map::AIRSPACE_SRC_ONLINE, settings));
 }
 
 AirspaceQueries::~AirspaceQueries()
@@ -31,6 +31,9 @@ class SqlDatabase;
 }
 }
 class AirspaceQuery;
+namespace query {
+struct QuerySettings;
+}
 
 typedef  QHash<map::MapAirspaceSources, AirspaceQuery *> AirspaceQueryMapType;
 typedef  QVector<const map::MapAirspace *> AirspaceVector;
@@ -126,7 +129,8 @@ private:
   friend class AirspaceController;
 
   explicit AirspaceQueries(atools::sql::SqlDatabase *dbSim, atools::sql::SqlDatabase *dbNav,
-                           atools::sql::SqlDatabase *dbUser, atools::sql::SqlDatabase *dbOnline);
+                           atools::sql::SqlDatabase *dbUser, atools::sql::SqlDatabase *dbOnline,
+                           const query::QuerySettings& settings);
 
   /* Close all query objects thus disconnecting from the database */
   void initQueries();
@@ -23,7 +23,6 @@
 #include "common/maptypesfactory.h"
 #include "fs/common/binarygeometry.h"
 #include "mapgui/maplayer.h"
-#include "settings/settings.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlutil.h"
 
@@ -35,23 +34,19 @@ using namespace Marble;
 using namespace atools::sql;
 using namespace atools::geo;
 
-static double queryRectInflationFactor = 0.2;
-static double queryRectInflationIncrement = 0.1;
-int AirspaceQuery::queryMaxRows = map::MAX_MAP_OBJECTS;
 
-AirspaceQuery::AirspaceQuery(SqlDatabase *sqlDb, map::MapAirspaceSource src)
+AirspaceQuery::AirspaceQuery(SqlDatabase *sqlDb, map::MapAirspaceSource src, const query::QuerySettings& settings)
   : db(sqlDb), source(src)
 {
   mapTypesFactory = new MapTypesFactory();
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
 
-  airspaceLineCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "AirspaceLineCache", 10000).toInt());
-  onlineCenterGeoCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "OnlineCenterGeoCache", 10000).toInt());
-  onlineCenterGeoFileCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "OnlineCenterGeoFileCache", 10000).toInt());
+  airspaceLineCache.setMaxCost(settings.airspaceQuery.airspaceLineCache);
+  onlineCenterGeoCache.setMaxCost(settings.airspaceQuery.onlineCenterGeoCache);
+  onlineCenterGeoFileCache.setMaxCost(settings.airspaceQuery.onlineCenterGeoFileCache);
 
-  queryRectInflationFactor = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "QueryRectInflationFactor", 0.3).toDouble();
-  queryRectInflationIncrement = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "QueryRectInflationIncrement", 0.1).toDouble();
-  queryMaxRows = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "AirspaceQueryRowLimit", map::MAX_MAP_OBJECTS).toInt();
+  queryRectInflationFactor = settings.airspaceQuery.queryRectInflationFactor;
+  queryRectInflationIncrement = settings.airspaceQuery.queryRectInflationIncrement;
+  queryMaxRows = settings.airspaceQuery.queryMaxRows;
 }
 
 AirspaceQuery::~AirspaceQuery()
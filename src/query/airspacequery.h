@@ -55,7 +55,7 @@ public:
 private:
   friend class AirspaceQueries;
 
-  explicit AirspaceQuery(atools::sql::SqlDatabase *sqlDb, map::MapAirspaceSource src);
+  explicit AirspaceQuery(atools::sql::SqlDatabase *sqlDb, map::MapAirspaceSource src, const query::QuerySettings& settings);
 
   void getAirspaceById(map::MapAirspace& airspace, int airspaceId);
 
@@ -110,7 +110,8 @@ private:
   QCache<int, atools::geo::LineString> airspaceLineCache;
   QCache<QString, atools::geo::LineString> onlineCenterGeoCache, onlineCenterGeoFileCache;
 
-  static int queryMaxRows;
+  int queryMaxRows = map::MAX_MAP_OBJECTS;
+  double queryRectInflationFactor = 0.2, queryRectInflationIncrement = 0.1;
 
   /* True if tables atc or boundary have content. Updated in clearCache and initQueries */
   bool hasAirspaces = false,
@@ -21,7 +21,6 @@
 #include "common/mapresult.h" // Needed for delete operator
 #include "common/maptypesfactory.h"
 #include "mapgui/maplayer.h"
-#include "settings/settings.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlutil.h"
 
@@ -31,19 +30,15 @@ using namespace Marble;
 using namespace atools::sql;
 using namespace atools::geo;
 
-static double queryRectInflationFactor = 0.2;
-static double queryRectInflationIncrement = 0.1;
-int AirwayQuery::queryMaxRowsAirways = map::MAX_MAP_OBJECTS;
 
-AirwayQuery::AirwayQuery(SqlDatabase *sqlDbNav, bool trackParam)
+AirwayQuery::AirwayQuery(SqlDatabase *sqlDbNav, bool trackParam, const query::QuerySettings& settings)
   : dbNav(sqlDbNav), track(trackParam)
 {
   mapTypesFactory = new MapTypesFactory();
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
 
-  queryRectInflationFactor = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "QueryRectInflationFactor", 0.3).toDouble();
-  queryRectInflationIncrement = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "QueryRectInflationIncrement", 0.1).toDouble();
-  queryMaxRowsAirways = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "AirwayQueryRowLimitAw", map::MAX_MAP_OBJECTS).toInt();
+  queryRectInflationFactor = settings.airwayQuery.queryRectInflationFactor;
+  queryRectInflationIncrement = settings.airwayQuery.queryRectInflationIncrement;
+  queryMaxRowsAirways = settings.airwayQuery.queryMaxRows;
 }
 
 AirwayQuery::~AirwayQuery()
@@ -97,7 +97,7 @@ private:
   /*
    * @param sqlDbNav for updated navaids
    */
-  explicit AirwayQuery(atools::sql::SqlDatabase *sqlDbNav, bool trackParam);
+  explicit AirwayQuery(atools::sql::SqlDatabase *sqlDbNav, bool trackParam, const query::QuerySettings& settings);
 
   /* Close all query objects thus disconnecting from the database */
   void initQueries();
@@ -124,7 +124,8 @@ private:
   /* true if this uses the track database (PACOTS, NAT, etc.) */
   bool track;
 
-  static int queryMaxRowsAirways;
+  int queryMaxRowsAirways = map::MAX_MAP_OBJECTS;
+  double queryRectInflationFactor = 0.2, queryRectInflationIncrement = 0.1;
 
   /* Database queries */
   atools::sql::SqlQuery *airwayByRectQuery = nullptr;
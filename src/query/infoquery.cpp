@@ -21,7 +21,6 @@
 #include "app/navapp.h"
 #include "common/maptools.h"
 #include "query/querytypes.h"
-#include "settings/settings.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
@@ -33,23 +32,23 @@ using atools::sql::SqlRecord;
 using atools::sql::SqlRecordList;
 using atools::sql::SqlUtil;
 
-InfoQuery::InfoQuery(SqlDatabase *sqlDbSim, atools::sql::SqlDatabase *sqlDbNav, atools::sql::SqlDatabase *sqlDbTrack)
+InfoQuery::InfoQuery(SqlDatabase *sqlDbSim, atools::sql::SqlDatabase *sqlDbNav, atools::sql::SqlDatabase *sqlDbTrack,
+                     const query::QuerySettings& settings)
   : dbSim(sqlDbSim), dbNav(sqlDbNav), dbTrack(sqlDbTrack)
 {
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
-  airportCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "AirportCache", 100).toInt());
-  vorCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "VorCache", 100).toInt());
-  ndbCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "NdbCache", 100).toInt());
-  msaCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "MsaCache", 100).toInt());
-  holdingCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "HoldingCache", 100).toInt());
-  runwayEndCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "RunwayEndCache", 100).toInt());
-  comCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "ComCache", 100).toInt());
-  runwayCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "RunwayCache", 100).toInt());
-  helipadCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "HelipadCache", 100).toInt());
-  startCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "StartCache", 100).toInt());
-  procedureCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "ApproachCache", 100).toInt());
-  transitionCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "TransitionCache", 100).toInt());
-  airportSceneryCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "AirportSceneryCache", 100).toInt());
+  airportCache.setMaxCost(settings.infoQuery.airportCache);
+  vorCache.setMaxCost(settings.infoQuery.vorCache);
+  ndbCache.setMaxCost(settings.infoQuery.ndbCache);
+  msaCache.setMaxCost(settings.infoQuery.msaCache);
+  holdingCache.setMaxCost(settings.infoQuery.holdingCache);
+  runwayEndCache.setMaxCost(settings.infoQuery.runwayEndCache);
+  comCache.setMaxCost(settings.infoQuery.comCache);
+  runwayCache.setMaxCost(settings.infoQuery.runwayCache);
+  helipadCache.setMaxCost(settings.infoQuery.helipadCache);
+  startCache.setMaxCost(settings.infoQuery.startCache);
+  procedureCache.setMaxCost(settings.infoQuery.approachCache);
+  transitionCache.setMaxCost(settings.infoQuery.transitionCache);
+  airportSceneryCache.setMaxCost(settings.infoQuery.airportSceneryCache);
 }
 
 InfoQuery::~InfoQuery()
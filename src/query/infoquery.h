@@ -34,6 +34,10 @@ class SqlRecord;
 }
 }
 
+namespace query {
+struct QuerySettings;
+}
+
 /*
  * Database queries for the info controller. Does not return objects but sql records. Records are cached.
  */
@@ -94,7 +98,8 @@ private:
    * @param sqlDb database for simulator scenery data
    * @param sqlDbNav for updated navaids
    */
-  explicit InfoQuery(atools::sql::SqlDatabase *sqlDbSim, atools::sql::SqlDatabase *sqlDbNav, atools::sql::SqlDatabase *sqlDbTrack);
+  explicit InfoQuery(atools::sql::SqlDatabase *sqlDbSim, atools::sql::SqlDatabase *sqlDbNav, atools::sql::SqlDatabase *sqlDbTrack,
+                     const query::QuerySettings& settings);
 
   /* Create all queries */
   void initQueries();
@@ -26,13 +26,13 @@
 #include "logbook/logdatacontroller.h"
 #include "mapgui/mapairporthandler.h"
 #include "mapgui/maplayer.h"
+#include "mapgui/mapscreengrid.h"
 #include "app/navapp.h"
 #include "online/onlinedatacontroller.h"
 #include "query/airportquery.h"
 #include "query/airspacequeries.h"
 #include "query/airwaytrackquery.h"
 #include "query/waypointtrackquery.h"
-#include "settings/settings.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlutil.h"
 #include "userdata/userdatacontroller.h"
@@ -52,10 +52,8 @@ using map::MapHelipad;
 using map::MapUserpoint;
 using map::MapAirportMsa;
 using map::MapHolding;
+using namespace std::placeholders;
 
-static double queryRectInflationFactor = 0.5;
-static double queryRectInflationIncrement = 0.5;
-int MapQuery::queryMaxRows = map::MAX_MAP_OBJECTS;
 
 // Queries only used for export ================================================
 // Get assigned airport for navaid by name, region and coordinate closest to position
@@ -75,22 +73,42 @@ static QLatin1String AIRPORTIDENT_FROM_NDB("select a.ident, n.lonx, n.laty "
                                            "order by (abs(n.lonx - :lonx) + abs(n.laty - :laty)) limit 1");
 static float MAX_AIRPORT_IDENT_DISTANCE_M = atools::geo::nmToMeter(5.f);
 
-MapQuery::MapQuery(atools::sql::SqlDatabase *sqlDbSim, SqlDatabase *sqlDbNav, SqlDatabase *sqlDbUser, const Queries *parentQueriesParam)
+MapQuery::MapQuery(atools::sql::SqlDatabase *sqlDbSim, SqlDatabase *sqlDbNav, SqlDatabase *sqlDbUser, const Queries *parentQueriesParam,
+                   const query::QuerySettings& settings)
   : dbSim(sqlDbSim), dbNav(sqlDbNav), dbUser(sqlDbUser), queries(parentQueriesParam)
 {
   mapTypesFactory = new MapTypesFactory();
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
-
-  runwayOverwiewCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "RunwayOverwiewCache", 1000).toInt());
-  queryRectInflationFactor = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor", 0.5).toDouble();
-  queryRectInflationIncrement = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.5).toDouble();
-  queryMaxRows = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "MapQueryRowLimit", map::MAX_MAP_OBJECTS).toInt();
+  screenGrid = new MapScreenGrid;
+
+  runwayOverwiewCache.setMaxCost(settings.mapQuery.runwayOverwiewCache);
+  queryRectInflationFactor = settings.mapQuery.queryRectInflationFactor;
+  queryRectInflationIncrement = settings.mapQuery.queryRectInflationIncrement;
+  queryMaxRows = settings.mapQuery.queryMaxRows;
+
+  // Maximum number of objects for each type in the tile indexes
+  int tileIndexObjects = settings.mapQuery.tileIndexObjects;
+  airportIndex.setMaxObjects(tileIndexObjects);
+  vorIndex.setMaxObjects(tileIndexObjects);
+  ndbIndex.setMaxObjects(tileIndexObjects);
+  markerIndex.setMaxObjects(tileIndexObjects);
+  holdingIndex.setMaxObjects(tileIndexObjects);
+  ilsIndex.setMaxObjects(tileIndexObjects);
+  airportMsaIndex.setMaxObjects(tileIndexObjects);
+
+  airportIndex.setMaxRows(queryMaxRows);
+  vorIndex.setMaxRows(queryMaxRows);
+  ndbIndex.setMaxRows(queryMaxRows);
+  markerIndex.setMaxRows(queryMaxRows);
+  holdingIndex.setMaxRows(queryMaxRows);
+  ilsIndex.setMaxRows(queryMaxRows);
+  airportMsaIndex.setMaxRows(queryMaxRows);
 }
 
 MapQuery::~MapQuery()
 {
   deInitQueries();
   delete mapTypesFactory;
+  delete screenGrid;
 }
 
 bool MapQuery::hasProcedures(const map::MapAirport& airport) const
@@ -686,84 +704,87 @@ void MapQuery::getNearestScreenObjects(const CoordinateConverter& conv, const Ma
   using maptools::insertSortedByDistance;
   using maptools::insertSortedByTowerDistance;
 
-  int x, y;
+  auto position = [](const map::MapBase& obj) -> const Pos& {
+                    return obj.position;
+                  };
+
+  // Points near xs/ys from the screen grid - index into cache list and screen coordinates
+  QVector<std::pair<int, QPoint> > points;
+
   if(mapLayer->isAirport() && types.testFlag(map::AIRPORT))
   {
     int minRunwayLength = NavApp::getMapAirportHandler()->getMinimumRunwayFt(); // GUI setting
-    for(int i = airportCache.list.size() - 1; i >= 0; i--)
+    updateScreenGridLayer(grid::AIRPORT, airportCache, conv, position);
+    screenGrid->getNearestPoints(points, grid::AIRPORT, xs, ys, screenDistance);
+    for(const std::pair<int, QPoint>& point : qAsConst(points))
     {
-      const MapAirport& airport = airportCache.list.at(i);
-
+      const MapAirport& airport = airportCache.list.at(point.first);
       if(airport.isVisible(types, minRunwayLength, mapLayer))
-      {
-        if(conv.wToS(airport.position, x, y))
-          if(atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-            insertSortedByDistance(conv, result.airports, &result.airportIds, xs, ys, airport);
+        insertSortedByDistance(conv, result.airports, &result.airportIds, xs, ys, airport);
+    }
 
-        if(airportDiagram)
-        {
-          // Include tower for airport diagrams
-          if(conv.wToS(airport.towerCoords, x, y) && atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-            insertSortedByTowerDistance(conv, result.towers, xs, ys, airport);
-        }
+    if(airportDiagram)
+    {
+      // Include tower for airport diagrams
+      updateScreenGridLayer(grid::AIRPORT_TOWER, airportCache, conv, [](const MapAirport& airport) -> const Pos& {
+          return airport.towerCoords;
+        });
+
+      points.clear();
+      screenGrid->getNearestPoints(points, grid::AIRPORT_TOWER, xs, ys, screenDistance);
+      for(const std::pair<int, QPoint>& point : qAsConst(points))
+      {
+        const MapAirport& airport = airportCache.list.at(point.first);
+        if(airport.isVisible(types, minRunwayLength, mapLayer))
+          insertSortedByTowerDistance(conv, result.towers, xs, ys, airport);
       }
     }
   }
 
   if(mapLayer->isAirportMsa() && types.testFlag(map::AIRPORT_MSA))
   {
-    for(int i = airportMsaCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapAirportMsa& msa = airportMsaCache.list.at(i);
-      if(conv.wToS(msa.position, x, y))
-        if(atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-          insertSortedByDistance(conv, result.airportMsa, &result.airportMsaIds, xs, ys, msa);
-    }
+    updateScreenGridLayer(grid::AIRPORT_MSA, airportMsaCache, conv, position);
+    points.clear();
+    screenGrid->getNearestPoints(points, grid::AIRPORT_MSA, xs, ys, screenDistance);
+    for(const std::pair<int, QPoint>& point : qAsConst(points))
+      insertSortedByDistance(conv, result.airportMsa, &result.airportMsaIds, xs, ys, airportMsaCache.list.at(point.first));
   }
 
   if(mapLayer->isVor() && types.testFlag(map::VOR))
   {
-    for(int i = vorCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapVor& vor = vorCache.list.at(i);
-      if(conv.wToS(vor.position, x, y))
-        if(atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-          insertSortedByDistance(conv, result.vors, &result.vorIds, xs, ys, vor);
-    }
+    updateScreenGridLayer(grid::VOR, vorCache, conv, position);
+    points.clear();
+    screenGrid->getNearestPoints(points, grid::VOR, xs, ys, screenDistance);
+    for(const std::pair<int, QPoint>& point : qAsConst(points))
+      insertSortedByDistance(conv, result.vors, &result.vorIds, xs, ys, vorCache.list.at(point.first));
   }
 
   if(mapLayer->isNdb() && types.testFlag(map::NDB))
   {
-    for(int i = ndbCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapNdb& ndb = ndbCache.list.at(i);
-      if(conv.wToS(ndb.position, x, y))
-        if((atools::geo::manhattanDistance(x, y, xs, ys)) < screenDistance)
-          insertSortedByDistance(conv, result.ndbs, &result.ndbIds, xs, ys, ndb);
-    }
+    updateScreenGridLayer(grid::NDB, ndbCache, conv, position);
+    points.clear();
+    screenGrid->getNearestPoints(points, grid::NDB, xs, ys, screenDistance);
+    for(const std::pair<int, QPoint>& point : qAsConst(points))
+      insertSortedByDistance(conv, result.ndbs, &result.ndbIds, xs, ys, ndbCache.list.at(point.first));
   }
 
   if(mapLayer->isHolding() && types.testFlag(map::HOLDING))
   {
-    for(int i = holdingCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapHolding& holding = holdingCache.list.at(i);
-      if(conv.wToS(holding.position, x, y))
-        if(atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-          insertSortedByDistance(conv, result.holdings, &result.holdingIds, xs, ys, holding);
-    }
+    updateScreenGridLayer(grid::HOLDING, holdingCache, conv, position);
+    points.clear();
+    screenGrid->getNearestPoints(points, grid::HOLDING, xs, ys, screenDistance);
+    for(const std::pair<int, QPoint>& point : qAsConst(points))
+      insertSortedByDistance(conv, result.holdings, &result.holdingIds, xs, ys, holdingCache.list.at(point.first));
   }
 
   // No flag since visibility is defined by type
   if(mapLayer->isUserpoint())
   {
-    for(int i = userpointCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapUserpoint& wp = userpointCache.list.at(i);
-      if(conv.wToS(wp.position, x, y))
-        if(atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-          insertSortedByDistance(conv, result.userpoints, &result.userpointIds, xs, ys, wp);
-    }
+    updateScreenGridLayer(grid::USERPOINT, userpointCache, conv, position);
+    points.clear();
+    screenGrid->getNearestPoints(points, grid::USERPOINT, xs, ys, screenDistance);
+    for(const std::pair<int, QPoint>& point : qAsConst(points))
+      insertSortedByDistance(conv, result.userpoints, &result.userpointIds, xs, ys, userpointCache.list.at(point.first));
   }
 
   // Add waypoints that displayed together with airways =================================
@@ -805,30 +826,27 @@ void MapQuery::getNearestScreenObjects(const CoordinateConverter& conv, const Ma
 
   if(mapLayer->isMarker() && types.testFlag(map::MARKER))
   {
-    for(int i = markerCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapMarker& wp = markerCache.list.at(i);
-      if(conv.wToS(wp.position, x, y))
-        if(atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-          insertSortedByDistance(conv, result.markers, nullptr, xs, ys, wp);
-    }
+    updateScreenGridLayer(grid::MARKER, markerCache, conv, position);
+    points.clear();
+    screenGrid->getNearestPoints(points, grid::MARKER, xs, ys, screenDistance);
+    for(const std::pair<int, QPoint>& point : qAsConst(points))
+      insertSortedByDistance(conv, result.markers, nullptr, xs, ys, markerCache.list.at(point.first));
   }
 
   if(mapLayer->isIls() && types.testFlag(map::ILS))
   {
-    for(int i = ilsCache.list.size() - 1; i >= 0; i--)
-    {
-      const MapIls& wp = ilsCache.list.at(i);
-      if(conv.wToS(wp.position, x, y))
-        if(atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
-          insertSortedByDistance(conv, result.ils, nullptr, xs, ys, wp);
-    }
+    updateScreenGridLayer(grid::ILS, ilsCache, conv, position);
+    points.clear();
+    screenGrid->getNearestPoints(points, grid::ILS, xs, ys, screenDistance);
+    for(const std::pair<int, QPoint>& point : qAsConst(points))
+      insertSortedByDistance(conv, result.ils, nullptr, xs, ys, ilsCache.list.at(point.first));
   }
 
   // Get objects from airport diagram =====================================================
   if(mapLayer->isAirport() && airportDiagram)
   {
-    // Also check parking and helipads in airport diagrams
+    // Also check parking and helipads in airport diagrams - number is small and not indexed
+    int x, y;
     QHash<int, QList<MapParking> > parkingCache = queries->getAirportQuerySim()->getParkingCache();
     for(auto it = parkingCache.constBegin(); it != parkingCache.constEnd(); ++it)
     {
@@ -858,6 +876,31 @@ void MapQuery::getNearestScreenObjects(const CoordinateConverter& conv, const Ma
   }
 }
 
+void MapQuery::clearScreenGrid() const
+{
+  screenGrid->clear();
+}
+
+template<typename TYPE, typename POSFUNC>
+void MapQuery::updateScreenGridLayer(grid::Type gridType, const query::SimpleRectCache<TYPE>& cache, const CoordinateConverter& conv,
+                                     POSFUNC posFunc) const
+{
+  const Marble::ViewportParams *viewport = conv.getViewport();
+  if(!screenGrid->isCurrent(gridType, viewport, cache.generation, cache.list.size()))
+  {
+    // Viewport or cache content changed - project all objects once
+    screenGrid->reset(gridType, viewport, cache.generation, cache.list.size());
+
+    int x, y;
+    for(int i = 0; i < cache.list.size(); i++)
+    {
+      const Pos& pos = posFunc(cache.list.at(i));
+      if(pos.isValid() && conv.wToS(pos, x, y))
+        screenGrid->insertPoint(gridType, i, QPoint(x, y));
+    }
+  }
+}
+
 const QList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy,
                                                     map::MapTypes types, bool& overflow)
 {
@@ -881,7 +924,7 @@ const QList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonB
   airportCacheNormalFlag = normal;
 
   airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
-  return fetchAirports(rect, airportByRectQuery, lazy, addonZoom || addonZoomFilter, normal, overflow);
+  return fetchAirports(rect, airportByRectQuery, lazy, addonZoom || addonZoomFilter, normal, mapLayer->getMinRunwayLength(), overflow);
 }
 
 const QList<map::MapAirport> *MapQuery::getAirportsByRect(const atools::geo::Rect& rect, const MapLayer *mapLayer, bool lazy,
@@ -902,7 +945,8 @@ const QList<map::MapAirport> *MapQuery::getAirportsByRect(const atools::geo::Rec
   airportCacheNormalFlag = normal;
 
   airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
-  return fetchAirports(latLonBox, airportByRectQuery, lazy, addonZoom || addonZoomFilter, normal, overflow);
+  return fetchAirports(latLonBox, airportByRectQuery, lazy, addonZoom || addonZoomFilter, normal, mapLayer->getMinRunwayLength(),
+                       overflow);
 }
 
 const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
@@ -919,17 +963,8 @@ const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const
 
   if(vorCache.list.isEmpty() && !lazy)
   {
-    for(const GeoDataLatLonBox& box : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(box, vorsByRectQuery);
-      vorsByRectQuery->exec();
-      while(vorsByRectQuery->next())
-      {
-        MapVor vor;
-        mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
-        vorCache.list.append(vor);
-      }
-    }
+    vorIndex.fetch(vorCache.list, query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement), 0,
+                   std::bind(&MapQuery::loadVors, this, _1, _2));
   }
   overflow = vorCache.validate(queryMaxRows);
   return &vorCache.list;
@@ -953,17 +988,8 @@ const QList<map::MapNdb> *MapQuery::getNdbs(const GeoDataLatLonBox& rect, const
 
   if(ndbCache.list.isEmpty() && !lazy)
   {
-    for(const GeoDataLatLonBox& box : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(box, ndbsByRectQuery);
-      ndbsByRectQuery->exec();
-      while(ndbsByRectQuery->next())
-      {
-        MapNdb ndb;
-        mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
-        ndbCache.list.append(ndb);
-      }
-    }
+    ndbIndex.fetch(ndbCache.list, query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement), 0,
+                   std::bind(&MapQuery::loadNdbs, this, _1, _2));
   }
   overflow = ndbCache.validate(queryMaxRows);
   return &ndbCache.list;
@@ -1101,17 +1127,8 @@ const QList<map::MapMarker> *MapQuery::getMarkers(const GeoDataLatLonBox& rect,
 
   if(markerCache.list.isEmpty() && !lazy)
   {
-    for(const GeoDataLatLonBox& box : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(box, markersByRectQuery);
-      markersByRectQuery->exec();
-      while(markersByRectQuery->next())
-      {
-        map::MapMarker marker;
-        mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
-        markerCache.list.append(marker);
-      }
-    }
+    markerIndex.fetch(markerCache.list, query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement), 0,
+                      std::bind(&MapQuery::loadMarkers, this, _1, _2));
   }
   overflow = markerCache.validate(queryMaxRows);
   return &markerCache.list;
@@ -1138,17 +1155,8 @@ const QList<map::MapHolding> *MapQuery::getHoldings(const Marble::GeoDataLatLonB
 
     if(holdingCache.list.isEmpty() && !lazy)
     {
-      for(const GeoDataLatLonBox& box : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-      {
-        query::bindRect(box, holdingByRectQuery);
-        holdingByRectQuery->exec();
-        while(holdingByRectQuery->next())
-        {
-          MapHolding holding;
-          mapTypesFactory->fillHolding(holdingByRectQuery->record(), holding);
-          holdingCache.list.append(holding);
-        }
-      }
+      holdingIndex.fetch(holdingCache.list, query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement), 0,
+                         std::bind(&MapQuery::loadHoldings, this, _1, _2));
     }
     overflow = holdingCache.validate(queryMaxRows);
     return &holdingCache.list;
@@ -1169,18 +1177,9 @@ const QList<map::MapAirportMsa> *MapQuery::getAirportMsa(const Marble::GeoDataLa
 
     if(airportMsaCache.list.isEmpty() && !lazy)
     {
-      for(const GeoDataLatLonBox& box : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-      {
-        query::bindRect(box, airportMsaByRectQuery);
-
-        airportMsaByRectQuery->exec();
-        while(airportMsaByRectQuery->next())
-        {
-          MapAirportMsa msa;
-          mapTypesFactory->fillAirportMsa(airportMsaByRectQuery->record(), msa);
-          airportMsaCache.list.append(msa);
-        }
-      }
+      airportMsaIndex.fetch(airportMsaCache.list,
+                            query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement), 0,
+                            std::bind(&MapQuery::loadAirportMsa, this, _1, _2));
     }
     overflow = airportMsaCache.validate(queryMaxRows);
     return &airportMsaCache.list;
@@ -1207,24 +1206,12 @@ const QList<map::MapIls> *MapQuery::getIls(GeoDataLatLonBox rect, const MapLayer
     // Increase bounding rect since ILS has no bounding to query
     rect.setBoundaries(rect.north() + increase, rect.south() - increase, rect.east() + increase, rect.west() - increase);
 
-    for(const GeoDataLatLonBox& box : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(box, ilsByRectQuery);
-
-      ilsByRectQuery->exec();
-      while(ilsByRectQuery->next())
-      {
-        // ILS is always loaded from nav except if all is off
-        map::MapRunwayEnd end;
-        if(mapLayer->isIlsDetail() && !NavApp::isNavdataOff())
-          // Get the runway end to fix graphical alignment issues in map
-          end = queries->getAirportQueryNav()->getRunwayEndById(ilsByRectQuery->valueInt("loc_runway_end_id"));
+    // ILS is always loaded from nav except if all is off
+    // Keep separate tiles for ILS with and without runway end alignment
+    bool runwayEnd = mapLayer->isIlsDetail() && !NavApp::isNavdataOff();
 
-        MapIls ils;
-        mapTypesFactory->fillIls(ilsByRectQuery->record(), ils, end.isFullyValid() ? end.heading : map::INVALID_HEADING_VALUE);
-        ilsCache.list.append(ils);
-      }
-    }
+    ilsIndex.fetch(ilsCache.list, query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement), runwayEnd,
+                   std::bind(&MapQuery::loadIls, this, _1, _2, runwayEnd));
   }
   overflow = ilsCache.validate(queryMaxRows);
   return &ilsCache.list;
@@ -1238,62 +1225,200 @@ const QList<map::MapIls> *MapQuery::getIls(GeoDataLatLonBox rect, const MapLayer
  * @return pointer to the airport cache
  */
 const QList<map::MapAirport> *MapQuery::fetchAirports(const Marble::GeoDataLatLonBox& rect, atools::sql::SqlQuery *query,
-                                                      bool lazy, bool addon, bool normal, bool& overflow)
+                                                      bool lazy, bool addon, bool normal, int minRunwayLength, bool& overflow)
 {
   if(!query::valid(Q_FUNC_INFO, query))
     return nullptr;
 
+  if(airportCache.list.isEmpty() && !lazy)
+    airportIndex.fetch(airportCache.list, query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement),
+                       airportVariant(minRunwayLength, addon, normal),
+                       std::bind(&MapQuery::loadAirports, this, _1, _2, query, addon, normal));
+
+  overflow = airportCache.validate(queryMaxRows);
+  return &airportCache.list;
+}
+
+void MapQuery::prefetch(MapQueryTiles& tiles, const GeoDataLatLonBox& rect, const MapLayer *mapLayer, map::MapTypes types)
+{
+  // Use same conditions as the painters
+  const QList<GeoDataLatLonBox> boxes = query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement);
+
+  if(types.testFlag(map::AIRPORT) && mapLayer->isAirport() && airportByRectQuery != nullptr)
+  {
+    bool addon = types.testFlag(map::AIRPORT_ADDON_ZOOM) || types.testFlag(map::AIRPORT_ADDON_ZOOM_FILTER);
+    bool normal = types & map::AIRPORT_ALL;
+    airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
+    airportIndex.prefetch(tiles.airports, boxes, airportVariant(mapLayer->getMinRunwayLength(), addon, normal),
+                          std::bind(&MapQuery::loadAirports, this, _1, _2, airportByRectQuery, addon, normal));
+  }
+
+  if(types.testFlag(map::VOR) && mapLayer->isVor() && vorsByRectQuery != nullptr)
+    vorIndex.prefetch(tiles.vors, boxes, 0, std::bind(&MapQuery::loadVors, this, _1, _2));
+
+  if(types.testFlag(map::NDB) && mapLayer->isNdb() && ndbsByRectQuery != nullptr)
+    ndbIndex.prefetch(tiles.ndbs, boxes, 0, std::bind(&MapQuery::loadNdbs, this, _1, _2));
+
+  if(types.testFlag(map::AIRPORT) && types.testFlag(map::ILS) && types.testFlag(map::MARKER) &&
+     mapLayer->isIls() && mapLayer->isMarker() && markersByRectQuery != nullptr)
+    markerIndex.prefetch(tiles.markers, boxes, 0, std::bind(&MapQuery::loadMarkers, this, _1, _2));
+
+  if(types.testFlag(map::HOLDING) && mapLayer->isHolding() && holdingByRectQuery != nullptr)
+    holdingIndex.prefetch(tiles.holdings, boxes, 0, std::bind(&MapQuery::loadHoldings, this, _1, _2));
+
+  if(types.testFlag(map::AIRPORT_MSA) && mapLayer->isAirportMsa() && airportMsaByRectQuery != nullptr)
+    airportMsaIndex.prefetch(tiles.airportMsa, boxes, 0, std::bind(&MapQuery::loadAirportMsa, this, _1, _2));
+
+  if(types.testFlag(map::AIRPORT) && types.testFlag(map::ILS) && mapLayer->isIls() && ilsByRectQuery != nullptr)
+  {
+    // Same increase as in getIls()
+    double increase = atools::geo::toRadians(9. / 60.);
+    GeoDataLatLonBox ilsRect(rect.north() + increase, rect.south() - increase, rect.east() + increase, rect.west() - increase);
+
+    bool runwayEnd = mapLayer->isIlsDetail() && !NavApp::isNavdataOff();
+    ilsIndex.prefetch(tiles.ils, query::splitAtAntiMeridian(ilsRect, queryRectInflationFactor, queryRectInflationIncrement),
+                      runwayEnd, std::bind(&MapQuery::loadIls, this, _1, _2, runwayEnd));
+  }
+}
+
+void MapQuery::insertPrefetched(const MapQueryTiles& tiles)
+{
+  airportIndex.insert(tiles.airports);
+  vorIndex.insert(tiles.vors);
+  ndbIndex.insert(tiles.ndbs);
+  markerIndex.insert(tiles.markers);
+  holdingIndex.insert(tiles.holdings);
+  ilsIndex.insert(tiles.ils);
+  airportMsaIndex.insert(tiles.airportMsa);
+}
+
+quint32 MapQuery::airportVariant(int minRunwayLength, bool addon, bool normal)
+{
+  // Keep separate tiles for each combination of query parameters
+  return (static_cast<quint32>(std::max(minRunwayLength, 0)) << 2) | (addon ? 2 : 0) | (normal ? 1 : 0);
+}
+
+void MapQuery::loadAirports(const GeoDataLatLonBox& box, QVector<MapAirport>& objects, SqlQuery *query, bool addon, bool normal)
+{
+  bool navdata = NavApp::isNavdataAll();
   AirportQuery *airportQueryNav = queries->getAirportQueryNav();
 
-  if(airportCache.list.isEmpty() && !lazy)
+  // Avoid duplicates between both queries
+  QSet<int> ids;
+
+  // Get normal airports ==========
+  if(normal)
   {
-    bool navdata = NavApp::isNavdataAll();
+    query::bindRect(box, query);
+    query->exec();
+    while(query->next())
+    {
+      MapAirport airport;
+      mapTypesFactory->fillAirport(query->record(), airport, true /* complete */, navdata, NavApp::isAirportDatabaseXPlane(navdata));
 
-    for(const GeoDataLatLonBox& box : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+      // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
+      airportQueryNav->correctAirportProcedureFlag(airport);
+
+      ids.insert(airport.id);
+      objects.append(airport);
+    }
+  }
+
+  // Get add-on airports ==========
+  if(addon && airportAddonByRectQuery != nullptr)
+  {
+    query::bindRect(box, airportAddonByRectQuery);
+    airportAddonByRectQuery->exec();
+    while(airportAddonByRectQuery->next())
     {
-      // Avoid duplicates between both queries
-      QSet<int> ids;
+      MapAirport airport;
+      mapTypesFactory->fillAirport(airportAddonByRectQuery->record(), airport, true /* complete */, navdata,
+                                   NavApp::isAirportDatabaseXPlane(navdata));
 
-      // Get normal airports ==========
-      if(normal)
-      {
-        query::bindRect(box, query);
-        query->exec();
-        while(query->next())
-        {
-          MapAirport airport;
-          mapTypesFactory->fillAirport(query->record(), airport, true /* complete */, navdata, NavApp::isAirportDatabaseXPlane(navdata));
+      // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
+      airportQueryNav->correctAirportProcedureFlag(airport);
 
-          // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
-          airportQueryNav->correctAirportProcedureFlag(airport);
+      if(!ids.contains(airport.id))
+        objects.append(airport);
+    }
+  }
+}
 
-          ids.insert(airport.id);
-          airportCache.list.append(airport);
-        }
-      }
+void MapQuery::loadVors(const GeoDataLatLonBox& box, QVector<MapVor>& objects)
+{
+  query::bindRect(box, vorsByRectQuery);
+  vorsByRectQuery->exec();
+  while(vorsByRectQuery->next())
+  {
+    MapVor vor;
+    mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
+    objects.append(vor);
+  }
+}
 
-      // Get add-on airports ==========
-      if(addon && airportAddonByRectQuery != nullptr)
-      {
-        query::bindRect(box, airportAddonByRectQuery);
-        airportAddonByRectQuery->exec();
-        while(airportAddonByRectQuery->next())
-        {
-          MapAirport airport;
-          mapTypesFactory->fillAirport(airportAddonByRectQuery->record(), airport, true /* complete */, navdata,
-                                       NavApp::isAirportDatabaseXPlane(navdata));
+void MapQuery::loadNdbs(const GeoDataLatLonBox& box, QVector<MapNdb>& objects)
+{
+  query::bindRect(box, ndbsByRectQuery);
+  ndbsByRectQuery->exec();
+  while(ndbsByRectQuery->next())
+  {
+    MapNdb ndb;
+    mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
+    objects.append(ndb);
+  }
+}
 
-          // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
-          airportQueryNav->correctAirportProcedureFlag(airport);
+void MapQuery::loadMarkers(const GeoDataLatLonBox& box, QVector<MapMarker>& objects)
+{
+  query::bindRect(box, markersByRectQuery);
+  markersByRectQuery->exec();
+  while(markersByRectQuery->next())
+  {
+    MapMarker marker;
+    mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
+    objects.append(marker);
+  }
+}
 
-          if(!ids.contains(airport.id))
-            airportCache.list.append(airport);
-        }
-      }
-    }
+void MapQuery::loadHoldings(const GeoDataLatLonBox& box, QVector<MapHolding>& objects)
+{
+  query::bindRect(box, holdingByRectQuery);
+  holdingByRectQuery->exec();
+  while(holdingByRectQuery->next())
+  {
+    MapHolding holding;
+    mapTypesFactory->fillHolding(holdingByRectQuery->record(), holding);
+    objects.append(holding);
+  }
+}
+
+void MapQuery::loadAirportMsa(const GeoDataLatLonBox& box, QVector<MapAirportMsa>& objects)
+{
+  query::bindRect(box, airportMsaByRectQuery);
+  airportMsaByRectQuery->exec();
+  while(airportMsaByRectQuery->next())
+  {
+    MapAirportMsa msa;
+    mapTypesFactory->fillAirportMsa(airportMsaByRectQuery->record(), msa);
+    objects.append(msa);
+  }
+}
+
+void MapQuery::loadIls(const GeoDataLatLonBox& box, QVector<MapIls>& objects, bool runwayEnd)
+{
+  query::bindRect(box, ilsByRectQuery);
+  ilsByRectQuery->exec();
+  while(ilsByRectQuery->next())
+  {
+    map::MapRunwayEnd end;
+    if(runwayEnd)
+      // Get the runway end to fix graphical alignment issues in map
+      end = queries->getAirportQueryNav()->getRunwayEndById(ilsByRectQuery->valueInt("loc_runway_end_id"));
+
+    MapIls ils;
+    mapTypesFactory->fillIls(ilsByRectQuery->record(), ils, end.isFullyValid() ? end.heading : map::INVALID_HEADING_VALUE);
+    objects.append(ils);
   }
-  overflow = airportCache.validate(queryMaxRows);
-  return &airportCache.list;
 }
 
 const QList<map::MapRunway> *MapQuery::getRunwaysForOverview(int airportId)
@@ -1545,6 +1670,15 @@ void MapQuery::deInitQueries()
   holdingCache.clear();
   ilsCache.clear();
   runwayOverwiewCache.clear();
+  screenGrid->clear();
+
+  airportIndex.clear();
+  vorIndex.clear();
+  ndbIndex.clear();
+  markerIndex.clear();
+  holdingIndex.clear();
+  ilsIndex.clear();
+  airportMsaIndex.clear();
 
   ATOOLS_DELETE(airportByRectQuery);
   ATOOLS_DELETE(airportAddonByRectQuery);
@@ -19,6 +19,7 @@
 #define LITTLENAVMAP_MAPQUERY_H
 
 #include "query/querytypes.h"
+#include "query/tileindex.h"
 
 #include <QCache>
 
@@ -27,6 +28,10 @@ struct MapResult;
 struct MapResultIndex;
 }
 
+namespace grid {
+enum Type : int;
+}
+
 namespace atools {
 namespace geo {
 class Rect;
@@ -38,10 +43,23 @@ class SqlQuery;
 }
 
 class CoordinateConverter;
+class MapScreenGrid;
 class MapTypesFactory;
 class MapLayer;
 class Queries;
 
+/* Tiles loaded by MapQuery::prefetch() for all map object types having a tile index */
+struct MapQueryTiles
+{
+  query::TileIndex<map::MapAirport>::Tiles airports;
+  query::TileIndex<map::MapVor>::Tiles vors;
+  query::TileIndex<map::MapNdb>::Tiles ndbs;
+  query::TileIndex<map::MapMarker>::Tiles markers;
+  query::TileIndex<map::MapHolding>::Tiles holdings;
+  query::TileIndex<map::MapIls>::Tiles ils;
+  query::TileIndex<map::MapAirportMsa>::Tiles airportMsa;
+};
+
 /*
  * Provides map related database queries.
  *
@@ -161,12 +179,17 @@ public:
    * @param xs/ys Screen coordinates
    * @param screenDistance maximum distance to coordinates
    * @param result will receive objects based on type
+   *
+   * Cached objects are looked up in a screen grid which is built on demand and kept until the viewport or the cache changes.
    */
   void getNearestScreenObjects(const CoordinateConverter& conv, const MapLayer *mapLayer, const QSet<int>& shownDetailAirportIds,
                                bool airportDiagram,
                                map::MapTypes types, map::MapDisplayTypes displayTypes, int xs, int ys, int screenDistance,
                                map::MapResult& result) const;
 
+  /* Clear screen grid used by getNearestScreenObjects(). Called on viewport changes. */
+  void clearScreenGrid() const;
+
   /* Only VOR, NDB, ILS and waypoints
    * All sorted by distance to pos with a maximum distance distanceNm
    * Uses distance * 4 and searches again if nothing was found.*/
@@ -241,6 +264,13 @@ public:
   bool hasArrivalProcedures(const map::MapAirport& airport) const;
   bool hasDepartureProcedures(const map::MapAirport& airport) const;
 
+  /* Load all objects for rect, layer and shown map object types into the tile indexes and copy the tiles to result.
+   * Used by prefetching on an instance owned by a worker thread. */
+  void prefetch(MapQueryTiles& tiles, const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, map::MapTypes types);
+
+  /* Add tiles loaded by prefetch() of another instance to the tile indexes */
+  void insertPrefetched(const MapQueryTiles& tiles);
+
 private:
   friend class Queries;
 
@@ -249,7 +279,7 @@ private:
    * @param sqlDbNav for updated navaids
    */
   explicit MapQuery(atools::sql::SqlDatabase *sqlDbSim, atools::sql::SqlDatabase *sqlDbNav, atools::sql::SqlDatabase *sqlDbUser,
-                    const Queries *parentQueriesParam);
+                    const Queries *parentQueriesParam, const query::QuerySettings& settings);
 
   /* Close all query objects thus disconnecting from the database */
   void initQueries();
@@ -266,7 +296,20 @@ private:
                                 float maxDistanceMeter, bool airportFromNavDatabase, map::AirportQueryFlags flags) const;
 
   const QList<map::MapAirport> *fetchAirports(const Marble::GeoDataLatLonBox& rect, atools::sql::SqlQuery *query,
-                                              bool lazy, bool addon, bool normal, bool& overflow);
+                                              bool lazy, bool addon, bool normal, int minRunwayLength, bool& overflow);
+
+  /* Load functions for the tile indexes. Append all objects in box. */
+  void loadAirports(const Marble::GeoDataLatLonBox& box, QVector<map::MapAirport>& objects, atools::sql::SqlQuery *query,
+                    bool addon, bool normal);
+  void loadVors(const Marble::GeoDataLatLonBox& box, QVector<map::MapVor>& objects);
+  void loadNdbs(const Marble::GeoDataLatLonBox& box, QVector<map::MapNdb>& objects);
+  void loadMarkers(const Marble::GeoDataLatLonBox& box, QVector<map::MapMarker>& objects);
+  void loadHoldings(const Marble::GeoDataLatLonBox& box, QVector<map::MapHolding>& objects);
+  void loadAirportMsa(const Marble::GeoDataLatLonBox& box, QVector<map::MapAirportMsa>& objects);
+  void loadIls(const Marble::GeoDataLatLonBox& box, QVector<map::MapIls>& objects, bool runwayEnd);
+
+  /* Tile index variant for airport query parameters */
+  static quint32 airportVariant(int minRunwayLength, bool addon, bool normal);
 
   QVector<map::MapIls> ilsByAirportAndRunway(const QString& airportIdent, const QString& runway) const;
 
@@ -275,6 +318,11 @@ private:
   QString airportIdentFromQuery(const QString& queryStr, const QString& ident, const QString& region,
                                 const atools::geo::Pos& pos, bool& found) const;
 
+  /* Rebuild the screen grid layer for the cache if viewport or cache content changed */
+  template<typename TYPE, typename POSFUNC>
+  void updateScreenGridLayer(grid::Type gridType, const query::SimpleRectCache<TYPE>& cache, const CoordinateConverter& conv,
+                             POSFUNC posFunc) const;
+
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *dbSim, *dbNav, *dbUser;
 
@@ -292,13 +340,26 @@ private:
   query::SimpleRectCache<map::MapIls> ilsCache;
   query::SimpleRectCache<map::MapAirportMsa> airportMsaCache;
 
+  /* Persistent tile indexes filling the rectangle caches above. Avoid queries when moving back to known regions. */
+  query::TileIndex<map::MapAirport> airportIndex;
+  query::TileIndex<map::MapVor> vorIndex;
+  query::TileIndex<map::MapNdb> ndbIndex;
+  query::TileIndex<map::MapMarker> markerIndex;
+  query::TileIndex<map::MapHolding> holdingIndex;
+  query::TileIndex<map::MapIls> ilsIndex;
+  query::TileIndex<map::MapAirportMsa> airportMsaIndex;
+
+  /* Screen coordinate index for objects in the caches above */
+  MapScreenGrid *screenGrid;
+
   bool gls = false;
 
   /* ID/object caches */
   QCache<int, QList<map::MapRunway> > runwayOverwiewCache;
   QCache<query::NearestCacheKeyNavaid, map::MapResultIndex> nearestNavaidCache;
 
-  static int queryMaxRows;
+  int queryMaxRows = map::MAX_MAP_OBJECTS;
+  double queryRectInflationFactor = 0.5, queryRectInflationIncrement = 0.5;
 
   /* Database queries */
   atools::sql::SqlQuery *runwayOverviewQuery = nullptr,
@@ -28,7 +28,6 @@
 #include "query/airportquery.h"
 #include "query/mapquery.h"
 #include "query/querymanager.h"
-#include "settings/settings.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
@@ -53,11 +52,11 @@ using proc::MapSpeedRestriction;
 namespace pln = atools::fs::pln;
 namespace ageo = atools::geo;
 
-ProcedureQuery::ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav, const Queries *queriesParam)
+ProcedureQuery::ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav, const Queries *queriesParam, const query::QuerySettings& settings)
   : dbNav(sqlDbNav)
 {
   queries = queriesParam;
-  verbose = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_PROCEDURE_DEBUG, false).toBool();
+  verbose = settings.procedureDebug;
 }
 
 ProcedureQuery::~ProcedureQuery()
@@ -36,6 +36,10 @@ class SqlQuery;
 }
 }
 
+namespace query {
+struct QuerySettings;
+}
+
 namespace proc {
 struct MapProcedureLeg;
 struct MapProcedureLegs;
@@ -185,7 +189,7 @@ private:
    * @param sqlDb database for simulator scenery data
    * @param sqlDbNav for updated navaids
    */
-  explicit ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav, const Queries *queriesParam);
+  explicit ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav, const Queries *queriesParam, const query::QuerySettings& settings);
 
   /* Create all queries */
   void initQueries();
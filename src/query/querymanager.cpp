@@ -19,7 +19,10 @@
 
 #include "app/navapp.h"
 #include "atools.h"
+#include "common/constants.h"
 #include "db/databasemanager.h"
+#include "db/dbtools.h"
+#include "exception.h"
 #include "query/airportquery.h"
 #include "query/airspacequeries.h"
 #include "query/airwayquery.h"
@@ -27,11 +30,43 @@
 #include "query/infoquery.h"
 #include "query/mapquery.h"
 #include "query/procedurequery.h"
+#include "query/querytypes.h"
 #include "query/waypointquery.h"
 #include "query/waypointtrackquery.h"
+#include "settings/settings.h"
+#include "sql/sqldatabase.h"
+
+#include <QCoreApplication>
+#include <QThread>
+
+using atools::sql::SqlDatabase;
 
 QueryManager *QueryManager::queryManagerInstance = nullptr;
 
+/* Connections of the database manager */
+static QueryDatabases mainDatabases()
+{
+  DatabaseManager *db = NavApp::getDatabaseManager();
+
+  QueryDatabases databases;
+  databases.sim = db->getDatabaseSim();
+  databases.nav = db->getDatabaseNav();
+  databases.user = db->getDatabaseUser();
+  databases.track = db->getDatabaseTrack();
+  databases.simAirspace = db->getDatabaseSimAirspace();
+  databases.navAirspace = db->getDatabaseNavAirspace();
+  databases.userAirspace = db->getDatabaseUserAirspace();
+  databases.online = db->getDatabaseOnline();
+  return databases;
+}
+
+/* All connections in the order used by threadDatabaseFiles */
+static QVector<SqlDatabase *> databaseList(const QueryDatabases& dbs)
+{
+  return QVector<SqlDatabase *>({dbs.sim, dbs.nav, dbs.user, dbs.track, dbs.simAirspace, dbs.navAirspace, dbs.userAirspace,
+                                 dbs.online});
+}
+
 void QueryManager::initQueries()
 {
   if(queriesGui != nullptr)
@@ -42,6 +77,17 @@ void QueryManager::initQueries()
     QueryLocker locker(queriesWeb);
     queriesWeb->initQueries();
   }
+
+  QMutexLocker poolLocker(&mutexWebQueries);
+  for(Queries *queries : qAsConst(queriesAdditional))
+  {
+    QueryLocker locker(queries);
+    queries->initQueries();
+  }
+
+  // Connections of worker threads are reopened by their owners
+  updateThreadDatabaseFiles();
+  invalidateQueriesThread();
 }
 
 void QueryManager::deInitQueries()
@@ -54,6 +100,15 @@ void QueryManager::deInitQueries()
     QueryLocker locker(queriesWeb);
     queriesWeb->deInitQueries();
   }
+
+  QMutexLocker poolLocker(&mutexWebQueries);
+  for(Queries *queries : qAsConst(queriesAdditional))
+  {
+    QueryLocker locker(queries);
+    queries->deInitQueries();
+  }
+
+  invalidateQueriesThread();
 }
 
 void QueryManager::preTrackLoad()
@@ -66,6 +121,13 @@ void QueryManager::preTrackLoad()
     QueryLocker locker(queriesWeb);
     queriesWeb->preTrackLoad();
   }
+
+  QMutexLocker poolLocker(&mutexWebQueries);
+  for(Queries *queries : qAsConst(queriesAdditional))
+  {
+    QueryLocker locker(queries);
+    queries->preTrackLoad();
+  }
 }
 
 void QueryManager::postTrackLoad()
@@ -78,6 +140,16 @@ void QueryManager::postTrackLoad()
     QueryLocker locker(queriesWeb);
     queriesWeb->postTrackLoad();
   }
+
+  QMutexLocker poolLocker(&mutexWebQueries);
+  for(Queries *queries : qAsConst(queriesAdditional))
+  {
+    QueryLocker locker(queries);
+    queries->postTrackLoad();
+  }
+
+  // Worker threads recreate their queries on next use
+  invalidateQueriesThread();
 }
 
 void QueryManager::preLoadAirspaces()
@@ -90,6 +162,13 @@ void QueryManager::preLoadAirspaces()
     QueryLocker locker(queriesWeb);
     queriesWeb->preLoadAirspaces();
   }
+
+  QMutexLocker poolLocker(&mutexWebQueries);
+  for(Queries *queries : qAsConst(queriesAdditional))
+  {
+    QueryLocker locker(queries);
+    queries->preLoadAirspaces();
+  }
 }
 
 void QueryManager::postLoadAirspaces()
@@ -102,6 +181,16 @@ void QueryManager::postLoadAirspaces()
     QueryLocker locker(queriesWeb);
     queriesWeb->postLoadAirspaces();
   }
+
+  QMutexLocker poolLocker(&mutexWebQueries);
+  for(Queries *queries : qAsConst(queriesAdditional))
+  {
+    QueryLocker locker(queries);
+    queries->postLoadAirspaces();
+  }
+
+  updateThreadDatabaseFiles();
+  invalidateQueriesThread();
 }
 
 void QueryManager::preDatabaseLoad()
@@ -114,6 +203,17 @@ void QueryManager::preDatabaseLoad()
     QueryLocker locker(queriesWeb);
     queriesWeb->preDatabaseLoad();
   }
+
+  QMutexLocker poolLocker(&mutexWebQueries);
+  for(Queries *queries : qAsConst(queriesAdditional))
+  {
+    QueryLocker locker(queries);
+    queries->preDatabaseLoad();
+  }
+
+  // Worker threads close their connections on next use and share the web queries until loading is done
+  threadDatabaseLoading = true;
+  invalidateQueriesThread();
 }
 
 void QueryManager::postDatabaseLoad()
@@ -126,14 +226,29 @@ void QueryManager::postDatabaseLoad()
     QueryLocker locker(queriesWeb);
     queriesWeb->postDatabaseLoad();
   }
+
+  QMutexLocker poolLocker(&mutexWebQueries);
+  for(Queries *queries : qAsConst(queriesAdditional))
+  {
+    QueryLocker locker(queries);
+    queries->postDatabaseLoad();
+  }
+
+  updateThreadDatabaseFiles();
+  threadDatabaseLoading = false;
+  invalidateQueriesThread();
 }
 
 Queries *QueryManager::getQueriesGui()
 {
   if(queriesGui == nullptr)
   {
-    queriesGui = new Queries();
+    queriesGui = new Queries(*querySettings);
     queriesGui->initQueries();
+
+    // Databases are open when the first queries are requested
+    QMutexLocker locker(&mutexWebQueries);
+    updateThreadDatabaseFiles();
   }
 
   return queriesGui;
@@ -142,47 +257,250 @@ Queries *QueryManager::getQueriesGui()
 Queries *QueryManager::getQueriesWeb()
 {
   QMutexLocker locker(&mutexWebQueries);
+  return queriesWebInternal();
+}
 
+Queries *QueryManager::queriesWebInternal()
+{
   if(queriesWeb == nullptr)
   {
-    queriesWeb = new Queries();
+    queriesWeb = new Queries(*querySettings);
     queriesWeb->initQueries();
   }
 
   return queriesWeb;
 }
 
+Queries *QueryManager::createQueriesAdditional()
+{
+  QMutexLocker locker(&mutexWebQueries);
+
+  Queries *queries = new Queries(*querySettings);
+  queries->initQueries();
+  queriesAdditional.append(queries);
+  return queries;
+}
+
+void QueryManager::releaseQueriesAdditional(Queries *queries)
+{
+  QMutexLocker locker(&mutexWebQueries);
+
+  if(queriesAdditional.removeOne(queries))
+    ATOOLS_DELETE_LOG(queries);
+}
+
+Queries *QueryManager::getQueriesThread()
+{
+  QThread *thread = QThread::currentThread();
+  if(thread == QCoreApplication::instance()->thread())
+    return getQueriesGui();
+
+  QMutexLocker locker(&mutexWebQueries);
+
+  // Files might be replaced - share web queries which are reset by the main thread
+  if(threadDatabaseLoading || threadDatabaseFiles.isEmpty())
+    return queriesWebInternal();
+
+  auto it = queriesThreadPool.find(thread);
+  if(it != queriesThreadPool.end())
+  {
+    if(it->generation == threadGeneration)
+      return it->queries;
+
+    // Outdated by database, track or airspace changes - reopen in the owning thread
+    if(reopenQueriesThread(*it))
+      return it->queries;
+
+    ThreadQueries threadQueries = queriesThreadPool.take(thread);
+    deleteThreadQueries(threadQueries);
+  }
+  else if(queriesThreadPool.size() < threadPoolSize)
+  {
+    Queries *queries = createQueriesThread(thread);
+    if(queries != nullptr)
+      return queries;
+  }
+
+  // Pool exhausted or failed - share web queries with other threads
+  return queriesWebInternal();
+}
+
+Queries *QueryManager::createQueriesThread(QThread *thread)
+{
+  // Create a new set of connections using unique names
+  ThreadQueries threadQueries;
+  QueryDatabases& dbs = threadQueries.databases;
+  QString prefix = dbtools::DATABASE_NAME_THREAD_PREFIX + QString::number(threadConnectionIndex++);
+  for(SqlDatabase **db : {&dbs.sim, &dbs.nav, &dbs.user, &dbs.track, &dbs.simAirspace, &dbs.navAirspace, &dbs.userAirspace,
+                          &dbs.online})
+  {
+    QString name = prefix + QString::number(threadQueries.connectionNames.size());
+    SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, name);
+    *db = new SqlDatabase(name);
+    threadQueries.connectionNames.append(name);
+  }
+
+  try
+  {
+    openThreadDatabases(threadQueries);
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open thread connections" << e.what();
+    deleteThreadQueries(threadQueries);
+    return nullptr;
+  }
+
+  threadQueries.queries = new Queries(threadQueries.databases, *querySettings);
+  threadQueries.queries->initQueries();
+  threadQueries.generation = threadGeneration;
+  queriesThreadPool.insert(thread, threadQueries);
+
+  qDebug() << Q_FUNC_INFO << "Created thread queries" << prefix << "for" << thread << "pool size" << queriesThreadPool.size();
+
+  // Release connections in the context of the finishing thread
+  QObject::connect(thread, &QThread::finished, [this, thread]() {
+    releaseQueriesThread(thread);
+  });
+
+  return threadQueries.queries;
+}
+
+void QueryManager::releaseQueriesThread(QThread *thread)
+{
+  QMutexLocker locker(&mutexWebQueries);
+
+  ThreadQueries threadQueries = queriesThreadPool.take(thread == nullptr ? QThread::currentThread() : thread);
+  if(threadQueries.queries != nullptr)
+    deleteThreadQueries(threadQueries);
+}
+
+bool QueryManager::reopenQueriesThread(ThreadQueries& threadQueries)
+{
+  qDebug() << Q_FUNC_INFO << "Reopening thread queries" << threadQueries.connectionNames.value(0);
+
+  // Delete queries before closing the connections they use
+  ATOOLS_DELETE_LOG(threadQueries.queries);
+  closeThreadDatabases(threadQueries);
+
+  try
+  {
+    openThreadDatabases(threadQueries);
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot reopen thread connections" << e.what();
+    return false;
+  }
+
+  threadQueries.queries = new Queries(threadQueries.databases, *querySettings);
+  threadQueries.queries->initQueries();
+  threadQueries.generation = threadGeneration;
+  return true;
+}
+
+void QueryManager::invalidateQueriesThread()
+{
+  // Pool entries are not touched here since connections belong to the worker threads
+  threadGeneration++;
+}
+
+void QueryManager::updateThreadDatabaseFiles()
+{
+  // Follow the main connections which might be closed or point to another file depending on navdata mode
+  threadDatabaseFiles.clear();
+  for(const SqlDatabase *db : databaseList(mainDatabases()))
+    threadDatabaseFiles.append(db != nullptr && db->isOpen() ? db->databaseName() : QString());
+}
+
+void QueryManager::openThreadDatabases(ThreadQueries& threadQueries)
+{
+  const QVector<SqlDatabase *> databases = databaseList(threadQueries.databases);
+  for(int i = 0; i < databases.size(); i++)
+  {
+    QString file = threadDatabaseFiles.value(i);
+    if(!file.isEmpty() && !databases.at(i)->isOpen())
+      dbtools::openDatabaseFileShared(databases.at(i), file, threadCacheKb, threadMmapSizeMb);
+  }
+}
+
+void QueryManager::closeThreadDatabases(ThreadQueries& threadQueries)
+{
+  for(SqlDatabase *db : databaseList(threadQueries.databases))
+  {
+    if(db != nullptr && db->isOpen())
+      db->close();
+  }
+}
+
+void QueryManager::deleteThreadQueries(ThreadQueries& threadQueries)
+{
+  ATOOLS_DELETE_LOG(threadQueries.queries);
+  closeThreadDatabases(threadQueries);
+
+  QueryDatabases& dbs = threadQueries.databases;
+  for(SqlDatabase **db : {&dbs.sim, &dbs.nav, &dbs.user, &dbs.track, &dbs.simAirspace, &dbs.navAirspace, &dbs.userAirspace,
+                          &dbs.online})
+    ATOOLS_DELETE_LOG(*db);
+
+  // Remove connections after deleting all objects using them
+  for(const QString& name : qAsConst(threadQueries.connectionNames))
+    SqlDatabase::removeDatabase(name);
+  threadQueries.connectionNames.clear();
+}
+
 void QueryManager::shutdown()
 {
+  {
+    QMutexLocker locker(&mutexWebQueries);
+    qDeleteAll(queriesAdditional);
+    queriesAdditional.clear();
+
+    for(ThreadQueries& threadQueries : queriesThreadPool)
+      deleteThreadQueries(threadQueries);
+    queriesThreadPool.clear();
+  }
+
   ATOOLS_DELETE_LOG(queriesGui);
   ATOOLS_DELETE_LOG(queriesWeb);
+  ATOOLS_DELETE_LOG(querySettings);
 }
 
 QueryManager::QueryManager()
 {
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+
+  // Read here once since settings cannot be accessed from worker threads
+  querySettings = new query::QuerySettings(query::QuerySettings::read());
+  threadPoolSize = settings.getAndStoreValue(lnm::SETTINGS_DATABASE + "ThreadPoolSize", 4).toInt();
+  threadCacheKb = settings.getAndStoreValue(lnm::SETTINGS_DATABASE + "ThreadCacheKb", 10000).toInt();
+  threadMmapSizeMb = settings.getAndStoreValue(lnm::SETTINGS_DATABASE + "ThreadMmapSizeMb", 256).toInt();
 }
 
 // ==============================================================================================
-Queries::Queries()
+Queries::Queries(const query::QuerySettings& settings)
+  : Queries(mainDatabases(), settings)
 {
-  DatabaseManager *db = NavApp::getDatabaseManager();
+}
 
-  airportQuerySim = new AirportQuery(db->getDatabaseSim(), this, false /* nav */);
-  airportQueryNav = new AirportQuery(db->getDatabaseNav(), this, true /* nav */);
-  mapQuery = new MapQuery(db->getDatabaseSim(), db->getDatabaseNav(), db->getDatabaseUser(), this);
+Queries::Queries(const QueryDatabases& databases, const query::QuerySettings& settings)
+{
+  airportQuerySim = new AirportQuery(databases.sim, this, false /* nav */, settings);
+  airportQueryNav = new AirportQuery(databases.nav, this, true /* nav */, settings);
+  mapQuery = new MapQuery(databases.sim, databases.nav, databases.user, this, settings);
 
-  airwayTrackQuery = new AirwayTrackQuery(new AirwayQuery(db->getDatabaseNav(), false /* track */),
-                                          new AirwayQuery(db->getDatabaseTrack(), true /* track */));
+  airwayTrackQuery = new AirwayTrackQuery(new AirwayQuery(databases.nav, false /* track */, settings),
+                                          new AirwayQuery(databases.track, true /* track */, settings));
 
-  waypointTrackQuery = new WaypointTrackQuery(new WaypointQuery(db->getDatabaseNav(), false /* track */),
-                                              new WaypointQuery(db->getDatabaseTrack(), true /* track */));
+  waypointTrackQuery = new WaypointTrackQuery(new WaypointQuery(databases.nav, false /* track */, settings),
+                                              new WaypointQuery(databases.track, true /* track */, settings));
 
-  infoQuery = new InfoQuery(db->getDatabaseSim(), db->getDatabaseNav(), db->getDatabaseTrack());
-  procedureQuery = new ProcedureQuery(db->getDatabaseNav(), this);
+  infoQuery = new InfoQuery(databases.sim, databases.nav, databases.track, settings);
+  procedureQuery = new ProcedureQuery(databases.nav, this, settings);
 
   // Need extra airspace databases since selection is independent of nav/sim
-  airspaceQueries = new AirspaceQueries(db->getDatabaseSimAirspace(), db->getDatabaseNavAirspace(), db->getDatabaseUserAirspace(),
-                                        db->getDatabaseOnline());
+  airspaceQueries = new AirspaceQueries(databases.simAirspace, databases.navAirspace, databases.userAirspace, databases.online,
+                                        settings);
 }
 
 Queries::~Queries()
@@ -20,12 +20,20 @@
 
 #include "util/locker.h"
 
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
 namespace atools {
 namespace sql {
 class SqlDatabase;
 }
 }
 
+namespace query {
+struct QuerySettings;
+}
+
 class AirspaceQueries;
 class AirportQuery;
 class AirspaceQuery;
@@ -34,6 +42,14 @@ class InfoQuery;
 class MapQuery;
 class ProcedureQuery;
 class WaypointTrackQuery;
+class QThread;
+
+/* Database connections used by one set of queries */
+struct QueryDatabases
+{
+  atools::sql::SqlDatabase *sim = nullptr, *nav = nullptr, *user = nullptr, *track = nullptr,
+                           *simAirspace = nullptr, *navAirspace = nullptr, *userAirspace = nullptr, *online = nullptr;
+};
 
 /*
  * Collects the most important scenery library database query classes and
@@ -112,8 +128,12 @@ public:
 private:
   friend class QueryManager;
 
-  /* Creates all contained query classes but does not initialize SQL queries. */
-  explicit Queries();
+  /* Creates all contained query classes using the connections of the database manager
+   * but does not initialize SQL queries. Settings have to be read in the main thread. */
+  explicit Queries(const query::QuerySettings& settings);
+
+  /* As above but uses the given connections */
+  explicit Queries(const QueryDatabases& databases, const query::QuerySettings& settings);
 
   /* Close all query objects thus disconnecting from the database */
   void initQueries();
@@ -185,15 +205,91 @@ public:
    * Creates and initalizes queries. */
   Queries *getQueriesWeb();
 
+  /* Synchronized. Create and initialize an additional set of queries for a hidden map widget like the map benchmark.
+   * Queries are handled like the web queries above on database changes. Use QueryLocker in threads before using. */
+  Queries *createQueriesAdditional();
+
+  /* Synchronized. Delete queries created by createQueriesAdditional() */
+  void releaseQueriesAdditional(Queries *queries);
+
+  /* Synchronized. Get queries for the calling thread which use their own read only connections.
+   * This allows worker threads like map prefetch and online data loading to read the
+   * databases in parallel without waiting for the web queries.
+   * Connections and queries are created on first call and released automatically when the thread finishes.
+   * Database, track or airspace changes only mark the queries as outdated. The owning thread closes and reopens
+   * them on the next call. Call this each time before using the queries.
+   * Returns the web queries if the pool is exhausted, while databases are switched
+   * or the GUI queries if called from the main thread. Use QueryLocker while using.
+   *
+   * Not used by web API actions and search since both run in the main thread: web API actions share the web map
+   * widget and controllers and search uses SQL models bound to the GUI connection. The profile worker reads
+   * only elevation data and no scenery database. */
+  Queries *getQueriesThread();
+
+  /* Synchronized. Release connections and queries of the given or calling thread before it finishes. */
+  void releaseQueriesThread(QThread *thread = nullptr);
+
   /* Shutdown for good */
   void shutdown();
 
 private:
   QueryManager();
 
+  /* Read only connections and queries owned by one worker thread. Accessed only by the owning thread except
+   * for deletion at shutdown. */
+  struct ThreadQueries
+  {
+    Queries *queries = nullptr;
+    QueryDatabases databases;
+    QStringList connectionNames;
+
+    /* Value of threadGeneration when queries were created */
+    int generation = 0;
+  };
+
+  /* Not synchronized. Open connections and create queries for the thread. Returns null on error. */
+  Queries *createQueriesThread(QThread *thread);
+
+  /* Not synchronized. Close, reopen connections and recreate queries of an outdated pool entry. Called by owning thread. */
+  bool reopenQueriesThread(ThreadQueries& threadQueries);
+
+  /* Not synchronized. Mark all pool entries as outdated. Called from main thread. */
+  void invalidateQueriesThread();
+
+  /* Not synchronized. Remember files of the main connections for the pool. Called from main thread. */
+  void updateThreadDatabaseFiles();
+
+  /* Not synchronized. Open connections of a pool entry to the files of the main connections. */
+  void openThreadDatabases(ThreadQueries& threadQueries);
+  void closeThreadDatabases(ThreadQueries& threadQueries);
+  void deleteThreadQueries(ThreadQueries& threadQueries);
+
+  /* Not synchronized. Create web queries if needed */
+  Queries *queriesWebInternal();
+
   Queries *queriesGui = nullptr, /* User interface queries. All accessed from main event loop. No synchronization needed. */
           *queriesWeb = nullptr; /* Web interface queries. Accessed from web threads. Synchronization needed. */
 
+  /* Additional queries for hidden map widgets like the benchmark. Synchronization needed. */
+  QVector<Queries *> queriesAdditional;
+
+  /* Queries with own read only connections per worker thread. Synchronized by mutexWebQueries. */
+  QHash<QThread *, ThreadQueries> queriesThreadPool;
+  int threadConnectionIndex = 0, threadPoolSize = 4, threadCacheKb = 10000, threadMmapSizeMb = 256;
+
+  /* Incremented on database, track and airspace changes. Pool entries with a lower value are reopened. */
+  int threadGeneration = 0;
+
+  /* Set between pre and post database load. Pool entries cannot be opened while files are replaced. */
+  bool threadDatabaseLoading = false;
+
+  /* Files of main connections sim, nav, user, track, simAirspace, navAirspace, userAirspace and online.
+   * Empty if closed. Copied in main thread since connections cannot be accessed from worker threads. */
+  QStringList threadDatabaseFiles;
+
+  /* Cache sizes and limits read in main thread */
+  query::QuerySettings *querySettings = nullptr;
+
   static QueryManager *queryManagerInstance;
   QMutex mutexWebQueries;
 };
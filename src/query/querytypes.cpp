@@ -17,8 +17,12 @@
 
 #include "query/querytypes.h"
 
+#include "common/constants.h"
 #include "sql/sqlquery.h"
 #include "geo/rect.h"
+#include "settings/settings.h"
+
+#include <QStringBuilder>
 
 using namespace Marble;
 
@@ -98,6 +102,73 @@ void fetchObjectsForRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *q
   }
 }
 
+QuerySettings QuerySettings::read()
+{
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  QuerySettings s;
+
+  // Keep order of former constructor calls since some keys are shared and the first default is stored
+  QString mq = lnm::SETTINGS_MAPQUERY, iq = lnm::SETTINGS_INFOQUERY;
+  s.airportQuery.runwayCache = settings.getAndStoreValue(mq % "RunwayCache", s.airportQuery.runwayCache).toInt();
+  s.airportQuery.apronCache = settings.getAndStoreValue(mq % "ApronCache", s.airportQuery.apronCache).toInt();
+  s.airportQuery.taxipathCache = settings.getAndStoreValue(mq % "TaxipathCache", s.airportQuery.taxipathCache).toInt();
+  s.airportQuery.parkingCache = settings.getAndStoreValue(mq % "ParkingCache", s.airportQuery.parkingCache).toInt();
+  s.airportQuery.startCache = settings.getAndStoreValue(mq % "StartCache", s.airportQuery.startCache).toInt();
+  s.airportQuery.helipadCache = settings.getAndStoreValue(mq % "HelipadCache", s.airportQuery.helipadCache).toInt();
+  s.airportQuery.airportIdCache = settings.getAndStoreValue(mq % "AirportIdCache", s.airportQuery.airportIdCache).toInt();
+  s.airportQuery.airportFuzzyIdCache = settings.getAndStoreValue(mq % "AirportFuzzyIdCache", s.airportQuery.airportFuzzyIdCache).toInt();
+  s.airportQuery.airportIdentCache = settings.getAndStoreValue(mq % "AirportIdentCache", s.airportQuery.airportIdentCache).toInt();
+
+  s.mapQuery.runwayOverwiewCache = settings.getAndStoreValue(mq % "RunwayOverwiewCache", s.mapQuery.runwayOverwiewCache).toInt();
+  s.mapQuery.queryRectInflationFactor =
+    settings.getAndStoreValue(mq % "QueryRectInflationFactor", s.mapQuery.queryRectInflationFactor).toDouble();
+  s.mapQuery.queryRectInflationIncrement =
+    settings.getAndStoreValue(mq % "QueryRectInflationIncrement", s.mapQuery.queryRectInflationIncrement).toDouble();
+  s.mapQuery.queryMaxRows = settings.getAndStoreValue(mq % "MapQueryRowLimit", s.mapQuery.queryMaxRows).toInt();
+  s.mapQuery.tileIndexObjects = settings.getAndStoreValue(mq % "TileIndexObjects", s.mapQuery.tileIndexObjects).toInt();
+
+  s.airwayQuery.queryRectInflationFactor =
+    settings.getAndStoreValue(mq % "QueryRectInflationFactor", s.airwayQuery.queryRectInflationFactor).toDouble();
+  s.airwayQuery.queryRectInflationIncrement =
+    settings.getAndStoreValue(mq % "QueryRectInflationIncrement", s.airwayQuery.queryRectInflationIncrement).toDouble();
+  s.airwayQuery.queryMaxRows = settings.getAndStoreValue(mq % "AirwayQueryRowLimitAw", s.airwayQuery.queryMaxRows).toInt();
+
+  s.waypointQuery.queryRectInflationFactor =
+    settings.getAndStoreValue(mq % "QueryRectInflationFactor", s.waypointQuery.queryRectInflationFactor).toDouble();
+  s.waypointQuery.queryRectInflationIncrement =
+    settings.getAndStoreValue(mq % "QueryRectInflationIncrement", s.waypointQuery.queryRectInflationIncrement).toDouble();
+  s.waypointQuery.queryMaxRows = settings.getAndStoreValue(mq % "WaypointQueryRowLimit1", s.waypointQuery.queryMaxRows).toInt();
+  s.waypointQuery.waypointInfoCache = settings.getAndStoreValue(iq % "WaypointCache", s.waypointQuery.waypointInfoCache).toInt();
+
+  s.infoQuery.airportCache = settings.getAndStoreValue(iq % "AirportCache", s.infoQuery.airportCache).toInt();
+  s.infoQuery.vorCache = settings.getAndStoreValue(iq % "VorCache", s.infoQuery.vorCache).toInt();
+  s.infoQuery.ndbCache = settings.getAndStoreValue(iq % "NdbCache", s.infoQuery.ndbCache).toInt();
+  s.infoQuery.msaCache = settings.getAndStoreValue(iq % "MsaCache", s.infoQuery.msaCache).toInt();
+  s.infoQuery.holdingCache = settings.getAndStoreValue(iq % "HoldingCache", s.infoQuery.holdingCache).toInt();
+  s.infoQuery.runwayEndCache = settings.getAndStoreValue(iq % "RunwayEndCache", s.infoQuery.runwayEndCache).toInt();
+  s.infoQuery.comCache = settings.getAndStoreValue(iq % "ComCache", s.infoQuery.comCache).toInt();
+  s.infoQuery.runwayCache = settings.getAndStoreValue(iq % "RunwayCache", s.infoQuery.runwayCache).toInt();
+  s.infoQuery.helipadCache = settings.getAndStoreValue(iq % "HelipadCache", s.infoQuery.helipadCache).toInt();
+  s.infoQuery.startCache = settings.getAndStoreValue(iq % "StartCache", s.infoQuery.startCache).toInt();
+  s.infoQuery.approachCache = settings.getAndStoreValue(iq % "ApproachCache", s.infoQuery.approachCache).toInt();
+  s.infoQuery.transitionCache = settings.getAndStoreValue(iq % "TransitionCache", s.infoQuery.transitionCache).toInt();
+  s.infoQuery.airportSceneryCache = settings.getAndStoreValue(iq % "AirportSceneryCache", s.infoQuery.airportSceneryCache).toInt();
+
+  s.procedureDebug = settings.getAndStoreValue(lnm::OPTIONS_PROCEDURE_DEBUG, false).toBool();
+
+  s.airspaceQuery.airspaceLineCache = settings.getAndStoreValue(mq % "AirspaceLineCache", s.airspaceQuery.airspaceLineCache).toInt();
+  s.airspaceQuery.onlineCenterGeoCache = settings.getAndStoreValue(mq % "OnlineCenterGeoCache", s.airspaceQuery.onlineCenterGeoCache).toInt();
+  s.airspaceQuery.onlineCenterGeoFileCache =
+    settings.getAndStoreValue(mq % "OnlineCenterGeoFileCache", s.airspaceQuery.onlineCenterGeoFileCache).toInt();
+  s.airspaceQuery.queryRectInflationFactor =
+    settings.getAndStoreValue(mq % "QueryRectInflationFactor", s.airspaceQuery.queryRectInflationFactor).toDouble();
+  s.airspaceQuery.queryRectInflationIncrement =
+    settings.getAndStoreValue(mq % "QueryRectInflationIncrement", s.airspaceQuery.queryRectInflationIncrement).toDouble();
+  s.airspaceQuery.queryMaxRows = settings.getAndStoreValue(mq % "AirspaceQueryRowLimit", s.airspaceQuery.queryMaxRows).toInt();
+
+  return s;
+}
+
 bool valid(const QString& function, const atools::sql::SqlQuery *query)
 {
   if(query == nullptr)
@@ -21,6 +21,7 @@
 #include "sql/sqlrecord.h"
 #include "sql/sqlquery.h"
 #include "common/maptypes.h"
+#include "mappainter/paintprofiler.h"
 
 #include <QList>
 
@@ -57,6 +58,54 @@ const QList<Marble::GeoDataLatLonBox> splitAtAntiMeridian(const Marble::GeoDataL
 /* Inflate rect by width and height in degrees. If it crosses the poles or date line it will be limited */
 void inflateQueryRect(Marble::GeoDataLatLonBox& rect, double factor, double increment);
 
+/* Cache sizes and limits for all query classes.
+ * Read once in the main thread since settings cannot be accessed from worker threads which create their own queries. */
+struct QuerySettings
+{
+  /* Read values and store defaults in settings. Call from main thread only. */
+  static QuerySettings read();
+
+  struct Airport
+  {
+    int runwayCache = 2000, apronCache = 1000, taxipathCache = 1000, parkingCache = 1000, startCache = 1000,
+        helipadCache = 1000, airportIdCache = 1000, airportFuzzyIdCache = 1000, airportIdentCache = 1000;
+  } airportQuery;
+
+  struct Map
+  {
+    int runwayOverwiewCache = 1000, queryMaxRows = map::MAX_MAP_OBJECTS, tileIndexObjects = 20000;
+    double queryRectInflationFactor = 0.5, queryRectInflationIncrement = 0.5;
+  } mapQuery;
+
+  struct Airspace
+  {
+    int airspaceLineCache = 10000, onlineCenterGeoCache = 10000, onlineCenterGeoFileCache = 10000,
+        queryMaxRows = map::MAX_MAP_OBJECTS;
+    double queryRectInflationFactor = 0.3, queryRectInflationIncrement = 0.1;
+  } airspaceQuery;
+
+  struct Airway
+  {
+    int queryMaxRows = map::MAX_MAP_OBJECTS;
+    double queryRectInflationFactor = 0.3, queryRectInflationIncrement = 0.1;
+  } airwayQuery;
+
+  struct Waypoint
+  {
+    int queryMaxRows = map::MAX_MAP_OBJECTS * 2, waypointInfoCache = 100;
+    double queryRectInflationFactor = 0.3, queryRectInflationIncrement = 0.1;
+  } waypointQuery;
+
+  struct Info
+  {
+    int airportCache = 100, vorCache = 100, ndbCache = 100, msaCache = 100, holdingCache = 100, runwayEndCache = 100,
+        comCache = 100, runwayCache = 100, helipadCache = 100, startCache = 100, approachCache = 100, transitionCache = 100,
+        airportSceneryCache = 100;
+  } infoQuery;
+
+  bool procedureDebug = false;
+};
+
 template<typename ID>
 const atools::sql::SqlRecord *cachedRecord(QCache<ID, atools::sql::SqlRecord>& cache, atools::sql::SqlQuery *query, ID id);
 
@@ -86,6 +135,9 @@ struct SimpleRectCache
   const MapLayer *curMapLayer = nullptr;
   QList<TYPE> list;
 
+  /* Incremented each time the list is cleared. Allows users like the screen grid to detect changes. */
+  quint32 generation = 0;
+
 };
 
 // ---------------------------------------------------------------------------------
@@ -95,8 +147,11 @@ bool SimpleRectCache<TYPE>::updateCache(const Marble::GeoDataLatLonBox& rect, co
                                         double increment, bool lazy, LayerCompareFunc funcSameLayer)
 {
   if(lazy)
+  {
     // Nothing changed
+    prof::count(prof::RECT_CACHE_HIT);
     return false;
+  }
 
   // Store bounding rectangle and inflate it
 
@@ -115,11 +170,14 @@ bool SimpleRectCache<TYPE>::updateCache(const Marble::GeoDataLatLonBox& rect, co
 #endif
   {
     // Rectangle not covered by loaded data or new layer selected
+    prof::count(prof::RECT_CACHE_MISS);
     list.clear();
+    generation++;
     curRect = rect;
     curMapLayer = mapLayer;
     return true;
   }
+  prof::count(prof::RECT_CACHE_HIT);
   return false;
 }
 
@@ -139,6 +197,7 @@ template<typename TYPE>
 void SimpleRectCache<TYPE>::clear()
 {
   list.clear();
+  generation++;
   curRect.clear();
   curMapLayer = nullptr;
 }
@@ -152,6 +211,7 @@ const atools::sql::SqlRecord *cachedRecord(QCache<ID, atools::sql::SqlRecord>& c
   if(rec != nullptr)
   {
     // Found record in cache
+    prof::count(prof::RECORD_CACHE_HIT);
     if(rec->isEmpty())
       // Empty record that indicates that no result was found
       return nullptr;
@@ -160,6 +220,7 @@ const atools::sql::SqlRecord *cachedRecord(QCache<ID, atools::sql::SqlRecord>& c
   }
   else
   {
+    prof::count(prof::RECORD_CACHE_MISS);
     query->exec();
     if(query->next())
     {
@@ -183,6 +244,7 @@ const atools::sql::SqlRecordList *cachedRecordList(QCache<ID, atools::sql::SqlRe
   if(rec != nullptr)
   {
     // Found record in cache
+    prof::count(prof::RECORD_CACHE_HIT);
     if(rec->isEmpty())
       // Empty record that indicates that no result was found
       return nullptr;
@@ -191,6 +253,7 @@ const atools::sql::SqlRecordList *cachedRecordList(QCache<ID, atools::sql::SqlRe
   }
   else
   {
+    prof::count(prof::RECORD_CACHE_MISS);
     query->exec();
 
     rec = new atools::sql::SqlRecordList;
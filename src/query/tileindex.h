@@ -0,0 +1,302 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_TILEINDEX_H
+#define LNM_TILEINDEX_H
+
+#include "geo/pos.h"
+#include "mappainter/paintprofiler.h"
+
+#include <QCache>
+#include <QHash>
+#include <QVector>
+
+#include <marble/GeoDataLatLonBox.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace query {
+
+/*
+ * Persistent spatial index for point map objects like airports or navaids which is filled lazily by region.
+ *
+ * The world is divided into tiles of one degree and each object is stored in the tile containing its position.
+ * Tiles are kept in a LRU cache limited by the number of objects. Missing tiles are loaded with one query
+ * for each row of adjacent missing tiles. A variant number allows to keep separate tiles for different
+ * query parameters like minimum runway length.
+ *
+ * Views covering too many tiles or tile rows exceeding the row limit are passed directly to the load function.
+ *
+ * Tiles can be loaded by an index in a worker thread and then be copied into the index used for painting.
+ *
+ * Not thread safe.
+ */
+template<typename TYPE>
+class TileIndex
+{
+public:
+  /* Has to append all objects having a position inside box to objects */
+  typedef std::function<void (const Marble::GeoDataLatLonBox& box, QVector<TYPE>& objects)> LoadFunc;
+
+  /* Tiles by key including variant */
+  typedef QHash<quint64, QVector<TYPE> > Tiles;
+
+  TileIndex()
+  {
+    tiles.setMaxCost(20000);
+  }
+
+  /* Append all objects inside the boxes to list. Boxes must not cross the anti-meridian. */
+  void fetch(QList<TYPE>& list, const QList<Marble::GeoDataLatLonBox>& boxes, quint32 variant, LoadFunc loadFunc)
+  {
+    fetchInternal(&list, nullptr, boxes, variant, loadFunc);
+  }
+
+  /* Load missing tiles and copy all complete tiles covering the boxes into tiles. Ignores boxes which are too large. */
+  void prefetch(Tiles& tiles, const QList<Marble::GeoDataLatLonBox>& boxes, quint32 variant, LoadFunc loadFunc)
+  {
+    fetchInternal(nullptr, &tiles, boxes, variant, loadFunc);
+  }
+
+  /* Add tiles loaded by another index which are not present yet */
+  void insert(const Tiles& tiles);
+
+  /* true if all tiles covering the boxes are loaded or if boxes are too large for the index */
+  bool contains(const QList<Marble::GeoDataLatLonBox>& boxes, quint32 variant) const;
+
+  /* Remove all tiles. Has to be called on database changes. */
+  void clear()
+  {
+    tiles.clear();
+  }
+
+  /* Maximum number of objects in the index */
+  void setMaxObjects(int maxObjects)
+  {
+    tiles.setMaxCost(maxObjects);
+  }
+
+  /* Row limit of the queries used in the load function. Results at the limit are not cached since they are incomplete. */
+  void setMaxRows(int value)
+  {
+    maxRows = value;
+  }
+
+private:
+  const static int COLUMNS = 360, ROWS = 180;
+
+  /* Do not use the index for views larger than about 40 by 25 degrees */
+  const static int MAX_TILES = 1000;
+
+  static int column(double lonX)
+  {
+    return std::max(0, std::min(COLUMNS - 1, static_cast<int>(std::floor(lonX + 180.))));
+  }
+
+  static int row(double latY)
+  {
+    return std::max(0, std::min(ROWS - 1, static_cast<int>(std::floor(latY + 90.))));
+  }
+
+  static quint64 key(quint32 variant, int row, int column)
+  {
+    return (static_cast<quint64>(variant) << 32) | static_cast<quint64>(row * COLUMNS + column);
+  }
+
+  /* Append objects inside bounding degree coordinates only */
+  static void appendFiltered(QList<TYPE>& list, const QVector<TYPE>& objects, double west, double east, double south, double north);
+
+  /* Either list or tilesCopy can be null */
+  void fetchInternal(QList<TYPE> *list, Tiles *tilesCopy, const QList<Marble::GeoDataLatLonBox>& boxes, quint32 variant,
+                     LoadFunc loadFunc);
+
+  /* Load tiles from column start to end in the given row, append objects inside bounds to list and copy tiles */
+  void loadTiles(QList<TYPE> *list, Tiles *tilesCopy, quint32 variant, int tileRow, int start, int end, double west, double east,
+                 double south, double north, LoadFunc loadFunc);
+
+  /* Get tile range for box and return false if too large */
+  static bool tileRange(const Marble::GeoDataLatLonBox& box, int& col1, int& row1, int& col2, int& row2);
+
+  QCache<quint64, QVector<TYPE> > tiles;
+  int maxRows = 0;
+};
+
+// ---------------------------------------------------------------------------------
+
+template<typename TYPE>
+bool TileIndex<TYPE>::tileRange(const Marble::GeoDataLatLonBox& box, int& col1, int& row1, int& col2, int& row2)
+{
+  using Marble::GeoDataCoordinates;
+
+  col1 = column(box.west(GeoDataCoordinates::Degree));
+  col2 = column(box.east(GeoDataCoordinates::Degree));
+  row1 = row(box.south(GeoDataCoordinates::Degree));
+  row2 = row(box.north(GeoDataCoordinates::Degree));
+  return col2 >= col1 && (col2 - col1 + 1) * (row2 - row1 + 1) <= MAX_TILES;
+}
+
+template<typename TYPE>
+void TileIndex<TYPE>::fetchInternal(QList<TYPE> *list, Tiles *tilesCopy, const QList<Marble::GeoDataLatLonBox>& boxes,
+                                    quint32 variant, LoadFunc loadFunc)
+{
+  using Marble::GeoDataCoordinates;
+
+  for(const Marble::GeoDataLatLonBox& box : boxes)
+  {
+    double west = box.west(GeoDataCoordinates::Degree), east = box.east(GeoDataCoordinates::Degree),
+           south = box.south(GeoDataCoordinates::Degree), north = box.north(GeoDataCoordinates::Degree);
+    int col1, row1, col2, row2;
+
+    if(!tileRange(box, col1, row1, col2, row2))
+    {
+      if(list != nullptr)
+      {
+        // Too large - query directly
+        QVector<TYPE> objects;
+        loadFunc(box, objects);
+        for(const TYPE& obj : qAsConst(objects))
+          list->append(obj);
+      }
+      continue;
+    }
+
+    for(int tileRow = row1; tileRow <= row2; tileRow++)
+    {
+      // Copy objects from present tiles and collect runs of adjacent missing tiles
+      // Objects are copied before loading since inserting new tiles can evict older ones
+      int runStart = -1;
+      for(int col = col1; col <= col2 + 1; col++)
+      {
+        quint64 tileKey = key(variant, tileRow, col);
+        const QVector<TYPE> *tile = col <= col2 ? tiles.object(tileKey) : nullptr;
+
+        if(tile != nullptr)
+        {
+          prof::count(prof::TILE_INDEX_HIT);
+          if(list != nullptr)
+            appendFiltered(*list, *tile, west, east, south, north);
+          if(tilesCopy != nullptr)
+            tilesCopy->insert(tileKey, *tile);
+        }
+
+        if(tile == nullptr && col <= col2)
+        {
+          if(runStart == -1)
+            runStart = col;
+        }
+        else if(runStart != -1)
+        {
+          loadTiles(list, tilesCopy, variant, tileRow, runStart, col - 1, west, east, south, north, loadFunc);
+          runStart = -1;
+        }
+      }
+    }
+  }
+}
+
+template<typename TYPE>
+void TileIndex<TYPE>::loadTiles(QList<TYPE> *list, Tiles *tilesCopy, quint32 variant, int tileRow, int start, int end, double west,
+                                double east, double south, double north, LoadFunc loadFunc)
+{
+  using Marble::GeoDataCoordinates;
+
+  Marble::GeoDataLatLonBox runBox;
+  runBox.setBoundaries(tileRow + 1. - 90., tileRow - 90., end + 1. - 180., start - 180., GeoDataCoordinates::Degree);
+
+  QVector<TYPE> objects;
+  loadFunc(runBox, objects);
+
+  // Incomplete result if row limit is reached - use but do not keep
+  bool complete = maxRows <= 0 || objects.size() < maxRows;
+
+  // Sort objects into tiles - drop objects on the border which belong to neighbor tiles
+  QVector<QVector<TYPE> > runTiles(end - start + 1);
+  for(const TYPE& obj : qAsConst(objects))
+  {
+    const atools::geo::Pos& pos = obj.getPosition();
+    int col = column(pos.getLonX());
+    if(row(pos.getLatY()) == tileRow && col >= start && col <= end)
+      runTiles[col - start].append(obj);
+  }
+
+  for(int i = 0; i < runTiles.size(); i++)
+  {
+    prof::count(prof::TILE_INDEX_MISS);
+    const QVector<TYPE>& tile = runTiles.at(i);
+    if(list != nullptr)
+      appendFiltered(*list, tile, west, east, south, north);
+
+    if(complete)
+    {
+      quint64 tileKey = key(variant, tileRow, start + i);
+      if(tilesCopy != nullptr)
+        tilesCopy->insert(tileKey, tile);
+
+      // Empty tiles are cached too to avoid repeated queries for empty regions
+      tiles.insert(tileKey, new QVector<TYPE>(tile), std::max(1, tile.size()));
+    }
+  }
+}
+
+template<typename TYPE>
+void TileIndex<TYPE>::insert(const Tiles& newTiles)
+{
+  for(auto it = newTiles.constBegin(); it != newTiles.constEnd(); ++it)
+  {
+    if(!tiles.contains(it.key()))
+      tiles.insert(it.key(), new QVector<TYPE>(it.value()), std::max(1, it.value().size()));
+  }
+}
+
+template<typename TYPE>
+bool TileIndex<TYPE>::contains(const QList<Marble::GeoDataLatLonBox>& boxes, quint32 variant) const
+{
+  for(const Marble::GeoDataLatLonBox& box : boxes)
+  {
+    int col1, row1, col2, row2;
+    if(tileRange(box, col1, row1, col2, row2))
+    {
+      for(int tileRow = row1; tileRow <= row2; tileRow++)
+      {
+        for(int col = col1; col <= col2; col++)
+        {
+          if(!tiles.contains(key(variant, tileRow, col)))
+            return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+template<typename TYPE>
+void TileIndex<TYPE>::appendFiltered(QList<TYPE>& list, const QVector<TYPE>& objects, double west, double east, double south,
+                                     double north)
+{
+  for(const TYPE& obj : objects)
+  {
+    const atools::geo::Pos& pos = obj.getPosition();
+    if(pos.getLonX() >= west && pos.getLonX() <= east && pos.getLatY() >= south && pos.getLatY() <= north)
+      list.append(obj);
+  }
+}
+
+} // namespace query
+
+#endif // LNM_TILEINDEX_H
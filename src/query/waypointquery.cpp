@@ -22,7 +22,6 @@
 #include "common/mapresult.h"
 #include "common/maptools.h"
 #include "mapgui/maplayer.h"
-#include "settings/settings.h"
 #include "sql/sqlutil.h"
 
 #include <QStringBuilder>
@@ -32,20 +31,16 @@ using namespace atools::sql;
 using namespace atools::geo;
 using map::MapWaypoint;
 
-static double queryRectInflationFactor = 0.2;
-static double queryRectInflationIncrement = 0.1;
-int WaypointQuery::queryMaxRowsWaypoints = map::MAX_MAP_OBJECTS;
 
-WaypointQuery::WaypointQuery(SqlDatabase *sqlDbNav, bool trackDatabaseParam)
+WaypointQuery::WaypointQuery(SqlDatabase *sqlDbNav, bool trackDatabaseParam, const query::QuerySettings& settings)
   : dbNav(sqlDbNav), trackDatabase(trackDatabaseParam)
 {
   mapTypesFactory = new MapTypesFactory();
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
 
-  queryRectInflationFactor = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "QueryRectInflationFactor", 0.3).toDouble();
-  queryRectInflationIncrement = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "QueryRectInflationIncrement", 0.1).toDouble();
-  queryMaxRowsWaypoints = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "WaypointQueryRowLimit1", map::MAX_MAP_OBJECTS * 2).toInt();
-  waypointInfoCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY % "WaypointCache", 100).toInt());
+  queryRectInflationFactor = settings.waypointQuery.queryRectInflationFactor;
+  queryRectInflationIncrement = settings.waypointQuery.queryRectInflationIncrement;
+  queryMaxRowsWaypoints = settings.waypointQuery.queryMaxRows;
+  waypointInfoCache.setMaxCost(settings.waypointQuery.waypointInfoCache);
 }
 
 WaypointQuery::~WaypointQuery()
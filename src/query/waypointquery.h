@@ -87,7 +87,7 @@ private:
    * @param sqlDb database for simulator scenery data
    * @param sqlDbNav for updated navaids
    */
-  explicit WaypointQuery(atools::sql::SqlDatabase *sqlDbNav, bool trackDatabaseParam);
+  explicit WaypointQuery(atools::sql::SqlDatabase *sqlDbNav, bool trackDatabaseParam, const query::QuerySettings& settings);
 
   /* Close all query objects thus disconnecting from the database */
   void initQueries();
@@ -104,7 +104,8 @@ private:
   query::SimpleRectCache<map::MapWaypoint> waypointCache, waypointAirwayCache;
   QCache<int, atools::sql::SqlRecord> waypointInfoCache;
 
-  static int queryMaxRowsWaypoints;
+  int queryMaxRowsWaypoints = map::MAX_MAP_OBJECTS;
+  double queryRectInflationFactor = 0.2, queryRectInflationIncrement = 0.1;
 
   bool trackDatabase;
 
@@ -2237,6 +2237,12 @@ void Route::calculateLegAltitudes()
   altitude->calculateAll(NavApp::getAircraftPerformance(), getCruiseAltitudeFt());
 }
 
+void Route::benchmarkLegAltitudes() const
+{
+  Route route(*this);
+  route.altitude->benchmark(NavApp::getAircraftPerformance(), getCruiseAltitudeFt());
+}
+
 /* Update the bounding rect using marble functions to catch anti meridian overlap */
 void Route::updateBoundingRect()
 {
@@ -2785,6 +2791,49 @@ void Route::createRouteLegsFromFlightplan()
   }
 }
 
+void Route::createRouteLegsFromFlightplan(const QList<RouteLeg>& oldLegs, int changeStart, int numOldChanged, int numNewChanged)
+{
+  clear();
+
+  const RouteLeg *lastLeg = nullptr;
+  int changeEnd = changeStart + numNewChanged, oldOffset = numOldChanged - numNewChanged;
+  bool synchronized = false;
+
+  for(int i = 0; i < flightplan.size(); i++)
+  {
+    // Old leg for unchanged entries before the change or after the change once resolved legs match again
+    int oldIndex = i < changeStart ? i : (i >= changeEnd && synchronized ? i + oldOffset : -1);
+
+    if(oldIndex >= 0 && oldIndex < oldLegs.size())
+    {
+      RouteLeg leg(oldLegs.at(oldIndex));
+      leg.setFlightplan(&flightplan);
+      leg.setFlightplanEntryIndex(i);
+      append(leg);
+    }
+    else
+    {
+      RouteLeg leg(&flightplan);
+      leg.createFromDatabaseByEntry(i, lastLeg);
+
+      if(leg.getMapType() == map::INVALID)
+        // Not found in database
+        qWarning() << "Entry for ident" << flightplan.at(i).getIdent() << "region" << flightplan.at(i).getRegion() << "is not valid";
+
+      if(i >= changeEnd && i + oldOffset < oldLegs.size())
+      {
+        // Same navaid as before - following legs will resolve to the same objects
+        const RouteLeg& oldLeg = oldLegs.at(i + oldOffset);
+        synchronized = leg.getMapType() == oldLeg.getMapType() && leg.getId() == oldLeg.getId() &&
+                       leg.getPosition() == oldLeg.getPosition();
+      }
+
+      append(leg);
+    }
+    lastLeg = &constLast();
+  }
+}
+
 void Route::assignAltitudes()
 {
   QVector<float> altVector = altitude->getAltitudes();
@@ -600,6 +600,11 @@ public:
    * Flight plan will be corrected if needed. */
   void createRouteLegsFromFlightplan();
 
+  /* As above but copies resolved legs from oldLegs for entries which are not changed. oldLegs are the legs of the
+   * previous plan where numOldChanged entries at changeStart were replaced with numNewChanged entries.
+   * Legs after the change are resolved again until a leg matches the old one since resolving depends on the previous leg. */
+  void createRouteLegsFromFlightplan(const QList<RouteLeg>& oldLegs, int changeStart, int numOldChanged, int numNewChanged);
+
   /* @return true if departure is valid and departure airport has no parking or departure of flight plan
    *  has parking or helipad as start position */
   bool hasValidParking() const;
@@ -653,6 +658,9 @@ public:
   /* Calculate route leg altitudes that are needed for the elevation profile */
   void calculateLegAltitudes();
 
+  /* Run altitude, fuel and wind calculation repeatedly on a copy of this route and print times to the log */
+  void benchmarkLegAltitudes() const;
+
   /* general distance in NM which is either cross track, previous or next waypoint */
   float getDistanceToFlightplan() const;
   bool isTooFarToFlightplan() const;
@@ -25,6 +25,7 @@
 #include "route/route.h"
 #include "weather/windreporter.h"
 
+#include <QElapsedTimer>
 #include <QLineF>
 
 // Altitude resulting from vertical angle is adjusted to restriction if close with this limit
@@ -40,6 +41,22 @@ const float AT_RESTRICTION_TOLERANCE_FT = 10.f;
 const float MIN_CRUISE_ALTITUDE_FT = 100.f;
 const float MIN_FLIGHTPLAN_DIST_NM = 0.5f;
 
+// Maximum number of additional passes for wind correction
+const int MAX_WIND_ITERATIONS = 3;
+
+// Stop wind correction iterations if TOC, TOD and ground speeds change less than this
+const float CONVERGED_DISTANCE_NM = 0.1f;
+const float CONVERGED_SPEED_KTS = 0.5f;
+
+// Climb and descent rates in ft per NM considered equal - no new pass needed
+const float CONVERGED_RATE_FT_PER_NM = 0.1f;
+
+// Altitude changes below this are ignored when flattening legs
+const float SIMPLIFY_TOLERANCE_FT = 1.f;
+
+// Flags for leg phases in calculateTrip()
+const int PHASE_CLIMB = 1, PHASE_CRUISE = 2, PHASE_DESCENT = 4;
+
 namespace ageo = atools::geo;
 
 RouteAltitude::RouteAltitude(const Route *routeParam)
@@ -827,11 +844,15 @@ void RouteAltitude::simplyfyRouteAltitudes()
   // Flatten descent legs starting from TOD to destination
   if(legIndexTopOfDescent < map::INVALID_INDEX_VALUE && legIndexTopOfDescent >= 0)
   {
-    // Use several iterations
+    // Use several iterations until nothing changes
     for(int i = 0; i < 16; i++)
     {
+      bool changed = false;
       for(int j = legIndexTopOfDescent; j < route->getDestinationAirportLegIndex(); j++)
-        simplifyRouteAltitude(j, false /* departure */);
+        changed |= simplifyRouteAltitude(j, false /* departure */);
+
+      if(!changed)
+        break;
     }
   }
   else
@@ -840,18 +861,22 @@ void RouteAltitude::simplyfyRouteAltitudes()
   // Flatten departure legs starting from departure to TOC
   if(legIndexTopOfClimb < map::INVALID_INDEX_VALUE && legIndexTopOfClimb >= 0)
   {
-    // Use several iterations
+    // Use several iterations until nothing changes
     for(int i = 0; i < 8; i++)
     {
+      bool changed = false;
       for(int j = 1; j < legIndexTopOfClimb; j++)
-        simplifyRouteAltitude(j, true /* departure */);
+        changed |= simplifyRouteAltitude(j, true /* departure */);
+
+      if(!changed)
+        break;
     }
   }
   else
     qWarning() << Q_FUNC_INFO;
 }
 
-void RouteAltitude::simplifyRouteAltitude(int index, bool departure)
+bool RouteAltitude::simplifyRouteAltitude(int index, bool departure)
 {
   // #ifdef DEBUG_INFORMATION
   // qDebug() << Q_FUNC_INFO << index;
@@ -860,7 +885,7 @@ void RouteAltitude::simplifyRouteAltitude(int index, bool departure)
   if(index <= 0 || index >= size() - 1)
   {
     qWarning() << Q_FUNC_INFO << "index <= 0 || index >= size() - 1";
-    return;
+    return false;
   }
 
   RouteAltitudeLeg *midAlt = &(*this)[index];
@@ -894,7 +919,7 @@ void RouteAltitude::simplifyRouteAltitude(int index, bool departure)
 
       // Right leg is too far after destination - quit here
       if(rightAlt->isAlternate() || rightAlt->isMissed())
-        return;
+        return false;
     }
   }
 
@@ -961,6 +986,8 @@ void RouteAltitude::simplifyRouteAltitude(int index, bool departure)
     qDebug() << Q_FUNC_INFO << "after adjust" << newAlt;
 #endif
 
+    bool changed = std::abs(midAlt->y2() - newAlt) > SIMPLIFY_TOLERANCE_FT;
+
     // Change middle leg and adjust altitude
     midAlt->setY2(newAlt);
 
@@ -973,7 +1000,10 @@ void RouteAltitude::simplifyRouteAltitude(int index, bool departure)
     // Also change skipped left neighbor
     if(leftSkippedAlt != nullptr)
       leftSkippedAlt->setY2(newAlt);
+
+    return changed;
   }
+  return false;
 }
 
 void RouteAltitude::collectErrors(const QStringList& altRestrErrors)
@@ -1011,6 +1041,7 @@ void RouteAltitude::calculateAll(const atools::fs::perf::AircraftPerf& perf, flo
 
   errors.clear();
   clearAll();
+  passes = 0;
   bool invalid = false;
 
   // Collect basic issues ================================================
@@ -1059,6 +1090,7 @@ void RouteAltitude::calculateAll(const atools::fs::perf::AircraftPerf& perf, flo
     QStringList altRestrErrors;
     calculate(altRestrErrors);
     collectErrors(altRestrErrors);
+    passes++;
 
     if(validProfile)
     {
@@ -1066,7 +1098,8 @@ void RouteAltitude::calculateAll(const atools::fs::perf::AircraftPerf& perf, flo
 
       // Recalculate more iterations to get more accuracy.
       // Wind related path changes can get the profile into different wind conditions changing the profile again.
-      for(int i = 0; i < 3; i++)
+      // Stop if the values converge which is the case after the first pass if there is no wind.
+      for(int i = 0; i < MAX_WIND_ITERATIONS; i++)
       {
 #ifdef DEBUG_INFORMATION
         qDebug() << Q_FUNC_INFO << "iteration" << i
@@ -1081,22 +1114,43 @@ void RouteAltitude::calculateAll(const atools::fs::perf::AircraftPerf& perf, flo
         qDebug() << Q_FUNC_INFO << "error descent" << descentSpeedWindCorrected - perf.getDescentSpeed();
 #endif
 
-        climbRateWindFtPerNm = perf.getClimbVertSpeed() * 60.f / climbSpeedWindCorrected;
-        descentRateWindFtPerNm = perf.getDescentVertSpeed() * 60.f / descentSpeedWindCorrected;
+        float climbRate = perf.getClimbVertSpeed() * 60.f / climbSpeedWindCorrected;
+        float descentRate = perf.getDescentVertSpeed() * 60.f / descentSpeedWindCorrected;
+
+        // Same rates result in the same profile - no need to calculate again
+        if(atools::almostEqual(climbRate, climbRateWindFtPerNm, CONVERGED_RATE_FT_PER_NM) &&
+           atools::almostEqual(descentRate, descentRateWindFtPerNm, CONVERGED_RATE_FT_PER_NM))
+          break;
+
+        climbRateWindFtPerNm = climbRate;
+        descentRateWindFtPerNm = descentRate;
 
 #ifdef DEBUG_INFORMATION
         qDebug() << Q_FUNC_INFO << "iteration" << i << "climbRateWindFtPerNm" << climbRateWindFtPerNm
                  << "descentRateWindFtPerNm" << descentRateWindFtPerNm;
 #endif
 
+        // Remember values of last pass to check convergence
+        float lastTocDist = distanceTopOfClimb, lastTodDist = distanceTopOfDescent,
+              lastClimbSpeed = climbSpeedWindCorrected, lastCruiseSpeed = cruiseSpeedWindCorrected,
+              lastDescentSpeed = descentSpeedWindCorrected;
+
         clearAll();
         calculate(altRestrErrors);
         collectErrors(altRestrErrors);
+        passes++;
 
         if(validProfile)
           calculateTrip(perf);
         else
           break;
+
+        if(atools::almostEqual(distanceTopOfClimb, lastTocDist, CONVERGED_DISTANCE_NM) &&
+           atools::almostEqual(distanceTopOfDescent, lastTodDist, CONVERGED_DISTANCE_NM) &&
+           atools::almostEqual(climbSpeedWindCorrected, lastClimbSpeed, CONVERGED_SPEED_KTS) &&
+           atools::almostEqual(cruiseSpeedWindCorrected, lastCruiseSpeed, CONVERGED_SPEED_KTS) &&
+           atools::almostEqual(descentSpeedWindCorrected, lastDescentSpeed, CONVERGED_SPEED_KTS))
+          break;
       }
     }
   } // if(!invalid)
@@ -1112,7 +1166,7 @@ void RouteAltitude::calculateAll(const atools::fs::perf::AircraftPerf& perf, flo
   qDebug() << "climbFuel" << climbFuel << "cruiseFuel" << cruiseFuel << "descentFuel" << descentFuel;
   qDebug() << "climbTime" << climbTime << "cruiseTime" << cruiseTime << "descentTime" << descentTime;
   qDebug() << "legIndexTopOfClimb" << legIndexTopOfClimb << "legIndexTopOfDescent" << legIndexTopOfDescent;
-  qDebug() << "validProfile" << validProfile << "unflyableLegs" << unflyableLegs;
+  qDebug() << "validProfile" << validProfile << "unflyableLegs" << unflyableLegs << "passes" << passes;
   qDebug() << "climbRateWindFtPerNm" << climbRateWindFtPerNm << "descentRateWindFtPerNm" << descentRateWindFtPerNm
            << "cruiseAltitude" << cruiseAltitude;
 
@@ -1751,8 +1805,6 @@ void RouteAltitude::calculateTrip(const atools::fs::perf::AircraftPerf& perf)
   if(isEmpty())
     return;
 
-  WindReporter *windReporter = NavApp::getWindReporter();
-
   climbFuel = cruiseFuel = descentFuel = climbTime = cruiseTime = descentTime = tripFuel = alternateFuel = 0.f;
 
   travelTime = 0.f;
@@ -1771,6 +1823,9 @@ void RouteAltitude::calculateTrip(const atools::fs::perf::AircraftPerf& perf)
     return;
   }
 
+  // Get winds for all changed legs in one batch
+  updateTripWinds(tocDist, todDist);
+
   for(int i = 0; i < size(); i++)
   {
     RouteAltitudeLeg& leg = (*this)[i];
@@ -1798,7 +1853,6 @@ void RouteAltitude::calculateTrip(const atools::fs::perf::AircraftPerf& perf)
       // Beginning and end of this leg
       float startDistLeg = leg.getDistanceFromStart() - leg.getDistanceTo();
       float endDistLeg = leg.getDistanceFromStart();
-      const ageo::LineString& legLine = leg.getLineString();
 
       // Reset all variables
       float climbDist = 0.f, cruiseDist = 0.f, descentDist = 0.f;
@@ -1806,74 +1860,60 @@ void RouteAltitude::calculateTrip(const atools::fs::perf::AircraftPerf& perf)
       atools::grib::Wind climbWind, cruiseWind, descentWind;
 
       // Check if leg covers TOC and/or TOD =================================================
-      // Calculate wind, distance and averate speed (TAS) for this leg
-      // Wind is interpolated by altitude
-      // Need to use smaller/greater *or equal* to catch special cases of exactly matching distances
-      if(endDistLeg <= tocDist)
+      // Calculate distance and averate speed (TAS) for this leg
+      int phases = tripPhases(leg, tocDist, todDist);
+      if(phases == PHASE_CLIMB)
       {
         // All climb before TOC ==========================
         climbDist = legDist;
-        climbWind = windReporter->getWindForLineStringRoute(legLine);
         climbSpeed = perf.getClimbSpeed();
       }
-      else if(startDistLeg >= todDist)
+      else if(phases == PHASE_DESCENT)
       {
         // All descent after TOD ==========================
         descentDist = legDist;
-        descentWind = windReporter->getWindForLineStringRoute(legLine);
         descentSpeed = perf.getDescentSpeed();
       }
-      else if(startDistLeg <= tocDist && endDistLeg >= todDist)
+      else if(phases == (PHASE_CLIMB | PHASE_CRUISE | PHASE_DESCENT))
       {
         // Crosses TOC *and* TOD  - phases climb, cruise and descent ==========================
-        // Climb to TOC ===================
+        // Climb to TOC, cruise - TOC to TOD and TOD to destination ===================
         climbDist = tocDist - startDistLeg;
-        climbWind = windReporter->getWindForLineStringRoute(legLine.left(2));
         climbSpeed = perf.getClimbSpeed();
-
-        // cruise - TOC to TOD ===================
         cruiseDist = todDist - tocDist;
-        cruiseWind = windReporter->getWindForLineStringRoute(legLine.mid(1, 2));
         cruiseSpeed = perf.getCruiseSpeed();
-
-        // TOD to destination ===================
         descentDist = endDistLeg - todDist;
-        descentWind = windReporter->getWindForLineStringRoute(legLine.right(2));
         descentSpeed = perf.getDescentSpeed();
       }
-      else if(startDistLeg <= tocDist && endDistLeg <= todDist)
+      else if(phases == (PHASE_CLIMB | PHASE_CRUISE))
       {
-        // Crosses TOC and goes into cruise ==========================
+        // Crosses TOC and goes into cruise to TOD ==========================
         climbDist = tocDist - startDistLeg;
-        climbWind = windReporter->getWindForLineStringRoute(legLine.left(2));
         climbSpeed = perf.getClimbSpeed();
-
-        // Cruise to TOD ==========================
         cruiseDist = endDistLeg - tocDist;
-        cruiseWind = windReporter->getWindForLineStringRoute(legLine.right(2));
         cruiseSpeed = perf.getCruiseSpeed();
       }
-      else if(startDistLeg >= tocDist && endDistLeg >= todDist)
+      else if(phases == (PHASE_CRUISE | PHASE_DESCENT))
       {
         // Goes from cruise to and after TOD ==========================
-        // Cruise to TOD ==========================
         cruiseDist = todDist - startDistLeg;
-        cruiseWind = windReporter->getWindForLineStringRoute(legLine.left(2));
         cruiseSpeed = perf.getCruiseSpeed();
-
-        // TOD to destination ===================
         descentDist = endDistLeg - todDist;
-        descentWind = windReporter->getWindForLineStringRoute(legLine.right(2));
         descentSpeed = perf.getDescentSpeed();
       }
       else
       {
         // Cruise only ==========================
         cruiseDist = legDist;
-        cruiseWind = windReporter->getWindForLineStringRoute(legLine);
         cruiseSpeed = perf.getCruiseSpeed();
       }
 
+      // Wind is interpolated by altitude - fetched for all legs before
+      const LegWinds& winds = tripWinds.at(i);
+      climbWind = winds.climb;
+      cruiseWind = winds.cruise;
+      descentWind = winds.descent;
+
       // Calculate ground speed for each phase (climb, cruise, descent) of this leg - 0 is phase is not touched
       float course = route->value(i).getCourseEndTrue();
 
@@ -1961,9 +2001,8 @@ void RouteAltitude::calculateTrip(const atools::fs::perf::AircraftPerf& perf)
         leg.cruiseFuel = perf.getCruiseFuelFlow() * leg.cruiseTime;
         leg.descentFuel = perf.getDescentFuelFlow() * leg.descentTime;
 
-        atools::grib::Wind wind = windReporter->getWindForPosRoute(legLine.getPos2());
-        leg.windSpeed = wind.speed;
-        leg.windDirection = wind.dir;
+        leg.windSpeed = winds.end.speed;
+        leg.windDirection = winds.end.dir;
 
         // Summarize trip values ====================
         travelTime += leg.getTime();
@@ -2078,6 +2117,137 @@ void RouteAltitude::calculateTrip(const atools::fs::perf::AircraftPerf& perf)
 #endif
 }
 
+int RouteAltitude::tripPhases(const RouteAltitudeLeg& leg, float tocDist, float todDist)
+{
+  // Beginning and end of this leg
+  float startDistLeg = leg.getDistanceFromStart() - leg.getDistanceTo();
+  float endDistLeg = leg.getDistanceFromStart();
+
+  // Need to use smaller/greater *or equal* to catch special cases of exactly matching distances
+  if(endDistLeg <= tocDist)
+    return PHASE_CLIMB;
+  else if(startDistLeg >= todDist)
+    return PHASE_DESCENT;
+  else if(startDistLeg <= tocDist && endDistLeg >= todDist)
+    return PHASE_CLIMB | PHASE_CRUISE | PHASE_DESCENT;
+  else if(startDistLeg <= tocDist && endDistLeg <= todDist)
+    return PHASE_CLIMB | PHASE_CRUISE;
+  else if(startDistLeg >= tocDist && endDistLeg >= todDist)
+    return PHASE_CRUISE | PHASE_DESCENT;
+  else
+    return PHASE_CRUISE;
+}
+
+bool RouteAltitude::LegWinds::isEqual(const atools::geo::LineString& otherLine, int otherPhases, int otherWindVersion) const
+{
+  if(windVersion != otherWindVersion || phases != otherPhases || line.size() != otherLine.size())
+    return false;
+
+  // Check if geometry including altitude is unchanged
+  for(int i = 0; i < line.size(); i++)
+  {
+    const ageo::Pos& pos1 = line.at(i), & pos2 = otherLine.at(i);
+    if(!atools::almostEqual(pos1.getLonX(), pos2.getLonX()) || !atools::almostEqual(pos1.getLatY(), pos2.getLatY()) ||
+       !atools::almostEqual(pos1.getAltitude(), pos2.getAltitude()))
+      return false;
+  }
+  return true;
+}
+
+void RouteAltitude::updateTripWinds(float tocDist, float todDist)
+{
+  WindReporter *windReporter = NavApp::getWindReporter();
+  int windVersion = windReporter->getWindDataVersion();
+
+  if(tripWinds.size() != size())
+    tripWinds.resize(size());
+
+  // Collect lines for phases and end positions of all legs which changed ======================
+  QVector<int> changedLegs;
+  QVector<ageo::LineString> lines;
+  ageo::LineString endPositions;
+  for(int i = 0; i < size(); i++)
+  {
+    const RouteAltitudeLeg& leg = value(i);
+
+    // Same conditions as in calculateTrip()
+    if(atools::almostEqual(leg.getDistanceTo(), 0.f) || leg.isAlternate())
+      continue;
+
+    const ageo::LineString& line = leg.getLineString();
+    int phases = tripPhases(leg, tocDist, todDist);
+    LegWinds& winds = tripWinds[i];
+
+    if(!winds.isEqual(line, phases, windVersion))
+    {
+      winds = LegWinds();
+      winds.line = line;
+      winds.phases = phases;
+      winds.windVersion = windVersion;
+      changedLegs.append(i);
+      endPositions.append(line.getPos2());
+
+      // Line contains bends at TOC and/or TOD - split into parts for phases
+      if(phases == PHASE_CLIMB || phases == PHASE_CRUISE || phases == PHASE_DESCENT)
+        lines.append(line);
+      else if(phases == (PHASE_CLIMB | PHASE_CRUISE | PHASE_DESCENT))
+        lines << line.left(2) << line.mid(1, 2) << line.right(2);
+      else
+        lines << line.left(2) << line.right(2);
+    }
+  }
+
+  if(changedLegs.isEmpty())
+    return;
+
+  // Query all in one batch ======================
+  QVector<atools::grib::Wind> lineWinds = windReporter->getWindForLineStringsRoute(lines);
+  QVector<atools::grib::Wind> endWinds = windReporter->getWindForPositionsRoute(endPositions);
+
+  // Assign results in the same order as collected ======================
+  int lineIndex = 0;
+  for(int i = 0; i < changedLegs.size(); i++)
+  {
+    LegWinds& winds = tripWinds[changedLegs.at(i)];
+    if(winds.phases & PHASE_CLIMB)
+      winds.climb = lineWinds.at(lineIndex++);
+    if(winds.phases & PHASE_CRUISE)
+      winds.cruise = lineWinds.at(lineIndex++);
+    if(winds.phases & PHASE_DESCENT)
+      winds.descent = lineWinds.at(lineIndex++);
+    winds.end = endWinds.at(i);
+  }
+}
+
+void RouteAltitude::benchmark(const atools::fs::perf::AircraftPerf& perf, float cruiseAltitudeFt)
+{
+  const int NUM_RUNS = 20;
+
+  qInfo() << Q_FUNC_INFO << "legs" << route->size() << "wind" << NavApp::getWindReporter()->hasAnyWindData()
+          << "cruise" << cruiseAltitudeFt;
+
+  for(bool cached : {false, true})
+  {
+    QElapsedTimer timer;
+    qint64 maxNs = 0L, totalNs = 0L;
+    for(int i = 0; i < NUM_RUNS; i++)
+    {
+      if(!cached)
+        tripWinds.clear();
+
+      timer.start();
+      calculateAll(perf, cruiseAltitudeFt);
+      qint64 ns = timer.nsecsElapsed();
+      maxNs = std::max(maxNs, ns);
+      totalNs += ns;
+    }
+
+    qInfo() << Q_FUNC_INFO << (cached ? "wind cache filled" : "wind cache empty") << "passes" << passes
+            << "average" << QString::number(totalNs / 1000000. / NUM_RUNS, 'f', 3) << "ms"
+            << "max" << QString::number(maxNs / 1000000., 'f', 3) << "ms";
+  }
+}
+
 float RouteAltitude::windCorrectedGroundSpeed(atools::grib::Wind& wind, float course, float speed)
 {
   float gs = ageo::windCorrectedGroundSpeed(wind.speed, wind.dir, course, speed);
@@ -19,6 +19,8 @@
 #define LNM_ROUTEALTITUDE_H
 
 #include "route/routealtitudeleg.h"
+#include "geo/linestring.h"
+#include "grib/windtypes.h"
 
 #include <QCoreApplication>
 
@@ -398,6 +400,10 @@ public:
     return descentTime;
   }
 
+  /* Runs calculateAll() repeatedly with empty and filled wind cache and prints times to the log.
+   * Changes this object. */
+  void benchmark(const atools::fs::perf::AircraftPerf& perf, float cruiseAltitudeFt);
+
   /* Calculates needed fuel to destination and TOD. Falls back to current aircraft consumption values if profile or
    * altitude legs are not valid. distanceToDest: Aircraft position distance to destination. */
   void calculateFuelAndTimeTo(FuelTimeResult& calculation, float distanceToDest, float distanceToNext,
@@ -413,6 +419,23 @@ private:
   /* Calculate traveling time and fuel consumption based on given performance object and wind */
   void calculateTrip(const atools::fs::perf::AircraftPerf& perf);
 
+  /* Winds for the phases of one leg as used in calculateTrip() */
+  struct LegWinds
+  {
+    atools::geo::LineString line; /* Leg geometry including altitudes */
+    int phases = 0, windVersion = -1;
+    atools::grib::Wind climb, cruise, descent, end;
+
+    /* true if winds were fetched for the same geometry, phases and wind data */
+    bool isEqual(const atools::geo::LineString& otherLine, int otherPhases, int otherWindVersion) const;
+  };
+
+  /* Combination of PHASE_CLIMB, PHASE_CRUISE and PHASE_DESCENT covered by leg */
+  static int tripPhases(const RouteAltitudeLeg& leg, float tocDist, float todDist);
+
+  /* Fetch winds for all legs in tripWinds where geometry, phases or wind data changed using one batch query */
+  void updateTripWinds(float tocDist, float todDist);
+
   /* Adjust the altitude to fit into the restriction. I.e. raise if it is below an at or above restriction */
   float adjustAltitudeForRestriction(float altitude, const proc::MapAltRestriction& restriction) const;
   void adjustVertAngleAltForRestriction(proc::MapAltRestriction& restriction) const;
@@ -448,7 +471,9 @@ private:
 
   /* Flatten altitude legs to avoid bends and flats when climbing/descending */
   void simplyfyRouteAltitudes();
-  void simplifyRouteAltitude(int index, bool departure);
+
+  /* Returns true if the altitude was changed */
+  bool simplifyRouteAltitude(int index, bool departure);
 
   /* Adjust range for vector size */
   int fixRange(int index) const;
@@ -497,6 +522,13 @@ private:
   /* Climb and descent are corrected for tail/head wind for second iteration in significant wind */
   float climbRateWindFtPerNm = 333.f, descentRateWindFtPerNm = 333.f, cruiseAltitude = 0.f;
 
+  /* Winds by leg index from last calculateTrip(). Legs are queried again only if geometry, phases or wind data
+   * changed which is the case for legs following an edited waypoint or a moved TOC or TOD. */
+  QVector<LegWinds> tripWinds;
+
+  /* Number of calculate() and calculateTrip() passes in last calculateAll() */
+  int passes = 0;
+
   /* Set by calculate */
   /* Contains a list of messages if the calculation result violates altitude restrictions
    * which can happen if the cruise altitude is too low */
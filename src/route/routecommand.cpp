@@ -18,11 +18,18 @@
 #include "route/routecommand.h"
 #include "route/routecontroller.h"
 
+#include "atools.h"
+
+#include <QDebug>
+
+using atools::fs::pln::Flightplan;
+
 RouteCommand::RouteCommand(RouteController *routeController,
                            const atools::fs::pln::Flightplan& flightplanBefore, const QString& text)
   : QUndoCommand(text), controller(routeController)
 {
-  planBeforeChange = flightplanBefore;
+  // Keep the whole plan until the change is known
+  headerBefore = flightplanBefore;
 }
 
 RouteCommand::~RouteCommand()
@@ -32,12 +39,35 @@ RouteCommand::~RouteCommand()
 
 void RouteCommand::setFlightplanAfter(const atools::fs::pln::Flightplan& flightplanAfter)
 {
-  planAfterChange = flightplanAfter;
+  const Flightplan& before = headerBefore;
+  int sizeBefore = before.size(), sizeAfter = flightplanAfter.size();
+
+  // Skip equal entries at start
+  int start = 0;
+  while(start < sizeBefore && start < sizeAfter && equal(before.at(start), flightplanAfter.at(start)))
+    start++;
+
+  // Skip equal entries at end
+  int end = 0;
+  while(end < sizeBefore - start && end < sizeAfter - start &&
+        equal(before.at(sizeBefore - end - 1), flightplanAfter.at(sizeAfter - end - 1)))
+    end++;
+
+  changeStart = start;
+  entriesBefore = before.mid(start, sizeBefore - start - end);
+  entriesAfter = flightplanAfter.mid(start, sizeAfter - start - end);
+
+  headerBefore = header(headerBefore);
+  headerAfter = header(flightplanAfter);
+
+#ifdef DEBUG_INFORMATION
+  qDebug() << Q_FUNC_INFO << text() << "start" << changeStart << "before" << entriesBefore.size() << "after" << entriesAfter.size();
+#endif
 }
 
 void RouteCommand::undo()
 {
-  controller->changeRouteUndo(planBeforeChange);
+  controller->changeRouteUndo(headerBefore, changeStart, entriesAfter.size(), entriesBefore);
 }
 
 void RouteCommand::redo()
@@ -46,5 +76,23 @@ void RouteCommand::redo()
     // Skip first redo - I need to do the initial changes myself
     firstRedoExecuted = true;
   else
-    controller->changeRouteRedo(planAfterChange);
+    controller->changeRouteRedo(headerAfter, changeStart, entriesBefore.size(), entriesAfter);
+}
+
+atools::fs::pln::Flightplan RouteCommand::header(const atools::fs::pln::Flightplan& flightplan)
+{
+  Flightplan plan(flightplan);
+  plan.erase(plan.begin(), plan.end());
+  return plan;
+}
+
+bool RouteCommand::equal(const atools::fs::pln::FlightplanEntry& entry1, const atools::fs::pln::FlightplanEntry& entry2)
+{
+  // Airport, runway and procedure fields are filled only in copies for export and are not compared
+  return entry1.getIdent() == entry2.getIdent() && entry1.getWaypointId() == entry2.getWaypointId() &&
+         entry1.getRegion() == entry2.getRegion() && entry1.getWaypointType() == entry2.getWaypointType() &&
+         entry1.getPosition() == entry2.getPosition() && atools::almostEqual(entry1.getAltitude(), entry2.getAltitude()) &&
+         entry1.getAirway() == entry2.getAirway() && entry1.getFlags() == entry2.getFlags() &&
+         entry1.getName() == entry2.getName() && entry1.getComment() == entry2.getComment() &&
+         entry1.getFrequency() == entry2.getFrequency() && atools::almostEqual(entry1.getMagvar(), entry2.getMagvar());
 }
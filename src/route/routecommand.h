@@ -26,7 +26,9 @@ class RouteController;
 
 /*
  * Flight plan undo command including a few workaround for QUndoCommand inflexibilities.
- * Keeps a copy of the flight plan before and after the change.
+ *
+ * Keeps only the flight plan header and the changed range of entries before and after the change. Entries are compared
+ * without procedure entries. Equal entries at the start and end are not stored to keep memory usage low for large plans.
  */
 class RouteCommand :
   public QUndoCommand
@@ -39,14 +41,33 @@ public:
   virtual void undo() override;
   virtual void redo() override;
 
-  /* Need to keep both versions in a redundant way since linking between commands is not reliable */
+  /* Need to keep both versions in a redundant way since linking between commands is not reliable.
+   * Calculates the changed range and drops the full copy of the plan before the change. */
   void setFlightplanAfter(const atools::fs::pln::Flightplan& flightplanAfter);
 
+  /* Approximate number of stored entries */
+  int getNumEntries() const
+  {
+    return entriesBefore.size() + entriesAfter.size();
+  }
+
 private:
+  /* Copy of the plan without entries */
+  static atools::fs::pln::Flightplan header(const atools::fs::pln::Flightplan& flightplan);
+
+  /* Compares all fields which are saved */
+  static bool equal(const atools::fs::pln::FlightplanEntry& entry1, const atools::fs::pln::FlightplanEntry& entry2);
+
   /* Avoid the first redo action when inserting the command. This not usable for complex interactions. */
   bool firstRedoExecuted = false;
   RouteController *controller;
-  atools::fs::pln::Flightplan planBeforeChange, planAfterChange;
+
+  /* Header including properties for procedures */
+  atools::fs::pln::Flightplan headerBefore, headerAfter;
+
+  /* Index of first changed entry and changed entries before and after */
+  int changeStart = 0;
+  QList<atools::fs::pln::FlightplanEntry> entriesBefore, entriesAfter;
 };
 
 #endif // LITTLENAVMAP_ROUTECOMMAND_H
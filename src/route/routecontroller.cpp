@@ -59,6 +59,7 @@
 #include "route/routecalcdialog.h"
 #include "route/routecommand.h"
 #include "route/routelabel.h"
+#include "route/routenetworkcache.h"
 #include "route/runwayselectiondialog.h"
 #include "route/userwaypointdialog.h"
 #include "routeextractor.h"
@@ -67,7 +68,6 @@
 #include "routestring/routestringwriter.h"
 #include "routing/routefinder.h"
 #include "routing/routenetwork.h"
-#include "routing/routenetworkloader.h"
 #include "settings/settings.h"
 #include "track/trackcontroller.h"
 #include "ui_mainwindow.h"
@@ -75,7 +75,9 @@
 #include "util/htmlbuilder.h"
 
 #include <QClipboard>
+#include <QEventLoop>
 #include <QFile>
+#include <QFutureWatcher>
 #include <QStandardItemModel>
 #include <QInputDialog>
 #include <QFileInfo>
@@ -85,6 +87,7 @@
 #include <QScrollBar>
 #include <QStringBuilder>
 #include <QUndoStack>
+#include <QtConcurrent/QtConcurrentRun>
 
 namespace rcol {
 // Route table column indexes
@@ -291,8 +294,14 @@ RouteController::RouteController(MainWindow* parentWindow, QTableView *tableView
   tableViewRoute->setContextMenuPolicy(Qt::CustomContextMenu);
 
   // Create flight plan calculation caches ===================================
-  routeNetworkRadio = new atools::routing::RouteNetwork(atools::routing::SOURCE_RADIO);
-  routeNetworkAirway = new atools::routing::RouteNetwork(atools::routing::SOURCE_AIRWAY);
+  routeNetworkCache = new RouteNetworkCache(this);
+  connect(routeNetworkCache, &RouteNetworkCache::preloadDone, this, [this]() {
+    if(routeCalcPending)
+    {
+      routeCalcPending = false;
+      calculateRoute();
+    }
+  });
 
   // Do not use a parent to allow the window moving to back
   routeCalcDialog = new RouteCalcDialog(nullptr);
@@ -342,6 +351,9 @@ RouteController::RouteController(MainWindow* parentWindow, QTableView *tableView
   // View ================================================================================
   connect(tableViewRoute, &QTableView::doubleClicked, this, &RouteController::doubleClick);
   connect(tableViewRoute, &QTableView::customContextMenuRequested, this, &RouteController::tableContextMenu);
+  // Invalidate snapshots first before any other receiver can fetch one
+  connect(this, &RouteController::routeChanged, this, &RouteController::routeModified);
+  connect(this, &RouteController::routeAltitudeChanged, this, &RouteController::routeModified);
   connect(this, &RouteController::routeChanged, this, &RouteController::updateRemarkWidget);
   connect(this, &RouteController::routeChanged, this, &RouteController::updateRemarkHeader);
   connect(ui->plainTextEditRouteRemarks, &QPlainTextEdit::textChanged, this, &RouteController::remarksTextChanged);
@@ -453,6 +465,7 @@ RouteController::~RouteController()
 {
   NavApp::removeDialogFromDockHandler(routeCalcDialog);
   routeAltDelayTimer.stop();
+  cancelRouteCalculation();
 
   ATOOLS_DELETE_LOG(routeCalcDialog);
   ATOOLS_DELETE_LOG(tabHandlerRoute);
@@ -460,8 +473,10 @@ RouteController::~RouteController()
   ATOOLS_DELETE_LOG(entryBuilder);
   ATOOLS_DELETE_LOG(model);
   ATOOLS_DELETE_LOG(undoStack);
-  ATOOLS_DELETE_LOG(routeNetworkRadio);
-  ATOOLS_DELETE_LOG(routeNetworkAirway);
+
+  // Cache sends preloadDone() when waiting in destructor
+  routeCalcPending = false;
+  ATOOLS_DELETE_LOG(routeNetworkCache);
   ATOOLS_DELETE_LOG(zoomHandler);
   ATOOLS_DELETE_LOG(symbolPainter);
   ATOOLS_DELETE_LOG(routeLabel);
@@ -1142,6 +1157,46 @@ void RouteController::clearFlightplan()
   route.clear();
 }
 
+std::shared_ptr<const Route> RouteController::getRouteSnapshot() const
+{
+  if(routeSnapshot == nullptr || routeSnapshotVersion != routeVersion)
+  {
+    // Route changed - copy once and share until next change
+    routeSnapshot = std::make_shared<const Route>(route);
+    routeSnapshotVersion = routeVersion;
+    routeSnapshotsAdjusted.clear();
+  }
+  return routeSnapshot;
+}
+
+std::shared_ptr<const Route> RouteController::getRouteSnapshotActive() const
+{
+  if(routeSnapshotActive == nullptr || routeSnapshotActiveVersion != routeActiveVersion ||
+     routeSnapshotActiveRouteVersion != routeVersion)
+  {
+    // Route, active leg or position changed - copy once and share until next change
+    routeSnapshotActive = std::make_shared<const Route>(route);
+    routeSnapshotActiveVersion = routeActiveVersion;
+    routeSnapshotActiveRouteVersion = routeVersion;
+  }
+  return routeSnapshotActive;
+}
+
+std::shared_ptr<const Route> RouteController::getRouteSnapshotAdjusted(rf::RouteAdjustOptions options) const
+{
+  // Updates snapshot and clears adjusted ones if route changed
+  std::shared_ptr<const Route> snapshot = getRouteSnapshot();
+
+  quint64 key = static_cast<quint64>(options.asFlagType());
+  std::shared_ptr<const Route> adjusted = routeSnapshotsAdjusted.value(key);
+  if(adjusted == nullptr)
+  {
+    adjusted = std::make_shared<const Route>(snapshot->updatedAltitudes().adjustedToOptions(options));
+    routeSnapshotsAdjusted.insert(key, adjusted);
+  }
+  return adjusted;
+}
+
 void RouteController::getSelectedRouteLegs(QList<int>& selLegIndexes) const
 {
   if(NavApp::getMainUi()->dockWidgetRoute->isVisible() && tableViewRoute->selectionModel() != nullptr)
@@ -2048,6 +2103,25 @@ void RouteController::calculateRoute()
 {
   qDebug() << Q_FUNC_INFO;
 
+  if(routeCalcFuture.isRunning())
+  {
+    // Nested call from event loop while waiting for worker
+    qWarning() << Q_FUNC_INFO << "Calculation already running";
+    return;
+  }
+
+  if(routeNetworkCache->isPreloading())
+  {
+    // Do not block the GUI - calculation is started again when networks are loaded
+    qDebug() << Q_FUNC_INFO << "Networks loading - calculation pending";
+    routeCalcPending = true;
+    NavApp::setStatusMessage(tr("Loading flight plan calculation network ..."));
+    return;
+  }
+
+  // Clear before fetching networks below which can send preloadDone() synchronously and start a nested calculation
+  routeCalcPending = false;
+
   atools::routing::RouteNetwork *net = nullptr;
   QString command;
   atools::routing::Modes mode = atools::routing::MODE_NONE;
@@ -2059,7 +2133,7 @@ void RouteController::calculateRoute()
   // Build configuration for route finder =======================================
   if(routeCalcDialog->getRoutingType() == rd::AIRWAY)
   {
-    net = routeNetworkAirway;
+    net = routeNetworkCache->getNetworkAirway();
     fetchAirways = true;
 
     // Airway preference =======================================
@@ -2101,19 +2175,16 @@ void RouteController::calculateRoute()
     // Radionav settings ========================================
     command = tr("Radionnav Flight Plan Calculation");
     fetchAirways = false;
-    net = routeNetworkRadio;
+    net = routeNetworkCache->getNetworkRadio();
     mode = atools::routing::MODE_RADIONAV_VOR;
     if(routeCalcDialog->isRadionavNdb())
       mode |= atools::routing::MODE_RADIONAV_NDB;
   }
 
-  if(!net->isLoaded())
-  {
-    atools::routing::RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
-    loader.load(net);
-  }
-
-  atools::routing::RouteFinder routeFinder(net);
+  // Read only snapshot for the worker. Containers are implicitly shared and detached only where the finder adds
+  // departure and destination nodes. The cached network is not touched and can be cleared while the worker runs.
+  atools::routing::RouteNetwork networkSnapshot(*net);
+  atools::routing::RouteFinder routeFinder(&networkSnapshot);
   routeFinder.setCostFactorForceAirways(routeCalcDialog->getAirwayPreferenceCostFactor());
 
   int fromIdx = -1, toIdx = -1;
@@ -2130,17 +2201,42 @@ void RouteController::calculateRoute()
     // Disable certain optimizations in route finder - use nearest underlying point as start for departure position
     mode |= atools::routing::MODE_POINT_TO_POINT;
 
-  if(calculateRouteInternal(&routeFinder, command, fetchAirways, routeCalcDialog->getCruisingAltitudeFt(), fromIdx, toIdx, mode))
-    NavApp::setStatusMessage(tr("Calculated flight plan."));
-  else
-    NavApp::setStatusMessage(tr("No route found."));
+  calculateRouteInternal(&routeFinder, command, fetchAirways, routeCalcDialog->getCruisingAltitudeFt(), fromIdx, toIdx, mode);
 
   routeCalcDialog->updateWidgets();
 }
 
 void RouteController::clearAirwayNetworkCache()
 {
-  routeNetworkAirway->clear();
+  cancelRouteCalculation();
+  routeNetworkCache->clearAirway();
+
+  // Tracks loaded or deleted - load again in background
+  routeNetworkCache->preload();
+}
+
+void RouteController::preTrackLoad()
+{
+  // Do not start a pending calculation while tracks are changed
+  routeCalcPending = false;
+  routeNetworkCache->waitForPreload();
+}
+
+void RouteController::preloadRouteNetworks()
+{
+  routeNetworkCache->preload();
+}
+
+void RouteController::cancelRouteCalculation()
+{
+  routeCalcPending = false;
+
+  if(routeCalcFuture.isRunning())
+  {
+    qDebug() << Q_FUNC_INFO << "Canceling route calculation";
+    routeCalcCanceled.store(true);
+    routeCalcFuture.waitForFinished();
+  }
 }
 
 /* Calculate a flight plan to all types */
@@ -2155,6 +2251,10 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
   // Stop any background tasks
   beforeRouteCalc();
 
+  // Indexes and positions below are valid only for this version. Route can be changed by edits, undo or
+  // loading while the event loop is running below.
+  quint64 editVersion = routeVersion;
+
   Flightplan& flightplan = route.getFlightplan();
 
   // Load network from database if not already done
@@ -2184,13 +2284,50 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
   progress.setWindowModality(Qt::ApplicationModal);
   progress.setMinimumDuration(500);
 
-  bool dialogShown = false, canceled = false;
-  routeFinder->setProgressCallback([&progress, &canceled, &dialogShown](int distToDest, int currentDistToDest) -> bool
+  // Progress values are written by the worker thread and read by the progress timer below
+  std::atomic_int progressMax(0), progressValue(0);
+  routeCalcCanceled.store(false);
+
+  routeFinder->setProgressCallback([this, &progressMax, &progressValue](int distToDest, int currentDistToDest) -> bool
+  {
+    progressMax.store(distToDest);
+    progressValue.store(distToDest - currentDistToDest);
+    return !routeCalcCanceled.load();
+  });
+
+  // Calculate the route and fetch waypoints in background - calls above lambda =================
+  // Network is loaded and not modified by the GUI thread until the worker is finished
+  float distance = 0.f;
+  QVector<RouteEntry> calculatedRoute;
+  int altitude = atools::roundToInt(altitudeFt);
+  routeCalcFuture = QtConcurrent::run([routeFinder, departurePos, destinationPos, altitude, mode,
+                                       &calculatedRoute, &distance]() -> bool
   {
-    QApplication::processEvents();
-    progress.setMaximum(distToDest);
-    progress.setValue(distToDest - currentDistToDest);
-    canceled = progress.wasCanceled();
+    bool result = routeFinder->calculateRoute(departurePos, destinationPos, altitude, mode);
+    if(result)
+    {
+      RouteExtractor extractor(routeFinder);
+      extractor.extractRoute(calculatedRoute, distance);
+      result = !calculatedRoute.isEmpty();
+    }
+    return result;
+  });
+
+  // Keep the event loop running to update map and simulator while waiting ============================
+  bool dialogShown = false;
+  QEventLoop loop;
+  QFutureWatcher<bool> watcher;
+  connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+
+  QTimer progressTimer;
+  progressTimer.setInterval(100);
+  connect(&progressTimer, &QTimer::timeout, this, [this, &progress, &progressMax, &progressValue, &dialogShown]() -> void
+  {
+    progress.setMaximum(progressMax.load());
+    progress.setValue(progressValue.load());
+
+    if(progress.wasCanceled())
+      routeCalcCanceled.store(true);
 
     if(!dialogShown && progress.isVisible())
     {
@@ -2198,17 +2335,36 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
       dialogShown = true;
       QGuiApplication::restoreOverrideCursor();
     }
-
-    return !canceled;
   });
 
-  // Calculate the route - calls above lambda ================================================
-  bool found = routeFinder->calculateRoute(departurePos, destinationPos, atools::roundToInt(altitudeFt), mode);
+  watcher.setFuture(routeCalcFuture);
+  progressTimer.start();
+  if(!routeCalcFuture.isFinished())
+    loop.exec();
+  progressTimer.stop();
+
+  if(!routeCalcFuture.isFinished())
+  {
+    // Loop was left by application exit - stop worker which uses the finder on the caller stack
+    routeCalcCanceled.store(true);
+    routeCalcFuture.waitForFinished();
+  }
+
+  bool found = routeCalcFuture.result();
+  bool canceled = routeCalcCanceled.load();
+
+  // Discard result if route was changed while waiting
+  bool discarded = routeVersion != editVersion;
+  if(discarded)
+  {
+    qDebug() << Q_FUNC_INFO << "Route changed during calculation - discarding result";
+    found = false;
+  }
 
   if(!dialogShown)
     QGuiApplication::restoreOverrideCursor();
 
-  qDebug() << Q_FUNC_INFO << "found" << found << "canceled" << canceled;
+  qDebug() << Q_FUNC_INFO << "found" << found << "canceled" << canceled << "Extracted size" << calculatedRoute.size();
 
   // Hide dialog
   progress.reset();
@@ -2216,21 +2372,6 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
   // Create wait cursor if calculation takes too long
   QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 
-  float distance = 0.f;
-  QVector<RouteEntry> calculatedRoute;
-
-  if(found && !canceled)
-  {
-    // A route was found
-
-    // Fetch waypoints
-    RouteExtractor extractor(routeFinder);
-    extractor.extractRoute(calculatedRoute, distance);
-    qDebug() << Q_FUNC_INFO << "Extracted size" << calculatedRoute.size();
-
-    found = calculatedRoute.size() > 0;
-  }
-
   if(found && !canceled)
   {
     // Compare to direct connection and check if route is too long
@@ -2325,7 +2466,15 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
   }
 
   QGuiApplication::restoreOverrideCursor();
-  if(!found && !canceled)
+
+  if(found)
+    NavApp::setStatusMessage(tr("Calculated flight plan."));
+  else if(discarded)
+    NavApp::setStatusMessage(tr("Flight plan changed during calculation. Result discarded."));
+  else
+    NavApp::setStatusMessage(tr("No route found."));
+
+  if(!found && !canceled && !discarded)
     // Use routeCalcDialog as parent to avoid main raising in front
     atools::gui::Dialog(routeCalcDialog).showInfoMsgBox(lnm::ACTIONS_SHOW_ROUTE_ERROR,
                                                         tr("Cannot calculate flight plan.\n\n"
@@ -2456,13 +2605,18 @@ void RouteController::preDatabaseLoad()
   atools::strToFile(atools::settings::Settings::getConfigFilename("_debug.lnmpln"), tempFlightplanStr);
 #endif
   routeCalcDialog->preDatabaseLoad();
+
+  // Close background connections before database files are changed
+  routeCalcPending = false;
+  routeNetworkCache->waitForPreload();
 }
 
 void RouteController::postDatabaseLoad()
 {
-  // Clear routing caches
-  routeNetworkRadio->clear();
-  routeNetworkAirway->clear();
+  // Clear routing caches and load again in background
+  cancelRouteCalculation();
+  routeNetworkCache->clear();
+  routeNetworkCache->preload();
   clearAllErrors();
 
   Flightplan flightplan;
@@ -3468,24 +3622,27 @@ void RouteController::tableSelectionChanged(const QItemSelection&, const QItemSe
     emit showPos(route.value(selectionModel->currentIndex().row()).getPosition(), map::INVALID_DISTANCE_VALUE, false /* doubleClick */);
 }
 
-void RouteController::changeRouteUndo(const atools::fs::pln::Flightplan& newFlightplan)
+void RouteController::changeRouteUndo(const atools::fs::pln::Flightplan& newHeader, int start, int numReplace,
+                                      const QList<atools::fs::pln::FlightplanEntry>& entries)
 {
   // Keep our own index as a workaround
   undoIndex--;
 
   qDebug() << "changeRouteUndo undoIndex" << undoIndex << "undoIndexClean" << undoIndexClean;
-  changeRouteUndoRedo(newFlightplan);
+  changeRouteUndoRedo(newHeader, start, numReplace, entries);
 }
 
-void RouteController::changeRouteRedo(const atools::fs::pln::Flightplan& newFlightplan)
+void RouteController::changeRouteRedo(const atools::fs::pln::Flightplan& newHeader, int start, int numReplace,
+                                      const QList<atools::fs::pln::FlightplanEntry>& entries)
 {
   // Keep our own index as a workaround
   undoIndex++;
   qDebug() << "changeRouteRedo undoIndex" << undoIndex << "undoIndexClean" << undoIndexClean;
-  changeRouteUndoRedo(newFlightplan);
+  changeRouteUndoRedo(newHeader, start, numReplace, entries);
 }
 
-void RouteController::changeRouteUndoRedo(const atools::fs::pln::Flightplan& newFlightplan)
+void RouteController::changeRouteUndoRedo(const atools::fs::pln::Flightplan& newHeader, int start, int numReplace,
+                                          const QList<atools::fs::pln::FlightplanEntry>& entries)
 {
   int currentRow = tableViewRoute->currentIndex().isValid() ? tableViewRoute->currentIndex().row() : -1;
   bool currentRowSelected = tableViewRoute->selectionModel()->isRowSelected(currentRow);
@@ -3493,12 +3650,41 @@ void RouteController::changeRouteUndoRedo(const atools::fs::pln::Flightplan& new
   // Ignore events triggering follow due to selection changes
   atools::util::ContextSaverBool saver(ignoreFollowSelection);
 
+  // Current plan and resolved legs without procedures - equal to the state after this command for undo
+  // and before this command for redo
+  Flightplan currentFlightplan = route.getFlightplanConst();
+  currentFlightplan.removeProcedureEntries();
+
+  QList<RouteLeg> currentLegs;
+  for(int i = 0; i < route.size(); i++)
+  {
+    const RouteLeg& leg = route.value(i);
+    if(!(leg.getFlightplanEntry().getFlags() & atools::fs::pln::entry::PROCEDURE))
+      currentLegs.append(leg);
+  }
+
+  if(start + numReplace > currentFlightplan.size())
+  {
+    qWarning() << Q_FUNC_INFO << "Flight plan changed outside of undo stack" << start << numReplace << currentFlightplan.size();
+    start = std::min(start, static_cast<int>(currentFlightplan.size()));
+    numReplace = std::min(numReplace, static_cast<int>(currentFlightplan.size()) - start);
+  }
+
+  // Use header from command and splice changed entries into current plan
+  Flightplan newFlightplan(newHeader);
+  newFlightplan.append(currentFlightplan.mid(0, start));
+  newFlightplan.append(entries);
+  newFlightplan.append(currentFlightplan.mid(start + numReplace));
+
   clearAllErrors();
   route.clearAll();
   route.setFlightplan(newFlightplan);
 
-  // Change format in plan according to last saved format
-  route.createRouteLegsFromFlightplan();
+  // Copy legs for unchanged entries and resolve only changed ones
+  if(currentLegs.size() == currentFlightplan.size())
+    route.createRouteLegsFromFlightplan(currentLegs, start, numReplace, entries.size());
+  else
+    route.createRouteLegsFromFlightplan();
   loadProceduresFromFlightplan(false /* clearOldProcedureProperties */, false /* cleanupRoute */, false /* autoresolveTransition */);
   route.updateAll();
   route.updateAirwaysAndAltitude(false /* adjustRouteAltitude */);
@@ -3536,6 +3722,9 @@ void RouteController::updateRemarksFont()
 
 void RouteController::optionsChanged()
 {
+  // Adjusted snapshots depend on options
+  routeModified();
+
   zoomHandler->zoomPercent(OptionData::instance().getGuiRouteTableTextSize());
 
   updateRemarksFont();
@@ -5660,6 +5849,9 @@ void RouteController::simDataChanged(const atools::fs::sc::SimConnectData& simul
       }
       else
         route.updateActivePos(position);
+
+      // Active leg and position changed - plan snapshots stay valid
+      routeActiveVersion++;
     }
     lastSimUpdate = QDateTime::currentDateTime().toMSecsSinceEpoch();
   }
@@ -6032,10 +6224,15 @@ void RouteController::postChange(RouteCommand *undoCommand)
 
     // Index and clean index workaround
     undoIndex++;
+    undoStack->push(undoCommand);
+
 #ifdef DEBUG_INFORMATION
-    qDebug() << "postChange undoIndex" << undoIndex << "undoIndexClean" << undoIndexClean;
+    // Stored entries are limited by the number of commands and the size of the changes
+    int numEntries = 0;
+    for(int i = 0; i < undoStack->count(); i++)
+      numEntries += static_cast<const RouteCommand *>(undoStack->command(i))->getNumEntries();
+    qDebug() << "postChange undoIndex" << undoIndex << "undoIndexClean" << undoIndexClean << "entries" << numEntries;
 #endif
-    undoStack->push(undoCommand);
   }
 }
 
@@ -6247,20 +6444,14 @@ void RouteController::debugNetworkClick(const atools::geo::Pos& pos)
   {
     qDebug() << Q_FUNC_INFO << pos;
 
-    atools::routing::RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
-    if(!routeNetworkAirway->isLoaded())
-      loader.load(routeNetworkAirway);
-    if(!routeNetworkRadio->isLoaded())
-      loader.load(routeNetworkRadio);
-
-    atools::routing::Node node = routeNetworkAirway->getNearestNode(pos);
+    atools::routing::Node node = routeNetworkCache->getNetworkAirway()->getNearestNode(pos);
     if(node.isValid())
     {
       qDebug() << "Airway node" << node;
       qDebug() << "Airway edges" << node.edges;
     }
 
-    node = routeNetworkRadio->getNearestNode(pos);
+    node = routeNetworkCache->getNetworkRadio()->getNearestNode(pos);
     if(node.isValid())
     {
       qDebug() << "Radio node" << node;
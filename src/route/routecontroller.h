@@ -21,9 +21,13 @@
 #include "routing/routenetworktypes.h"
 #include "route/route.h"
 
+#include <QFuture>
 #include <QItemSelection>
 #include <QTimer>
 
+#include <atomic>
+#include <memory>
+
 class QUndoStack;
 
 class QAction;
@@ -63,6 +67,7 @@ class QTextCursor;
 class RouteCalcDialog;
 class RouteCommand;
 class RouteLabel;
+class RouteNetworkCache;
 class SymbolPainter;
 class UnitStringTool;
 
@@ -147,6 +152,38 @@ public:
     return route;
   }
 
+  /* Immutable copy of the route which can be shared by readers and passed to threads without copying.
+   * The copy is created on the first call after a change of the route and kept until the next change.
+   * Active leg and aircraft position are not updated in the copy. Use getRouteSnapshotActive() if needed.
+   * Has to be called from the GUI thread. Snapshots remain valid as long as the pointer is kept. */
+  std::shared_ptr<const Route> getRouteSnapshot() const;
+
+  /* As above but also copied again after active leg or aircraft position changed. Used for progress information. */
+  std::shared_ptr<const Route> getRouteSnapshotActive() const;
+
+  /* Snapshot with updated altitudes and adjusted to options as used for saving and exporting.
+   * Cached per option set until the route changes. Has to be called from the GUI thread. */
+  std::shared_ptr<const Route> getRouteSnapshotAdjusted(rf::RouteAdjustOptions options) const;
+
+  /* Incremented on every change of the flight plan or its legs but not by aircraft position updates */
+  quint64 getRouteVersion() const
+  {
+    return routeVersion;
+  }
+
+  /* Incremented on every update of active leg and aircraft position */
+  quint64 getRouteActiveVersion() const
+  {
+    return routeActiveVersion;
+  }
+
+  /* Invalidates snapshots. Has to be called after modifying the route through getRoute() if no routeChanged()
+   * signal is sent afterwards. */
+  void routeModified()
+  {
+    routeVersion++;
+  }
+
   /* Get a copy of all route map objects (legs) that are selected in the flight plan table view */
   void getSelectedRouteLegs(QList<int>& selLegIndexes) const;
 
@@ -328,6 +365,12 @@ public:
   /* Clear network, so it will be reloaded before next flight plan calculation. */
   void clearAirwayNetworkCache();
 
+  /* Wait for background network loading before tracks are changed */
+  void preTrackLoad();
+
+  /* Load flight plan calculation networks in background */
+  void preloadRouteNetworks();
+
 #ifdef DEBUG_NETWORK_INFORMATION
   void debugNetworkClick(const atools::geo::Pos& pos);
 
@@ -415,11 +458,14 @@ private:
   /* Saves flight plan sippet using LNM format to given name. Given range must not contains procedures or alternates. */
   bool saveFlightplanLnmSelectionAs(const QString& filename, int from, int to) const;
 
-  /* Called by undo command */
-  void changeRouteUndo(const atools::fs::pln::Flightplan& newFlightplan);
+  /* Called by undo command. Replaces numReplace entries at start in the current plan (without procedures) with the
+   * given entries and uses the header and properties of newHeader. */
+  void changeRouteUndo(const atools::fs::pln::Flightplan& newHeader, int start, int numReplace,
+                       const QList<atools::fs::pln::FlightplanEntry>& entries);
 
   /* Called by undo command */
-  void changeRouteRedo(const atools::fs::pln::Flightplan& newFlightplan);
+  void changeRouteRedo(const atools::fs::pln::Flightplan& newHeader, int start, int numReplace,
+                       const QList<atools::fs::pln::FlightplanEntry>& entries);
 
   /* Save undo state before and after change */
   /* Call this before doing any change to the flight plan that should be undoable */
@@ -485,6 +531,9 @@ private:
 
   /* Calculate flight plan pressed in dock window */
   void calculateRoute();
+
+  /* Runs the finder in background and applies the result. The result is discarded if the route is changed
+   * while waiting. Returns true if the route was found and applied. */
   bool calculateRouteInternal(atools::routing::RouteFinder *routeFinder,
                               const QString& commandName,
                               bool fetchAirways, float altitudeFt, int fromIndex, int toIndex,
@@ -494,8 +543,9 @@ private:
   void updateFlightplanFromWidgets(atools::fs::pln::Flightplan& flightplan);
   void updateFlightplanFromWidgets();
 
-  /* Used by undo/redo */
-  void changeRouteUndoRedo(const atools::fs::pln::Flightplan& newFlightplan);
+  /* Used by undo/redo. Keeps resolved legs for unchanged entries. */
+  void changeRouteUndoRedo(const atools::fs::pln::Flightplan& newHeader, int start, int numReplace,
+                           const QList<atools::fs::pln::FlightplanEntry>& entries);
 
   void tableCopyClipboardTriggered();
 
@@ -540,6 +590,9 @@ private:
   void loadProceduresFromFlightplan(bool clearOldProcedureProperties, bool cleanupRoute, bool autoresolveTransition);
 
   void beforeRouteCalc();
+
+  /* Cancel a running flight plan calculation and wait until the worker thread has left the route network */
+  void cancelRouteCalculation();
   void updateFlightplanEntryAirway(int airwayId, atools::fs::pln::FlightplanEntry& entry);
   QIcon iconForLeg(const RouteLeg& leg, int size) const;
 
@@ -610,11 +663,25 @@ private:
   int undoIndexClean = 0;
 
   /* Network cache for flight plan calculation */
-  atools::routing::RouteNetwork *routeNetworkRadio = nullptr, *routeNetworkAirway = nullptr;
+  RouteNetworkCache *routeNetworkCache = nullptr;
+
+  /* Calculation was requested while networks are loaded in background. Started on RouteNetworkCache::preloadDone(). */
+  bool routeCalcPending = false;
+
+  /* Route finder running in background on a copy of the network. Result is true if a route was found. */
+  QFuture<bool> routeCalcFuture;
+  std::atomic_bool routeCalcCanceled{false};
 
   /* Flightplan and route objects */
   Route route; /* real route containing all segments */
 
+  /* Shared copies of route and versions. Replaced lazily when routeVersion changes or
+   * when routeActiveVersion changes for routeSnapshotActive. */
+  quint64 routeVersion = 1, routeActiveVersion = 1;
+  mutable quint64 routeSnapshotVersion = 0, routeSnapshotActiveVersion = 0, routeSnapshotActiveRouteVersion = 0;
+  mutable std::shared_ptr<const Route> routeSnapshot, routeSnapshotActive;
+  mutable QHash<quint64, std::shared_ptr<const Route> > routeSnapshotsAdjusted;
+
   /* Current filename of empty if no route - also remember start and dest to avoid accidental overwriting */
   QString routeFilename, fileDepartureIdent, fileDestinationIdent;
 
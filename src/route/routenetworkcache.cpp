@@ -0,0 +1,210 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routenetworkcache.h"
+
+#include "app/navapp.h"
+#include "atools.h"
+#include "db/dbtools.h"
+#include "routing/routenetwork.h"
+#include "routing/routenetworkloader.h"
+#include "sql/sqldatabase.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
+using atools::routing::RouteNetwork;
+using atools::routing::RouteNetworkLoader;
+using atools::sql::SqlDatabase;
+
+/* SQLite page cache and memory map size for the short lived preloading connections */
+static const int PRELOAD_CACHE_KB = 50000;
+static const int PRELOAD_MMAP_SIZE_MB = 256;
+
+RouteNetworkCache::RouteNetworkCache(QObject *parent)
+  : QObject(parent)
+{
+  networkRadio = new RouteNetwork(atools::routing::SOURCE_RADIO);
+  networkAirway = new RouteNetwork(atools::routing::SOURCE_AIRWAY);
+  preloadCanceled.store(false);
+
+  connect(&preloadWatcher, &QFutureWatcher<Networks>::finished, this, &RouteNetworkCache::preloadFinished);
+}
+
+RouteNetworkCache::~RouteNetworkCache()
+{
+  waitForPreload();
+
+  ATOOLS_DELETE_LOG(networkRadio);
+  ATOOLS_DELETE_LOG(networkAirway);
+}
+
+void RouteNetworkCache::preload()
+{
+  if(preloadWatcher.isRunning())
+    return;
+
+  // Take result of a finished task if signal is still pending
+  preloadFinished();
+
+  bool airway = !networkAirway->isLoaded(), radio = !networkRadio->isLoaded();
+  SqlDatabase *navDb = NavApp::getDatabaseNav(), *trackDb = NavApp::getDatabaseTrack();
+
+  if((airway || radio) && navDb != nullptr && navDb->isOpen() && trackDb != nullptr && trackDb->isOpen())
+  {
+    qDebug() << Q_FUNC_INFO << "airway" << airway << "radio" << radio;
+
+    // Pass only file names - connections are created and removed by the worker thread
+    preloadCanceled.store(false);
+    preloadWatcher.setFuture(QtConcurrent::run(this, &RouteNetworkCache::preloadNetworks,
+                                               navDb->databaseName(), trackDb->databaseName(), airway, radio));
+  }
+}
+
+RouteNetworkCache::Networks RouteNetworkCache::preloadNetworks(QString navFile, QString trackFile, bool airway, bool radio)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  Networks networks;
+  try
+  {
+    // Connections have to be created, used and removed in this thread
+    SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, dbtools::DATABASE_NAME_ROUTE_NAV);
+    SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, dbtools::DATABASE_NAME_ROUTE_TRACK);
+
+    {
+      // Destroy database objects before removing the connections
+      SqlDatabase dbNav(dbtools::DATABASE_NAME_ROUTE_NAV), dbTrack(dbtools::DATABASE_NAME_ROUTE_TRACK);
+      dbtools::openDatabaseFileShared(&dbNav, navFile, PRELOAD_CACHE_KB, PRELOAD_MMAP_SIZE_MB);
+      dbtools::openDatabaseFileShared(&dbTrack, trackFile, PRELOAD_CACHE_KB, PRELOAD_MMAP_SIZE_MB);
+
+      RouteNetworkLoader loader(&dbNav, &dbTrack);
+      if(airway && !preloadCanceled.load())
+      {
+        networks.airway = new RouteNetwork(atools::routing::SOURCE_AIRWAY);
+        loader.load(networks.airway);
+      }
+
+      if(radio && !preloadCanceled.load())
+      {
+        networks.radio = new RouteNetwork(atools::routing::SOURCE_RADIO);
+        loader.load(networks.radio);
+      }
+
+      dbNav.close();
+      dbTrack.close();
+    }
+  }
+  catch(std::exception& e)
+  {
+    // Fall back to synchronous loading
+    qWarning() << Q_FUNC_INFO << "Error preloading networks" << e.what();
+    delete networks.airway;
+    delete networks.radio;
+    networks = Networks();
+  }
+
+  SqlDatabase::removeDatabase(dbtools::DATABASE_NAME_ROUTE_NAV);
+  SqlDatabase::removeDatabase(dbtools::DATABASE_NAME_ROUTE_TRACK);
+
+  qDebug() << Q_FUNC_INFO << "Preloading took" << timer.elapsed() << "ms";
+  return networks;
+}
+
+void RouteNetworkCache::preloadFinished()
+{
+  QFuture<Networks> future = preloadWatcher.future();
+  if(future.isRunning() || future.isCanceled() || future.resultCount() == 0)
+    return;
+
+  Networks networks = future.result();
+
+  // Replace only the networks which were not loaded when starting the task
+  if(networks.airway != nullptr)
+  {
+    delete networkAirway;
+    networkAirway = networks.airway;
+  }
+
+  if(networks.radio != nullptr)
+  {
+    delete networkRadio;
+    networkRadio = networks.radio;
+  }
+
+  // Avoid taking the result a second time
+  preloadWatcher.setFuture(QFuture<Networks>());
+
+  emit preloadDone();
+}
+
+void RouteNetworkCache::waitForPreload()
+{
+  // Skip loading of remaining networks - these are loaded synchronously if needed
+  preloadCanceled.store(true);
+  waitForPreloadInternal();
+}
+
+void RouteNetworkCache::waitForPreloadInternal()
+{
+  if(preloadWatcher.isRunning())
+  {
+    qDebug() << Q_FUNC_INFO << "Waiting for preload";
+    preloadWatcher.waitForFinished();
+  }
+
+  // Take result now and do not wait for the finished signal
+  preloadFinished();
+}
+
+RouteNetwork *RouteNetworkCache::loadNetwork(RouteNetwork *network)
+{
+  if(!network->isLoaded())
+  {
+    RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
+    loader.load(network);
+  }
+  return network;
+}
+
+RouteNetwork *RouteNetworkCache::getNetworkAirway()
+{
+  // Wait first since preloading might replace the network
+  waitForPreloadInternal();
+  return loadNetwork(networkAirway);
+}
+
+RouteNetwork *RouteNetworkCache::getNetworkRadio()
+{
+  waitForPreloadInternal();
+  return loadNetwork(networkRadio);
+}
+
+void RouteNetworkCache::clear()
+{
+  waitForPreload();
+  networkRadio->clear();
+  networkAirway->clear();
+}
+
+void RouteNetworkCache::clearAirway()
+{
+  waitForPreload();
+  networkAirway->clear();
+}
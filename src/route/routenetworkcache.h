@@ -0,0 +1,110 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_ROUTENETWORKCACHE_H
+#define LNM_ROUTENETWORKCACHE_H
+
+#include <QFutureWatcher>
+#include <QObject>
+
+#include <atomic>
+
+namespace atools {
+namespace routing {
+class RouteNetwork;
+}
+}
+
+/*
+ * Keeps the airway and radio navaid networks used for flight plan calculation.
+ *
+ * Networks can be loaded in background after startup, database or track changes using own read only
+ * database connections which are created and removed by the worker thread. This avoids waiting for the SQL
+ * load on the first calculation. The networks are loaded synchronously on the GUI thread if nothing was preloaded.
+ *
+ * Networks are kept in memory only. A persistent memory mapped file keyed by navdata cycle would need a serialization
+ * and a memory layout without pointers and implicitly shared containers in the routing library.
+ *
+ * All methods have to be called from the GUI thread.
+ */
+class RouteNetworkCache :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit RouteNetworkCache(QObject *parent);
+  virtual ~RouteNetworkCache() override;
+
+  RouteNetworkCache(const RouteNetworkCache& other) = delete;
+  RouteNetworkCache& operator=(const RouteNetworkCache& other) = delete;
+
+  /* Start loading all networks which are not loaded yet in background and return immediately.
+   * Does nothing if loading is already running or database is not open. */
+  void preload();
+
+  /* Cancel background loading and wait until the worker has closed its database connections.
+   * Waits only for the network currently loading. Needed before databases are modified. */
+  void waitForPreload();
+
+  /* True while networks are loaded in background. preloadDone() is sent when finished. */
+  bool isPreloading() const
+  {
+    return preloadWatcher.isRunning();
+  }
+
+  /* Get loaded networks. Waits for background loading if running and loads synchronously if needed.
+   * Check isPreloading() before to avoid blocking. */
+  atools::routing::RouteNetwork *getNetworkAirway();
+  atools::routing::RouteNetwork *getNetworkRadio();
+
+  /* Remove networks from memory. Waits for background loading if running. */
+  void clear();
+  void clearAirway();
+
+signals:
+  /* Background loading finished and networks were taken over. Can also be sent synchronously from
+   * getNetworkAirway(), getNetworkRadio(), clear() or waitForPreload() if these take the result. */
+  void preloadDone();
+
+private:
+  struct Networks
+  {
+    atools::routing::RouteNetwork *airway = nullptr, *radio = nullptr;
+  };
+
+  /* Called in background thread. Opens, uses and removes own connections to the given database files. */
+  Networks preloadNetworks(QString navFile, QString trackFile, bool airway, bool radio);
+
+  /* Wait without canceling */
+  void waitForPreloadInternal();
+
+  /* Take networks from finished background task. Called by watcher. */
+  void preloadFinished();
+
+  /* Load network in GUI thread if not loaded */
+  atools::routing::RouteNetwork *loadNetwork(atools::routing::RouteNetwork *network);
+
+  atools::routing::RouteNetwork *networkRadio = nullptr, *networkAirway = nullptr;
+
+  QFutureWatcher<Networks> preloadWatcher;
+
+  /* Checked by worker before loading the next network */
+  std::atomic<bool> preloadCanceled;
+};
+
+#endif // LNM_ROUTENETWORKCACHE_H
@@ -1613,6 +1613,7 @@ bool RouteExport::exportFlighplanAsRxpGns(const QString& filename, bool saveAsUs
   {
     // Regions are required for the export
     NavApp::getRoute().updateAirportRegions();
+    NavApp::getRouteController()->routeModified();
     FlightplanIO().saveGarminFpl(buildAdjustedRoute(rf::DEFAULT_OPTS_NO_PROC).getFlightplanConst(), filename, saveAsUserWaypoints);
   }
   catch(atools::Exception& e)
@@ -2095,7 +2096,8 @@ Route RouteExport::buildAdjustedRoute(rf::RouteAdjustOptions options)
       options |= rf::SAVE_AIRWAY_WP;
   }
 
-  Route adjustedRoute = NavApp::getRouteConst().updatedAltitudes().adjustedToOptions(options);
+  // Copy cached adjusted snapshot since airways are updated below
+  Route adjustedRoute(*NavApp::getRouteSnapshotAdjusted(options));
 
   // Update airway structures
   adjustedRoute.updateAirwaysAndAltitude(false /* adjustRouteAltitude */);
@@ -64,6 +64,9 @@ UserdataController::UserdataController(atools::fs::userdata::UserdataManager *us
   lastAddedRecord = new SqlRecord();
 
   connect(this, &UserdataController::userdataChanged, manager, &atools::sql::DataManagerBase::updateUndoRedoActions);
+  connect(this, &UserdataController::userdataChanged, this, [this]() {
+    userdataVersion++;
+  });
 
   Ui::MainWindow *ui = NavApp::getMainUi();
   connect(ui->actionSearchUserpointUndo, &QAction::triggered, this, &UserdataController::undoTriggered);
@@ -154,6 +154,12 @@ public:
   /* Show choice dialog with options to remove empty or duplicate userpoints */
   void cleanupUserdata();
 
+  /* Incremented on each userdataChanged() signal */
+  quint64 getUserdataVersion() const
+  {
+    return userdataVersion;
+  }
+
 signals:
   /* Sent after database modification to update the search result table */
   void refreshUserdataSearch(bool loadAll, bool keepSelection, bool force);
@@ -203,6 +209,7 @@ private:
   /* Takes care about all action logic like toggling of all/selected and none/selected */
   atools::gui::ActionButtonHandler *buttonHandler;
 
+  quint64 userdataVersion = 1;
 };
 
 #endif // USERDATACONTROLLER_H
@@ -0,0 +1,193 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "weather/windgridcache.h"
+
+#include "atools.h"
+#include "geo/calculations.h"
+#include "geo/rect.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+
+/* Standard levels in feet. First one is used for AGL display. */
+static const QVector<float> LEVELS_FT({260.f, 2000.f, 5000.f, 10000.f, 15000.f, 20000.f, 25000.f, 30000.f, 35000.f,
+                                       40000.f, 45000.f});
+
+WindGridCache::WindGridCache(QueryFunc queryFunc)
+  : query(queryFunc)
+{
+}
+
+void WindGridCache::updateVersion(int newVersion)
+{
+  if(version != newVersion)
+  {
+    tiles.clear();
+    version = newVersion;
+    revision++;
+  }
+}
+
+int WindGridCache::numColumns(int gridSpacing)
+{
+  return static_cast<int>(std::ceil(360. / tileDegrees(gridSpacing)));
+}
+
+int WindGridCache::numRows(int gridSpacing)
+{
+  return static_cast<int>(std::ceil(180. / tileDegrees(gridSpacing)));
+}
+
+bool WindGridCache::getWinds(atools::grib::WindPosList& winds, const atools::geo::Rect& rect, float altitudeFt, int gridSpacing,
+                             bool lazy)
+{
+  if(gridSpacing <= 0 || !rect.isValid())
+    return true;
+
+  gridSpacings.insert(gridSpacing);
+
+  // Find standard levels below and above altitude and interpolation factor ============
+  int lower = 0, upper = 0;
+  float fraction = 0.f;
+  if(altitudeFt >= LEVELS_FT.constLast())
+    lower = upper = LEVELS_FT.size() - 1;
+  else if(altitudeFt > LEVELS_FT.constFirst())
+  {
+    while(upper < LEVELS_FT.size() - 1 && LEVELS_FT.at(upper) < altitudeFt)
+      upper++;
+    lower = upper - 1;
+    fraction = (altitudeFt - LEVELS_FT.at(lower)) / (LEVELS_FT.at(upper) - LEVELS_FT.at(lower));
+
+    if(atools::almostEqual(fraction, 1.f, 0.001f))
+      lower = upper;
+  }
+
+  // Find tile range ============
+  int degrees = tileDegrees(gridSpacing);
+  int column1 = atools::minmax(0, numColumns(gridSpacing) - 1, static_cast<int>(std::floor((rect.getWest() + 180.f) / degrees)));
+  int column2 = atools::minmax(0, numColumns(gridSpacing) - 1, static_cast<int>(std::floor((rect.getEast() + 180.f) / degrees)));
+  int row1 = atools::minmax(0, numRows(gridSpacing) - 1, static_cast<int>(std::floor((rect.getSouth() + 90.f) / degrees)));
+  int row2 = atools::minmax(0, numRows(gridSpacing) - 1, static_cast<int>(std::floor((rect.getNorth() + 90.f) / degrees)));
+
+  bool complete = true;
+  for(int row = row1; row <= row2; row++)
+  {
+    for(int column = column1; column <= column2; column++)
+    {
+      // Fetch both first since building a tile can change the hash
+      tile(lower, gridSpacing, row, column, lazy);
+      tile(upper, gridSpacing, row, column, lazy);
+      const atools::grib::WindPosList *lowerTile = tile(lower, gridSpacing, row, column, true /* lazy */);
+      const atools::grib::WindPosList *upperTile = tile(upper, gridSpacing, row, column, true /* lazy */);
+
+      if(lowerTile == nullptr || upperTile == nullptr)
+      {
+        complete = false;
+        continue;
+      }
+
+      // Tiles for different levels have the same grid points
+      bool interpolate = lowerTile != upperTile && lowerTile->size() == upperTile->size();
+      for(int i = 0; i < lowerTile->size(); i++)
+      {
+        const atools::grib::WindPos& windPos = lowerTile->at(i);
+        if(!rect.contains(windPos.pos))
+          continue;
+
+        atools::grib::WindPos result;
+        result.pos = windPos.pos.alt(altitudeFt);
+        result.wind = windPos.wind;
+
+        const atools::grib::Wind& upperWind = upperTile->at(i).wind;
+        if(interpolate && windPos.wind.isValid() && upperWind.isValid())
+        {
+          // Interpolate vectors to avoid problems with direction wrapping
+          float u = atools::geo::windUComponent(windPos.wind.speed, windPos.wind.dir) * (1.f - fraction) +
+                    atools::geo::windUComponent(upperWind.speed, upperWind.dir) * fraction;
+          float v = atools::geo::windVComponent(windPos.wind.speed, windPos.wind.dir) * (1.f - fraction) +
+                    atools::geo::windVComponent(upperWind.speed, upperWind.dir) * fraction;
+          result.wind.dir = atools::geo::windDirectionFromUV(u, v);
+          result.wind.speed = atools::geo::windSpeedFromUV(u, v);
+        }
+
+        winds.append(result);
+      }
+    }
+  }
+  return complete;
+}
+
+const atools::grib::WindPosList *WindGridCache::tile(int level, int gridSpacing, int row, int column, bool lazy)
+{
+  quint64 tileKey = key(level, gridSpacing, row, column);
+  auto it = tiles.constFind(tileKey);
+  if(it != tiles.constEnd())
+    return &it.value();
+
+  if(lazy)
+    return nullptr;
+
+  int degrees = tileDegrees(gridSpacing);
+  float west = -180.f + column * degrees, south = -90.f + row * degrees;
+  float east = std::min(180.f, west + degrees), north = std::min(90.f, south + degrees);
+
+  atools::grib::WindPosList winds;
+  query(winds, atools::geo::Rect(west, north, east, south), LEVELS_FT.at(level), gridSpacing);
+
+  // Keep only points not belonging to east and north neighbors to avoid duplicates
+  winds.erase(std::remove_if(winds.begin(), winds.end(), [west, east, south, north](const atools::grib::WindPos& windPos) -> bool {
+    float lonX = windPos.pos.getLonX(), latY = windPos.pos.getLatY();
+    return lonX < west || latY < south || (lonX >= east && east < 180.f) || (latY >= north && north < 90.f);
+  }), winds.end());
+
+  revision++;
+  return &tiles.insert(tileKey, winds).value();
+}
+
+bool WindGridCache::buildTiles(qint64 maxNs)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  for(int gridSpacing : qAsConst(gridSpacings))
+  {
+    for(int level = 0; level < LEVELS_FT.size(); level++)
+    {
+      for(int row = 0; row < numRows(gridSpacing); row++)
+      {
+        for(int column = 0; column < numColumns(gridSpacing); column++)
+        {
+          if(!tiles.contains(key(level, gridSpacing, row, column)))
+          {
+            tile(level, gridSpacing, row, column, false /* lazy */);
+            if(timer.nsecsElapsed() > maxNs)
+              return true;
+          }
+        }
+      }
+    }
+  }
+
+#ifdef DEBUG_INFORMATION
+  qDebug() << Q_FUNC_INFO << "All tiles built" << tiles.size();
+#endif
+  return false;
+}
@@ -0,0 +1,99 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_WINDGRIDCACHE_H
+#define LNM_WINDGRIDCACHE_H
+
+#include "grib/windtypes.h"
+
+#include <QHash>
+#include <QSet>
+
+#include <functional>
+
+namespace atools {
+namespace geo {
+class Rect;
+}
+}
+
+/*
+ * Cache for wind barb grids which are divided into tiles per standard level and grid spacing.
+ *
+ * Winds for levels between standard levels are interpolated from the two neighbor levels using U and V components.
+ * A tile covers TILE_CELLS by TILE_CELLS grid points. Missing tiles are either built on request or by buildTiles()
+ * which can be called repeatedly to fill all tiles for all grid spacings used so far.
+ *
+ * Not thread safe.
+ */
+class WindGridCache
+{
+public:
+  /* Has to fill winds with grid points for the given rectangle, altitude and spacing in degree */
+  typedef std::function<void (atools::grib::WindPosList& winds, const atools::geo::Rect& rect, float altitudeFt,
+                              int gridSpacing)> QueryFunc;
+
+  explicit WindGridCache(QueryFunc queryFunc);
+
+  /* Removes all tiles if version differs from the last one. Grid spacings are kept for rebuilding. */
+  void updateVersion(int version);
+
+  /* Append winds inside the rectangle which must not cross the anti-meridian.
+   * Only uses already built tiles if lazy is true. Returns false if tiles were missing in lazy mode. */
+  bool getWinds(atools::grib::WindPosList& winds, const atools::geo::Rect& rect, float altitudeFt, int gridSpacing,
+                bool lazy);
+
+  /* Build missing tiles for all standard levels and used grid spacings until maxNs nanoseconds are used.
+   * Returns true if there are still missing tiles. */
+  bool buildTiles(qint64 maxNs);
+
+  /* Incremented on every change of tiles */
+  int getRevision() const
+  {
+    return revision;
+  }
+
+private:
+  const static int TILE_CELLS = 30;
+
+  static quint64 key(int level, int gridSpacing, int row, int column)
+  {
+    return ((static_cast<quint64>(level) * 256 + static_cast<quint64>(gridSpacing)) * 1000 + static_cast<quint64>(row)) * 1000 +
+           static_cast<quint64>(column);
+  }
+
+  /* Tile size in degrees */
+  static int tileDegrees(int gridSpacing)
+  {
+    return TILE_CELLS * gridSpacing;
+  }
+
+  static int numColumns(int gridSpacing);
+  static int numRows(int gridSpacing);
+
+  /* Get tile and build it if missing and not lazy. Returns null if missing. */
+  const atools::grib::WindPosList *tile(int level, int gridSpacing, int row, int column, bool lazy);
+
+  QueryFunc query;
+  QHash<quint64, atools::grib::WindPosList> tiles;
+
+  /* Grid spacings requested so far */
+  QSet<int> gridSpacings;
+  int version = -1, revision = 0;
+};
+
+#endif // LNM_WINDGRIDCACHE_H
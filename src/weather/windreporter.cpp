@@ -20,14 +20,16 @@
 #include "app/navapp.h"
 #include "common/constants.h"
 #include "common/unit.h"
+#include "geo/linestring.h"
 #include "geo/marbleconverter.h"
 #include "grib/windquery.h"
 #include "gui/dialog.h"
-#include "mapgui/maplayer.h"
 #include "options/optiondata.h"
 #include "perf/aircraftperfcontroller.h"
+#include "query/querytypes.h"
 #include "settings/settings.h"
 #include "ui_mainwindow.h"
+#include "weather/windgridcache.h"
 
 #include <QToolButton>
 #include <QDir>
@@ -35,6 +37,12 @@
 static const double queryRectInflationFactor = 0.2;
 static const double queryRectInflationIncrement = 0.1;
 
+/* Clear route wind cache if it gets larger than this */
+static const int ROUTE_WIND_CACHE_MAX_SIZE = 100000;
+
+/* Time used for building wind grid tiles per event loop iteration */
+static const qint64 GRID_BUILD_SLICE_NS = 20000000L;
+
 namespace windinternal {
 
 WindSliderAction::WindSliderAction(QObject *parent)
@@ -171,6 +179,28 @@ WindReporter::WindReporter(QObject *parent, atools::fs::FsPaths::SimulatorType t
   atools::settings::Settings& settings = atools::settings::Settings::instance();
   verbose = settings.getAndStoreValue(lnm::OPTIONS_WEATHER_DEBUG, false).toBool();
 
+  // Connected first to invalidate caches before any receiver recalculates
+  connect(this, &WindReporter::windUpdated, this, [this]() {
+    windDataVersion++;
+  });
+
+  // Wind grid tiles ==================
+  windGridCache = new WindGridCache([this](atools::grib::WindPosList& winds, const atools::geo::Rect& rect, float altitudeFt,
+                                           int gridSpacing) {
+    currentWindQuery()->getWindForRect(winds, rect, altitudeFt, gridSpacing);
+  });
+
+  // Build remaining tiles in small slices while the event loop is idle
+  gridBuildTimer.setInterval(0);
+  connect(&gridBuildTimer, &QTimer::timeout, this, &WindReporter::buildWindGridTiles);
+  connect(this, &WindReporter::windUpdated, this, [this]() {
+    if(isWindShown() && currentWindQuery()->hasWindData())
+    {
+      windGridCache->updateVersion(windDataVersion);
+      gridBuildTimer.start();
+    }
+  });
+
   // Real wind ==================
   windQueryOnline = new atools::grib::WindQuery(parent, verbose);
   connect(windQueryOnline, &atools::grib::WindQuery::windDataUpdated, this, &WindReporter::windDownloadFinished);
@@ -191,6 +221,8 @@ WindReporter::WindReporter(QObject *parent, atools::fs::FsPaths::SimulatorType t
 
 WindReporter::~WindReporter()
 {
+  gridBuildTimer.stop();
+  ATOOLS_DELETE_LOG(windGridCache);
   ATOOLS_DELETE_LOG(windQueryOnline);
   ATOOLS_DELETE_LOG(windQueryManual);
   ATOOLS_DELETE_LOG(actionGroup);
@@ -702,7 +734,7 @@ void WindReporter::debugDumpContainerSizes() const
     windQueryManual->debugDumpContainerSizes();
   if(windQueryOnline != nullptr)
     windQueryOnline->debugDumpContainerSizes();
-  qDebug() << Q_FUNC_INFO << "windPosCache.list.size()" << windPosCache.list.size();
+  qDebug() << Q_FUNC_INFO << "windPosResult.size()" << windPosResult.size();
 
 }
 
@@ -756,47 +788,45 @@ float WindReporter::getManualAltitudeFt() const
     return map::INVALID_ALTITUDE_VALUE;
 }
 
-const atools::grib::WindPosList *WindReporter::getWindForRect(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy,
-                                                              int gridSpacing)
+const atools::grib::WindPosList *WindReporter::getWindForRect(const Marble::GeoDataLatLonBox& rect, bool lazy, int gridSpacing)
 {
-  // Result is sorted by y and x coordinates
-  // Pos(-127.000000,52.000000,11500.000000)
-  // Pos(-127.000000,51.000000,11500.000000)
-  // Pos(-127.000000,50.000000,11500.000000)
-  // Pos(-127.000000,49.000000,11500.000000)
-  // Pos(-126.000000,52.000000,11500.000000)
-  // Pos(-126.000000,51.000000,11500.000000)
-  // Pos(-126.000000,50.000000,11500.000000)
-  // Pos(-126.000000,49.000000,11500.000000)
-
   atools::grib::WindQuery *windQuery = currentWindQuery();
   if(windQuery->hasWindData())
   {
-    // Update
-    windPosCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                             [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
-    {
-      return curLayer->hasSameQueryParametersWind(newLayer);
-    });
+    windGridCache->updateVersion(windDataVersion);
 
-    if((windPosCache.list.isEmpty() && !lazy) || cachedLevel != sliderActionAltitude->getAltitudeFt()) // Force update if level has changed
+    // Collect again only if view, level or tiles have changed
+    float altitudeFt = getDisplayAltitudeFt();
+    bool complete = true;
+    if(rect != windPosResultRect || atools::almostNotEqual(altitudeFt, windPosResultAltitude) ||
+       gridSpacing != windPosResultGridSpacing || windGridCache->getRevision() != windPosResultRevision)
     {
-      windPosCache.clear();
+      windPosResult.clear();
       for(const Marble::GeoDataLatLonBox& box : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-      {
-        atools::geo::Rect geoRect = mconvert::fromGdc(box);
+        complete &= windGridCache->getWinds(windPosResult, mconvert::fromGdc(box), altitudeFt, gridSpacing, lazy);
 
-        atools::grib::WindPosList windPosList;
-        windQuery->getWindForRect(windPosList, geoRect, getDisplayAltitudeFt(), gridSpacing);
-        windPosCache.list.append(windPosList);
-        cachedLevel = sliderActionAltitude->getAltitudeFt();
-      }
+      // Keep parameters only for complete results to fill missing tiles on next call
+      windPosResultRect = complete ? rect : Marble::GeoDataLatLonBox();
+      windPosResultAltitude = altitudeFt;
+      windPosResultGridSpacing = gridSpacing;
+      windPosResultRevision = windGridCache->getRevision();
     }
-    return &windPosCache.list;
+
+    // Fill missing tiles in background - other levels are prepared on windUpdated
+    if(!complete)
+      gridBuildTimer.start();
+    return &windPosResult;
   }
   return nullptr;
 }
 
+void WindReporter::buildWindGridTiles()
+{
+  // Limit to a few milliseconds per event loop iteration to keep the GUI responsive
+  if(!currentWindQuery()->hasWindData() || !windGridCache->buildTiles(GRID_BUILD_SLICE_NS))
+    gridBuildTimer.stop();
+}
+
 atools::grib::WindPos WindReporter::getWindForPos(const atools::geo::Pos& pos, float altFeet)
 {
   atools::grib::WindQuery *windQuery = currentWindQuery();
@@ -834,6 +864,74 @@ atools::grib::Wind WindReporter::getWindForLineStringRoute(const atools::geo::Li
   return currentWindQuery()->getWindAverageForLineString(line);
 }
 
+QVector<atools::grib::Wind> WindReporter::getWindForLineStringsRoute(const QVector<atools::geo::LineString>& lines)
+{
+  QVector<QVector<qint32> > keys;
+  keys.reserve(lines.size());
+  for(const atools::geo::LineString& line : lines)
+    keys.append(routeWindKey(line));
+
+  atools::grib::WindQuery *windQuery = currentWindQuery();
+  return routeWinds(keys, [windQuery, &lines](int index) -> atools::grib::Wind {
+    return windQuery->getWindAverageForLineString(lines.at(index));
+  });
+}
+
+QVector<atools::grib::Wind> WindReporter::getWindForPositionsRoute(const atools::geo::LineString& positions)
+{
+  QVector<QVector<qint32> > keys;
+  keys.reserve(positions.size());
+  for(const atools::geo::Pos& pos : positions)
+    keys.append(routeWindKey(pos));
+
+  atools::grib::WindQuery *windQuery = currentWindQuery();
+  return routeWinds(keys, [windQuery, &positions](int index) -> atools::grib::Wind {
+    return windQuery->getWindForPos(positions.at(index));
+  });
+}
+
+QVector<qint32> WindReporter::routeWindKey(const atools::geo::LineString& line)
+{
+  // About ten meters and one foot resolution - first value separates lines from positions
+  QVector<qint32> key;
+  key.reserve(line.size() * 3 + 1);
+  key.append(1);
+  for(const atools::geo::Pos& pos : line)
+  {
+    key.append(atools::roundToInt(pos.getLonX() * 10000.f));
+    key.append(atools::roundToInt(pos.getLatY() * 10000.f));
+    key.append(atools::roundToInt(pos.getAltitude()));
+  }
+  return key;
+}
+
+QVector<qint32> WindReporter::routeWindKey(const atools::geo::Pos& pos)
+{
+  return QVector<qint32>({0, atools::roundToInt(pos.getLonX() * 10000.f), atools::roundToInt(pos.getLatY() * 10000.f),
+                          atools::roundToInt(pos.getAltitude())});
+}
+
+QVector<atools::grib::Wind> WindReporter::routeWinds(const QVector<QVector<qint32> >& keys,
+                                                     const std::function<atools::grib::Wind(int index)>& query) const
+{
+  if(routeWindCacheVersion != windDataVersion || routeWindCache.size() > ROUTE_WIND_CACHE_MAX_SIZE)
+  {
+    routeWindCache.clear();
+    routeWindCacheVersion = windDataVersion;
+  }
+
+  QVector<atools::grib::Wind> winds;
+  winds.reserve(keys.size());
+  for(int i = 0; i < keys.size(); i++)
+  {
+    auto it = routeWindCache.constFind(keys.at(i));
+    if(it == routeWindCache.constEnd())
+      it = routeWindCache.insert(keys.at(i), query(i));
+    winds.append(it.value());
+  }
+  return winds;
+}
+
 atools::grib::WindPosList WindReporter::windStackForPosInternal(const atools::geo::Pos& pos, QVector<int> altitudesFt) const
 {
   atools::grib::WindPosList winds;
@@ -841,23 +939,31 @@ atools::grib::WindPosList WindReporter::windStackForPosInternal(const atools::ge
 
   if(windQuery->hasWindData())
   {
-    atools::grib::WindPos wp;
+    // Collect positions for all levels - treat 0 level as AGL
+    atools::geo::LineString positions;
+    QVector<QVector<qint32> > keys;
+    for(int altitudeFt : altitudesFt)
+    {
+      positions.append(pos.alt(altitudeFt == 0 ? 260.f : altitudeFt));
+      keys.append(routeWindKey(positions.constLast()));
+    }
+
+    // Get wind for all layers/altitudes in one call
+    QVector<atools::grib::Wind> levelWinds = routeWinds(keys, [windQuery, &positions](int index) -> atools::grib::Wind {
+      return windQuery->getWindForPos(positions.at(index));
+    });
 
-    // Collect wind for all levels
+    atools::grib::WindPos wp;
     for(int i = 0; i < altitudesFt.size(); i++)
     {
-      // Treat 0 level as AGL
-      float alt = altitudesFt.at(i) == 0 ? 260.f : altitudesFt.at(i);
-
-      // Get wind for layer/altitude
-      wp.pos = pos.alt(alt);
+      wp.pos = positions.at(i);
       if(currentSource != wind::WIND_SOURCE_NOAA && altitudesFt.at(i) == 0)
       {
         wp.wind.dir = map::INVALID_COURSE_VALUE;
         wp.wind.speed = map::INVALID_SPEED_VALUE;
       }
       else
-        wp.wind = windQuery->getWindForPos(wp.pos);
+        wp.wind = levelWinds.at(i);
       winds.append(wp);
     }
   }
@@ -925,6 +1031,7 @@ void WindReporter::updateManualRouteWinds()
   windQueryManual->initFromFixedModel(perfController->getManualWindDirDeg(),
                                       perfController->getManualWindSpeedKts(),
                                       perfController->getManualWindAltFt());
+  windDataVersion++;
 }
 
 #ifdef DEBUG_INFORMATION
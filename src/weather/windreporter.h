@@ -20,10 +20,15 @@
 
 #include "fs/fspaths.h"
 #include "grib/windtypes.h"
-#include "query/querytypes.h"
 
+#include <QHash>
+#include <QTimer>
 #include <QWidgetAction>
 
+#include <functional>
+
+#include <marble/GeoDataLatLonBox.h>
+
 namespace windinternal {
 class WindSliderAction;
 class WindLabelAction;
@@ -45,6 +50,7 @@ class QAction;
 class QActionGroup;
 class QSlider;
 class Route;
+class WindGridCache;
 
 namespace wind {
 
@@ -116,6 +122,12 @@ public:
     return hasOnlineWindData() || isWindManual();
   }
 
+  /* Incremented whenever wind data or source changes. Allows to detect outdated cached wind values. */
+  int getWindDataVersion() const
+  {
+    return windDataVersion;
+  }
+
   /* Get currently shown/selected wind bar altitude level in ft. 0. if none is selected.  */
   float getDisplayAltitudeFt() const;
 
@@ -123,9 +135,8 @@ public:
   float getManualAltitudeFt() const;
 
   /* Get a list of wind positions for the given rectangle for painting. Does not use manual wind setting.
-   * Result is sorted by y and x coordinates. */
-  const atools::grib::WindPosList *getWindForRect(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
-                                                  bool lazy, int gridSpacing);
+   * Served from the tiled grid cache. Uses only already built tiles if lazy is true. */
+  const atools::grib::WindPosList *getWindForRect(const Marble::GeoDataLatLonBox& rect, bool lazy, int gridSpacing);
 
   /* Get (interpolated) wind for given position and altitude */
   atools::grib::WindPos getWindForPos(const atools::geo::Pos& pos, float altFeet);
@@ -139,6 +150,11 @@ public:
   atools::grib::Wind getWindForLineRoute(const atools::geo::Line& line);
   atools::grib::Wind getWindForLineStringRoute(const atools::geo::LineString& line);
 
+  /* Batch versions of the methods above. Results are in the same order as the lines or positions.
+   * Equal lines and positions are queried only once and results are kept until wind data changes. */
+  QVector<atools::grib::Wind> getWindForLineStringsRoute(const QVector<atools::geo::LineString>& lines);
+  QVector<atools::grib::Wind> getWindForPositionsRoute(const atools::geo::LineString& positions);
+
   /* Get a list of winds for the given position at all given altitudes. Returns only not interpolated levels.
    * Altitiude field in resulting pos contains the altitude. */
   atools::grib::WindPosList getWindStackForPos(const atools::geo::Pos& pos, const atools::grib::WindPos *additionalWind = nullptr) const;
@@ -178,6 +194,17 @@ private:
    * Adds flight plan altitude if needed and selected in GUI. Does not use manual wind setting.*/
   atools::grib::WindPosList windStackForPosInternal(const atools::geo::Pos& pos, QVector<int> altitudesFt) const;
 
+  /* Key for routeWindCache from rounded coordinates and altitudes for line averages and single positions */
+  static QVector<qint32> routeWindKey(const atools::geo::LineString& line);
+  static QVector<qint32> routeWindKey(const atools::geo::Pos& pos);
+
+  /* Get memoized winds for keys or call query for the missing ones. Query gets the index in keys. */
+  QVector<atools::grib::Wind> routeWinds(const QVector<QVector<qint32> >& keys,
+                                         const std::function<atools::grib::Wind(int index)>& query) const;
+
+  /* Called by gridBuildTimer to build missing wind grid tiles in time slices */
+  void buildWindGridTiles();
+
   /* One of the toolbar dropdown menu items of main menu items was triggered */
   void toolbarActionTriggered();
   void toolbarActionFlightplanTriggered();
@@ -235,14 +262,25 @@ private:
   /* Avoid action signals when updating GUI elements */
   bool ignoreUpdates = false;
 
-  /* Wind positions as a result of querying the rectangle for caching */
-  query::SimpleRectCache<atools::grib::WindPos> windPosCache;
-  int cachedLevel = wind::NONE;
+  /* Wind grids per standard level and grid spacing. Filled on request and by gridBuildTimer. */
+  WindGridCache *windGridCache = nullptr;
+  QTimer gridBuildTimer;
+
+  /* Wind positions for the last requested rectangle and parameters used to detect changes */
+  atools::grib::WindPosList windPosResult;
+  Marble::GeoDataLatLonBox windPosResultRect;
+  float windPosResultAltitude = -1.f;
+  int windPosResultGridSpacing = 0, windPosResultRevision = -1;
 
   windinternal::WindSliderAction *sliderActionAltitude = nullptr;
   windinternal::WindLabelAction *labelActionWindAltitude = nullptr;
 
   bool downloadErrorReported = false;
+  int windDataVersion = 0;
+
+  /* Winds for flight plan lines and positions. Cleared if windDataVersion changes or if too large. */
+  mutable QHash<QVector<qint32>, atools::grib::Wind> routeWindCache;
+  mutable int routeWindCacheVersion = -1;
 };
 
 namespace windinternal {
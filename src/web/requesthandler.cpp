@@ -26,6 +26,7 @@
 #include "info/infocontroller.h"
 #include "route/routecontroller.h"
 #include "web/webmapcontroller.h"
+#include "web/webmaprequestscheduler.h"
 #include "webapi/webapicontroller.h"
 #include "web/webtools.h"
 #include "web/webapp.h"
@@ -35,12 +36,16 @@
 #include "util/htmlbuilder.h"
 #include "gui/helphandler.h"
 #include "common/constants.h"
+#include "atools.h"
 
 #include <QBuffer>
 #include <QCoreApplication>
 #include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QUrl>
 #include <QPainter>
+#include <QStringBuilder>
 #include <QtWidgets/QApplication>
 
 using namespace stefanfrings;
@@ -53,12 +58,14 @@ RequestHandler::RequestHandler(QObject *parent, WebMapController *webMapControll
   if(verbose)
     qDebug() << Q_FUNC_INFO;
 
+  mapRequestScheduler = new WebMapRequestScheduler(verbose);
+
   /* Fetch data through methods asynchronously to separate the call from this thread and run it in the main thread.
    * It has to wait for the main event queue to finish the request but saves a lot of synchronization through mutexes. */
   connect(this, &RequestHandler::getUserAircraft,
           NavApp::getMapPaintWidgetGui(), &MapPaintWidget::getUserAircraft, Qt::BlockingQueuedConnection);
   connect(this, &RequestHandler::getRoute,
-          NavApp::getRouteController(), &RouteController::getRouteConst, Qt::BlockingQueuedConnection);
+          NavApp::getRouteController(), &RouteController::getRouteSnapshotActive, Qt::BlockingQueuedConnection);
   connect(this, &RequestHandler::getFlightplanTableAsHtml,
           NavApp::getRouteController(), &RouteController::getFlightplanTableAsHtml, Qt::BlockingQueuedConnection);
   connect(this, &RequestHandler::getAirportText,
@@ -80,6 +87,8 @@ RequestHandler::~RequestHandler()
 {
   if(verbose)
     qDebug() << Q_FUNC_INFO;
+
+  ATOOLS_DELETE_LOG(mapRequestScheduler);
 }
 
 void RequestHandler::service(HttpRequest& request, HttpResponse& response)
@@ -95,6 +104,10 @@ void RequestHandler::service(HttpRequest& request, HttpResponse& response)
     // ===========================================================================
     // Requests for map images only - either with or without session
     handleMapImage(request, response);
+  else if(path == QLatin1String("/mapimagestats"))
+    // ===========================================================================
+    // Queue depth and latency of map image requests
+    handleMapImageStats(response);
   else if(path.startsWith(webApiController->webApiPathPrefix))
     // ===========================================================================
     // Requests for web api - either with or without session
@@ -218,34 +231,39 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
 
     QString mapcmd = params.asStr(QStringLiteral(u"mapcmd"), QLatin1String(""));
 
-    if(mapcmd == QLatin1String("user"))
-      // Show user aircraft
-      mapPixmap = emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
-    else if(mapcmd == QLatin1String("route"))
-      // Center flight plan
-      mapPixmap = emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
-    else if(mapcmd == QLatin1String("airport"))
-      // Show an airport by ident
-      mapPixmap = emit getPixmapObject(width, height, web::AIRPORT, params.asStr(
-                                         QStringLiteral(u"airport")).toUpper(), requestedDistanceKm);
-    else if(mapcmd == QLatin1String("center"))
-    {
-      // Center map around given postion
-      atools::geo::Pos pos(0.0, 0.0);
-      pos.setLonX(params.asFloat(QStringLiteral(u"lon")));
-      pos.setLatY(params.asFloat(QStringLiteral(u"lat")));
-      mapPixmap = emit getPixmapPosDistance(width, height, pos, requestedDistanceKm, QLatin1String(""));
-    }
-    else
-    {
-      // When zooming in or out use the last corrected distance (i.e. actual distance) as a base
-      // Zoom or move map
-      mapPixmap = emit getPixmapPosDistance(width, height,
-                                            atools::geo::Pos(session.get("lon").toFloat(),
-                                                             session.get("lat").toFloat()),
-                                            (mapcmd == QLatin1String("in") || mapcmd == QLatin1String("out")) ?
-                                            session.get("corrected_distance").toFloat() : requestedDistanceKm, mapcmd);
-    }
+    // Result depends on session state - do not merge but pass through scheduler for statistics
+    mapPixmap = mapRequestScheduler->render(QString(), [&]() -> MapPixmap {
+      MapPixmap pixmap;
+      if(mapcmd == QLatin1String("user"))
+        // Show user aircraft
+        pixmap = emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
+      else if(mapcmd == QLatin1String("route"))
+        // Center flight plan
+        pixmap = emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
+      else if(mapcmd == QLatin1String("airport"))
+        // Show an airport by ident
+        pixmap = emit getPixmapObject(width, height, web::AIRPORT, params.asStr(
+                                           QStringLiteral(u"airport")).toUpper(), requestedDistanceKm);
+      else if(mapcmd == QLatin1String("center"))
+      {
+        // Center map around given postion
+        atools::geo::Pos pos(0.0, 0.0);
+        pos.setLonX(params.asFloat(QStringLiteral(u"lon")));
+        pos.setLatY(params.asFloat(QStringLiteral(u"lat")));
+        pixmap = emit getPixmapPosDistance(width, height, pos, requestedDistanceKm, QLatin1String(""));
+      }
+      else
+      {
+        // When zooming in or out use the last corrected distance (i.e. actual distance) as a base
+        // Zoom or move map
+        pixmap = emit getPixmapPosDistance(width, height,
+                                              atools::geo::Pos(session.get("lon").toFloat(),
+                                                               session.get("lat").toFloat()),
+                                              (mapcmd == QLatin1String("in") || mapcmd == QLatin1String("out")) ?
+                                              session.get("corrected_distance").toFloat() : requestedDistanceKm, mapcmd);
+      }
+      return pixmap;
+    });
 
     if(mapPixmap.hasNoError())
     {
@@ -265,38 +283,48 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
 
     // ============================================================================
     // Session-less / state-less calls ============================================
-    if(params.has(QStringLiteral(u"user")))
-      // User aircraft =======================
-      mapPixmap = emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
-    else if(params.has(QStringLiteral(u"route")))
-      // Center flight plan =======================
-      mapPixmap = emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
-    else if(params.has(QStringLiteral(u"airport")))
-      // Show airport =======================
-      mapPixmap = emit getPixmapObject(width, height, web::AIRPORT, params.asStr("airport"), requestedDistanceKm);
-    else if(params.has(QStringLiteral(u"leftlon")) && params.has(QStringLiteral(u"toplat")) && params.has(QStringLiteral(u"rightlon")) &&
-            params.has(QStringLiteral(u"bottomlat")))
-    {
-      // Show rectangle =======================
-      atools::geo::Rect rect(params.asFloat(QStringLiteral(u"leftlon")), params.asFloat(QStringLiteral(u"toplat")),
-                             params.asFloat(QStringLiteral(u"rightlon")), params.asFloat(QStringLiteral(u"bottomlat")));
-      mapPixmap = emit getPixmapRect(width, height, rect);
-    }
-    else if(params.has(QStringLiteral(u"distance")) || (params.has(QStringLiteral(u"lon")) && params.has(QStringLiteral(u"lat"))))
-    {
-      // Show position =======================
-      atools::geo::Pos pos;
-      if(params.has(QStringLiteral(u"lon")) && params.has(QStringLiteral(u"lat")))
+    // Merge identical pending requests from different clients which are identified by all parameters
+    QString key;
+    const QMultiMap<QByteArray, QByteArray> parameterMap = request.getParameterMap();
+    for(auto it = parameterMap.constBegin(); it != parameterMap.constEnd(); ++it)
+      key.append(QString::fromUtf8(it.key()) % '=' % QString::fromUtf8(it.value()) % '&');
+
+    mapPixmap = mapRequestScheduler->render(key, [&]() -> MapPixmap {
+      MapPixmap pixmap;
+      if(params.has(QStringLiteral(u"user")))
+        // User aircraft =======================
+        pixmap = emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
+      else if(params.has(QStringLiteral(u"route")))
+        // Center flight plan =======================
+        pixmap = emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
+      else if(params.has(QStringLiteral(u"airport")))
+        // Show airport =======================
+        pixmap = emit getPixmapObject(width, height, web::AIRPORT, params.asStr("airport"), requestedDistanceKm);
+      else if(params.has(QStringLiteral(u"leftlon")) && params.has(QStringLiteral(u"toplat")) && params.has(QStringLiteral(u"rightlon")) &&
+              params.has(QStringLiteral(u"bottomlat")))
       {
-        pos.setLonX(params.asFloat(QStringLiteral(u"lon")));
-        pos.setLatY(params.asFloat(QStringLiteral(u"lat")));
+        // Show rectangle =======================
+        atools::geo::Rect rect(params.asFloat(QStringLiteral(u"leftlon")), params.asFloat(QStringLiteral(u"toplat")),
+                               params.asFloat(QStringLiteral(u"rightlon")), params.asFloat(QStringLiteral(u"bottomlat")));
+        pixmap = emit getPixmapRect(width, height, rect);
       }
+      else if(params.has(QStringLiteral(u"distance")) || (params.has(QStringLiteral(u"lon")) && params.has(QStringLiteral(u"lat"))))
+      {
+        // Show position =======================
+        atools::geo::Pos pos;
+        if(params.has(QStringLiteral(u"lon")) && params.has(QStringLiteral(u"lat")))
+        {
+          pos.setLonX(params.asFloat(QStringLiteral(u"lon")));
+          pos.setLatY(params.asFloat(QStringLiteral(u"lat")));
+        }
 
-      mapPixmap = emit getPixmapPosDistance(width, height, pos, requestedDistanceKm, QLatin1String(""));
-    }
-    else
-      // Show current map view =======================
-      mapPixmap = emit getPixmap(width, height);
+        pixmap = emit getPixmapPosDistance(width, height, pos, requestedDistanceKm, QLatin1String(""));
+      }
+      else
+        // Show current map view =======================
+        pixmap = emit getPixmap(width, height);
+      return pixmap;
+    });
 
     if(mapPixmap.hasError())
       // Show error message as image
@@ -351,7 +379,20 @@ inline void RequestHandler::handleWebApiRequest(HttpRequest& request, HttpRespon
   apiRequest.body = request.getBody();
 
   // Call API in-sync
-  WebApiResponse result = emit serviceWebApi(apiRequest);
+  WebApiResponse result;
+  if(apiRequest.path.startsWith("/map/image") || apiRequest.path.startsWith("/map/tile/"))
+  {
+    // Rendering map images - merge identical requests identified by path and all parameters
+    QString key = QString::fromUtf8(apiRequest.path) % '?';
+    for(auto it = apiRequest.parameters.constBegin(); it != apiRequest.parameters.constEnd(); ++it)
+      key.append(QString::fromUtf8(it.key()) % '=' % QString::fromUtf8(it.value()) % '&');
+
+    result = mapRequestScheduler->service(key, [this, &apiRequest]() -> WebApiResponse {
+      return emit serviceWebApi(apiRequest);
+    });
+  }
+  else
+    result = emit serviceWebApi(apiRequest);
 
   // Map API response
   response.setStatus(result.status);
@@ -363,6 +404,18 @@ inline void RequestHandler::handleWebApiRequest(HttpRequest& request, HttpRespon
   response.write(result.body, true);
 }
 
+inline void RequestHandler::handleMapImageStats(HttpResponse& response)
+{
+  QJsonObject json;
+  json.insert("queue_depth", mapRequestScheduler->getQueueDepth());
+  json.insert("average_latency_ms", mapRequestScheduler->getAverageLatencyMs());
+  json.insert("requests", static_cast<double>(mapRequestScheduler->getNumRequests()));
+  json.insert("merged", static_cast<double>(mapRequestScheduler->getNumMerged()));
+
+  response.setHeader("Content-Type", "application/json");
+  response.write(QJsonDocument(json).toJson(QJsonDocument::Compact), true);
+}
+
 inline void RequestHandler::handleHtmlFileRequest(HttpRequest& request, HttpResponse& response, HttpSession& session, QString& file,
                                                   const QString& extension)
 {
@@ -429,7 +482,8 @@ inline void RequestHandler::handleHtmlFileRequest(HttpRequest& request, HttpResp
     // Aircraft progress
     if(t.contains(QStringLiteral(u"{aircraftProgressText}")))
     {
-      Route route = emit getRoute();
+      // Shared snapshot - copied only once after each route or active leg and position change
+      std::shared_ptr<const Route> route = emit getRoute();
       html.clear();
 
       // Additional required progress fields are defined in aircraftprogressconfig.cpp in vector ADDITIONAL_WEB_IDS
@@ -437,7 +491,7 @@ inline void RequestHandler::handleHtmlFileRequest(HttpRequest& request, HttpResp
 
       {
         HtmlInfoBuilderLocker locker(htmlInfoBuilder);
-        htmlInfoBuilder->aircraftProgressText(userAircraft, html, route);
+        htmlInfoBuilder->aircraftProgressText(userAircraft, html, *route);
       }
       t.setVariable(QStringLiteral(u"aircraftProgressText"), html.getHtml());
     }
@@ -28,6 +28,8 @@
 
 #include <QPixmap>
 
+#include <memory>
+
 #include "geo/pos.h"
 #include "geo/rect.h"
 #include "route/route.h"
@@ -39,6 +41,7 @@ class HttpSession;
 }
 
 class HtmlInfoBuilder;
+class WebMapRequestScheduler;
 
 /*
  * Handles all HTTP server requests including stateless and stateful. Maintains a session for the stateful page.
@@ -72,7 +75,7 @@ signals:
   MapPixmap getPixmapRect(int width, int height, atools::geo::Rect rect, const QString& errorCase = tr("Invalid rectangle"));
 
   atools::fs::sc::SimConnectUserAircraft getUserAircraft();
-  Route getRoute();
+  std::shared_ptr<const Route> getRoute();
   QString getFlightplanTableAsHtml(int iconSize, bool print);
   QStringList getAirportText(QString ident);
   atools::geo::Pos getCurrentMapWidgetPos();
@@ -97,6 +100,9 @@ private:
   /* Handle stateful and stateless api requests. */
   void handleWebApiRequest(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
 
+  /* Return queue depth, latency and number of requests of the map image scheduler as JSON */
+  void handleMapImageStats(stefanfrings::HttpResponse& response);
+
   /* Handle html file requests. */
   void handleHtmlFileRequest(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response, stefanfrings::HttpSession& session,
                              QString& file, const QString& extension);
@@ -111,6 +117,9 @@ private:
   WebMapController *webMapController;
   HtmlInfoBuilder *htmlInfoBuilder;
 
+  /* Merges identical map image requests and keeps statistics. Thread safe. */
+  WebMapRequestScheduler *mapRequestScheduler = nullptr;
+
   bool verbose = false;
 };
 
@@ -71,6 +71,10 @@ struct MapPixmap
  * This has to run in the main thread and event queue. Therefore, it is necessary to use queued signals to separate
  * a thread from the HTTP server.
  *
+ * Uses only one map widget. A pool of widgets would not render concurrently since MapPaintWidget is a QWidget
+ * painting into a QPixmap which both are bound to the main thread. Concurrent requests are serialized and identical
+ * ones are merged by WebMapRequestScheduler instead.
+ *
  * All methods avoid a blurry map by zoomin out to the next best level. This can result in different distances
  * than expected.
  */
@@ -0,0 +1,72 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "web/webmaprequestscheduler.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+WebMapRequestScheduler::WebMapRequestScheduler(bool verboseParam)
+  : verbose(verboseParam)
+{
+}
+
+WebMapRequestScheduler::~WebMapRequestScheduler()
+{
+  QMutexLocker locker(&mutex);
+  qDebug() << Q_FUNC_INFO << "requests" << numRequests << "merged" << numMerged << "max queue depth" << maxQueueDepth
+           << "average latency ms" << (numRequests > 0 ? latencySumNs / 1000000. / numRequests : 0.)
+           << "max latency ms" << latencyMaxNs / 1000000.;
+}
+
+int WebMapRequestScheduler::getQueueDepth() const
+{
+  QMutexLocker locker(&mutex);
+  return queueDepth;
+}
+
+double WebMapRequestScheduler::getAverageLatencyMs() const
+{
+  QMutexLocker locker(&mutex);
+  return numRequests > 0 ? latencySumNs / 1000000. / numRequests : 0.;
+}
+
+quint64 WebMapRequestScheduler::getNumRequests() const
+{
+  QMutexLocker locker(&mutex);
+  return numRequests;
+}
+
+quint64 WebMapRequestScheduler::getNumMerged() const
+{
+  QMutexLocker locker(&mutex);
+  return numMerged;
+}
+
+void WebMapRequestScheduler::requestFinished(const QString& key, qint64 latencyNs, bool merged)
+{
+  numRequests++;
+  if(merged)
+    numMerged++;
+  latencySumNs += latencyNs;
+  latencyMaxNs = std::max(latencyMaxNs, latencyNs);
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << key << "merged" << merged << "latency ms" << latencyNs / 1000000.
+             << "queue depth" << queueDepth << "requests" << numRequests << "merged total" << numMerged;
+}
@@ -0,0 +1,165 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_WEBMAPREQUESTSCHEDULER_H
+#define LNM_WEBMAPREQUESTSCHEDULER_H
+
+#include "web/webmapcontroller.h"
+#include "webapi/webapiresponse.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <functional>
+
+/*
+ * Schedules map image requests coming from the HTTP server threads.
+ *
+ * Identical requests which are pending at the same time are merged. Only the first one is passed to the
+ * renderer in the main thread while all others wait for its result. Covers /mapimage requests as well as the
+ * image and tile requests of the web API.
+ *
+ * Different requests are rendered one after the other since the single renderer in WebMapController has to run in
+ * the main thread.
+ *
+ * Keeps track of the number of pending requests (queue depth) and the latency from request to delivery of the
+ * rendered map. Values are logged per request in verbose mode, as a summary on deletion and can be
+ * fetched by the path /mapimagestats.
+ *
+ * All methods are thread safe.
+ */
+class WebMapRequestScheduler
+{
+public:
+  explicit WebMapRequestScheduler(bool verboseParam);
+  ~WebMapRequestScheduler();
+
+  WebMapRequestScheduler(const WebMapRequestScheduler& other) = delete;
+  WebMapRequestScheduler& operator=(const WebMapRequestScheduler& other) = delete;
+
+  /* Call renderFunc which usually uses a blocking queued signal to the WebMapController and return its result.
+   * Waits for a pending request with the same key instead if there is one. Requests with an empty key are never merged. */
+  MapPixmap render(const QString& key, const std::function<MapPixmap()>& renderFunc)
+  {
+    return schedule(key, renderFunc, pendingPixmaps);
+  }
+
+  /* Same as above for web API map requests which return an encoded image */
+  WebApiResponse service(const QString& key, const std::function<WebApiResponse()>& serviceFunc)
+  {
+    return schedule(key, serviceFunc, pendingResponses);
+  }
+
+  /* Number of requests currently rendering or waiting for a merged result */
+  int getQueueDepth() const;
+
+  /* Average latency in milliseconds for all requests */
+  double getAverageLatencyMs() const;
+
+  /* Number of all and merged requests */
+  quint64 getNumRequests() const;
+  quint64 getNumMerged() const;
+
+private:
+  template<typename RESULT>
+  struct PendingRequest
+  {
+    RESULT result;
+    bool done = false;
+  };
+
+  template<typename RESULT>
+  using PendingHash = QHash<QString, QSharedPointer<PendingRequest<RESULT> > >;
+
+  /* Call func or wait for a pending request with the same key */
+  template<typename RESULT>
+  RESULT schedule(const QString& key, const std::function<RESULT()>& func, PendingHash<RESULT>& pending);
+
+  /* Update statistics and log. Called with mutex locked. */
+  void requestFinished(const QString& key, qint64 latencyNs, bool merged);
+
+  PendingHash<MapPixmap> pendingPixmaps;
+  PendingHash<WebApiResponse> pendingResponses;
+  mutable QMutex mutex;
+  QWaitCondition finishedCondition;
+
+  /* Statistics */
+  int queueDepth = 0, maxQueueDepth = 0;
+  quint64 numRequests = 0, numMerged = 0;
+  qint64 latencySumNs = 0, latencyMaxNs = 0;
+
+  bool verbose = false;
+};
+
+template<typename RESULT>
+RESULT WebMapRequestScheduler::schedule(const QString& key, const std::function<RESULT()>& func, PendingHash<RESULT>& pending)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QSharedPointer<PendingRequest<RESULT> > request;
+  {
+    QMutexLocker locker(&mutex);
+    queueDepth++;
+    maxQueueDepth = std::max(maxQueueDepth, queueDepth);
+
+    if(!key.isEmpty())
+    {
+      request = pending.value(key);
+      if(!request.isNull())
+      {
+        // Same request is already rendering - wait for result =====================
+        while(!request->done)
+          finishedCondition.wait(&mutex);
+
+        queueDepth--;
+        requestFinished(key, timer.nsecsElapsed(), true /* merged */);
+        return request->result;
+      }
+
+      // First request for this key - others will wait for this one
+      request = QSharedPointer<PendingRequest<RESULT> >::create();
+      pending.insert(key, request);
+    }
+  }
+
+  // Render without locking the scheduler
+  RESULT result = func();
+
+  {
+    QMutexLocker locker(&mutex);
+    if(!request.isNull())
+    {
+      // Publish result and wake up all waiting threads
+      request->result = result;
+      request->done = true;
+      pending.remove(key);
+      finishedCondition.wakeAll();
+    }
+
+    queueDepth--;
+    requestFinished(key, timer.nsecsElapsed(), false /* merged */);
+  }
+
+  return result;
+}
+
+#endif // LNM_WEBMAPREQUESTSCHEDULER_H
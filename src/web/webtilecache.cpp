@@ -0,0 +1,210 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "web/webtilecache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStringBuilder>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+WebTileCache::WebTileCache(const QString& diskCachePathParam, int memoryCacheKb, qint64 diskCacheKb, bool verboseParam)
+  : diskCachePath(diskCachePathParam), sessionId(QString::number(QDateTime::currentMSecsSinceEpoch(), 36)),
+  diskCacheMaxBytes(diskCacheKb * 1024), verbose(verboseParam)
+{
+  qDebug() << Q_FUNC_INFO << diskCachePath << "memory kB" << memoryCacheKb << "disk kB" << diskCacheKb;
+
+  memoryCache.setMaxCost(memoryCacheKb);
+
+  if(!diskCachePath.isEmpty())
+  {
+    QMutexLocker locker(&mutex);
+    diskDirectory = sessionId % '_' % QString::number(diskIndex);
+
+    // Tiles of earlier sessions might show outdated data
+    removeOutdatedBackground();
+  }
+}
+
+WebTileCache::~WebTileCache()
+{
+  qDebug() << Q_FUNC_INFO << "hits" << hits << "disk hits" << diskHits << "misses" << misses;
+
+  // Disk directory is removed in background on next start
+  QMutexLocker locker(&mutex);
+  memoryCache.clear();
+}
+
+QByteArray WebTileCache::value(const QString& key)
+{
+  QString filename;
+  quint32 index;
+  {
+    QMutexLocker locker(&mutex);
+
+    // Memory =====================
+    const QByteArray *bytes = memoryCache.object(key);
+    if(bytes != nullptr)
+    {
+      hits++;
+      return *bytes;
+    }
+
+    if(!diskCachePath.isEmpty() && diskDirectoryCreated)
+      filename = tileFilename(diskDirectory, key);
+    index = diskIndex;
+  }
+
+  // Disk - read without lock to avoid blocking other threads =====================
+  if(!filename.isEmpty())
+  {
+    QFile file(filename);
+    if(file.open(QIODevice::ReadOnly))
+    {
+      QByteArray fileBytes = file.readAll();
+      file.close();
+
+      if(!fileBytes.isEmpty())
+      {
+        QMutexLocker locker(&mutex);
+        diskHits++;
+
+        // Do not add to memory if invalidated while reading
+        if(index == diskIndex)
+          memoryCache.insert(key, new QByteArray(fileBytes), std::max(1, fileBytes.size() / 1024));
+        return fileBytes;
+      }
+    }
+  }
+
+  QMutexLocker locker(&mutex);
+  misses++;
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "miss" << key << "hits" << hits << "disk hits" << diskHits << "misses" << misses;
+
+  return QByteArray();
+}
+
+void WebTileCache::insert(const QString& key, const QByteArray& bytes)
+{
+  if(bytes.isEmpty())
+    return;
+
+  QString directory;
+  quint32 index;
+  {
+    QMutexLocker locker(&mutex);
+    memoryCache.insert(key, new QByteArray(bytes), std::max(1, bytes.size() / 1024));
+
+    if(diskCachePath.isEmpty())
+      return;
+
+    // Start over in a new directory if disk cache is full
+    if(diskCacheBytes + bytes.size() > diskCacheMaxBytes)
+      nextDiskDirectory();
+
+    // Reserve space before writing
+    diskCacheBytes += bytes.size();
+    directory = diskDirectory;
+    index = diskIndex;
+  }
+
+  // Disk - create directory and write without lock to avoid blocking other threads =====================
+  QString path = diskCachePath % QDir::separator() % directory;
+  if(!QDir().mkpath(path))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot create" << path;
+    return;
+  }
+
+  // Write to temporary file and rename to avoid reading partially written files in value()
+  QSaveFile file(tileFilename(directory, key));
+  if(file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size() && file.commit())
+  {
+    QMutexLocker locker(&mutex);
+    if(index == diskIndex)
+      diskDirectoryCreated = true;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot write" << file.fileName() << file.errorString();
+}
+
+void WebTileCache::invalidate()
+{
+  QMutexLocker locker(&mutex);
+  generation++;
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "generation" << generation;
+
+  // Old tiles cannot be found anymore since the generation is part of the key
+  memoryCache.clear();
+
+  if(!diskCachePath.isEmpty())
+    nextDiskDirectory();
+}
+
+quint32 WebTileCache::getGeneration() const
+{
+  QMutexLocker locker(&mutex);
+  return generation;
+}
+
+QString WebTileCache::tileFilename(const QString& directory, const QString& key) const
+{
+  // Key contains characters not allowed in filenames - use hash
+  return diskCachePath % QDir::separator() % directory % QDir::separator() %
+         QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex()) + ".tile";
+}
+
+void WebTileCache::nextDiskDirectory()
+{
+  diskCacheBytes = 0;
+  diskIndex++;
+  diskDirectory = sessionId % '_' % QString::number(diskIndex);
+  diskDirectoryCreated = false;
+  removeOutdatedBackground();
+}
+
+void WebTileCache::removeOutdatedBackground()
+{
+  const QString path = diskCachePath, sessionPrefix = sessionId % '_';
+  const quint32 minIndex = diskIndex;
+
+  // Do not block the calling thread by deleting possibly large directories
+  QtConcurrent::run([path, sessionPrefix, minIndex]() -> void {
+    const QFileInfoList entries = QDir(path).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    for(const QFileInfo& entry : entries)
+    {
+      // Keep current directory and newer ones which might have been created after this task was started
+      const QString name = entry.fileName();
+      if(name.startsWith(sessionPrefix) && name.mid(sessionPrefix.size()).toUInt() >= minIndex)
+        continue;
+
+      if(entry.isDir())
+        QDir(entry.filePath()).removeRecursively();
+      else
+        QFile::remove(entry.filePath());
+    }
+  });
+}
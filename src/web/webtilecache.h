@@ -0,0 +1,82 @@
+/*****************************************************************************
+* Copyright 2015-2025 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_WEBTILECACHE_H
+#define LNM_WEBTILECACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QString>
+
+/*
+ * Two level cache for encoded map tiles served by the web API.
+ *
+ * Keeps recently used tiles in memory and all tiles in a directory on disk. Tiles are identified by a string key
+ * which has to contain all parameters affecting the image like tile coordinates, theme and map layer options.
+ *
+ * A generation counter is incremented on invalidate() which is called when map data changes. Callers have to add
+ * the generation to the key. Each generation writes to its own sub directory on disk which is
+ * removed in background when outdated. Sub directories of earlier sessions are removed in background on creation
+ * since data might have changed between sessions. Nothing is deleted synchronously.
+ *
+ * All methods are thread safe. Disk files are read and written without holding the lock.
+ */
+class WebTileCache
+{
+public:
+  /* Disk cache is disabled if path is empty */
+  WebTileCache(const QString& diskCachePathParam, int memoryCacheKb, qint64 diskCacheKb, bool verboseParam);
+  ~WebTileCache();
+
+  WebTileCache(const WebTileCache& other) = delete;
+  WebTileCache& operator=(const WebTileCache& other) = delete;
+
+  /* Get encoded tile from memory or disk. Returns empty array if not found. */
+  QByteArray value(const QString& key);
+
+  /* Add encoded tile to memory and disk cache */
+  void insert(const QString& key, const QByteArray& bytes);
+
+  /* Drop all memory tiles, increment generation and remove the outdated disk directory in background */
+  void invalidate();
+
+  /* Changes on each invalidate() */
+  quint32 getGeneration() const;
+
+private:
+  /* Full path to disk cache file for key in the given sub directory */
+  QString tileFilename(const QString& directory, const QString& key) const;
+
+  /* Switch to a new disk directory and remove the current one in background. Called with mutex locked. */
+  void nextDiskDirectory();
+
+  /* Remove all files and directories in diskCachePath except the current and newer directories of this session.
+   * Runs in a background thread. Called with mutex locked. */
+  void removeOutdatedBackground();
+
+  QCache<QString, QByteArray> memoryCache;
+  QString diskCachePath, sessionId, diskDirectory;
+  qint64 diskCacheMaxBytes, diskCacheBytes = 0;
+  quint32 generation = 0, diskIndex = 0;
+  bool diskDirectoryCreated = false;
+  quint64 hits = 0, diskHits = 0, misses = 0;
+  mutable QMutex mutex;
+  bool verbose = false;
+};
+
+#endif // LNM_WEBTILECACHE_H
@@ -30,18 +30,109 @@
 #include "app/navapp.h"
 #include "common/mapresult.h"
 #include "web/webmapcontroller.h"
+#include "web/webtilecache.h"
+#include "db/databasemanager.h"
+#include "route/routecontroller.h"
+#include "online/onlinedatacontroller.h"
+#include "userdata/userdatacontroller.h"
+#include "logbook/logdatacontroller.h"
+#include "airspace/airspacecontroller.h"
+#include "weather/weatherreporter.h"
+#include "weather/windreporter.h"
+#include "route/route.h"
+#include "settings/settings.h"
+#include "geo/calculations.h"
+#include "geo/marbleconverter.h"
 
 #include <QDebug>
 #include <QBuffer>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QPixmap>
+#include <QStringBuilder>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
 
 using InfoBuilderTypes::MapFeaturesData;
 
+/* Size of the dummy map used to resolve zoom distance and map layer for feature requests */
+const static int FEATURES_MAP_SIZE = 300;
+
+/* Web Mercator tile size in pixel and maximum zoom level */
+const static int TILE_SIZE = 256;
+const static int TILE_MAX_ZOOM = 20;
+
+/* Tile cache sizes */
+const static int TILE_MEMORY_CACHE_KB = 64 * 1024;
+const static qint64 TILE_DISK_CACHE_KB = 512 * 1024;
+
+/* Sorted type and id of all features for comparison */
+static QStringList featureIds(const MapFeaturesData& data)
+{
+  QStringList ids;
+  for(const map::MapAirport& airport : data.airports)
+    ids.append(QString("airport/%1").arg(airport.id));
+  for(const map::MapNdb& ndb : data.ndbs)
+    ids.append(QString("ndb/%1").arg(ndb.id));
+  for(const map::MapVor& vor : data.vors)
+    ids.append(QString("vor/%1").arg(vor.id));
+  for(const map::MapMarker& marker : data.markers)
+    ids.append(QString("marker/%1").arg(marker.id));
+  for(const map::MapWaypoint& waypoint : data.waypoints)
+    ids.append(QString("waypoint/%1").arg(waypoint.id));
+  ids.sort();
+  ids.removeDuplicates();
+  return ids;
+}
+
+/* Web API actions are dispatched to the main thread. Run func directly there or as a blocking call if called from
+ * another thread. */
+static void runInMainThread(const std::function<void()>& func)
+{
+  if(QThread::currentThread() == QCoreApplication::instance()->thread())
+    func();
+  else
+    QMetaObject::invokeMethod(QCoreApplication::instance(), func, Qt::BlockingQueuedConnection);
+}
+
+/* Convert XYZ tile numbers to a rectangle in degree using the Web Mercator definition */
+static atools::geo::Rect tileRect(int z, int x, int y)
+{
+  double numTiles = std::pow(2., z);
+  auto lonX = [numTiles](int tileX) -> float {
+                return static_cast<float>(tileX / numTiles * 360. - 180.);
+              };
+  auto latY = [numTiles](int tileY) -> float {
+                return static_cast<float>(atools::geo::toDegree(std::atan(std::sinh(M_PI * (1. - 2. * tileY / numTiles)))));
+              };
+
+  return atools::geo::Rect(lonX(x), latY(y), lonX(x + 1), latY(y + 1));
+}
+
 MapActionsController::MapActionsController(QObject *parent, bool verboseParam, AbstractInfoBuilder *infoBuilderParam)
   : AbstractLnmActionsController(parent, verboseParam, infoBuilderParam)
 {
   qDebug() << Q_FUNC_INFO;
   init();
+
+  tileCache = new WebTileCache(atools::settings::Settings::getPath() % QDir::separator() % "webtiles",
+                               TILE_MEMORY_CACHE_KB, TILE_DISK_CACHE_KB, verbose);
+
+  // Map data shown on tiles changed
+  connect(NavApp::getDatabaseManager(), &DatabaseManager::preDatabaseLoad, this, &MapActionsController::invalidateTiles);
+  connect(NavApp::getRouteController(), &RouteController::routeChanged, this, &MapActionsController::invalidateTiles);
+  connect(NavApp::getOnlinedataController(), &OnlinedataController::onlineClientAndAtcUpdated,
+          this, &MapActionsController::invalidateTiles);
+
+  // Weather has no version - user points, logbook, airspaces and winds are covered by the tile key
+  connect(NavApp::getWeatherReporter(), &WeatherReporter::weatherUpdated, this, &MapActionsController::invalidateTiles);
 }
 
 WebApiResponse MapActionsController::imageAction(WebApiRequest request)
@@ -112,71 +203,311 @@ WebApiResponse MapActionsController::featuresAction(WebApiRequest request)
     request.parameters.value("bottomlat").toFloat()
     );
 
-  bool overflow = false;
-
-  // Init dummy image request
-  WebApiRequest *imageRequest = new WebApiRequest();
-  imageRequest->parameters = QMap<QByteArray, QByteArray>();
-  imageRequest->parameters.insert("leftlon", request.parameters.value("leftlon"));
-  imageRequest->parameters.insert("toplat", request.parameters.value("toplat"));
-  imageRequest->parameters.insert("rightlon", request.parameters.value("rightlon"));
-  imageRequest->parameters.insert("bottomlat", request.parameters.value("bottomlat"));
-  imageRequest->parameters.insert("detailfactor", request.parameters.value("detailfactor"));
-  imageRequest->parameters.insert("width", "300");
-  imageRequest->parameters.insert("height", "300");
-  imageRequest->parameters.insert("format", "jpg");
-  imageRequest->parameters.insert("quality", "1");
-
-  // Perform dummy image request
-  imageAction(*imageRequest);
-
-  // Extract results created during dummy image request
-  QList<map::MapAirport> airports;
-  QList<map::MapNdb> ndbs;
-  QList<map::MapVor> vors;
-  QList<map::MapMarker> markers;
-  QList<map::MapWaypoint> waypoints;
+  response.body = infoBuilder->features(getFeaturesRect(rect, request.parameters.value("detailfactor").toInt()));
+
+  return response;
+}
+
+WebApiResponse MapActionsController::tileAction(WebApiRequest request)
+{
+  WebApiResponse response = getResponse();
+  response.status = 400;
 
-  Queries *queries = mapPaintWidget->getQueries();
+  // Path is "/map/tile/{z}/{x}/{y}" where y can have a file extension like "123.png" =========
+  QList<QByteArray> pathList = request.path.split('/');
+  if(pathList.size() != 6)
   {
-    QueryLocker locker(queries);
-    airports = *queries->getMapQuery()->getAirportsByRect(rect, mapPaintWidget->getMapPaintLayer()->getMapLayer(),
-                                                          false, map::NONE, overflow);
+    response.body = "Invalid tile path";
+    return response;
   }
 
+  QString format = QString(request.parameters.value("format", "png"));
+  QByteArray tileY = pathList.at(5);
+  int extension = tileY.indexOf('.');
+  if(extension != -1)
   {
-    QueryLocker locker(queries);
-    ndbs = *queries->getMapQuery()->getNdbsByRect(rect, mapPaintWidget->getMapPaintLayer()->getMapLayer(), false, overflow);
+    format = QString(tileY.mid(extension + 1));
+    tileY = tileY.left(extension);
   }
+  if(format == QLatin1String("jpeg"))
+    format = "jpg";
+
+  bool okZ, okX, okY;
+  int z = pathList.at(3).toInt(&okZ), x = pathList.at(4).toInt(&okX), y = tileY.toInt(&okY);
+  int numTiles = 1 << std::min(std::max(z, 0), TILE_MAX_ZOOM);
 
+  if(!okZ || !okX || !okY || z < 0 || z > TILE_MAX_ZOOM || x < 0 || x >= numTiles || y < 0 || y >= numTiles)
   {
-    QueryLocker locker(queries);
-    vors = *queries->getMapQuery()->getVorsByRect(rect, mapPaintWidget->getMapPaintLayer()->getMapLayer(), false, overflow);
+    response.body = "Invalid tile coordinates";
+    return response;
   }
 
+  if(format != QLatin1String("png") && format != QLatin1String("jpg"))
   {
-    QueryLocker locker(queries);
-    markers = *queries->getMapQuery()->getMarkersByRect(rect, mapPaintWidget->getMapPaintLayer()->getMapLayer(), false, overflow);
+    response.body = "Invalid format";
+    return response;
   }
 
+  int quality = request.parameters.value("quality", "-1").toInt();
+  int detailFactor = request.parameters.value("detailfactor", QByteArray::number(MapLayerSettings::MAP_DEFAULT_DETAIL_LEVEL)).toInt();
+
+  // Look for tile in cache or render ====================================
+  QString key = tileKey(z, x, y, format, quality, detailFactor);
+  QByteArray bytes = tileCache->value(key);
+
+  if(bytes.isEmpty())
   {
-    QueryLocker locker(queries);
-    waypoints = queries->getWaypointTrackQuery()->getWaypointsByRect(rect, mapPaintWidget->getMapPaintLayer()->getMapLayer(),
-                                                                     false, overflow);
+    MapPixmap map = getPixmapTile(tileRect(z, x, y), detailFactor);
+
+    if(map.isValid())
+    {
+      QBuffer buffer(&bytes);
+      buffer.open(QIODevice::WriteOnly);
+      map.pixmap.save(&buffer, format == QLatin1String("jpg") ? "JPG" : "PNG", quality);
+      tileCache->insert(key, bytes);
+    }
   }
 
-  MapFeaturesData data = {
-    airports,
-    ndbs,
-    vors,
-    markers,
-    waypoints
-  };
+  if(!bytes.isEmpty())
+  {
+    response.headers.replace("Content-Type", format == QLatin1String("jpg") ? "image/jpeg" : "image/png");
 
-  response.body = infoBuilder->features(data);
+    // Add copyright/attributions to header
+    response.headers.insert("Image-Attributions",
+                            NavApp::getMapThemeHandler()->getTheme(mapPaintWidget->getCurrentThemeId()).getCopyright().toUtf8());
+    response.status = 200;
+    response.body = bytes;
+  }
+  else
+  {
+    response.status = 404;
+    response.body = "Cannot render tile";
+  }
 
   return response;
+}
 
+/* Options of the GUI map which are copied when rendering. Projection is not included since tiles are always
+ * rendered in Mercator. Has to be called in the main thread. */
+static QString tileOptionsKey(const MapPaintWidget *mapWidget)
+{
+  const map::MapAirspaceFilter& airspaces = mapWidget->getShownAirspaces();
+
+  return QString("%1/%2/%3/%4/%5/%6/%7/%8").arg(mapWidget->getCurrentThemeId()).
+         arg(static_cast<quint64>(mapWidget->getShownMapTypes())).
+         arg(static_cast<quint32>(mapWidget->getShownMapDisplayTypes())).
+         arg(static_cast<quint64>(airspaces.types)).arg(static_cast<quint32>(airspaces.flags)).
+         arg(airspaces.minAltitudeFt).arg(airspaces.maxAltitudeFt).arg(mapWidget->getShownMinimumRunwayFt());
+}
+
+/* Versions of user data shown on tiles, wind level and active flight plan leg. Has to be called in the main thread. */
+static QString tileDataKey()
+{
+  const WindReporter *windReporter = NavApp::getWindReporter();
+
+  return QString("%1/%2/%3/%4/%5/%6").arg(NavApp::getUserdataController()->getUserdataVersion()).
+         arg(NavApp::getLogdataController()->getLogdataVersion()).
+         arg(NavApp::getAirspaceController()->getAirspaceVersion()).
+         arg(windReporter->getWindDataVersion()).arg(static_cast<double>(windReporter->getDisplayAltitudeFt())).
+         arg(NavApp::getRouteConst().getActiveLegIndexCorrected());
+}
+
+QString MapActionsController::tileKey(int z, int x, int y, const QString& format, int quality, int detailFactor) const
+{
+  // Take a snapshot of the map options and data versions in the main thread
+  QString options;
+  runInMainThread([&options]() -> void {
+    options = tileOptionsKey(NavApp::getMapWidgetGui()) % '/' % tileDataKey();
+  });
+
+  return QString("%1/%2/%3/%4/%5/%6/%7/").arg(tileCache->getGeneration()).arg(z).arg(x).arg(y).
+         arg(format).arg(quality).arg(detailFactor) % options;
+}
+
+void MapActionsController::invalidateTiles()
+{
+  if(tileCache != nullptr)
+    tileCache->invalidate();
+}
+
+WebApiResponse MapActionsController::featuresbenchmarkAction(WebApiRequest request)
+{
+  if(!verbose)
+    return notFoundAction(request);
+
+  WebApiResponse response = getResponse();
+
+  atools::geo::Rect rect(
+    request.parameters.value("leftlon").toFloat(),
+    request.parameters.value("toplat").toFloat(),
+    request.parameters.value("rightlon").toFloat(),
+    request.parameters.value("bottomlat").toFloat()
+    );
+  int detailFactor = request.parameters.value("detailfactor").toInt();
+  int iterations = atools::minmax(1, 1000, request.parameters.value("iterations", "10").toInt());
+
+  // Run previous implementation rendering a dummy image ===================
+  QElapsedTimer timer;
+  timer.start();
+  QStringList idsRendered;
+  for(int i = 0; i < iterations; i++)
+    idsRendered = featureIds(getFeaturesRectRendered(rect, detailFactor));
+  qint64 renderedNs = timer.nsecsElapsed();
+
+  // Run query without rendering ===================
+  timer.restart();
+  QStringList idsQueried;
+  for(int i = 0; i < iterations; i++)
+    idsQueried = featureIds(getFeaturesRect(rect, detailFactor));
+  qint64 queriedNs = timer.nsecsElapsed();
+
+  // Compare results of last iteration ===================
+  QJsonArray missing, additional;
+  for(const QString& id : idsRendered)
+  {
+    if(!std::binary_search(idsQueried.constBegin(), idsQueried.constEnd(), id))
+      missing.append(id);
+  }
+  for(const QString& id : idsQueried)
+  {
+    if(!std::binary_search(idsRendered.constBegin(), idsRendered.constEnd(), id))
+      additional.append(id);
+  }
+
+  QJsonObject json;
+  json.insert("iterations", iterations);
+  json.insert("rendered_ms_per_request", renderedNs / 1000000. / iterations);
+  json.insert("rendered_features", idsRendered.size());
+  json.insert("queried_ms_per_request", queriedNs / 1000000. / iterations);
+  json.insert("queried_features", idsQueried.size());
+  json.insert("equal", missing.isEmpty() && additional.isEmpty());
+  json.insert("missing_in_queried", missing);
+  json.insert("additional_in_queried", additional);
+  json.insert("speedup", queriedNs > 0 ? static_cast<double>(renderedNs) / static_cast<double>(queriedNs) : 0.);
+
+  qDebug() << Q_FUNC_INFO << json;
+
+  response.headers.replace("Content-Type", "application/json");
+  response.body = QJsonDocument(json).toJson(QJsonDocument::Compact);
+  response.status = 200;
+  return response;
+}
+
+WebApiResponse MapActionsController::profileAction(WebApiRequest request)
+{
+  WebApiResponse response = getResponse();
+
+  bool reset = request.parameters.value("reset") == "true";
+  QJsonObject json;
+
+  // Profilers are updated while painting in the main thread - read and reset them there
+  runInMainThread([this, reset, &json]() -> void {
+    // Main window map and the map used for web images and tiles
+    MapPaintLayer *guiLayer = NavApp::getMapPaintWidgetGui()->getMapPaintLayer();
+    MapPaintLayer *webLayer = mapPaintWidget != nullptr ? mapPaintWidget->getMapPaintLayer() : nullptr;
+
+    json.insert("map", guiLayer->getProfiler()->getJson());
+    if(webLayer != nullptr)
+      json.insert("web", webLayer->getProfiler()->getJson());
+
+    // Start a new measurement period after sending the current values
+    if(reset)
+    {
+      guiLayer->getProfiler()->reset();
+      if(webLayer != nullptr)
+        webLayer->getProfiler()->reset();
+    }
+  });
+
+  response.headers.replace("Content-Type", "application/json");
+  response.body = QJsonDocument(json).toJson(QJsonDocument::Compact);
+  response.status = 200;
+  return response;
+}
+
+MapFeaturesData MapActionsController::getFeaturesRect(const atools::geo::Rect& rect, int detailFactor)
+{
+  QList<map::MapAirport> airports;
+  QList<map::MapNdb> ndbs;
+  QList<map::MapVor> vors;
+  QList<map::MapMarker> markers;
+  QList<map::MapWaypoint> waypoints;
+
+  if(mapPaintWidget != nullptr && rect.isValid())
+  {
+    MapPaintWidgetLocker locker(mapPaintWidget);
+    Queries *queries = mapPaintWidget->getQueries();
+    QueryLocker queryLocker(queries);
+
+    // Copy all map settings except trail
+    mapPaintWidget->copySettings(*NavApp::getMapWidgetGui(), false /* deep */);
+
+    // Use the size of the former dummy image to get the same zoom distance - does not paint
+    mapPaintWidget->setMapSize(FEATURES_MAP_SIZE, FEATURES_MAP_SIZE, false /* ignoreUiScale */);
+    mapPaintWidget->showRectStreamlined(rect, false);
+
+    // Set detail factor which also updates the layers for the new zoom distance
+    MapPaintLayer *paintLayer = mapPaintWidget->getMapPaintLayer();
+    paintLayer->setDetailLevel(detailFactor, detailFactor);
+
+    const MapLayer *mapLayer = paintLayer->getMapLayer();
+    if(mapLayer != nullptr)
+    {
+      bool overflow = false;
+      MapQuery *mapQuery = queries->getMapQuery();
+
+      // Validate the airport cache for this rect using the same types as the painter
+      const QList<map::MapAirport> *airportList = mapQuery->getAirports(mconvert::toGdc(rect), mapLayer, false,
+                                                                        mapPaintWidget->getShownMapTypes(), overflow);
+      if(airportList != nullptr)
+        airports = *airportList;
+
+      const QList<map::MapNdb> *ndbList = mapQuery->getNdbsByRect(rect, mapLayer, false, overflow);
+      if(ndbList != nullptr)
+        ndbs = *ndbList;
+
+      const QList<map::MapVor> *vorList = mapQuery->getVorsByRect(rect, mapLayer, false, overflow);
+      if(vorList != nullptr)
+        vors = *vorList;
+
+      const QList<map::MapMarker> *markerList = mapQuery->getMarkersByRect(rect, mapLayer, false, overflow);
+      if(markerList != nullptr)
+        markers = *markerList;
+
+      waypoints = queries->getWaypointTrackQuery()->getWaypointsByRect(rect, mapLayer, false, overflow);
+    }
+    else if(verbose)
+      qDebug() << Q_FUNC_INFO << "No map layer for" << rect << "distance" << mapPaintWidget->distance();
+  }
+
+  return {airports, ndbs, vors, markers, waypoints};
+}
+
+MapFeaturesData MapActionsController::getFeaturesRectRendered(const atools::geo::Rect& rect, int detailFactor)
+{
+  // Perform dummy image request to fill the caches
+  getPixmapRect(FEATURES_MAP_SIZE, FEATURES_MAP_SIZE, rect, detailFactor, QString(), false /* ignoreUiScale */);
+
+  QList<map::MapAirport> airports;
+  QList<map::MapNdb> ndbs;
+  QList<map::MapVor> vors;
+  QList<map::MapMarker> markers;
+  QList<map::MapWaypoint> waypoints;
+
+  const MapLayer *mapLayer = mapPaintWidget->getMapPaintLayer()->getMapLayer();
+  if(mapLayer != nullptr)
+  {
+    bool overflow = false;
+    Queries *queries = mapPaintWidget->getQueries();
+    QueryLocker locker(queries);
+    airports = *queries->getMapQuery()->getAirportsByRect(rect, mapLayer, false, map::NONE, overflow);
+    ndbs = *queries->getMapQuery()->getNdbsByRect(rect, mapLayer, false, overflow);
+    vors = *queries->getMapQuery()->getVorsByRect(rect, mapLayer, false, overflow);
+    markers = *queries->getMapQuery()->getMarkersByRect(rect, mapLayer, false, overflow);
+    waypoints = queries->getWaypointTrackQuery()->getWaypointsByRect(rect, mapLayer, false, overflow);
+  }
+
+  return {airports, ndbs, vors, markers, waypoints};
 }
 
 WebApiResponse MapActionsController::featureAction(WebApiRequest request)
@@ -220,6 +551,7 @@ MapActionsController::~MapActionsController()
 {
   qDebug() << Q_FUNC_INFO;
   deInit();
+  ATOOLS_DELETE_LOG(tileCache);
 }
 
 void MapActionsController::init()
@@ -345,6 +677,58 @@ MapPixmap MapActionsController::getPixmapPosDistance(int width, int height, atoo
   }
 }
 
+void MapActionsController::copySettingsForRect(int detailFactor)
+{
+  // Copy all map settings except trail - this also sets Mercator projection
+  mapPaintWidget->copySettings(*NavApp::getMapWidgetGui(), false /* deep */);
+
+  // Disable dynamic/live features
+  mapPaintWidget->setShowMapObject(map::AIRCRAFT_ALL, false);
+  mapPaintWidget->setShowMapObject(map::AIRCRAFT_TRAIL, false);
+
+  mapPaintWidget->setShowMapObjectDisplay(map::COMPASS_ROSE, false);
+  mapPaintWidget->setShowMapObjectDisplay(map::AIRCRAFT_ENDURANCE, false);
+  mapPaintWidget->setShowMapObjectDisplay(map::AIRCRAFT_SELECTED_ALT_RANGE, false);
+  mapPaintWidget->setShowMapObjectDisplay(map::AIRCRAFT_TURN_PATH, false);
+
+  // Set detail factor
+  mapPaintWidget->getMapPaintLayer()->setDetailLevel(detailFactor, detailFactor);
+
+  // Disable copyright note and wind
+  mapPaintWidget->setPaintCopyright(false);
+  mapPaintWidget->setPaintWindHeader(false);
+}
+
+MapPixmap MapActionsController::getPixmapTile(const atools::geo::Rect& rect, int detailFactor)
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << rect;
+
+  if(mapPaintWidget == nullptr)
+    return MapPixmap();
+
+  MapPaintWidgetLocker locker(mapPaintWidget);
+  QueryLocker queryLocker(mapPaintWidget->getQueries());
+
+  copySettingsForRect(detailFactor);
+
+  // Resize first to have the viewport ready for centering
+  mapPaintWidget->setMapSize(TILE_SIZE, TILE_SIZE, false /* ignoreUiScale */);
+
+  // Tile numbers are defined for Mercator - copySettings() already sets it
+  if(mapPaintWidget->projection() != Marble::Mercator)
+    mapPaintWidget->setProjection(Marble::Mercator);
+
+  // Use exact tile bounds without snapping to zoom steps
+  mapPaintWidget->showRectMercatorExact(rect, TILE_SIZE);
+
+  MapPixmap mapPixmap;
+  mapPixmap.correctedDistanceKm = mapPixmap.requestedDistanceKm = static_cast<float>(mapPaintWidget->distance());
+  mapPixmap.pixmap = mapPaintWidget->getPixmap(TILE_SIZE, TILE_SIZE, false /* ignoreUiScale */);
+  mapPixmap.pos = mapPaintWidget->getCenterPos();
+  return mapPixmap;
+}
+
 MapPixmap MapActionsController::getPixmapRect(int width, int height, atools::geo::Rect rect, int detailFactor, const QString& errorCase,
                                               bool ignoreUiScale)
 {
@@ -358,27 +742,9 @@ MapPixmap MapActionsController::getPixmapRect(int width, int height, atools::geo
       MapPaintWidgetLocker locker(mapPaintWidget);
       QueryLocker queryLocker(mapPaintWidget->getQueries());
 
-      // Copy all map settings except trail
-      mapPaintWidget->copySettings(*NavApp::getMapWidgetGui(), false /* deep */);
-
-      // Disable dynamic/live features
-      mapPaintWidget->setShowMapObject(map::AIRCRAFT_ALL, false);
-      mapPaintWidget->setShowMapObject(map::AIRCRAFT_TRAIL, false);
-
-      mapPaintWidget->setShowMapObjectDisplay(map::COMPASS_ROSE, false);
-      mapPaintWidget->setShowMapObjectDisplay(map::AIRCRAFT_ENDURANCE, false);
-      mapPaintWidget->setShowMapObjectDisplay(map::AIRCRAFT_SELECTED_ALT_RANGE, false);
-      mapPaintWidget->setShowMapObjectDisplay(map::AIRCRAFT_TURN_PATH, false);
-
-      // Set detail factor
-      mapPaintWidget->getMapPaintLayer()->setDetailLevel(detailFactor, detailFactor);
-
+      copySettingsForRect(detailFactor);
       mapPaintWidget->showRectStreamlined(rect, false);
 
-      // Disable copyright note and wind
-      mapPaintWidget->setPaintCopyright(false);
-      mapPaintWidget->setPaintWindHeader(false);
-
       MapPixmap mapPixmap;
 
       // No distance requested. Therefore requested is equal to actual
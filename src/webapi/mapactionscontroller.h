@@ -27,8 +27,13 @@ class MapPaintWidget;
 class WebApiRequest;
 class WebApiResponse;
 class AbstractInfoBuilder;
+class WebTileCache;
 struct MapPixmap;
 
+namespace InfoBuilderTypes {
+struct MapFeaturesData;
+}
+
 namespace atools {
 namespace geo {
 class Rect;
@@ -57,6 +62,20 @@ public:
      * @brief get map feature by id
      */
     Q_INVOKABLE WebApiResponse featureAction(WebApiRequest request);
+    /**
+     * @brief get Web Mercator map tile by path "/map/tile/{z}/{x}/{y}". Tiles are cached in memory and on disk.
+     */
+    Q_INVOKABLE WebApiResponse tileAction(WebApiRequest request);
+    /**
+     * @brief compare feature query without rendering against the previous path which rendered a dummy image.
+     * Parameters like features plus optional iterations. Only available if the web server runs in verbose mode.
+     */
+    Q_INVOKABLE WebApiResponse featuresbenchmarkAction(WebApiRequest request);
+    /**
+     * @brief get paint times and cache counters as JSON for the main map and the web map.
+     * Parameter "reset=true" clears all statistics after returning them.
+     */
+    Q_INVOKABLE WebApiResponse profileAction(WebApiRequest request);
 
     explicit MapActionsController(QWidget *parent, bool verboseParam);
     virtual ~MapActionsController() override;
@@ -81,7 +100,28 @@ protected:
     MapPixmap getPixmapRect(int width, int height, atools::geo::Rect rect, int detailFactor = MapLayerSettings::MAP_DEFAULT_DETAIL_LEVEL,
                             const QString& errorCase = tr("Invalid rectangle"), bool ignoreUiScale = true);
 
+    /* Get Web Mercator tile exactly covering rect with TILE_SIZE pixels. Neither draws wind pointer at top nor copyright. */
+    MapPixmap getPixmapTile(const atools::geo::Rect& rect, int detailFactor);
+
+    /* Copy settings from GUI map, disable live features, copyright and wind and set detail level.
+     * Called with web map widget locked. */
+    void copySettingsForRect(int detailFactor);
+
+    /* Get airports, navaids and waypoints for the rectangle. Resolves the map layer for zoom distance and
+     * detail factor and queries the rect caches under one lock. Does not render. */
+    InfoBuilderTypes::MapFeaturesData getFeaturesRect(const atools::geo::Rect& rect, int detailFactor);
+
+    /* Previous implementation which renders a dummy image to fill the rect caches. Only used for benchmarking. */
+    InfoBuilderTypes::MapFeaturesData getFeaturesRectRendered(const atools::geo::Rect& rect, int detailFactor);
+
+    /* Build cache key from tile coordinates and all options affecting the map image */
+    QString tileKey(int z, int x, int y, const QString& format, int quality, int detailFactor) const;
+
+    /* Drop all cached tiles after database, flight plan, online network or weather changes */
+    void invalidateTiles();
+
     MapPaintWidget *mapPaintWidget = nullptr;
+    WebTileCache *tileCache = nullptr;
 };
 
 #endif // MAPACTIONSCONTROLLER_H